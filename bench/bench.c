@@ -0,0 +1,2955 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "iso.h"
+#include "atlas.h"
+#include "profile.h"
+#include "alloc.h"
+#include "player.h"
+#include "entity.h"
+#include "spatial.h"
+#include "path.h"
+#include "collision.h"
+#include "sim.h"
+#include "mapfile.h"
+#include "stream.h"
+#include "tilegen.h"
+#include "layer.h"
+#include "impostor.h"
+#include "pick.h"
+#include "raster.h"
+#include "image.h"
+#include "queue.h"
+#include "tilestream.h"
+
+#include "recorder.h"
+
+#include <Ignis/Renderer/Renderer.h>
+
+/*
+ * Headless frame benchmark. Every result is one JSON object per line on
+ * stdout so runs can be diffed and checked for regressions by scripts.
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+
+static uint64_t benchNow()
+{
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+}
+
+static void benchSleep(uint32_t ms)
+{
+    Sleep(ms);
+}
+#else
+#include <time.h>
+
+static uint64_t benchNow()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void benchSleep(uint32_t ms)
+{
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000l };
+    nanosleep(&ts, NULL);
+}
+#endif
+
+#define BENCH_VIEW_WIDTH  1920.0f
+#define BENCH_VIEW_HEIGHT 1080.0f
+
+#define BENCH_TILE_SIZE   50.0f
+#define BENCH_TILE_OFFSET 8.0f
+
+#define BENCH_FRAME_ARENA (256 * 1024) /* as in main */
+
+typedef struct
+{
+    uint64_t min_time;  /* ns per case */
+    uint32_t max_frames;
+    uint32_t max_size;
+    uint32_t full_max;  /* largest map rendered with the whole map in view */
+} BenchConfig;
+
+typedef struct
+{
+    IsoMap map;
+    Player player;
+    IsoEntityLayer entities;
+    IgnisTexture2D atlas;
+    IsoAtlas tiles;
+    IsoLayerStack layers; /* the map as ground */
+    rect view;
+    rect full_view;
+} BenchScene;
+
+typedef void (*BenchFrameFn)(BenchScene* scene);
+
+static uint32_t benchHash(uint32_t x, uint32_t y)
+{
+    uint32_t h = x * 0x8da6b343u ^ y * 0xd8163841u;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    return h ^ (h >> 15);
+}
+
+/* water border, grass with patches of sand and lakes */
+static int benchGenerateMap(IsoMap* map, uint32_t size)
+{
+    if (!isoMapInit(map, NULL, size, size, BENCH_TILE_SIZE, BENCH_TILE_OFFSET))
+        return 0;
+
+    for (uint32_t row = 0; row < size; row++)
+    {
+        for (uint32_t col = 0; col < size; col++)
+        {
+            uint32_t tile = 1;
+            uint32_t patch = benchHash(col >> 4, row >> 4) & 15;
+
+            if (col == 0 || row == 0 || col == size - 1 || row == size - 1) tile = 3;
+            else if (patch == 0) tile = 2;
+            else if (patch == 1) tile = 3;
+
+            if (!isoMapSetTile(map, col, row, tile))
+                return 0;
+        }
+    }
+
+    return 1;
+}
+
+static void benchSetupScene(BenchScene* scene)
+{
+    IsoMap* map = &scene->map;
+    float center = map->width * map->tile_size * .5f;
+
+    // center the map on screen
+    vec2 screen_center = cartesianToIso((vec2) { center, center });
+    isoMapSetOrigin(map, (vec2) { BENCH_VIEW_WIDTH * .5f - screen_center.x, BENCH_VIEW_HEIGHT * .5f - screen_center.y });
+
+    scene->view = (rect){ { 0.0f, 0.0f }, { BENCH_VIEW_WIDTH, BENCH_VIEW_HEIGHT } };
+
+    float extent = map->width * map->tile_size;
+    scene->full_view.min = vec2_add(map->origin, (vec2) { -extent - map->tile_size, 0.0f });
+    scene->full_view.max = vec2_add(map->origin, (vec2) { extent + map->tile_size, extent + map->tile_size + map->tile_offset });
+
+    scene->player.position = (vec2) { center, center };
+    scene->player.speed = 60.0f;
+    scene->player.extent = .2f * map->tile_size;
+
+    scene->atlas = (IgnisTexture2D){ 0 };
+    scene->atlas.rows = 1;
+    scene->atlas.columns = 5;
+    scene->atlas.width = 500;
+    scene->atlas.height = 58;
+    isoAtlasInitGrid(&scene->tiles, scene->atlas);
+    isoLayerStackInit(&scene->layers, &scene->map, &scene->tiles);
+
+    // the player and a pillar on every 8th tile of the 64x64 tiles around it
+    isoEntityLayerInit(&scene->entities, 64);
+    IsoEntity entity = { scene->player.position, { 32.0f, 64.0f }, &scene->atlas, 0 };
+    isoEntityLayerAdd(&scene->entities, entity);
+
+    uint32_t first = map->width > 64 ? map->width / 2 - 32 : 0;
+    uint32_t last = map->width > 64 ? first + 64 : map->width;
+    for (uint32_t row = first; row < last; row += 8)
+    {
+        for (uint32_t col = first; col < last; col += 8)
+        {
+            entity.position = (vec2){ (col + .5f) * map->tile_size, (row + .5f) * map->tile_size };
+            entity.frame = 1;
+            isoEntityLayerAdd(&scene->entities, entity);
+        }
+    }
+}
+
+static void benchFrameRender(BenchScene* scene)
+{
+    renderMap(&scene->map, &scene->tiles, scene->view);
+    ignisBatch2DFlush();
+}
+
+static void benchFrameRenderFull(BenchScene* scene)
+{
+    renderMap(&scene->map, &scene->tiles, scene->full_view);
+    ignisBatch2DFlush();
+}
+
+static void benchFrameHighlight(BenchScene* scene)
+{
+    vec2 cursor = { BENCH_VIEW_WIDTH * .5f, BENCH_VIEW_HEIGHT * .5f };
+    highlightTile(&scene->map, screenToWorld(&scene->map, cursor));
+    ignisPrimitives2DFlush();
+}
+
+static void benchFramePlayer(BenchScene* scene)
+{
+    playerUpdate(&scene->player, &scene->map, (vec2) { 1.0f, 0.0f }, 1.0f / 60.0f);
+}
+
+static void benchFrameEntities(BenchScene* scene)
+{
+    isoEntityLayerSort(&scene->entities, &scene->map);
+    isoEntityLayerRender(&scene->entities, &scene->map, &scene->layers, scene->view);
+    ignisBatch2DFlush();
+}
+
+/* mirrors OnUpdate without the text overlay */
+static void benchFrameFull(BenchScene* scene)
+{
+    benchFramePlayer(scene);
+    scene->entities.entities[0].position = scene->player.position;
+
+    benchFrameEntities(scene);
+    benchFrameHighlight(scene);
+}
+
+/* set when a warmed up frame touched the heap */
+static int bench_steady_allocs = 0;
+
+static void benchRun(const BenchConfig* config, BenchScene* scene, const char* name, BenchFrameFn frame)
+{
+    // warm up caches and lazy allocations, the frame arena grows at the end of the frame as in main
+    frame(scene);
+    isoMemFrame();
+
+    benchRecorderReset();
+    int64_t allocs_start = benchAllocations();
+    uint64_t tracked_start = isoMemAllocCount();
+
+    uint32_t frames = 0;
+    uint64_t start = benchNow();
+    uint64_t elapsed = 0;
+    while (elapsed < config->min_time && frames < config->max_frames)
+    {
+        frame(scene);
+        isoMemFrame();
+        frames++;
+        elapsed = benchNow() - start;
+    }
+
+    int64_t allocs = benchAllocations();
+    double allocs_per_frame = allocs < 0 ? -1.0 : (double)(allocs - allocs_start) / frames;
+
+    if (allocs != allocs_start || isoMemAllocCount() != tracked_start)
+    {
+        fprintf(stderr, "%s allocated in steady state frames\n", name);
+        bench_steady_allocs = 1;
+    }
+
+    double ns_per_frame = (double)elapsed / frames;
+    double tiles_per_frame = (double)bench_recorder.quads / frames;
+    double ns_per_tile = tiles_per_frame > 0.0 ? ns_per_frame / tiles_per_frame : 0.0;
+
+    printf("{\"bench\":\"%s\",\"map\":%u,\"frames\":%u,\"ns_per_frame\":%.1f,\"ns_per_tile\":%.3f,"
+           "\"tiles_per_frame\":%.1f,\"primitives_per_frame\":%.1f,\"allocs_per_frame\":%.2f,\"checksum\":%.0f}\n",
+           name, scene->map.width, frames, ns_per_frame, ns_per_tile,
+           tiles_per_frame, (double)bench_recorder.primitives / frames, allocs_per_frame, bench_recorder.checksum);
+    fflush(stdout);
+}
+
+/* batch transforms against the per point functions they replace */
+#define BENCH_POINTS 65536
+
+typedef enum
+{
+    BENCH_WORLD_TO_SCREEN,
+    BENCH_SCREEN_TO_WORLD,
+    BENCH_TILE_SCREEN_POS
+} BenchTransform;
+
+static void benchTransformPoints(const IsoMap* map, BenchTransform transform, const float* x, const float* y,
+                                 const uint32_t* cols, const uint32_t* rows, float* out_x, float* out_y, int batched)
+{
+    if (batched)
+    {
+        switch (transform)
+        {
+        case BENCH_WORLD_TO_SCREEN: worldToScreenArray(map, x, y, out_x, out_y, BENCH_POINTS); break;
+        case BENCH_SCREEN_TO_WORLD: screenToWorldArray(map, x, y, out_x, out_y, BENCH_POINTS); break;
+        case BENCH_TILE_SCREEN_POS: getTileScreenPosArray(map, cols, rows, out_x, out_y, BENCH_POINTS); break;
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < BENCH_POINTS; i++)
+    {
+        vec2 p = { x[i], y[i] };
+        switch (transform)
+        {
+        case BENCH_WORLD_TO_SCREEN: p = worldToScreen(map, p); break;
+        case BENCH_SCREEN_TO_WORLD: p = screenToWorld(map, p); break;
+        case BENCH_TILE_SCREEN_POS: p = getTileScreenPos(map, cols[i], rows[i]); break;
+        }
+        out_x[i] = p.x;
+        out_y[i] = p.y;
+    }
+}
+
+static int benchTransforms(const BenchConfig* config)
+{
+    static const char* names[] = { "worldToScreenArray", "screenToWorldArray", "getTileScreenPosArray" };
+    static const IsoKernel kernels[] = { ISO_KERNEL_SCALAR, ISO_KERNEL_SSE2, ISO_KERNEL_AVX2 };
+
+    IsoMap map;
+    if (!isoMapInit(&map, NULL, 1, 1, BENCH_TILE_SIZE, BENCH_TILE_OFFSET))
+        return 0;
+    isoMapSetOrigin(&map, (vec2) { 960.0f, -4000.0f });
+
+    float* buffer = malloc(6 * BENCH_POINTS * sizeof(float));
+    uint32_t* tiles = malloc(2 * BENCH_POINTS * sizeof(uint32_t));
+    if (!buffer || !tiles)
+    {
+        free(buffer);
+        free(tiles);
+        isoMapDestroy(&map);
+        return 0;
+    }
+
+    float* x = buffer;
+    float* y = x + BENCH_POINTS;
+    float* out_x = y + BENCH_POINTS;
+    float* out_y = out_x + BENCH_POINTS;
+    float* ref_x = out_y + BENCH_POINTS;
+    float* ref_y = ref_x + BENCH_POINTS;
+    uint32_t* cols = tiles;
+    uint32_t* rows = tiles + BENCH_POINTS;
+
+    for (uint32_t i = 0; i < BENCH_POINTS; i++)
+    {
+        cols[i] = benchHash(i, 1) & 8191;
+        rows[i] = benchHash(i, 2) & 8191;
+        x[i] = cols[i] * 37.5f;
+        y[i] = rows[i] * 12.25f;
+    }
+
+    int result = 1;
+    for (int t = BENCH_WORLD_TO_SCREEN; t <= BENCH_TILE_SCREEN_POS; t++)
+    {
+        benchTransformPoints(&map, t, x, y, cols, rows, ref_x, ref_y, 0);
+
+        for (int k = -1; k < (int)(sizeof(kernels) / sizeof(kernels[0])); k++)
+        {
+            // k == -1 times the per point functions as the baseline
+            int batched = k >= 0;
+            IsoKernel kernel = batched ? isoTransformSetKernel(kernels[k]) : ISO_KERNEL_SCALAR;
+            if (batched && kernel != kernels[k]) continue;
+
+            uint32_t runs = 0;
+            uint64_t start = benchNow();
+            uint64_t elapsed = 0;
+            while (elapsed < config->min_time / 4 && runs < config->max_frames)
+            {
+                benchTransformPoints(&map, t, x, y, cols, rows, out_x, out_y, batched);
+                runs++;
+                elapsed = benchNow() - start;
+            }
+
+            float max_error = 0.0f;
+            for (size_t i = 0; i < BENCH_POINTS; i++)
+            {
+                float error = fmaxf(fabsf(out_x[i] - ref_x[i]), fabsf(out_y[i] - ref_y[i]));
+                if (error > max_error) max_error = error;
+            }
+
+            // tolerance covers the different rounding of the affine form
+            if (max_error > 1e-2f) result = 0;
+
+            printf("{\"bench\":\"%s\",\"kernel\":\"%s\",\"points\":%d,\"runs\":%u,\"ns_per_point\":%.3f,\"max_error\":%g}\n",
+                   names[t], batched ? isoKernelName(kernel) : "per_point",
+                   BENCH_POINTS, runs, (double)elapsed / ((double)runs * BENCH_POINTS), max_error);
+            fflush(stdout);
+        }
+    }
+
+    isoTransformSetKernel(ISO_KERNEL_AUTO);
+
+    free(buffer);
+    free(tiles);
+    isoMapDestroy(&map);
+    return result;
+}
+
+/* vectorized mat4 functions against the scalar by value versions */
+#define BENCH_MATRICES 1024
+
+static float benchRandom(uint32_t* seed)
+{
+    *seed = *seed * 1664525u + 1013904223u;
+    return (float)(*seed >> 8) / (float)(1u << 24) * 2.0f - 1.0f;
+}
+
+static float benchMat4Error(const mat4* a, const mat4* b)
+{
+    float error = 0.0f;
+    for (int i = 0; i < 16; i++)
+    {
+        float e = fabsf(a->v[i] - b->v[i]) / fmaxf(1.0f, fabsf(b->v[i]));
+        if (e > error) error = e;
+    }
+    return error;
+}
+
+static void benchReportMat4(const char* name, const char* kernel, uint32_t count, uint64_t ns, float error)
+{
+    printf("{\"bench\":\"%s\",\"kernel\":\"%s\",\"count\":%u,\"ns_per_op\":%.3f,\"max_error\":%g}\n",
+           name, kernel, count, (double)ns / count, error);
+    fflush(stdout);
+}
+
+static int benchMat4()
+{
+    mat4* a = malloc(3 * BENCH_MATRICES * sizeof(mat4));
+    vec3* points = malloc(4 * BENCH_POINTS * sizeof(vec3));
+    if (!a || !points)
+    {
+        free(a);
+        free(points);
+        return 0;
+    }
+
+    mat4* b = a + BENCH_MATRICES;
+    mat4* r = b + BENCH_MATRICES;
+
+    // diagonally dominant so every matrix is well conditioned
+    uint32_t seed = 1;
+    for (uint32_t i = 0; i < 2 * BENCH_MATRICES; i++)
+    {
+        for (int j = 0; j < 16; j++)
+            a[i].v[j] = benchRandom(&seed) + ((j % 5 == 0) ? 4.0f : 0.0f);
+    }
+
+    uint64_t start = benchNow();
+    for (uint32_t i = 0; i < BENCH_MATRICES; i++)
+        r[i] = mat4_multiply(a[i], b[i]);
+    benchReportMat4("mat4_multiply", "scalar", BENCH_MATRICES, benchNow() - start, 0.0f);
+
+    start = benchNow();
+    for (uint32_t i = 0; i < BENCH_MATRICES; i++)
+        psmat4_multiply(&r[i], &a[i], &b[i]);
+    uint64_t elapsed = benchNow() - start;
+
+    float multiply_error = 0.0f;
+    for (uint32_t i = 0; i < BENCH_MATRICES; i++)
+    {
+        mat4 ref = mat4_multiply(a[i], b[i]);
+        multiply_error = fmaxf(multiply_error, benchMat4Error(&r[i], &ref));
+    }
+    benchReportMat4("psmat4_multiply", "simd", BENCH_MATRICES, elapsed, multiply_error);
+
+    start = benchNow();
+    for (uint32_t i = 0; i < BENCH_MATRICES; i++)
+        r[i] = mat4_inverse(a[i]);
+    benchReportMat4("mat4_inverse", "scalar", BENCH_MATRICES, benchNow() - start, 0.0f);
+
+    start = benchNow();
+    for (uint32_t i = 0; i < BENCH_MATRICES; i++)
+        psmat4_inverse(&r[i], &a[i]);
+    elapsed = benchNow() - start;
+
+    float inverse_error = 0.0f;
+    for (uint32_t i = 0; i < BENCH_MATRICES; i++)
+    {
+        mat4 ref = mat4_inverse(a[i]);
+        inverse_error = fmaxf(inverse_error, benchMat4Error(&r[i], &ref));
+    }
+    benchReportMat4("psmat4_inverse", "simd", BENCH_MATRICES, elapsed, inverse_error);
+
+    // points through a full projection so the divide matters
+    vec3* transformed = points + BENCH_POINTS;
+    vec2* points2 = (vec2*)(transformed + BENCH_POINTS);
+    vec2* transformed2 = points2 + BENCH_POINTS;
+
+    for (uint32_t i = 0; i < BENCH_POINTS; i++)
+    {
+        points[i] = (vec3){ benchRandom(&seed) * 100.0f, benchRandom(&seed) * 100.0f, -2.0f - fabsf(benchRandom(&seed)) * 50.0f };
+        points2[i] = (vec2){ points[i].x, points[i].y };
+    }
+
+    mat4 view = mat4_translate(mat4_indentity(), (vec3) { 1.0f, 2.0f, -3.0f });
+    mat4 projection = mat4_multiply(mat4_perspective(1.0f, 1.5f, 0.1f, 100.0f), view);
+
+    // first touch of the output pages is not part of the measurement
+    mat4_transform_vec3_array(&projection, points, transformed, BENCH_POINTS);
+    mat4_transform_vec2_array(&projection, points2, transformed2, BENCH_POINTS);
+
+    start = benchNow();
+    mat4_transform_vec3_array(&projection, points, transformed, BENCH_POINTS);
+    elapsed = benchNow() - start;
+
+    float transform_error = 0.0f;
+    for (uint32_t i = 0; i < BENCH_POINTS; i++)
+    {
+        const float* v = projection.v;
+        vec3 p = points[i];
+        float w = v[3] * p.x + v[7] * p.y + v[11] * p.z + v[15];
+        vec3 ref = {
+            (v[0] * p.x + v[4] * p.y + v[8] * p.z + v[12]) / w,
+            (v[1] * p.x + v[5] * p.y + v[9] * p.z + v[13]) / w,
+            (v[2] * p.x + v[6] * p.y + v[10] * p.z + v[14]) / w
+        };
+        float e = fmaxf(fabsf(ref.x - transformed[i].x), fmaxf(fabsf(ref.y - transformed[i].y), fabsf(ref.z - transformed[i].z)));
+        transform_error = fmaxf(transform_error, e / fmaxf(1.0f, fabsf(ref.x) + fabsf(ref.y) + fabsf(ref.z)));
+    }
+    benchReportMat4("mat4_transform_vec3_array", "simd", BENCH_POINTS, elapsed, transform_error);
+
+    start = benchNow();
+    mat4_transform_vec2_array(&projection, points2, transformed2, BENCH_POINTS);
+    elapsed = benchNow() - start;
+
+    float transform2_error = 0.0f;
+    for (uint32_t i = 0; i < BENCH_POINTS; i++)
+    {
+        const float* v = projection.v;
+        vec2 p = points2[i];
+        float w = v[3] * p.x + v[7] * p.y + v[15];
+        vec2 ref = { (v[0] * p.x + v[4] * p.y + v[12]) / w, (v[1] * p.x + v[5] * p.y + v[13]) / w };
+        float e = fmaxf(fabsf(ref.x - transformed2[i].x), fabsf(ref.y - transformed2[i].y));
+        transform2_error = fmaxf(transform2_error, e / fmaxf(1.0f, fabsf(ref.x) + fabsf(ref.y)));
+    }
+    benchReportMat4("mat4_transform_vec2_array", "simd", BENCH_POINTS, elapsed, transform2_error);
+
+    free(a);
+    free(points);
+
+    return multiply_error < 1e-5f && inverse_error < 1e-5f && transform_error < 1e-5f && transform2_error < 1e-5f;
+}
+
+/* skyline packing of random sprite sizes, checked for bounds and overlaps */
+#define BENCH_ATLAS_FRAMES 4096
+
+static int benchAtlasPack()
+{
+    IsoAtlasFrame* frames = malloc(BENCH_ATLAS_FRAMES * sizeof(IsoAtlasFrame));
+    if (!frames) return 0;
+
+    uint32_t seed = 7;
+    uint64_t area = 0;
+    for (uint32_t i = 0; i < BENCH_ATLAS_FRAMES; i++)
+    {
+        frames[i].w = 16 + (uint32_t)((benchRandom(&seed) * .5f + .5f) * 112.0f);
+        frames[i].h = 16 + (uint32_t)((benchRandom(&seed) * .5f + .5f) * 112.0f);
+        area += (uint64_t)frames[i].w * frames[i].h;
+    }
+
+    uint32_t width = 0, height = 0;
+    uint64_t start = benchNow();
+    int result = isoAtlasPack(frames, BENCH_ATLAS_FRAMES, 1, 8192, &width, &height);
+    uint64_t elapsed = benchNow() - start;
+
+    result = result && (width & (width - 1)) == 0 && (height & (height - 1)) == 0;
+
+    // padded rects may touch but never overlap
+    for (uint32_t i = 0; result && i < BENCH_ATLAS_FRAMES; i++)
+    {
+        const IsoAtlasFrame* a = &frames[i];
+        if (a->x + a->w + 1 > width || a->y + a->h + 1 > height)
+            result = 0;
+
+        for (uint32_t j = i + 1; result && j < BENCH_ATLAS_FRAMES; j++)
+        {
+            const IsoAtlasFrame* b = &frames[j];
+            if (a->x < b->x + b->w + 1 && b->x < a->x + a->w + 1 && a->y < b->y + b->h + 1 && b->y < a->y + a->h + 1)
+                result = 0;
+        }
+    }
+
+    printf("{\"bench\":\"isoAtlasPack\",\"frames\":%u,\"ns\":%llu,\"width\":%u,\"height\":%u,\"occupancy\":%.3f}\n",
+           BENCH_ATLAS_FRAMES, (unsigned long long)elapsed, width, height, (double)area / ((double)width * height));
+    fflush(stdout);
+
+    free(frames);
+    return result;
+}
+
+/* pooled chunk tiles against the heap, and the arena settling at its peak */
+#define BENCH_POOL_OBJECTS 4096
+#define BENCH_POOL_ROUNDS  16
+
+static int benchMemory()
+{
+    void** objects = malloc(BENCH_POOL_OBJECTS * sizeof(void*));
+    if (!objects) return 0;
+
+    int result = 1;
+    size_t size = ISO_CHUNK_TILES * sizeof(uint32_t);
+
+    IsoPool pool;
+    isoPoolInit(&pool, ISO_MEM_GENERAL, size, 64);
+
+    // the first round grows the pool, later rounds must reuse it
+    uint64_t pool_ns = 0;
+    for (uint32_t round = 0; round < BENCH_POOL_ROUNDS && result; round++)
+    {
+        uint64_t allocs = isoMemAllocCount();
+        uint64_t start = benchNow();
+        for (uint32_t i = 0; i < BENCH_POOL_OBJECTS; i++)
+            objects[i] = isoPoolAlloc(&pool);
+        for (uint32_t i = 0; i < BENCH_POOL_OBJECTS; i++)
+            isoPoolFree(&pool, objects[BENCH_POOL_OBJECTS - 1 - i]);
+        if (round > 0) pool_ns += benchNow() - start;
+
+        result = pool.used == 0 && pool.capacity == BENCH_POOL_OBJECTS && (round == 0 || isoMemAllocCount() == allocs);
+    }
+    isoPoolDestroy(&pool);
+
+    uint64_t heap_ns = 0;
+    for (uint32_t round = 1; round < BENCH_POOL_ROUNDS && result; round++)
+    {
+        uint64_t start = benchNow();
+        for (uint32_t i = 0; i < BENCH_POOL_OBJECTS; i++)
+            objects[i] = isoMalloc(ISO_MEM_GENERAL, size);
+        for (uint32_t i = 0; i < BENCH_POOL_OBJECTS; i++)
+            isoFree(objects[BENCH_POOL_OBJECTS - 1 - i]);
+        heap_ns += benchNow() - start;
+    }
+
+    // everything handed back, the counters are balanced again
+    result = result && isoMemStats(ISO_MEM_GENERAL)->bytes == 0;
+
+    // an arena that starts too small overflows once and then stays on its own block
+    IsoArena arena;
+    uint64_t arena_allocs = 0;
+    if (result && isoArenaInit(&arena, ISO_MEM_FRAME, 1024))
+    {
+        for (uint32_t frame = 0; frame < 4 && result; frame++)
+        {
+            uint64_t allocs = isoMemAllocCount();
+            for (uint32_t i = 0; i < 64; i++)
+            {
+                size_t mark = isoArenaMark(&arena);
+                uint8_t* a = isoArenaAlloc(&arena, 100);
+                uint8_t* b = isoArenaAlloc(&arena, 1000);
+                result = result && a && b && ((uintptr_t)b & 15) == 0 && a + 100 <= b;
+                if (i & 1) isoArenaRelease(&arena, mark);
+            }
+            isoArenaReset(&arena);
+            if (frame > 1) arena_allocs += isoMemAllocCount() - allocs;
+        }
+        result = result && arena_allocs == 0 && arena.size >= arena.peak && !arena.overflow;
+        isoArenaDestroy(&arena);
+    }
+
+    double ops = (double)(BENCH_POOL_ROUNDS - 1) * BENCH_POOL_OBJECTS;
+    printf("{\"bench\":\"isoPoolAlloc\",\"objects\":%u,\"size\":%u,\"ns_per_alloc_free\":%.1f,\"heap_ns_per_alloc_free\":%.1f,\"arena_steady_allocs\":%llu}\n",
+           BENCH_POOL_OBJECTS, (uint32_t)size, pool_ns / ops, heap_ns / ops, (unsigned long long)arena_allocs);
+    fflush(stdout);
+
+    free(objects);
+    return result;
+}
+
+/* writers on several threads into one ring, nothing may get lost while it fits */
+#define BENCH_PROFILE_THREADS 4
+#define BENCH_PROFILE_EVENTS  100000
+
+static const char* bench_profile_names[] = { "zone0", "zone1", "zone2", "zone3" };
+
+static int benchProfileWriter(void* arg)
+{
+    IsoProfiler* profiler = arg;
+    for (uint32_t i = 0; i < BENCH_PROFILE_EVENTS; i++)
+        isoProfileEnd(profiler, i & 3, isoClockNs());
+    return 0;
+}
+
+static int benchProfiler()
+{
+    IsoProfiler profiler;
+    if (!isoProfilerInit(&profiler, bench_profile_names, 4, BENCH_PROFILE_THREADS * BENCH_PROFILE_EVENTS))
+        return 0;
+
+    IsoThread* threads[BENCH_PROFILE_THREADS];
+    uint64_t start = benchNow();
+    for (uint32_t i = 0; i < BENCH_PROFILE_THREADS; i++)
+        threads[i] = isoThreadCreate(benchProfileWriter, &profiler);
+
+    // drain while they write
+    uint32_t frames = 0;
+    while (isoAtomicLoad(&profiler.head) < BENCH_PROFILE_THREADS * BENCH_PROFILE_EVENTS)
+    {
+        isoProfilerFrame(&profiler);
+        frames++;
+    }
+
+    for (uint32_t i = 0; i < BENCH_PROFILE_THREADS; i++)
+        if (threads[i]) isoThreadJoin(threads[i]);
+    uint64_t elapsed = benchNow() - start;
+
+    isoProfilerFrame(&profiler);
+
+    int result = profiler.read == BENCH_PROFILE_THREADS * BENCH_PROFILE_EVENTS && profiler.dropped == 0;
+
+    // a ring smaller than the events keeps the newest and counts the rest as dropped
+    IsoProfiler small;
+    if (result && isoProfilerInit(&small, bench_profile_names, 4, 1024))
+    {
+        benchProfileWriter(&small);
+        isoProfilerFrame(&small);
+        result = small.dropped == BENCH_PROFILE_EVENTS - 1024 && small.read == BENCH_PROFILE_EVENTS;
+
+        IsoProfileStats stats;
+        isoProfilerStats(&small, 0, &stats);
+        result = result && stats.min <= stats.avg && stats.avg <= stats.p99;
+        isoProfilerDestroy(&small);
+    }
+
+    printf("{\"bench\":\"isoProfileEnd\",\"threads\":%u,\"events\":%u,\"ns_per_event\":%.1f,\"drains\":%u}\n",
+           BENCH_PROFILE_THREADS, BENCH_PROFILE_THREADS * BENCH_PROFILE_EVENTS,
+           (double)elapsed / (BENCH_PROFILE_THREADS * BENCH_PROFILE_EVENTS), frames);
+    fflush(stdout);
+
+    isoProfilerDestroy(&profiler);
+    return result;
+}
+
+/* parallel tile generation of the whole map for a growing number of workers */
+static int benchTileBuilder(const BenchConfig* config, BenchScene* scene)
+{
+    /* always include a few oversubscribed runs so band ordering gets checked on small machines */
+    uint32_t max_threads = isoCpuCount() < 4 ? 4 : isoCpuCount();
+    IsoVertex* reference = NULL;
+    uint32_t reference_quads = 0;
+    int result = 1;
+
+    for (uint32_t threads = 1; threads <= max_threads && result; threads *= 2)
+    {
+        IsoJobPool pool;
+        IsoTileBuilder builder;
+        if (!isoJobPoolInit(&pool, threads - 1) || !isoTileBuilderInit(&builder, &pool, 4 * threads))
+            return 0;
+
+        isoTileBuilderBuild(&builder, &scene->layers, scene->full_view);
+        int64_t allocs_start = benchAllocations();
+
+        uint32_t frames = 0;
+        uint64_t start = benchNow();
+        uint64_t elapsed = 0;
+        while (elapsed < config->min_time && frames < config->max_frames)
+        {
+            if (!isoTileBuilderBuild(&builder, &scene->layers, scene->full_view))
+                return 0;
+            frames++;
+            elapsed = benchNow() - start;
+        }
+
+        int64_t allocs = benchAllocations();
+        double allocs_per_frame = allocs < 0 ? -1.0 : (double)(allocs - allocs_start) / frames;
+
+        double ns_per_frame = (double)elapsed / frames;
+        printf("{\"bench\":\"isoTileBuilderBuild\",\"map\":%u,\"threads\":%u,\"frames\":%u,\"ns_per_frame\":%.1f,"
+               "\"ns_per_tile\":%.3f,\"tiles_per_frame\":%u,\"allocs_per_frame\":%.2f}\n",
+               scene->map.width, threads, frames, ns_per_frame, ns_per_frame / builder.quads, builder.quads, allocs_per_frame);
+        fflush(stdout);
+
+        /* the parallel output has to match the single threaded build vertex for vertex */
+        size_t size = (size_t)builder.quads * ISO_QUAD_VERTICES * sizeof(IsoVertex);
+        if (!reference)
+        {
+            reference = malloc(size);
+            reference_quads = builder.quads;
+            if (reference) memcpy(reference, builder.vertices, size);
+            else result = 0;
+        }
+        else if (builder.quads != reference_quads || memcmp(reference, builder.vertices, size) != 0)
+        {
+            result = 0;
+        }
+
+        isoTileBuilderDestroy(&builder);
+        isoJobPoolDestroy(&pool);
+    }
+
+    free(reference);
+    return result;
+}
+
+/* incremental depth sort of moving entities against sorting from scratch */
+static int benchDepthKeyCompare(const void* a, const void* b)
+{
+    float da = ((const IsoDepthKey*)a)->depth;
+    float db = ((const IsoDepthKey*)b)->depth;
+    return (da > db) - (da < db);
+}
+
+static int benchEntitySort(const BenchConfig* config, const IsoMap* map)
+{
+    const uint32_t counts[] = { 1000, 10000, 50000 };
+    float extent = map->width * map->tile_size;
+    uint32_t seed = 7;
+    int result = 1;
+
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]) && result; c++)
+    {
+        uint32_t count = counts[c];
+
+        IsoEntityLayer layer;
+        vec2* velocity = malloc(count * sizeof(vec2));
+        IsoDepthKey* keys = malloc(count * sizeof(IsoDepthKey));
+        if (!velocity || !keys || !isoEntityLayerInit(&layer, count))
+            return 0;
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            IsoEntity entity = { { 0 }, { 32.0f, 64.0f }, NULL, 0 };
+            entity.position.x = (benchRandom(&seed) * .5f + .5f) * extent;
+            entity.position.y = (benchRandom(&seed) * .5f + .5f) * extent;
+            isoEntityLayerAdd(&layer, entity);
+
+            // up to player speed at 60 fps
+            velocity[i] = (vec2){ benchRandom(&seed), benchRandom(&seed) };
+        }
+
+        // first sort sees unsorted keys and has to take the radix path
+        isoEntityLayerSort(&layer, map);
+        if (!layer.sort_radix || !isoEntityLayerIsSorted(&layer)) result = 0;
+
+        uint32_t frames = 0;
+        uint32_t radix_frames = 0;
+        uint64_t shifts = 0;
+        uint64_t sort_ns = 0;
+        uint64_t qsort_ns = 0;
+
+        uint64_t start = benchNow();
+        while (benchNow() - start < config->min_time && frames < config->max_frames)
+        {
+            for (uint32_t i = 0; i < count; i++)
+                layer.entities[i].position = vec2_add(layer.entities[i].position, velocity[i]);
+
+            uint64_t t0 = benchNow();
+            isoEntityLayerSort(&layer, map);
+            uint64_t t1 = benchNow();
+
+            // baseline: a full qsort of the same keys every frame
+            memcpy(keys, layer.order, count * sizeof(IsoDepthKey));
+            uint64_t t2 = benchNow();
+            qsort(keys, count, sizeof(IsoDepthKey), benchDepthKeyCompare);
+            uint64_t t3 = benchNow();
+
+            sort_ns += t1 - t0;
+            qsort_ns += t3 - t2;
+            shifts += layer.sort_shifts;
+            radix_frames += layer.sort_radix;
+            frames++;
+
+            if (!isoEntityLayerIsSorted(&layer)) result = 0;
+        }
+
+        printf("{\"bench\":\"isoEntityLayerSort\",\"map\":%u,\"entities\":%u,\"frames\":%u,\"ns_per_frame\":%.1f,"
+               "\"qsort_ns_per_frame\":%.1f,\"shifts_per_frame\":%.1f,\"radix_frames\":%u}\n",
+               map->width, count, frames, (double)sort_ns / frames, (double)qsort_ns / frames,
+               (double)shifts / frames, radix_frames);
+        fflush(stdout);
+
+        isoEntityLayerDestroy(&layer);
+        free(velocity);
+        free(keys);
+    }
+
+    return result;
+}
+
+/* neighbour queries of moving agents against a linear scan */
+#define BENCH_AGENTS       50000
+#define BENCH_QUERY_RADIUS (2.0f * BENCH_TILE_SIZE)
+#define BENCH_QUERY_MAX    256
+
+static uint32_t benchLinearRadius(const vec2* positions, uint32_t count, vec2 center, float radius)
+{
+    uint32_t found = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        float dx = positions[i].x - center.x;
+        float dy = positions[i].y - center.y;
+        if (dx * dx + dy * dy <= radius * radius) found++;
+    }
+    return found;
+}
+
+static int benchSpatial(const BenchConfig* config, const IsoMap* map)
+{
+    float extent = map->width * map->tile_size;
+    uint32_t seed = 11;
+
+    vec2* positions = malloc(BENCH_AGENTS * sizeof(vec2));
+    vec2* velocity = malloc(BENCH_AGENTS * sizeof(vec2));
+    uint32_t* results = malloc(BENCH_QUERY_MAX * sizeof(uint32_t));
+
+    IsoSpatialHash hash;
+    if (!positions || !velocity || !results || !isoSpatialHashInit(&hash, map, 1, BENCH_AGENTS))
+        return 0;
+
+    // agents crowd the middle of the map so queries are not trivially empty
+    for (uint32_t i = 0; i < BENCH_AGENTS; i++)
+    {
+        positions[i].x = (benchRandom(&seed) * .1f + .5f) * extent;
+        positions[i].y = (benchRandom(&seed) * .1f + .5f) * extent;
+        velocity[i] = (vec2){ benchRandom(&seed), benchRandom(&seed) };
+        isoSpatialHashInsert(&hash, i, positions[i]);
+    }
+
+    uint32_t frames = 0;
+    uint64_t move_ns = 0;
+    uint64_t query_ns = 0;
+    uint64_t found = 0;
+
+    uint64_t start = benchNow();
+    while (benchNow() - start < config->min_time && frames < config->max_frames)
+    {
+        uint64_t t0 = benchNow();
+        for (uint32_t i = 0; i < BENCH_AGENTS; i++)
+        {
+            positions[i] = vec2_add(positions[i], velocity[i]);
+            isoSpatialHashMove(&hash, i, positions[i]);
+        }
+        uint64_t t1 = benchNow();
+        for (uint32_t i = 0; i < BENCH_AGENTS; i++)
+            found += isoSpatialHashQueryRadius(&hash, positions[i], BENCH_QUERY_RADIUS, results, BENCH_QUERY_MAX);
+        uint64_t t2 = benchNow();
+
+        move_ns += t1 - t0;
+        query_ns += t2 - t1;
+        frames++;
+    }
+
+    // the same queries as a linear scan, also checking the counts
+    int result = 1;
+    uint32_t checks = 64;
+    uint64_t t0 = benchNow();
+    for (uint32_t i = 0; i < checks; i++)
+    {
+        uint32_t agent = (i * 7919u) % BENCH_AGENTS;
+        uint32_t expected = benchLinearRadius(positions, BENCH_AGENTS, positions[agent], BENCH_QUERY_RADIUS);
+        if (expected != isoSpatialHashQueryRadius(&hash, positions[agent], BENCH_QUERY_RADIUS, results, BENCH_QUERY_MAX))
+            result = 0;
+    }
+    uint64_t linear_ns = benchNow() - t0;
+
+    // rect query spanning more cells than buckets takes the full scan path
+    rect all = { { -extent, -extent }, { 2.0f * extent, 2.0f * extent } };
+    if (isoSpatialHashQueryRect(&hash, all, results, 0) != BENCH_AGENTS)
+        result = 0;
+
+    printf("{\"bench\":\"isoSpatialHash\",\"map\":%u,\"agents\":%u,\"frames\":%u,\"move_ns_per_agent\":%.2f,"
+           "\"query_ns\":%.1f,\"linear_query_ns\":%.1f,\"neighbours_per_query\":%.1f}\n",
+           map->width, BENCH_AGENTS, frames, (double)move_ns / ((double)frames * BENCH_AGENTS),
+           (double)query_ns / ((double)frames * BENCH_AGENTS), (double)linear_ns / checks,
+           (double)found / ((double)frames * BENCH_AGENTS));
+    fflush(stdout);
+
+    isoSpatialHashDestroy(&hash);
+    free(positions);
+    free(velocity);
+    free(results);
+
+    return result;
+}
+
+/* hierarchical against plain A* on long random paths */
+#define BENCH_PATHS 100
+
+/* consecutive tiles, walkable, diagonals not cutting corners */
+static int benchPathValid(const IsoMap* map, const IsoPath* path, IsoPathPoint start, IsoPathPoint goal)
+{
+    if (!path->count) return 0;
+    if (path->points[0].col != start.col || path->points[0].row != start.row) return 0;
+    if (path->points[path->count - 1].col != goal.col || path->points[path->count - 1].row != goal.row) return 0;
+
+    for (uint32_t i = 0; i < path->count; i++)
+    {
+        IsoPathPoint p = path->points[i];
+        if (!isoTileWalkable(isoMapGetTile(map, p.col, p.row))) return 0;
+        if (i == 0) continue;
+
+        IsoPathPoint q = path->points[i - 1];
+        int32_t dx = (int32_t)p.col - (int32_t)q.col;
+        int32_t dy = (int32_t)p.row - (int32_t)q.row;
+        if (dx < -1 || dx > 1 || dy < -1 || dy > 1 || (dx == 0 && dy == 0)) return 0;
+
+        if (dx && dy && (!isoTileWalkable(isoMapGetTile(map, q.col + dx, q.row))
+                      || !isoTileWalkable(isoMapGetTile(map, q.col, q.row + dy))))
+            return 0;
+    }
+
+    return 1;
+}
+
+static IsoPathPoint benchRandomTile(const IsoMap* map, uint32_t* seed)
+{
+    IsoPathPoint p;
+    do
+    {
+        p.col = (uint32_t)((benchRandom(seed) * .5f + .5f) * (map->width - 1));
+        p.row = (uint32_t)((benchRandom(seed) * .5f + .5f) * (map->height - 1));
+    } while (!isoTileWalkable(isoMapGetTile(map, p.col, p.row)));
+    return p;
+}
+
+static int benchPathfinding(IsoMap* map)
+{
+    IsoPathfinder pathfinder;
+    if (!isoPathfinderInit(&pathfinder, map)) return 0;
+
+    IsoPath path = { 0 };
+    uint32_t seed = 5;
+    int result = 1;
+
+    uint64_t grid_ns = 0, hpa_ns = 0;
+    uint64_t grid_expansions = 0, hpa_expansions = 0;
+    uint64_t grid_cost = 0, hpa_cost = 0;
+    uint32_t found = 0;
+
+    // build every cluster up front so the timings only show the searches
+    uint64_t t0 = benchNow();
+    isoPathFind(&pathfinder, (IsoPathPoint) { 1, 1 }, (IsoPathPoint) { map->width - 2, map->height - 2 }, &path);
+    for (uint32_t i = 0; i < pathfinder.cluster_cols * pathfinder.cluster_rows; i++)
+    {
+        if (!pathfinder.clusters[i].built)
+        {
+            uint32_t col = (i % pathfinder.cluster_cols) << ISO_PATH_CLUSTER_SHIFT;
+            uint32_t row = (i / pathfinder.cluster_cols) << ISO_PATH_CLUSTER_SHIFT;
+            isoPathFind(&pathfinder, (IsoPathPoint) { col, row }, (IsoPathPoint) { col, row }, &path);
+        }
+    }
+    uint64_t build_ns = benchNow() - t0;
+
+    for (uint32_t i = 0; i < BENCH_PATHS && result; i++)
+    {
+        IsoPathPoint start = benchRandomTile(map, &seed);
+        IsoPathPoint goal = benchRandomTile(map, &seed);
+
+        t0 = benchNow();
+        int grid_found = isoPathFindGrid(&pathfinder, start, goal, &path);
+        uint64_t t1 = benchNow();
+
+        if (grid_found && !benchPathValid(map, &path, start, goal)) result = 0;
+        uint32_t cost = path.cost;
+        grid_expansions += path.expansions;
+
+        uint64_t t2 = benchNow();
+        int hpa_found = isoPathFind(&pathfinder, start, goal, &path);
+        uint64_t t3 = benchNow();
+
+        // both have to agree on reachability
+        if (hpa_found != grid_found) result = 0;
+        if (hpa_found && !benchPathValid(map, &path, start, goal)) result = 0;
+        hpa_expansions += path.expansions;
+
+        if (grid_found)
+        {
+            grid_cost += cost;
+            hpa_cost += path.cost;
+            found++;
+        }
+
+        grid_ns += t1 - t0;
+        hpa_ns += t3 - t2;
+    }
+
+    // block a whole cluster border column and check only its neighbours get rebuilt
+    uint32_t built = pathfinder.clusters_built;
+    uint32_t col = 8 * ISO_PATH_CLUSTER_SIZE - 1;
+    for (uint32_t row = 8 * ISO_PATH_CLUSTER_SIZE; row < 9 * ISO_PATH_CLUSTER_SIZE; row++)
+    {
+        isoMapSetTile(map, col, row, ISO_TILE_WATER);
+        isoPathfinderTileChanged(&pathfinder, col, row);
+    }
+
+    IsoPathPoint start = { col - 3, 8 * ISO_PATH_CLUSTER_SIZE + 8 };
+    IsoPathPoint goal = { col + 3, 8 * ISO_PATH_CLUSTER_SIZE + 8 };
+    isoMapSetTile(map, start.col, start.row, 1);
+    isoMapSetTile(map, goal.col, goal.row, 1);
+    isoPathfinderTileChanged(&pathfinder, start.col, start.row);
+    isoPathfinderTileChanged(&pathfinder, goal.col, goal.row);
+
+    int grid_found = isoPathFindGrid(&pathfinder, start, goal, &path);
+    if (isoPathFind(&pathfinder, start, goal, &path) != grid_found) result = 0;
+    if (grid_found && !benchPathValid(map, &path, start, goal)) result = 0;
+    uint32_t rebuilt = pathfinder.clusters_built - built;
+
+    printf("{\"bench\":\"isoPathFind\",\"map\":%u,\"paths\":%u,\"found\":%u,\"build_ms\":%.1f,"
+           "\"grid_us\":%.1f,\"grid_expansions\":%.0f,\"hpa_us\":%.1f,\"hpa_expansions\":%.0f,"
+           "\"cost_ratio\":%.3f,\"clusters_rebuilt\":%u}\n",
+           map->width, BENCH_PATHS, found, build_ns / 1e6,
+           grid_ns / 1e3 / BENCH_PATHS, (double)grid_expansions / BENCH_PATHS,
+           hpa_ns / 1e3 / BENCH_PATHS, (double)hpa_expansions / BENCH_PATHS,
+           grid_cost ? (double)hpa_cost / grid_cost : 1.0, rebuilt);
+    fflush(stdout);
+
+    isoPathFree(&path);
+    isoPathfinderDestroy(&pathfinder);
+
+    return result;
+}
+
+/* batched swept collision, cost per mover should not depend on the map size */
+#define BENCH_MOVERS 10000
+
+static int benchMoverOverlaps(const IsoMap* map, float x, float y, vec2 half)
+{
+    int32_t col_min = (int32_t)floorf((x - half.x) / map->tile_size);
+    int32_t col_max = (int32_t)ceilf((x + half.x) / map->tile_size) - 1;
+    int32_t row_min = (int32_t)floorf((y - half.y) / map->tile_size);
+    int32_t row_max = (int32_t)ceilf((y + half.y) / map->tile_size) - 1;
+
+    for (int32_t row = row_min; row <= row_max; row++)
+    {
+        for (int32_t col = col_min; col <= col_max; col++)
+        {
+            if (col < 0 || row < 0 || col >= (int32_t)map->width || row >= (int32_t)map->height) return 1;
+            if (!isoTileWalkable(isoMapGetTile(map, (uint32_t)col, (uint32_t)row))) return 1;
+        }
+    }
+    return 0;
+}
+
+static int benchCollision(const BenchConfig* config, const IsoMap* map)
+{
+    float* x = malloc(BENCH_MOVERS * sizeof(float));
+    float* y = malloc(BENCH_MOVERS * sizeof(float));
+    float* vx = malloc(BENCH_MOVERS * sizeof(float));
+    float* vy = malloc(BENCH_MOVERS * sizeof(float));
+    if (!x || !y || !vx || !vy) return 0;
+
+    uint32_t seed = 3;
+    vec2 half = { .2f * map->tile_size, .2f * map->tile_size };
+    float speed = 4.0f * map->tile_size; // tiles per second
+
+    for (uint32_t i = 0; i < BENCH_MOVERS; i++)
+    {
+        IsoPathPoint tile = benchRandomTile(map, &seed);
+        x[i] = (tile.col + .5f) * map->tile_size;
+        y[i] = (tile.row + .5f) * map->tile_size;
+        vx[i] = benchRandom(&seed) * speed;
+        vy[i] = benchRandom(&seed) * speed;
+    }
+
+    int result = 1;
+    uint32_t frames = 0;
+    uint64_t elapsed = 0;
+    uint32_t stopped = 0;
+
+    while (elapsed < config->min_time && frames < config->max_frames)
+    {
+        uint64_t start = benchNow();
+        isoMapSweepArray(map, x, y, vx, vy, half, 1.0f / 60.0f, BENCH_MOVERS);
+        elapsed += benchNow() - start;
+        frames++;
+
+        // blocked movers turn around so the crowd keeps bumping into things
+        for (uint32_t i = 0; i < BENCH_MOVERS; i++)
+        {
+            if (vx[i] == 0.0f) { vx[i] = benchRandom(&seed) * speed; stopped++; }
+            if (vy[i] == 0.0f) { vy[i] = benchRandom(&seed) * speed; stopped++; }
+        }
+    }
+
+    for (uint32_t i = 0; i < BENCH_MOVERS; i++)
+    {
+        if (benchMoverOverlaps(map, x[i], y[i], half)) result = 0;
+    }
+
+    printf("{\"bench\":\"isoMapSweepArray\",\"map\":%u,\"movers\":%u,\"frames\":%u,\"ns_per_mover\":%.2f,\"blocked_per_frame\":%.1f}\n",
+           map->width, BENCH_MOVERS, frames, (double)elapsed / ((double)frames * BENCH_MOVERS), (double)stopped / frames);
+    fflush(stdout);
+
+    free(x);
+    free(y);
+    free(vx);
+    free(vy);
+
+    return result;
+}
+
+/* map files, open cost should only depend on the chunk directory */
+#define BENCH_MAP_FILE "isobench.isom"
+
+static int benchMapsEqual(const IsoMap* a, const IsoMap* b)
+{
+    if (a->width != b->width || a->height != b->height || a->tile_size != b->tile_size) return 0;
+    if (a->max_elevation != b->max_elevation) return 0;
+
+    for (uint32_t row = 0; row < a->height; row++)
+    {
+        for (uint32_t col = 0; col < a->width; col++)
+        {
+            if (isoMapGetTile(a, col, row) != isoMapGetTile(b, col, row)) return 0;
+            if (isoMapGetElevation(a, col, row) != isoMapGetElevation(b, col, row)) return 0;
+        }
+    }
+    return 1;
+}
+
+static int benchMapFile(const IsoMap* map)
+{
+    uint64_t start = benchNow();
+    if (!isoMapSave(map, BENCH_MAP_FILE)) return 0;
+    uint64_t save = benchNow() - start;
+
+    IsoMap loaded;
+    uint64_t open = UINT64_MAX;
+    for (int i = 0; i < 5; i++)
+    {
+        start = benchNow();
+        if (!isoMapOpen(&loaded, BENCH_MAP_FILE)) return 0;
+        uint64_t elapsed = benchNow() - start;
+        if (elapsed < open) open = elapsed;
+
+        if (i < 4) isoMapDestroy(&loaded);
+    }
+
+    // the first pass over all tiles faults every chunk in
+    start = benchNow();
+    int result = benchMapsEqual(map, &loaded);
+    uint64_t first_read = benchNow() - start;
+
+    // edits stay in memory, the file is unchanged
+    uint32_t col = map->width / 2, row = map->height / 2;
+    uint32_t tile = isoMapGetTile(map, col, row);
+    if (!isoMapSetTile(&loaded, col, row, tile == 1 ? 2 : 1)) result = 0;
+    isoMapDestroy(&loaded);
+
+    if (!isoMapOpen(&loaded, BENCH_MAP_FILE)) result = 0;
+    else
+    {
+        if (isoMapGetTile(&loaded, col, row) != tile) result = 0;
+
+        // saving over the file the chunks are mapped from must not truncate it under them
+        if (!isoMapSave(&loaded, BENCH_MAP_FILE)) result = 0;
+        isoMapDestroy(&loaded);
+
+        FILE* temp = fopen(BENCH_MAP_FILE ".tmp", "rb");
+        if (temp)
+        {
+            fclose(temp);
+            result = 0;
+        }
+    }
+
+    if (!isoMapOpen(&loaded, BENCH_MAP_FILE)) result = 0;
+    else
+    {
+        if (!benchMapsEqual(map, &loaded)) result = 0;
+        isoMapDestroy(&loaded);
+    }
+
+    // an elevation bound no tile can have is a broken header like any other
+    FILE* file = fopen(BENCH_MAP_FILE, "r+b");
+    uint32_t max_elevation = ISO_TILE_MAX_ELEVATION + 1;
+    if (!file || fseek(file, (long)offsetof(IsoMapFileHeader, max_elevation), SEEK_SET) != 0
+        || fwrite(&max_elevation, sizeof(max_elevation), 1, file) != 1)
+        result = 0;
+    if (file && fclose(file) != 0) result = 0;
+
+    if (isoMapOpen(&loaded, BENCH_MAP_FILE))
+    {
+        isoMapDestroy(&loaded);
+        result = 0;
+    }
+
+    remove(BENCH_MAP_FILE);
+
+    printf("{\"bench\":\"isoMapOpen\",\"map\":%u,\"chunks\":%u,\"save_ms\":%.2f,\"open_us\":%.1f,\"first_read_ms\":%.2f}\n",
+           map->width, map->chunk_cols * map->chunk_rows, save / 1e6, open / 1e3, first_read / 1e6);
+    fflush(stdout);
+
+    return result;
+}
+
+/* hills on top of the generated map, culled against drawing every level */
+#define BENCH_HILL_SIZE   256
+#define BENCH_HILL_HEIGHT 24
+
+static int benchGenerateHills(IsoMap* map)
+{
+    if (!benchGenerateMap(map, BENCH_HILL_SIZE)) return 0;
+
+    for (uint32_t row = 0; row < map->height; row++)
+    {
+        for (uint32_t col = 0; col < map->width; col++)
+        {
+            if (isoMapGetTile(map, col, row) == 3) continue;
+
+            float height = 12.0f + 8.0f * sinf(col * .15f) * cosf(row * .11f) + 6.0f * sinf((col + row) * .05f);
+            int32_t elevation = (int32_t)height + (int32_t)(benchHash(col, row) & 1);
+            if (elevation < 0) elevation = 0;
+            if (elevation > BENCH_HILL_HEIGHT) elevation = BENCH_HILL_HEIGHT;
+
+            if (!isoMapSetElevation(map, col, row, (uint32_t)elevation))
+                return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* every level of every visible tile, what renderMap drew before culling */
+static void benchFrameRenderUnculled(BenchScene* scene)
+{
+    const IsoMap* map = &scene->map;
+
+    IsoTileRange range;
+    if (isoMapGetVisibleRange(map, scene->view, &range))
+    {
+        for (uint32_t row = range.row_min; row <= range.row_max; row++)
+        {
+            uint32_t col_min, col_max;
+            if (!isoTileRangeRow(map, &range, row, &col_min, &col_max))
+                continue;
+
+            for (uint32_t col = col_min; col <= col_max; col++)
+            {
+                const IsoChunk* chunk = isoMapGetChunk(map, col, row);
+                uint32_t tile = isoChunkGet(chunk, col & ISO_CHUNK_MASK, row & ISO_CHUNK_MASK);
+                if (ISO_TILE_ID(tile) != ISO_TILE_EMPTY)
+                    renderTile(map, &scene->tiles, col, row, tile, 0);
+            }
+        }
+    }
+    ignisBatch2DFlush();
+}
+
+/*
+ * Paints the tile shapes of the recorded quads in order into owner (quad
+ * index + 1 per pixel) and returns the pixels written.
+ */
+static uint64_t benchRasterize(const IsoMap* map, const float* positions, uint32_t quads, uint32_t* owner)
+{
+    const int32_t width = (int32_t)BENCH_VIEW_WIDTH;
+    const int32_t height = (int32_t)BENCH_VIEW_HEIGHT;
+
+    float size = map->tile_size;
+    memset(owner, 0, (size_t)width * height * sizeof(uint32_t));
+
+    uint64_t written = 0;
+    for (uint32_t i = 0; i < quads; i++)
+    {
+        float x = positions[i * 2 + 0];
+        float y = positions[i * 2 + 1];
+
+        int32_t x0 = (int32_t)floorf(x), x1 = (int32_t)ceilf(x + 2.0f * size);
+        int32_t y0 = (int32_t)floorf(y), y1 = (int32_t)ceilf(y + size + map->tile_offset);
+        if (x0 < 0) x0 = 0;
+        if (y0 < 0) y0 = 0;
+        if (x1 > width) x1 = width;
+        if (y1 > height) y1 = height;
+
+        for (int32_t py = y0; py < y1; py++)
+        {
+            for (int32_t px = x0; px < x1; px++)
+            {
+                float lx = px + .5f - x;
+                float ly = py + .5f - y;
+                float edge = lx < size ? lx : 2.0f * size - lx;
+
+                if (edge < 0.0f || ly < (size - edge) * .5f || ly > (size + edge) * .5f + map->tile_offset)
+                    continue;
+
+                owner[py * width + px] = i + 1;
+                written++;
+            }
+        }
+    }
+    return written;
+}
+
+static uint32_t benchRecordQuads(BenchScene* scene, BenchFrameFn frame, float* positions, uint64_t max)
+{
+    benchRecorderReset();
+    bench_recorder.positions = positions;
+    bench_recorder.position_max = max;
+
+    frame(scene);
+
+    uint64_t quads = bench_recorder.quads;
+    benchRecorderReset();
+    return quads <= max ? (uint32_t)quads : 0;
+}
+
+static int benchElevation(const BenchConfig* config)
+{
+    BenchScene scene;
+    if (!benchGenerateHills(&scene.map)) return 0;
+    benchSetupScene(&scene);
+
+    benchRun(config, &scene, "renderMap_hills", benchFrameRender);
+    benchRun(config, &scene, "renderMap_hills_unculled", benchFrameRenderUnculled);
+
+    // the culled frame has to end up with the same pixels as drawing every level
+    const uint64_t max = 1u << 20;
+    size_t pixels = (size_t)BENCH_VIEW_WIDTH * (size_t)BENCH_VIEW_HEIGHT;
+
+    float* culled = malloc(max * 2 * sizeof(float));
+    float* unculled = malloc(max * 2 * sizeof(float));
+    uint32_t* owner_culled = malloc(pixels * sizeof(uint32_t));
+    uint32_t* owner_unculled = malloc(pixels * sizeof(uint32_t));
+
+    int result = culled && unculled && owner_culled && owner_unculled;
+    uint32_t quads_culled = 0, quads_unculled = 0;
+    uint64_t written_culled = 0, written_unculled = 0, covered = 0, mismatches = 0;
+
+    if (result)
+    {
+        quads_culled = benchRecordQuads(&scene, benchFrameRender, culled, max);
+        quads_unculled = benchRecordQuads(&scene, benchFrameRenderUnculled, unculled, max);
+        result = quads_culled && quads_unculled;
+    }
+
+    if (result)
+    {
+        written_culled = benchRasterize(&scene.map, culled, quads_culled, owner_culled);
+        written_unculled = benchRasterize(&scene.map, unculled, quads_unculled, owner_unculled);
+
+        for (size_t i = 0; i < pixels; i++)
+        {
+            uint32_t a = owner_culled[i], b = owner_unculled[i];
+            if (b) covered++;
+
+            if (!a || !b)
+            {
+                if (a != b) mismatches++;
+            }
+            else if (culled[(a - 1) * 2] != unculled[(b - 1) * 2] || culled[(a - 1) * 2 + 1] != unculled[(b - 1) * 2 + 1])
+            {
+                mismatches++;
+            }
+        }
+        if (mismatches) result = 0;
+
+        // the other paths cull the same levels
+        IsoTileBuilder builder;
+        if (!isoTileBuilderInit(&builder, NULL, 4)) result = 0;
+        else
+        {
+            if (!isoTileBuilderBuild(&builder, &scene.layers, scene.view) || builder.quads != quads_culled)
+                result = 0;
+            isoTileBuilderDestroy(&builder);
+        }
+
+        IsoEntityLayer empty;
+        isoEntityLayerInit(&empty, 1);
+        benchRecorderReset();
+        isoEntityLayerRender(&empty, &scene.map, &scene.layers, scene.view);
+        if (bench_recorder.quads != quads_culled) result = 0;
+        isoEntityLayerDestroy(&empty);
+
+        if (!benchMapFile(&scene.map)) result = 0;
+    }
+
+    printf("{\"bench\":\"elevation\",\"map\":%u,\"max_elevation\":%u,\"quads_culled\":%u,\"quads_unculled\":%u,"
+           "\"overdraw_culled\":%.2f,\"overdraw_unculled\":%.2f,\"mismatched_pixels\":%llu}\n",
+           scene.map.width, scene.map.max_elevation, quads_culled, quads_unculled,
+           covered ? (double)written_culled / covered : 0.0, covered ? (double)written_unculled / covered : 0.0,
+           (unsigned long long)mismatches);
+    fflush(stdout);
+
+    free(culled);
+    free(unculled);
+    free(owner_culled);
+    free(owner_unculled);
+
+    isoAtlasDestroy(&scene.tiles);
+    isoEntityLayerDestroy(&scene.entities);
+    isoMapDestroy(&scene.map);
+    return result;
+}
+
+/* picking on the hills against the owner of every pixel in draw order */
+static int benchPicking()
+{
+    BenchScene scene;
+    if (!benchGenerateHills(&scene.map)) return 0;
+    benchSetupScene(&scene);
+
+    const uint64_t max = 1u << 20;
+    size_t pixels = (size_t)BENCH_VIEW_WIDTH * (size_t)BENCH_VIEW_HEIGHT;
+
+    float* positions = malloc(max * 2 * sizeof(float));
+    uint32_t* owner = malloc(pixels * sizeof(uint32_t));
+    IsoPick* picks = malloc(pixels * sizeof(IsoPick));
+    vec2* points = malloc(pixels * sizeof(vec2));
+
+    IsoSpatialHash hash;
+    int result = positions && owner && picks && points && isoSpatialHashInit(&hash, &scene.map, 1, 256);
+    uint32_t quads = result ? benchRecordQuads(&scene, benchFrameRenderUnculled, positions, max) : 0;
+    if (!quads) result = 0;
+
+    uint64_t mismatches = 0, flat_mismatches = 0, sides = 0, entity_hits = 0, entity_mismatches = 0;
+    double ns_per_pick = 0.0, ns_per_rect = 0.0;
+    uint32_t rect_tiles = 0;
+
+    if (result)
+    {
+        benchRasterize(&scene.map, positions, quads, owner);
+
+        for (uint32_t py = 0; py < (uint32_t)BENCH_VIEW_HEIGHT; py++)
+        {
+            for (uint32_t px = 0; px < (uint32_t)BENCH_VIEW_WIDTH; px++)
+                points[py * (uint32_t)BENCH_VIEW_WIDTH + px] = (vec2){ px + .5f, py + .5f };
+        }
+
+        IsoPicker picker = { &scene.layers, NULL, NULL, { 0.0f, 0.0f } };
+        uint64_t start = benchNow();
+        isoPickPoints(&picker, points, (uint32_t)pixels, picks);
+        ns_per_pick = (double)(benchNow() - start) / pixels;
+
+        for (size_t i = 0; i < pixels; i++)
+        {
+            const IsoPick* pick = &picks[i];
+            if (!owner[i] || pick->col == ISO_PICK_NONE)
+            {
+                if (owner[i] || pick->col != ISO_PICK_NONE) mismatches++;
+                continue;
+            }
+
+            // the quad drawn last at the pixel is the level picked
+            vec2 pos = getTileScreenPos(&scene.map, pick->col, pick->row);
+            pos.y -= pick->level * scene.map.tile_offset;
+            const float* quad = positions + (owner[i] - 1) * 2;
+            if (fabsf(quad[0] - pos.x) > .01f || fabsf(quad[1] - pos.y) > .01f) mismatches++;
+            sides += pick->side;
+
+            // what the flat lookup gets wrong
+            vec2 world = screenToWorld(&scene.map, points[i]);
+            if ((uint32_t)floorf(world.x / scene.map.tile_size) != pick->col || (uint32_t)floorf(world.y / scene.map.tile_size) != pick->row)
+                flat_mismatches++;
+        }
+        if (mismatches) result = 0;
+
+        // the hash finds the same entities as testing all of them
+        for (uint32_t i = 0; i < scene.entities.count; i++)
+            isoSpatialHashInsert(&hash, i, scene.entities.entities[i].position);
+
+        IsoPicker linear = { &scene.layers, &scene.entities, NULL, { 32.0f, 64.0f } };
+        IsoPicker hashed = { &scene.layers, &scene.entities, &hash, { 32.0f, 64.0f } };
+        for (size_t i = 0; i < pixels; i += 7)
+        {
+            IsoPick a, b;
+            isoPickPoint(&linear, points[i], &a);
+            isoPickPoint(&hashed, points[i], &b);
+            if (a.entity != b.entity || a.col != b.col || a.row != b.row) entity_mismatches++;
+            if (b.entity != ISO_ENTITY_NONE) entity_hits++;
+        }
+        if (entity_mismatches || !entity_hits) result = 0;
+
+        // box selection of the middle of the screen
+        rect area = { { BENCH_VIEW_WIDTH * .25f, BENCH_VIEW_HEIGHT * .25f }, { BENCH_VIEW_WIDTH * .75f, BENCH_VIEW_HEIGHT * .75f } };
+        uint32_t rounds = 0;
+        start = benchNow();
+        for (; rounds < 20; rounds++)
+            rect_tiles = isoPickRectTiles(&hashed, area, picks, (uint32_t)pixels);
+        ns_per_rect = (double)(benchNow() - start) / rounds;
+
+        for (uint32_t i = 0; i < rect_tiles; i++)
+        {
+            vec2 pos = getTileScreenPos(&scene.map, picks[i].col, picks[i].row);
+            vec2 center = { pos.x + scene.map.tile_size, pos.y + scene.map.tile_size * .5f - picks[i].level * scene.map.tile_offset };
+            if (center.x < area.min.x || center.x > area.max.x || center.y < area.min.y || center.y > area.max.y) result = 0;
+        }
+        if (!rect_tiles) result = 0;
+    }
+
+    printf("{\"bench\":\"picking\",\"map\":%u,\"max_elevation\":%u,\"pixels\":%llu,\"mismatched_pixels\":%llu,"
+           "\"flat_mismatched_pixels\":%llu,\"side_pixels\":%llu,\"ns_per_pick\":%.1f,\"entity_hits\":%llu,"
+           "\"entity_mismatches\":%llu,\"rect_tiles\":%u,\"us_per_rect\":%.1f}\n",
+           scene.map.width, scene.map.max_elevation, (unsigned long long)pixels, (unsigned long long)mismatches,
+           (unsigned long long)flat_mismatches, (unsigned long long)sides, ns_per_pick, (unsigned long long)entity_hits,
+           (unsigned long long)entity_mismatches, rect_tiles, ns_per_rect / 1e3);
+    fflush(stdout);
+
+    isoSpatialHashDestroy(&hash);
+    free(positions);
+    free(owner);
+    free(picks);
+    free(points);
+
+    isoAtlasDestroy(&scene.tiles);
+    isoEntityLayerDestroy(&scene.entities);
+    isoMapDestroy(&scene.map);
+    return result;
+}
+
+/* static decoration layers under one dynamic overlay */
+#define BENCH_LAYER_SIZE  256
+#define BENCH_LAYER_PATH  64  /* overlay tiles changed every frame */
+
+static void benchFrameLayersDynamic(BenchScene* scene)
+{
+    renderLayers(&scene->layers, scene->view, ISO_LAYER_DYNAMIC);
+    ignisBatch2DFlush();
+}
+
+static void benchFrameLayersAll(BenchScene* scene)
+{
+    renderLayers(&scene->layers, scene->view, ISO_LAYER_ALL);
+    ignisBatch2DFlush();
+}
+
+/* a sparse layer, some of its tiles one level high */
+static int benchGenerateLayer(IsoMap* layer, const IsoMap* map, uint32_t seed)
+{
+    if (!isoMapInit(layer, NULL, map->width, map->height, map->tile_size, map->tile_offset))
+        return 0;
+
+    for (uint32_t row = 0; row < map->height; row++)
+    {
+        for (uint32_t col = 0; col < map->width; col++)
+        {
+            uint32_t h = benchHash(col + seed * 7919, row);
+            if (h & 7) continue;
+
+            if (!isoMapSetTile(layer, col, row, 2) || !isoMapSetElevation(layer, col, row, (h >> 3) & 1))
+                return 0;
+        }
+    }
+    return 1;
+}
+
+/* quads and chunk versions of a stack, the static build plus the dynamic pass have to add up to all layers */
+static int benchLayerCheck(BenchScene* scene, IsoTileBuilder* builder, uint32_t* dynamic_quads)
+{
+    if (!isoTileBuilderBuild(builder, &scene->layers, scene->view))
+        return 0;
+
+    benchRecorderReset();
+    benchFrameLayersDynamic(scene);
+    *dynamic_quads = (uint32_t)bench_recorder.quads;
+
+    benchRecorderReset();
+    benchFrameLayersAll(scene);
+    uint64_t all = bench_recorder.quads;
+
+    IsoEntityLayer empty;
+    isoEntityLayerInit(&empty, 1);
+    benchRecorderReset();
+    isoEntityLayerRender(&empty, &scene->map, &scene->layers, scene->view);
+    uint64_t sorted = bench_recorder.quads;
+    isoEntityLayerDestroy(&empty);
+
+    benchRecorderReset();
+    return all == builder->quads + *dynamic_quads && sorted == all;
+}
+
+static int benchLayers(const BenchConfig* config)
+{
+    const uint32_t counts[] = { 1, 2, 4 };
+
+    BenchScene scene;
+    if (!benchGenerateMap(&scene.map, BENCH_LAYER_SIZE)) return 0;
+    benchSetupScene(&scene);
+
+    IsoMap layers[4];
+    IsoMap overlay;
+    uint32_t generated = 0;
+    int result = isoMapInit(&overlay, NULL, BENCH_LAYER_SIZE, BENCH_LAYER_SIZE, BENCH_TILE_SIZE, BENCH_TILE_OFFSET);
+
+    IsoTileBuilder builder;
+    if (!isoTileBuilderInit(&builder, NULL, 4)) result = 0;
+
+    // a diagonal path through the middle of the view as the overlay
+    uint32_t center = BENCH_LAYER_SIZE / 2;
+    for (uint32_t i = 0; i < BENCH_LAYER_PATH && result; i++)
+        isoMapSetTile(&overlay, center - BENCH_LAYER_PATH / 2 + i, center, 3);
+
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]) && result; c++)
+    {
+        isoLayerStackInit(&scene.layers, &scene.map, &scene.tiles);
+        for (uint32_t i = 0; i < counts[c] && result; i++)
+        {
+            if (i == generated && !benchGenerateLayer(&layers[generated++], &scene.map, i)) result = 0;
+            else if (!isoLayerStackPush(&scene.layers, "decoration", &layers[i], &scene.tiles, ISO_LAYER_STATIC)) result = 0;
+        }
+        if (!result || !isoLayerStackPush(&scene.layers, "overlay", &overlay, &scene.tiles, ISO_LAYER_DYNAMIC))
+        {
+            result = 0;
+            break;
+        }
+
+        uint32_t dynamic_quads = 0;
+        if (!benchLayerCheck(&scene, &builder, &dynamic_quads)) result = 0;
+        uint32_t static_quads = builder.quads;
+
+        // editing the overlay must leave the cached static chunks alone, editing a static layer must not
+        uint32_t chunk = (center >> ISO_CHUNK_SHIFT) * scene.map.chunk_cols + (center >> ISO_CHUNK_SHIFT);
+        uint32_t version = isoLayerStackChunkVersion(&scene.layers, chunk);
+
+        isoMapSetTile(&overlay, center, center, 1);
+        if (isoLayerStackChunkVersion(&scene.layers, chunk) != version) result = 0;
+        isoMapSetTile(&overlay, center, center, 3);
+
+        uint32_t tile = isoMapGetTile(&layers[0], center, center);
+        isoMapSetTile(&layers[0], center, center, tile == 2 ? 1 : 2);
+        if (isoLayerStackChunkVersion(&scene.layers, chunk) == version) result = 0;
+        isoMapSetTile(&layers[0], center, center, tile);
+
+        uint64_t start = benchNow();
+        uint32_t builds = 0;
+        while (benchNow() - start < config->min_time / 4 && builds < config->max_frames)
+        {
+            isoTileBuilderBuild(&builder, &scene.layers, scene.view);
+            builds++;
+        }
+        double ns_per_build = builds ? (double)(benchNow() - start) / builds : 0.0;
+
+        char name[64];
+        snprintf(name, sizeof(name), "renderLayers_dynamic_%u", counts[c]);
+        benchRun(config, &scene, name, benchFrameLayersDynamic);
+        snprintf(name, sizeof(name), "renderLayers_all_%u", counts[c]);
+        benchRun(config, &scene, name, benchFrameLayersAll);
+
+        printf("{\"bench\":\"layers\",\"map\":%u,\"static_layers\":%u,\"static_quads\":%u,\"dynamic_quads\":%u,"
+               "\"ns_per_static_build\":%.1f}\n",
+               scene.map.width, counts[c], static_quads, dynamic_quads, ns_per_build);
+        fflush(stdout);
+    }
+
+    isoTileBuilderDestroy(&builder);
+    for (uint32_t i = 0; i < generated; i++)
+        isoMapDestroy(&layers[i]);
+    isoMapDestroy(&overlay);
+
+    isoAtlasDestroy(&scene.tiles);
+    isoEntityLayerDestroy(&scene.entities);
+    isoMapDestroy(&scene.map);
+    return result;
+}
+
+/* water cycling through two frames, resolved per frame in the batch path and per vertex for cached quads */
+#define BENCH_ANIMATION_SIZE 256
+
+static double bench_animation_time = 0.0;
+
+static void benchFrameAnimated(BenchScene* scene)
+{
+    bench_animation_time += 1.0 / 60.0;
+    isoAtlasAnimate(&scene->tiles, bench_animation_time);
+    benchFrameRender(scene);
+}
+
+/* what res/shaders/batch.vert does with the uvs of a vertex */
+static void benchShadeVertex(const IsoAtlas* atlas, const IsoVertex* vertex, uint32_t corner, float* u, float* v)
+{
+    uint32_t index = (uint32_t)(vertex->texture + .5f);
+    uint32_t animation = index / ISO_TEXTURE_UNITS;
+
+    *u = vertex->u;
+    *v = vertex->v;
+    if (!animation) return;
+
+    IgnisRect frame = atlas->frames[atlas->lookup[atlas->animations[animation - 1].tile]].src;
+    *u = frame.x + (corner == 1 || corner == 2) * frame.w;
+    *v = frame.y + (corner >= 2) * frame.h;
+}
+
+static int benchAnimation(const BenchConfig* config)
+{
+    BenchScene scene;
+    if (!benchGenerateMap(&scene.map, BENCH_ANIMATION_SIZE)) return 0;
+    benchSetupScene(&scene);
+
+    const char* names[] = { "empty", "grass", "sand", "water", "placeholder" };
+    for (uint32_t i = 0; i < scene.tiles.frame_count && i < 5; i++)
+        strcpy(scene.tiles.frames[i].name, names[i]);
+
+    benchRun(config, &scene, "renderMap_static", benchFrameRender);
+
+    const char* water[] = { "water", "placeholder" };
+    int result = isoAtlasAddAnimation(&scene.tiles, 3, water, 2, .5f);
+
+    uint32_t versions = 0;
+    for (uint32_t i = 0; i < scene.map.chunk_cols * scene.map.chunk_rows; i++)
+        versions += scene.map.chunks[i].version;
+
+    // geometry built at time 0 has to shade like a fresh build at any later time
+    IsoTileBuilder cached, fresh;
+    if (!isoTileBuilderInit(&cached, NULL, 1) || !isoTileBuilderInit(&fresh, NULL, 1)) return 0;
+
+    isoAtlasAnimate(&scene.tiles, 0.0);
+    if (!isoTileBuilderBuild(&cached, &scene.layers, scene.full_view)) result = 0;
+
+    uint32_t animated = 0, mismatches = 0;
+    for (uint32_t step = 1; step <= 4 && result; step++)
+    {
+        isoAtlasAnimate(&scene.tiles, step * .5);
+        if (!isoTileBuilderBuild(&fresh, &scene.layers, scene.full_view) || fresh.quads != cached.quads)
+        {
+            result = 0;
+            break;
+        }
+
+        for (uint32_t i = 0; i < cached.quads * ISO_QUAD_VERTICES; i++)
+        {
+            float u, v;
+            benchShadeVertex(&scene.tiles, &cached.vertices[i], i % ISO_QUAD_VERTICES, &u, &v);
+            if (u != fresh.vertices[i].u || v != fresh.vertices[i].v) mismatches++;
+            if (step == 1 && cached.vertices[i].texture != 0.0f) animated++;
+        }
+    }
+    if (mismatches || !animated) result = 0;
+
+    // the batch path sees the frame change
+    isoAtlasAnimate(&scene.tiles, 0.0);
+    benchRecorderReset();
+    benchFrameRenderFull(&scene);
+    double checksum = bench_recorder.checksum;
+
+    isoAtlasAnimate(&scene.tiles, .5);
+    benchRecorderReset();
+    benchFrameRenderFull(&scene);
+    if (bench_recorder.checksum == checksum) result = 0;
+    benchRecorderReset();
+
+    benchRun(config, &scene, "renderMap_animated", benchFrameAnimated);
+
+    // animating never touched the tiles
+    for (uint32_t i = 0; i < scene.map.chunk_cols * scene.map.chunk_rows; i++)
+        versions -= scene.map.chunks[i].version;
+    if (versions) result = 0;
+
+    uint64_t start = benchNow();
+    uint32_t calls = 0;
+    for (; calls < 100000; calls++)
+        isoAtlasAnimate(&scene.tiles, calls * .01);
+    double ns_per_animate = (double)(benchNow() - start) / calls;
+
+    printf("{\"bench\":\"animation\",\"map\":%u,\"animations\":%u,\"animated_vertices\":%u,\"mismatched_vertices\":%u,"
+           "\"ns_per_animate\":%.1f}\n",
+           scene.map.width, scene.tiles.animation_count, animated, mismatches, ns_per_animate);
+    fflush(stdout);
+
+    isoTileBuilderDestroy(&cached);
+    isoTileBuilderDestroy(&fresh);
+    isoAtlasDestroy(&scene.tiles);
+    isoEntityLayerDestroy(&scene.entities);
+    isoMapDestroy(&scene.map);
+    return result;
+}
+
+/* zoomed out views drawn from impostors */
+#define BENCH_IMPOSTOR_SIZE  2048
+#define BENCH_IMPOSTOR_SLOTS 256
+
+/* frame f is a diamond with sides in a color of its own */
+static int benchImpostorPixels(IsoAtlas* atlas)
+{
+    uint32_t w = (uint32_t)atlas->texture.width, h = (uint32_t)atlas->texture.height;
+    atlas->pixels = isoCalloc(ISO_MEM_RENDER, (size_t)w * h, 4);
+    if (!atlas->pixels) return 0;
+
+    for (uint32_t f = 0; f < atlas->frame_count; f++)
+    {
+        const IsoAtlasFrame* frame = &atlas->frames[f];
+        float half_w = frame->w * .5f, half_h = half_w * .5f;
+
+        for (uint32_t y = 0; y < frame->h; y++)
+        {
+            for (uint32_t x = 0; x < frame->w; x++)
+            {
+                float edge = half_h * (1.0f - fabsf(x + .5f - half_w) / half_w);
+                if (y + .5f < half_h - edge || y + .5f > half_h + edge + (frame->h - 2.0f * half_h)) continue;
+
+                uint8_t* pixel = atlas->pixels + ((size_t)(frame->y + y) * w + frame->x + x) * 4;
+                pixel[0] = (uint8_t)(40 * f);
+                pixel[1] = (uint8_t)(200 - 30 * f);
+                pixel[2] = (uint8_t)(60 + 20 * f);
+                pixel[3] = 255;
+            }
+        }
+    }
+    return 1;
+}
+
+/* the top face center of a tile in the impostor of its block has the color of the tile */
+static int benchImpostorTile(const IsoImpostorCache* cache, const IsoMap* map, uint32_t slot, uint32_t level, uint32_t col, uint32_t row)
+{
+    float size = (float)(ISO_CHUNK_SIZE << level);
+    float dc = (float)(col % (ISO_CHUNK_SIZE << level));
+    float dr = (float)(row % (ISO_CHUNK_SIZE << level));
+    float scale = cache->scale / (float)(1u << level);
+
+    // relative to the left and bottom of the block
+    float x = (dc - dr + size) * map->tile_size * scale;
+    float y = ISO_IMPOSTOR_HEIGHT - ((2.0f * size - dc - dr - 1.0f) * map->tile_size * .5f + map->tile_offset) * scale;
+
+    const uint8_t* pixel = isoImpostorPixels(cache, slot) + ((size_t)y * ISO_IMPOSTOR_WIDTH + (size_t)x) * 4;
+
+    int id = (int)isoMapGetTile(map, col, row);
+    int expected[3] = { 40 * id, 200 - 30 * id, 60 + 20 * id };
+    for (uint32_t c = 0; c < 3; c++)
+    {
+        if (abs(pixel[c] - expected[c]) > 2) return 0;
+    }
+    return pixel[3] == 255;
+}
+
+static int benchImpostors(const BenchConfig* config)
+{
+    uint32_t size = config->max_size < BENCH_IMPOSTOR_SIZE ? config->max_size : BENCH_IMPOSTOR_SIZE;
+    if (size < 2 * ISO_CHUNK_SIZE) size = 2 * ISO_CHUNK_SIZE;
+
+    BenchScene scene;
+    if (!benchGenerateMap(&scene.map, size)) return 0;
+    benchSetupScene(&scene);
+
+    IsoImpostorCache cache;
+    int result = benchImpostorPixels(&scene.tiles) && isoImpostorCacheInit(&cache, &scene.layers, BENCH_IMPOSTOR_SLOTS);
+    if (!result)
+    {
+        isoAtlasDestroy(&scene.tiles);
+        isoEntityLayerDestroy(&scene.entities);
+        isoMapDestroy(&scene.map);
+        return 0;
+    }
+
+    // the whole map on a 1080p screen, small maps at least as far out as impostors start
+    float zoom = BENCH_VIEW_HEIGHT / (size * scene.map.tile_size + scene.map.tile_offset);
+    float far = ISO_IMPOSTOR_WIDTH / (4.0f * ISO_CHUNK_SIZE * scene.map.tile_size);
+    if (zoom > far) zoom = far;
+    uint32_t level = isoImpostorLevel(&cache, &scene.map, zoom);
+    if (level == ISO_IMPOSTOR_NONE || isoImpostorLevel(&cache, &scene.map, 1.0f) != ISO_IMPOSTOR_NONE) result = 0;
+    if (level == ISO_IMPOSTOR_NONE) level = cache.level_count - 1;
+
+    // the first update builds the whole pyramid
+    cache.budget = UINT32_MAX / 2;
+    uint64_t start = benchNow();
+    result &= isoImpostorCacheUpdate(&cache, &scene.layers, scene.full_view, level);
+    double ms_cold = (benchNow() - start) / 1e6;
+
+    uint32_t quads = cache.quads;
+    uint32_t rasterized = cache.rasterized;
+    if (!quads || quads > 4096 || rasterized != scene.map.chunk_cols * scene.map.chunk_rows) result = 0;
+
+    start = benchNow();
+    uint32_t updates = 0;
+    for (; updates < 1000; updates++)
+    {
+        result &= isoImpostorCacheUpdate(&cache, &scene.layers, scene.full_view, level);
+        if (cache.rebuilt) result = 0;
+    }
+    double us_warm = (benchNow() - start) / (1e3 * updates);
+
+    // a level 0 block in the middle of the screen
+    uint32_t col = size / 2 + 8, row = size / 2 + 8;
+    rect center = scene.view;
+    result &= isoImpostorCacheUpdate(&cache, &scene.layers, center, 0);
+    uint32_t center_quads = cache.quads;
+
+    int32_t slot = cache.lookup[0][(row >> ISO_CHUNK_SHIFT) * cache.blocks_x[0] + (col >> ISO_CHUNK_SHIFT)];
+    if (slot < 0 || !benchImpostorTile(&cache, &scene.map, (uint32_t)slot, 0, col, row)) result = 0;
+
+    // an edit rebuilds its chunk and nothing else
+    isoMapSetTile(&scene.map, col, row, isoMapGetTile(&scene.map, col, row) == 1 ? 2 : 1);
+    result &= isoImpostorCacheUpdate(&cache, &scene.layers, center, 0);
+    uint32_t edit_rebuilt = cache.rebuilt;
+    if (edit_rebuilt != 1 || cache.rasterized != 1 || cache.quads != center_quads) result = 0;
+    if (slot < 0 || !benchImpostorTile(&cache, &scene.map, (uint32_t)slot, 0, col, row)) result = 0;
+
+    result &= isoImpostorCacheUpdate(&cache, &scene.layers, center, 0);
+    if (cache.rebuilt) result = 0;
+
+    // the edit reaches level 1 through its children
+    result &= isoImpostorCacheUpdate(&cache, &scene.layers, center, 1);
+    slot = cache.lookup[1][(row >> (ISO_CHUNK_SHIFT + 1)) * cache.blocks_x[1] + (col >> (ISO_CHUNK_SHIFT + 1))];
+    if (slot < 0 || !benchImpostorTile(&cache, &scene.map, (uint32_t)slot, 1, col, row)) result = 0;
+
+    // rebuilding the stale top of the pyramid within the budget, stale images stay on screen meanwhile
+    isoMapSetTile(&scene.map, col + 1, row, 2);
+    cache.budget = 64;
+    uint32_t frames = 0, stale_quads = quads;
+    do
+    {
+        result &= isoImpostorCacheUpdate(&cache, &scene.layers, scene.full_view, level);
+        if (cache.rasterized > cache.budget + (1u << (2 * level))) result = 0;
+        if (cache.quads != stale_quads) result = 0;
+        frames++;
+    } while (cache.rebuilt && frames < 1000);
+
+    printf("{\"bench\":\"impostors\",\"map\":%u,\"tiles\":%llu,\"level\":%u,\"quads\":%u,\"ms_cold\":%.1f,\"us_warm\":%.1f,"
+           "\"center_quads\":%u,\"edit_rebuilt\":%u,\"edit_frames\":%u,\"texture_mb\":%.1f}\n",
+           size, (unsigned long long)size * size, level, quads, ms_cold, us_warm, center_quads, edit_rebuilt, frames,
+           cache.columns * ISO_IMPOSTOR_WIDTH * cache.rows * ISO_IMPOSTOR_HEIGHT * 4 / 1048576.0);
+    fflush(stdout);
+
+    isoImpostorCacheDestroy(&cache);
+    isoAtlasDestroy(&scene.tiles);
+    isoEntityLayerDestroy(&scene.entities);
+    isoMapDestroy(&scene.map);
+    return result;
+}
+
+/* streaming while walking across the map, updates must never wait for loads */
+#define BENCH_STREAM_RADIUS 3
+#define BENCH_STREAM_BUDGET (1u << 20)
+#define BENCH_STREAM_FRAMES 600
+
+static int benchStreamResidentValid(const IsoStreamer* streamer, const IsoMap* source)
+{
+    const IsoMap* map = streamer->map;
+    for (uint32_t i = 0; i < map->chunk_cols * map->chunk_rows; i++)
+    {
+        // skips edited chunks
+        if (streamer->state[i] != ISO_STREAM_RESIDENT || map->chunks[i].version != streamer->version[i]) continue;
+
+        uint32_t col0 = (i % map->chunk_cols) << ISO_CHUNK_SHIFT;
+        uint32_t row0 = (i / map->chunk_cols) << ISO_CHUNK_SHIFT;
+        for (uint32_t row = row0; row < row0 + ISO_CHUNK_SIZE; row++)
+        {
+            for (uint32_t col = col0; col < col0 + ISO_CHUNK_SIZE; col++)
+            {
+                if (isoMapGetTile(map, col, row) != isoMapGetTile(source, col, row)) return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static int benchStreaming(const IsoMap* source)
+{
+    if (!isoMapSave(source, BENCH_MAP_FILE)) return 0;
+
+    IsoMap map;
+    IsoStreamer streamer;
+    if (!isoStreamOpen(&streamer, &map, BENCH_MAP_FILE, BENCH_STREAM_RADIUS, BENCH_STREAM_BUDGET))
+    {
+        remove(BENCH_MAP_FILE);
+        return 0;
+    }
+
+    // diagonal walk at 5 chunks per second, 60 updates per second
+    float chunk_size = map.tile_size * ISO_CHUNK_SIZE;
+    vec2 velocity = { 4.0f * chunk_size, 3.0f * chunk_size };
+    vec2 focus = { chunk_size * 2.5f, chunk_size * 2.5f };
+    float extent = map.width * map.tile_size;
+
+    int result = 1;
+    uint64_t elapsed = 0, worst = 0;
+    uint64_t over_budget = 0;
+
+    // edits made while the chunk is still a placeholder have to survive its load
+    isoStreamUpdate(&streamer, focus, velocity);
+    uint32_t edit_col = (uint32_t)(focus.x / map.tile_size), edit_row = (uint32_t)(focus.y / map.tile_size);
+    uint32_t pending_tile = isoMapGetTile(source, edit_col + 1, edit_row) == 1 ? 2 : 1;
+    if (!isoMapSetTile(&map, edit_col + 1, edit_row, pending_tile) || !isoMapSetElevation(&map, edit_col + 2, edit_row, 3))
+        result = 0;
+
+    isoStreamFlush(&streamer);
+    if (isoMapGetTile(&map, edit_col + 1, edit_row) != pending_tile) result = 0;
+    if (isoMapGetTile(&map, edit_col + 2, edit_row) != isoMapGetTile(source, edit_col + 2, edit_row)) result = 0;
+    if (isoMapGetElevation(&map, edit_col + 2, edit_row) != 3) result = 0;
+    if (isoMapGetTile(&map, edit_col + 3, edit_row) != isoMapGetTile(source, edit_col + 3, edit_row)) result = 0;
+
+    // an edited chunk has to survive being left behind
+    uint32_t edit_tile = isoMapGetTile(&map, edit_col, edit_row) == 1 ? 2 : 1;
+    if (!isoMapSetTile(&map, edit_col, edit_row, edit_tile)) result = 0;
+
+    for (uint32_t frame = 0; frame < BENCH_STREAM_FRAMES; frame++)
+    {
+        focus = vec2_add(focus, vec2_mult(velocity, 1.0f / 60.0f));
+        if (focus.x < 0.0f || focus.x > extent) { velocity.x = -velocity.x; focus.x = fminf(fmaxf(focus.x, 0.0f), extent); }
+        if (focus.y < 0.0f || focus.y > extent) { velocity.y = -velocity.y; focus.y = fminf(fmaxf(focus.y, 0.0f), extent); }
+
+        uint64_t start = benchNow();
+        isoStreamUpdate(&streamer, focus, velocity);
+        uint64_t time = benchNow() - start;
+
+        elapsed += time;
+        if (time > worst) worst = time;
+        if (streamer.stats.resident_bytes > BENCH_STREAM_BUDGET) over_budget++;
+
+        // real frames also render, this leaves the worker some time
+        benchSleep(2);
+    }
+
+    isoStreamFlush(&streamer);
+    if (!benchStreamResidentValid(&streamer, source)) result = 0;
+    if (isoMapGetTile(&map, edit_col, edit_row) != edit_tile) result = 0;
+    if (isoMapGetTile(&map, edit_col + 1, edit_row) != pending_tile) result = 0;
+
+    const IsoStreamStats* stats = &streamer.stats;
+    printf("{\"bench\":\"isoStreamUpdate\",\"map\":%u,\"frames\":%u,\"avg_us\":%.2f,\"max_us\":%.2f,\"hit_rate\":%.3f,"
+           "\"loads\":%llu,\"evictions\":%llu,\"load_avg_ms\":%.3f,\"load_max_ms\":%.3f,\"resident_kb\":%llu,\"frames_over_budget\":%llu}\n",
+           map.width, BENCH_STREAM_FRAMES, elapsed / (1e3 * BENCH_STREAM_FRAMES), worst / 1e3,
+           (double)stats->hits / (double)(stats->hits + stats->misses),
+           (unsigned long long)stats->loads, (unsigned long long)stats->evictions,
+           stats->loads ? stats->latency_total / (1e6 * stats->loads) : 0.0, stats->latency_max / 1e6,
+           (unsigned long long)(stats->resident_bytes >> 10), (unsigned long long)over_budget);
+    fflush(stdout);
+
+    isoStreamClose(&streamer);
+    isoMapDestroy(&map);
+    remove(BENCH_MAP_FILE);
+
+    return result;
+}
+
+/* headless fixed ticks, two runs with the same seed have to end up equal */
+#define BENCH_SIM_TICKS  10000
+#define BENCH_SIM_AGENTS 1000
+
+static int benchSimRun(const IsoMap* map, uint64_t* elapsed, IsoSim* out)
+{
+    IsoSim sim;
+    if (!isoSimInit(&sim, map, 60.0f, BENCH_SIM_AGENTS, 7)) return 0;
+    sim.player.position = (vec2){ (map->width / 2 + .5f) * map->tile_size, (map->height / 2 + .5f) * map->tile_size };
+
+    IsoSimInput input = { { 1.0f, 1.0f } };
+
+    uint64_t start = benchNow();
+    for (uint32_t i = 0; i < BENCH_SIM_TICKS; i++)
+    {
+        // the player walks a square
+        if (i % 240 == 0) input.move = (vec2){ -input.move.y, input.move.x };
+        isoSimTick(&sim, &input);
+    }
+    *elapsed = benchNow() - start;
+
+    *out = sim;
+    return 1;
+}
+
+static int benchSim(const IsoMap* map)
+{
+    IsoSim a, b;
+    uint64_t elapsed_a, elapsed_b;
+    if (!benchSimRun(map, &elapsed_a, &a)) return 0;
+    if (!benchSimRun(map, &elapsed_b, &b))
+    {
+        isoSimDestroy(&a);
+        return 0;
+    }
+
+    int result = a.ticks == BENCH_SIM_TICKS
+        && a.player.position.x == b.player.position.x && a.player.position.y == b.player.position.y
+        && memcmp(a.x, b.x, BENCH_SIM_AGENTS * sizeof(float)) == 0
+        && memcmp(a.y, b.y, BENCH_SIM_AGENTS * sizeof(float)) == 0;
+
+    for (uint32_t i = 0; i < BENCH_SIM_AGENTS; i++)
+    {
+        if (benchMoverOverlaps(map, a.x[i], a.y[i], a.agent_extent)) result = 0;
+    }
+
+    uint64_t elapsed = elapsed_a < elapsed_b ? elapsed_a : elapsed_b;
+    printf("{\"bench\":\"isoSimTick\",\"map\":%u,\"agents\":%u,\"ticks\":%u,\"ns_per_tick\":%.1f,\"ticks_per_s\":%.0f,\"deterministic\":%d}\n",
+           map->width, BENCH_SIM_AGENTS, BENCH_SIM_TICKS, (double)elapsed / BENCH_SIM_TICKS,
+           BENCH_SIM_TICKS * 1e9 / (double)elapsed, result);
+    fflush(stdout);
+
+    isoSimDestroy(&a);
+    isoSimDestroy(&b);
+
+    return result;
+}
+
+/*
+ * Headless ticks over a streamed map, as iso --stream --headless runs them.
+ * The player walks fast enough to leave the budget behind, loads arrive once
+ * a simulated second and paths around the player have to match those of a
+ * fresh pathfinder, which only holds if it hears of every loaded and evicted
+ * chunk.
+ */
+#define BENCH_STREAM_SIM_TICKS  3600
+#define BENCH_STREAM_SIM_BUDGET (64u * ISO_CHUNK_TILES * sizeof(uint32_t))
+
+static int benchStreamSim(const IsoMap* source)
+{
+    if (!isoMapSave(source, BENCH_MAP_FILE)) return 0;
+
+    IsoMap map;
+    IsoStreamer streamer;
+    if (!isoStreamOpen(&streamer, &map, BENCH_MAP_FILE, BENCH_STREAM_RADIUS, BENCH_STREAM_SIM_BUDGET))
+    {
+        remove(BENCH_MAP_FILE);
+        return 0;
+    }
+
+    IsoSim sim;
+    IsoPathfinder pathfinder;
+    IsoPath path = { 0 };
+    int sim_ready = isoSimInit(&sim, &map, 60.0f, BENCH_SIM_AGENTS, 1);
+    int pathfinder_ready = isoPathfinderInit(&pathfinder, &map);
+    int result = sim_ready && pathfinder_ready;
+
+    uint32_t paths = 0, found = 0, changed = 0;
+    if (result)
+    {
+        float chunk_size = map.tile_size * ISO_CHUNK_SIZE;
+        sim.player.position = (vec2){ map.width * map.tile_size * .5f, map.height * map.tile_size * .5f };
+        sim.player_previous = sim.player.position;
+        sim.player.speed = 2.0f * chunk_size;
+
+        isoStreamUpdate(&streamer, sim.player.position, vec2_zero());
+        isoStreamFlush(&streamer);
+
+        IsoSimInput input = { { 1.0f, 1.0f } };
+        for (uint32_t i = 0; i < BENCH_STREAM_SIM_TICKS && result; i++)
+        {
+            // the player walks a square of 20 chunks
+            if (i % 600 == 0) input.move = (vec2){ -input.move.y, input.move.x };
+            isoSimTick(&sim, &input);
+
+            vec2 velocity = vec2_mult(vec2_sub(sim.player.position, sim.player_previous), 1.0f / sim.step);
+            isoStreamUpdate(&streamer, sim.player.position, velocity);
+            if (i % 60 == 59) isoStreamFlush(&streamer);
+
+            for (uint32_t c = 0; c < streamer.changed_count; c++)
+                isoPathfinderChunkChanged(&pathfinder, streamer.changed[c]);
+            changed += streamer.changed_count;
+
+            if (i % 30 != 29) continue;
+
+            // clusters built from the tiles as they are now have to give the same paths
+            IsoPathfinder fresh;
+            if (!isoPathfinderInit(&fresh, &map))
+            {
+                result = 0;
+                break;
+            }
+
+            // towards the edge of the resident chunks, where clusters border placeholders that arrive later
+            IsoPathPoint start = { (uint32_t)(sim.player.position.x / map.tile_size), (uint32_t)(sim.player.position.y / map.tile_size) };
+            const int32_t directions[8][2] = { { -1, -1 }, { 0, -1 }, { 1, -1 }, { -1, 0 }, { 1, 0 }, { -1, 1 }, { 0, 1 }, { 1, 1 } };
+            int32_t reach = BENCH_STREAM_RADIUS * ISO_CHUNK_SIZE;
+            for (uint32_t d = 0; d < 8; d++)
+            {
+                int32_t goal_col = (int32_t)start.col + directions[d][0] * reach;
+                int32_t goal_row = (int32_t)start.row + directions[d][1] * reach;
+                if (goal_col < 0 || goal_row < 0 || goal_col >= (int32_t)map.width || goal_row >= (int32_t)map.height) continue;
+
+                IsoPathPoint goal = { (uint32_t)goal_col, (uint32_t)goal_row };
+                int fresh_found = isoPathFind(&fresh, start, goal, &path);
+                uint32_t cost = path.cost;
+
+                if (isoPathFind(&pathfinder, start, goal, &path) != fresh_found) result = 0;
+                if (fresh_found && (!benchPathValid(&map, &path, start, goal) || path.cost != cost)) result = 0;
+
+                paths++;
+                found += fresh_found;
+            }
+            isoPathfinderDestroy(&fresh);
+        }
+
+        isoStreamFlush(&streamer);
+        if (!benchStreamResidentValid(&streamer, source)) result = 0;
+
+        // the walk has to have loaded and evicted chunks for this to mean anything
+        if (!streamer.stats.loads || !streamer.stats.evictions) result = 0;
+    }
+
+    printf("{\"bench\":\"streamSim\",\"map\":%u,\"agents\":%u,\"ticks\":%u,\"loads\":%llu,\"evictions\":%llu,"
+           "\"chunks_changed\":%u,\"paths\":%u,\"found\":%u,\"ok\":%d}\n",
+           map.width, BENCH_SIM_AGENTS, BENCH_STREAM_SIM_TICKS,
+           (unsigned long long)streamer.stats.loads, (unsigned long long)streamer.stats.evictions,
+           changed, paths, found, result);
+    fflush(stdout);
+
+    isoPathFree(&path);
+    if (pathfinder_ready) isoPathfinderDestroy(&pathfinder);
+    if (sim_ready) isoSimDestroy(&sim);
+    isoStreamClose(&streamer);
+    isoMapDestroy(&map);
+    remove(BENCH_MAP_FILE);
+
+    return result;
+}
+
+/* the software backend against the analytic tile shapes, across thread counts and at thumbnail sizes */
+#define BENCH_RASTER_SIZE 4096
+#define BENCH_RASTER_FILE "isobench.png"
+
+static void benchRasterFrame(BenchScene* scene, IsoRaster* raster, rect view)
+{
+    isoRasterBegin(raster, view, IGNIS_BLACK);
+    isoRenderSetBackend(isoRasterBackend(raster));
+    renderMap(&scene->map, &scene->tiles, view);
+    isoRenderFlush();
+    isoRenderSetBackend(NULL);
+}
+
+static int benchRaster(const BenchConfig* config)
+{
+    BenchScene scene;
+    if (!benchGenerateHills(&scene.map)) return 0;
+    benchSetupScene(&scene);
+
+    IsoJobPool pool;
+    IsoRaster raster;
+    int result = benchImpostorPixels(&scene.tiles) && isoJobPoolInit(&pool, 0);
+    if (result && !isoRasterInit(&raster, &pool, (uint32_t)BENCH_VIEW_WIDTH, (uint32_t)BENCH_VIEW_HEIGHT))
+    {
+        isoJobPoolDestroy(&pool);
+        result = 0;
+    }
+    if (!result)
+    {
+        isoAtlasDestroy(&scene.tiles);
+        isoEntityLayerDestroy(&scene.entities);
+        isoMapDestroy(&scene.map);
+        return 0;
+    }
+    isoRasterAddTexture(&raster, &scene.tiles.texture, scene.tiles.pixels);
+
+    // every pixel has the color of the tile picked under it, which matches the analytic shapes
+    benchRasterFrame(&scene, &raster, scene.view);
+
+    uint64_t mismatches = 0;
+    IsoPicker picker = { &scene.layers, NULL, NULL, { 0.0f, 0.0f } };
+    for (uint32_t y = 0; y < raster.height; y++)
+    {
+        for (uint32_t x = 0; x < raster.width; x++)
+        {
+            IsoPick pick;
+            isoPickPoint(&picker, (vec2){ x + .5f, y + .5f }, &pick);
+
+            int expected[4] = { 0, 0, 0, 255 };
+            if (pick.col != ISO_PICK_NONE)
+            {
+                int id = (int)isoMapGetTile(&scene.map, pick.col, pick.row);
+                expected[0] = 40 * id;
+                expected[1] = 200 - 30 * id;
+                expected[2] = 60 + 20 * id;
+            }
+
+            const uint8_t* pixel = raster.pixels + ((size_t)y * raster.width + x) * 4;
+            if (pixel[0] != expected[0] || pixel[1] != expected[1] || pixel[2] != expected[2] || pixel[3] != expected[3])
+                mismatches++;
+        }
+    }
+    if (mismatches || raster.missing) result = 0;
+
+    // primitives go over the tiles
+    isoRenderSetBackend(isoRasterBackend(&raster));
+    isoRenderFillCircle(BENCH_VIEW_WIDTH * .5f, BENCH_VIEW_HEIGHT * .5f, 3, IGNIS_RED);
+    isoRenderFlush();
+    isoRenderSetBackend(NULL);
+
+    const uint8_t* dot = raster.pixels + ((size_t)(raster.height / 2) * raster.width + raster.width / 2) * 4;
+    if (dot[0] != 255 || dot[1] != 0 || dot[2] != 0) result = 0;
+
+    isoRasterDestroy(&raster);
+    isoJobPoolDestroy(&pool);
+
+    // a 4096 squared window and the whole map shrunk to a 4096 wide thumbnail
+    vec2 center = { BENCH_VIEW_WIDTH * .5f, BENCH_VIEW_HEIGHT * .5f };
+    rect window = { { center.x - BENCH_RASTER_SIZE * .5f, center.y - BENCH_RASTER_SIZE * .5f },
+                    { center.x + BENCH_RASTER_SIZE * .5f, center.y + BENCH_RASTER_SIZE * .5f } };
+
+    float aspect = (scene.full_view.max.y - scene.full_view.min.y) / (scene.full_view.max.x - scene.full_view.min.x);
+    const struct { const char* name; rect view; uint32_t width; uint32_t height; } images[] = {
+        { "window", window, BENCH_RASTER_SIZE, BENCH_RASTER_SIZE },
+        { "thumbnail", scene.full_view, BENCH_RASTER_SIZE, (uint32_t)(BENCH_RASTER_SIZE * aspect) }
+    };
+
+    uint32_t max_threads = isoCpuCount() < 4 ? 4 : isoCpuCount();
+    for (uint32_t i = 0; i < 2 && result; i++)
+    {
+        uint8_t* reference = NULL;
+        size_t bytes = (size_t)images[i].width * images[i].height * 4;
+
+        for (uint32_t threads = 1; threads <= max_threads && result; threads *= 2)
+        {
+            if (!isoJobPoolInit(&pool, threads - 1)) return 0;
+            if (!isoRasterInit(&raster, &pool, images[i].width, images[i].height))
+            {
+                isoJobPoolDestroy(&pool);
+                return 0;
+            }
+            isoRasterAddTexture(&raster, &scene.tiles.texture, scene.tiles.pixels);
+
+            uint32_t frames = 0;
+            uint64_t start = benchNow();
+            uint64_t elapsed = 0;
+            while ((elapsed < config->min_time / 4 || frames < 2) && frames < config->max_frames)
+            {
+                benchRasterFrame(&scene, &raster, images[i].view);
+                frames++;
+                elapsed = benchNow() - start;
+            }
+
+            printf("{\"bench\":\"isoRaster\",\"image\":\"%s\",\"width\":%u,\"height\":%u,\"threads\":%u,\"frames\":%u,"
+                   "\"ms_per_image\":%.2f,\"quads\":%u,\"flushes\":%u}\n",
+                   images[i].name, raster.width, raster.height, threads, frames, elapsed / 1e6 / frames, raster.quads, raster.flushes);
+            fflush(stdout);
+
+            // bins make the image independent of the thread count
+            if (!reference)
+            {
+                reference = malloc(bytes);
+                if (reference) memcpy(reference, raster.pixels, bytes);
+                else result = 0;
+            }
+            else if (memcmp(reference, raster.pixels, bytes) != 0)
+            {
+                result = 0;
+            }
+
+            if (threads == 1 && i == 1)
+            {
+                uint64_t write_start = benchNow();
+                int written = isoImageWrite(BENCH_RASTER_FILE, raster.pixels, raster.width, raster.height);
+                uint64_t write_ns = benchNow() - write_start;
+
+                FILE* file = written ? fopen(BENCH_RASTER_FILE, "rb") : NULL;
+                long size = 0;
+                if (file && fseek(file, 0, SEEK_END) == 0) size = ftell(file);
+                if (file) fclose(file);
+                remove(BENCH_RASTER_FILE);
+
+                printf("{\"bench\":\"isoImageWritePNG\",\"width\":%u,\"height\":%u,\"ms\":%.1f,\"bytes\":%ld,\"ratio\":%.3f}\n",
+                       raster.width, raster.height, write_ns / 1e6, size, (double)size / bytes);
+                fflush(stdout);
+                if (size <= 0) result = 0;
+            }
+
+            isoRasterDestroy(&raster);
+            isoJobPoolDestroy(&pool);
+        }
+        free(reference);
+    }
+
+    printf("{\"bench\":\"raster\",\"map\":%u,\"mismatched_pixels\":%llu}\n", scene.map.width, (unsigned long long)mismatches);
+    fflush(stdout);
+
+    isoAtlasDestroy(&scene.tiles);
+    isoEntityLayerDestroy(&scene.entities);
+    isoMapDestroy(&scene.map);
+    return result;
+}
+
+/* the sorted queue draws the same image as submission order with fewer draws, through the raster and the Ignis stub */
+#define BENCH_QUEUE_LAYERS 2 /* decoration layers, the last with its own atlas */
+
+static void benchQueueFrame(BenchScene* scene)
+{
+    isoEntityLayerRender(&scene->entities, &scene->map, &scene->layers, scene->view);
+
+    isoRenderSetOrder(ISO_RENDER_LAYER_OVERLAY, 0);
+    vec2 center = { BENCH_VIEW_WIDTH * .5f, BENCH_VIEW_HEIGHT * .5f };
+    highlightTile(&scene->map, screenToWorld(&scene->map, center));
+    for (uint32_t i = 0; i < scene->entities.count; i++)
+    {
+        vec2 foot = worldToScreen(&scene->map, scene->entities.entities[i].position);
+        isoRenderFillCircle(foot.x, foot.y, 4, IGNIS_RED);
+    }
+
+    isoRenderSetOrder(ISO_RENDER_LAYER_UI, 0);
+    isoRenderText(8.0f, 8.0f, "isobench");
+}
+
+static void benchQueueRaster(BenchScene* scene, IsoRaster* raster, IsoRenderQueue* queue)
+{
+    isoRasterBegin(raster, scene->view, IGNIS_BLACK);
+    isoRenderSetBackend(queue ? isoRenderQueueBackend(queue) : isoRasterBackend(raster));
+    benchQueueFrame(scene);
+    isoRenderSetBackend(NULL);
+
+    if (queue) isoRenderQueueSubmit(queue, isoRasterBackend(raster));
+    else isoRasterFlush(raster);
+}
+
+static int benchQueue(const BenchConfig* config)
+{
+    BenchScene scene;
+    if (!benchGenerateHills(&scene.map)) return 0;
+    benchSetupScene(&scene);
+    isoEntityLayerSort(&scene.entities, &scene.map);
+
+    // the decoration atlas is the tile atlas with red and blue swapped
+    IsoAtlas decoration;
+    isoAtlasInitGrid(&decoration, scene.atlas);
+
+    IsoMap layers[BENCH_QUEUE_LAYERS];
+    uint32_t generated = 0;
+    int result = benchImpostorPixels(&scene.tiles) && benchImpostorPixels(&decoration);
+    if (result)
+    {
+        size_t texels = (size_t)decoration.texture.width * decoration.texture.height;
+        for (size_t i = 0; i < texels; i++)
+        {
+            uint8_t red = decoration.pixels[i * 4];
+            decoration.pixels[i * 4] = decoration.pixels[i * 4 + 2];
+            decoration.pixels[i * 4 + 2] = red;
+        }
+    }
+
+    for (uint32_t i = 0; i < BENCH_QUEUE_LAYERS && result; i++)
+    {
+        const IsoAtlas* atlas = i == BENCH_QUEUE_LAYERS - 1 ? &decoration : &scene.tiles;
+        if (!benchGenerateLayer(&layers[generated++], &scene.map, i)) result = 0;
+        else if (!isoLayerStackPush(&scene.layers, "decoration", &layers[i], atlas, ISO_LAYER_STATIC)) result = 0;
+    }
+
+    IsoRenderQueue queue;
+    IsoRaster direct, queued;
+    int queue_ready = result && isoRenderQueueInit(&queue, 0);
+    int direct_ready = result && isoRasterInit(&direct, NULL, (uint32_t)BENCH_VIEW_WIDTH, (uint32_t)BENCH_VIEW_HEIGHT);
+    int queued_ready = result && isoRasterInit(&queued, NULL, (uint32_t)BENCH_VIEW_WIDTH, (uint32_t)BENCH_VIEW_HEIGHT);
+    if (!queue_ready || !direct_ready || !queued_ready) result = 0;
+
+    if (result)
+    {
+        IsoRaster* rasters[] = { &direct, &queued };
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            isoRasterAddTexture(rasters[i], &scene.tiles.texture, scene.tiles.pixels);
+            isoRasterAddTexture(rasters[i], &decoration.texture, decoration.pixels);
+            isoRasterAddTexture(rasters[i], &scene.atlas, scene.tiles.pixels);
+        }
+
+        // draws of equal order never overlap, so grouping them by texture leaves every pixel as it was
+        benchQueueRaster(&scene, &direct, NULL);
+        benchQueueRaster(&scene, &queued, &queue);
+
+        size_t bytes = (size_t)direct.width * direct.height * 4;
+        if (memcmp(direct.pixels, queued.pixels, bytes) != 0 || direct.missing || queued.missing) result = 0;
+        if (direct.quads != queued.quads || direct.primitives != queued.primitives) result = 0;
+    }
+
+    if (result)
+    {
+        // direct to the Ignis stub, with a flush per renderer like the frame before the queue
+        benchRecorderReset();
+        uint32_t frames = 0;
+        uint64_t start = benchNow();
+        while (benchNow() - start < config->min_time / 4 && frames < config->max_frames)
+        {
+            benchQueueFrame(&scene);
+            isoRenderFlush();
+            frames++;
+        }
+        double direct_ns = frames ? (double)(benchNow() - start) / frames : 0.0;
+        uint64_t direct_quads = frames ? bench_recorder.quads / frames : 0;
+
+        // recorded, sorted and replayed, steady state without allocations
+        isoRenderSetBackend(isoRenderQueueBackend(&queue));
+        benchQueueFrame(&scene);
+        isoRenderSetBackend(NULL);
+        isoRenderQueueSubmit(&queue, isoRenderIgnisBackend());
+
+        benchRecorderReset();
+        int64_t allocations = benchAllocations();
+        uint64_t sort_ns = 0;
+        frames = 0;
+        start = benchNow();
+        while (benchNow() - start < config->min_time / 4 && frames < config->max_frames)
+        {
+            isoRenderSetBackend(isoRenderQueueBackend(&queue));
+            benchQueueFrame(&scene);
+            isoRenderSetBackend(NULL);
+
+            uint64_t submit = benchNow();
+            isoRenderQueueSubmit(&queue, isoRenderIgnisBackend());
+            sort_ns += benchNow() - submit;
+            frames++;
+        }
+        double queued_ns = frames ? (double)(benchNow() - start) / frames : 0.0;
+        allocations = benchAllocations() - allocations;
+
+        if (!frames || bench_recorder.quads / frames != direct_quads || bench_recorder.texts != frames) result = 0;
+        if (queue.draws > queue.unsorted_draws || queue.state_changes > queue.unsorted_state_changes) result = 0;
+        if (allocations || queue.dropped) result = 0;
+
+        printf("{\"bench\":\"renderQueue\",\"map\":%u,\"layers\":%u,\"commands\":%u,\"draws\":%u,\"unsorted_draws\":%u,"
+               "\"state_changes\":%u,\"unsorted_state_changes\":%u,\"sort_passes\":%u,\"ns_direct\":%.0f,\"ns_queued\":%.0f,"
+               "\"ns_submit\":%.0f,\"allocations\":%lld}\n",
+               scene.map.width, scene.layers.count, queue.commands_submitted, queue.draws, queue.unsorted_draws,
+               queue.state_changes, queue.unsorted_state_changes, queue.sort_passes, direct_ns, queued_ns,
+               frames ? (double)sort_ns / frames : 0.0, (long long)allocations);
+        fflush(stdout);
+    }
+
+    if (queued_ready) isoRasterDestroy(&queued);
+    if (direct_ready) isoRasterDestroy(&direct);
+    if (queue_ready) isoRenderQueueDestroy(&queue);
+
+    for (uint32_t i = 0; i < generated; i++)
+        isoMapDestroy(&layers[i]);
+    isoAtlasDestroy(&decoration);
+    isoAtlasDestroy(&scene.tiles);
+    isoEntityLayerDestroy(&scene.entities);
+    isoMapDestroy(&scene.map);
+    return result;
+}
+
+/* the instanced words against the quads of the tile builder, on the hills with decorations and on a flat map in full */
+#define BENCH_STREAM_LAYERS 2
+
+static int benchStreamVertexEqual(const IsoVertex* a, const IsoVertex* b)
+{
+    return fabsf(a->x - b->x) < 1e-3f && fabsf(a->y - b->y) < 1e-3f && a->z == b->z
+        && a->u == b->u && a->v == b->v && a->texture == b->texture;
+}
+
+/* expands every word like res/shaders/tiles.vert and counts the quads that differ from the builder */
+static uint32_t benchStreamMismatches(const IsoTileStream* stream, const IsoTileBuilder* builder)
+{
+    uint32_t mismatches = 0, quad = 0;
+    for (uint32_t d = 0; d < stream->draw_count; d++)
+    {
+        const IsoTileStreamDraw* draw = &stream->draws[d];
+        for (uint32_t i = 0; i < draw->count; i++, quad++)
+        {
+            IsoVertex vertices[ISO_QUAD_VERTICES];
+            isoTileStreamQuad(stream, draw, stream->words[draw->first + i], vertices);
+
+            const IsoVertex* expected = builder->vertices + (size_t)quad * ISO_QUAD_VERTICES;
+            for (uint32_t v = 0; v < ISO_QUAD_VERTICES; v++)
+            {
+                if (!benchStreamVertexEqual(&vertices[v], &expected[v]))
+                {
+                    mismatches++;
+                    break;
+                }
+            }
+        }
+    }
+    return mismatches;
+}
+
+/* draws is the number of instanced calls the view needed */
+static int benchTileStreamCase(const BenchConfig* config, BenchScene* scene, const char* name, rect view, uint32_t* draws)
+{
+    IsoTileBuilder builder;
+    IsoTileStream stream;
+    int builder_ready = isoTileBuilderInit(&builder, NULL, 4);
+    int stream_ready = isoTileStreamInit(&stream);
+
+    int result = builder_ready && stream_ready
+        && isoTileBuilderBuild(&builder, &scene->layers, view)
+        && isoTileStreamBuild(&stream, &scene->layers, view, ISO_LAYER_STATIC);
+
+    uint32_t mismatches = 0;
+    if (result)
+    {
+        if (stream.count != builder.quads || stream.dropped) result = 0;
+        else mismatches = benchStreamMismatches(&stream, &builder);
+        if (mismatches || !stream.count) result = 0;
+    }
+
+    double ns_builder = 0.0, ns_stream = 0.0;
+    if (result)
+    {
+        uint64_t start = benchNow();
+        uint32_t builds = 0;
+        while (benchNow() - start < config->min_time / 4 && builds < config->max_frames)
+        {
+            isoTileBuilderBuild(&builder, &scene->layers, view);
+            builds++;
+        }
+        ns_builder = (double)(benchNow() - start) / builds;
+
+        start = benchNow();
+        builds = 0;
+        while (benchNow() - start < config->min_time / 4 && builds < config->max_frames)
+        {
+            isoTileStreamBuild(&stream, &scene->layers, view, ISO_LAYER_STATIC);
+            builds++;
+        }
+        ns_stream = (double)(benchNow() - start) / builds;
+    }
+
+    // four vertices per quad against one word
+    uint64_t quad_bytes = (uint64_t)builder.quads * ISO_QUAD_VERTICES * sizeof(IsoVertex);
+    uint64_t word_bytes = (uint64_t)stream.count * sizeof(uint32_t);
+    double ratio = word_bytes ? (double)quad_bytes / word_bytes : 0.0;
+    if (ratio < 20.0) result = 0;
+
+    printf("{\"bench\":\"tileStream\",\"scene\":\"%s\",\"map\":%u,\"layers\":%u,\"words\":%u,\"quads\":%u,\"draws\":%u,"
+           "\"mismatched_quads\":%u,\"bytes_words\":%llu,\"bytes_quads\":%llu,\"upload_ratio\":%.1f,"
+           "\"ns_builder\":%.0f,\"ns_stream\":%.0f}\n",
+           name, scene->map.width, scene->layers.count, stream.count, builder.quads, stream.draw_count, mismatches,
+           (unsigned long long)word_bytes, (unsigned long long)quad_bytes, ratio, ns_builder, ns_stream);
+    fflush(stdout);
+
+    *draws = stream.draw_count;
+    if (stream_ready) isoTileStreamDestroy(&stream);
+    if (builder_ready) isoTileBuilderDestroy(&builder);
+    return result;
+}
+
+static int benchTileStream(const BenchConfig* config)
+{
+    BenchScene scene;
+    if (!benchGenerateHills(&scene.map)) return 0;
+    benchSetupScene(&scene);
+
+    IsoMap layers[BENCH_STREAM_LAYERS];
+    uint32_t generated = 0;
+    uint32_t draws = 0;
+    int result = 1;
+    for (uint32_t i = 0; i < BENCH_STREAM_LAYERS && result; i++)
+    {
+        if (!benchGenerateLayer(&layers[generated++], &scene.map, i)) result = 0;
+        else if (!isoLayerStackPush(&scene.layers, "decoration", &layers[i], &scene.tiles, ISO_LAYER_STATIC)) result = 0;
+    }
+
+    if (result && !benchTileStreamCase(config, &scene, "hills", scene.view, &draws)) result = 0;
+
+    for (uint32_t i = 0; i < generated; i++)
+        isoMapDestroy(&layers[i]);
+    isoAtlasDestroy(&scene.tiles);
+    isoEntityLayerDestroy(&scene.entities);
+    isoMapDestroy(&scene.map);
+    if (!result) return 0;
+
+    // wider than the window of one draw
+    if (!benchGenerateMap(&scene.map, BENCH_LAYER_SIZE)) return 0;
+    benchSetupScene(&scene);
+
+    result = benchTileStreamCase(config, &scene, "flat_full", scene.full_view, &draws) && draws > 1;
+
+    // a tall upper tile on the highest ground reaches past what a word holds, those levels are counted instead
+    IsoMap tower;
+    int tower_ready = isoMapInit(&tower, NULL, scene.map.width, scene.map.height, scene.map.tile_size, scene.map.tile_offset);
+    uint32_t col = scene.map.width / 2, row = scene.map.height / 2;
+    uint32_t quads = 0, words = 0, dropped = 0;
+
+    if (result && tower_ready && isoMapSetElevation(&scene.map, col, row, ISO_TILE_MAX_ELEVATION)
+        && isoMapSetTile(&tower, col, row, 2) && isoMapSetElevation(&tower, col, row, 4)
+        && isoLayerStackPush(&scene.layers, "tower", &tower, &scene.tiles, ISO_LAYER_STATIC))
+    {
+        IsoTileBuilder builder;
+        IsoTileStream stream;
+        if (isoTileBuilderInit(&builder, NULL, 4))
+        {
+            if (isoTileBuilderBuild(&builder, &scene.layers, scene.full_view)) quads = builder.quads;
+            isoTileBuilderDestroy(&builder);
+        }
+        if (isoTileStreamInit(&stream))
+        {
+            if (isoTileStreamBuild(&stream, &scene.layers, scene.full_view, ISO_LAYER_STATIC))
+            {
+                words = stream.count;
+                dropped = stream.dropped;
+            }
+            isoTileStreamDestroy(&stream);
+        }
+    }
+    if (!dropped || words + dropped != quads) result = 0;
+
+    printf("{\"bench\":\"tileStream\",\"scene\":\"tower\",\"map\":%u,\"words\":%u,\"quads\":%u,\"dropped\":%u}\n",
+           scene.map.width, words, quads, dropped);
+    fflush(stdout);
+
+    if (tower_ready) isoMapDestroy(&tower);
+    isoAtlasDestroy(&scene.tiles);
+    isoEntityLayerDestroy(&scene.entities);
+    isoMapDestroy(&scene.map);
+    return result;
+}
+
+static void benchUsage(const char* exe)
+{
+    fprintf(stderr, "usage: %s [--min-time ms] [--max-frames n] [--max-size n] [--full-max n]\n", exe);
+}
+
+int main(int argc, char** argv)
+{
+    BenchConfig config = {
+        .min_time = 200 * 1000000ull,
+        .max_frames = 100000,
+        .max_size = 8192,
+        .full_max = 1024
+    };
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (value && strcmp(argv[i], "--min-time") == 0)        config.min_time = strtoull(value, NULL, 10) * 1000000ull;
+        else if (value && strcmp(argv[i], "--max-frames") == 0) config.max_frames = (uint32_t)strtoul(value, NULL, 10);
+        else if (value && strcmp(argv[i], "--max-size") == 0)   config.max_size = (uint32_t)strtoul(value, NULL, 10);
+        else if (value && strcmp(argv[i], "--full-max") == 0)   config.full_max = (uint32_t)strtoul(value, NULL, 10);
+        else
+        {
+            benchUsage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+
+    if (config.max_frames == 0) config.max_frames = 1;
+
+    if (!isoMemInit(BENCH_FRAME_ARENA))
+    {
+        fprintf(stderr, "failed to allocate the frame arena\n");
+        return 1;
+    }
+
+    if (!benchTransforms(&config))
+    {
+        fprintf(stderr, "batch transforms disagree with the per point functions\n");
+        return 1;
+    }
+
+    if (!benchMat4())
+    {
+        fprintf(stderr, "vectorized mat4 functions disagree with the scalar versions\n");
+        return 1;
+    }
+
+    if (!benchAtlasPack())
+    {
+        fprintf(stderr, "packed atlas frames overlap or leave the texture\n");
+        return 1;
+    }
+
+    if (!benchMemory())
+    {
+        fprintf(stderr, "pool or arena allocated in steady state or lost track of bytes\n");
+        return 1;
+    }
+
+    if (!benchProfiler())
+    {
+        fprintf(stderr, "profiler lost or miscounted events\n");
+        return 1;
+    }
+
+    if (!benchElevation(&config))
+    {
+        fprintf(stderr, "culled elevation levels were visible or the render paths disagree\n");
+        return 1;
+    }
+
+    if (!benchPicking())
+    {
+        fprintf(stderr, "picked tiles differ from what is drawn under the point\n");
+        return 1;
+    }
+
+    if (!benchLayers(&config))
+    {
+        fprintf(stderr, "layer render paths disagree or dynamic edits touched static chunks\n");
+        return 1;
+    }
+
+    if (!benchAnimation(&config))
+    {
+        fprintf(stderr, "animated quads shade differently from the batch path or touched the map\n");
+        return 1;
+    }
+
+    if (!benchImpostors(&config))
+    {
+        fprintf(stderr, "impostors show the wrong tiles, rebuild unchanged chunks or draw too many quads\n");
+        return 1;
+    }
+
+    if (!benchRaster(&config))
+    {
+        fprintf(stderr, "software raster differs from the tile shapes or between thread counts\n");
+        return 1;
+    }
+
+    if (!benchQueue(&config))
+    {
+        fprintf(stderr, "render queue changed the image, drew more than submission order or allocated\n");
+        return 1;
+    }
+
+    if (!benchTileStream(&config))
+    {
+        fprintf(stderr, "instanced tile words expand to other quads than the tile builder or upload too much\n");
+        return 1;
+    }
+
+    const uint32_t sizes[] = { 10, 64, 256, 1024, 2048, 4096, 8192 };
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        if (sizes[i] > config.max_size) break;
+
+        BenchScene scene;
+        if (!benchGenerateMap(&scene.map, sizes[i]))
+        {
+            fprintf(stderr, "failed to generate %ux%u map\n", sizes[i], sizes[i]);
+            return 1;
+        }
+
+        benchSetupScene(&scene);
+
+        benchRun(&config, &scene, "frame", benchFrameFull);
+        benchRun(&config, &scene, "renderMap", benchFrameRender);
+        benchRun(&config, &scene, "highlightTile", benchFrameHighlight);
+        benchRun(&config, &scene, "playerUpdate", benchFramePlayer);
+        benchRun(&config, &scene, "entities", benchFrameEntities);
+
+        if (sizes[i] <= config.full_max)
+        {
+            benchRun(&config, &scene, "renderMap_full", benchFrameRenderFull);
+
+            if (!benchTileBuilder(&config, &scene))
+            {
+                fprintf(stderr, "tile builder failed\n");
+                return 1;
+            }
+        }
+
+        if (sizes[i] == 256 && !benchEntitySort(&config, &scene.map))
+        {
+            fprintf(stderr, "entity depth sort failed\n");
+            return 1;
+        }
+
+        if (sizes[i] == 1024 && !benchSpatial(&config, &scene.map))
+        {
+            fprintf(stderr, "spatial hash queries disagree with a linear scan\n");
+            return 1;
+        }
+
+        if (sizes[i] >= 64 && !benchCollision(&config, &scene.map))
+        {
+            fprintf(stderr, "movers ended up inside blocked tiles\n");
+            return 1;
+        }
+
+        if (sizes[i] >= 64 && !benchMapFile(&scene.map))
+        {
+            fprintf(stderr, "map file does not round trip\n");
+            return 1;
+        }
+
+        if (sizes[i] == 2048 && !benchStreaming(&scene.map))
+        {
+            fprintf(stderr, "streamed chunks disagree with the map\n");
+            return 1;
+        }
+
+        if (sizes[i] == 2048 && !benchStreamSim(&scene.map))
+        {
+            fprintf(stderr, "headless ticks over a streamed map went wrong\n");
+            return 1;
+        }
+
+        if (sizes[i] == 1024 && !benchSim(&scene.map))
+        {
+            fprintf(stderr, "simulation is not deterministic or agents ended up inside blocked tiles\n");
+            return 1;
+        }
+
+        // last, it edits the map
+        if (sizes[i] == 1024 && !benchPathfinding(&scene.map))
+        {
+            fprintf(stderr, "hierarchical paths disagree with plain A*\n");
+            return 1;
+        }
+
+        isoAtlasDestroy(&scene.tiles);
+        isoEntityLayerDestroy(&scene.entities);
+        isoMapDestroy(&scene.map);
+    }
+
+    isoMemShutdown();
+    return bench_steady_allocs ? 1 : 0;
+}
@@ -0,0 +1,538 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "iso.h"
+#include "atlas.h"
+#include "alloc.h"
+#include "layer.h"
+#include "tilegen.h"
+#include "tilestream.h"
+#include "cache.h"
+#include "image.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+/*
+ * Headless GL check of the render paths that draw with OpenGL themselves.
+ * Runs on a surfaceless EGL context (e.g. Mesa llvmpipe with
+ * LIBGL_ALWAYS_SOFTWARE=1), draws the same views through the threaded quads
+ * (RENDER_THREADED) and the instanced tile words (RENDER_INSTANCED) into an
+ * offscreen framebuffer and compares the pixels read back. Results are JSON
+ * lines like the bench, the exit code is 1 if the paths disagree.
+ */
+
+#define GLCHECK_WIDTH  1920
+#define GLCHECK_HEIGHT 1080
+
+#define GLCHECK_TILE_SIZE   50.0f
+#define GLCHECK_TILE_OFFSET 8.0f
+
+#define GLCHECK_HILLS_SIZE 128
+#define GLCHECK_FULL_SIZE  320 /* wider than the window of one instanced draw */
+
+#define GLCHECK_FRAME_ARENA (256 * 1024) /* as in main */
+
+typedef struct
+{
+    EGLDisplay display;
+    EGLContext context;
+    GLuint framebuffer;
+    GLuint color;
+} GLCheckContext;
+
+typedef struct
+{
+    IsoMap map;
+    IsoMap layers[2];
+    IsoLayerStack stack;
+    rect view;
+} GLCheckScene;
+
+static char* glCheckReadFile(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+
+    char* buffer = NULL;
+    if (fseek(file, 0, SEEK_END) == 0)
+    {
+        long size = ftell(file);
+        if (size >= 0 && fseek(file, 0, SEEK_SET) == 0 && (buffer = malloc((size_t)size + 1)))
+        {
+            if (fread(buffer, 1, (size_t)size, file) == (size_t)size)
+            {
+                buffer[size] = '\0';
+            }
+            else
+            {
+                free(buffer);
+                buffer = NULL;
+            }
+        }
+    }
+
+    fclose(file);
+    return buffer;
+}
+
+static GLuint glCheckCompile(GLenum type, const char* path)
+{
+    char* source = glCheckReadFile(path);
+    if (!source)
+    {
+        fprintf(stderr, "failed to read %s\n", path);
+        return 0;
+    }
+
+    GLuint shader = glCreateShader(type);
+    const GLchar* sources[] = { source };
+    glShaderSource(shader, 1, sources, NULL);
+    glCompileShader(shader);
+    free(source);
+
+    GLint status = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status != GL_TRUE)
+    {
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        fprintf(stderr, "failed to compile %s:\n%s\n", path, log);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+/* the part of Ignis cache.c loads its shaders with */
+int ignisCreateShadervf(IgnisShader* shader, const char* vert, const char* frag)
+{
+    shader->program = 0;
+
+    GLuint vertex = glCheckCompile(GL_VERTEX_SHADER, vert);
+    GLuint fragment = vertex ? glCheckCompile(GL_FRAGMENT_SHADER, frag) : 0;
+    if (!fragment)
+    {
+        glDeleteShader(vertex);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    glLinkProgram(program);
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE)
+    {
+        char log[1024];
+        glGetProgramInfoLog(program, sizeof(log), NULL, log);
+        fprintf(stderr, "failed to link %s with %s:\n%s\n", vert, frag, log);
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    shader->program = program;
+    return 1;
+}
+
+void ignisDeleteShader(IgnisShader* shader)
+{
+    glDeleteProgram(shader->program);
+    shader->program = 0;
+}
+
+static int glCheckContextInit(GLCheckContext* gl)
+{
+    memset(gl, 0, sizeof(GLCheckContext));
+
+    // no window system needed where the surfaceless platform exists
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    gl->display = getPlatformDisplay ? getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL) : EGL_NO_DISPLAY;
+    if (gl->display == EGL_NO_DISPLAY)
+        gl->display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    EGLint major, minor;
+    if (gl->display == EGL_NO_DISPLAY || !eglInitialize(gl->display, &major, &minor) || !eglBindAPI(EGL_OPENGL_API))
+        return 0;
+
+    // contexts without a config are fine as everything goes to the framebuffer below
+    EGLint config_attributes[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+    EGLConfig config = EGL_NO_CONFIG_KHR;
+    EGLint configs = 0;
+    if (!eglChooseConfig(gl->display, config_attributes, &config, 1, &configs) || configs == 0)
+        config = EGL_NO_CONFIG_KHR;
+
+    EGLint context_attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    gl->context = eglCreateContext(gl->display, config, EGL_NO_CONTEXT, context_attributes);
+    if (gl->context == EGL_NO_CONTEXT || !eglMakeCurrent(gl->display, EGL_NO_SURFACE, EGL_NO_SURFACE, gl->context))
+        return 0;
+
+    glGenRenderbuffers(1, &gl->color);
+    glBindRenderbuffer(GL_RENDERBUFFER, gl->color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, GLCHECK_WIDTH, GLCHECK_HEIGHT);
+
+    glGenFramebuffers(1, &gl->framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, gl->framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, gl->color);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        return 0;
+
+    // as in main
+    glViewport(0, 0, GLCHECK_WIDTH, GLCHECK_HEIGHT);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    return 1;
+}
+
+static void glCheckContextDestroy(GLCheckContext* gl)
+{
+    if (gl->framebuffer) glDeleteFramebuffers(1, &gl->framebuffer);
+    if (gl->color) glDeleteRenderbuffers(1, &gl->color);
+
+    if (gl->context != EGL_NO_CONTEXT)
+    {
+        eglMakeCurrent(gl->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(gl->display, gl->context);
+    }
+    if (gl->display != EGL_NO_DISPLAY) eglTerminate(gl->display);
+}
+
+/*
+ * A grid atlas of five tile sized frames: a raised diamond with a lit top
+ * and two shaded sides, transparent around it. Every frame and every atlas
+ * gets its own colors, texels vary across the frame so wrong uvs show up.
+ */
+static int glCheckAtlasInit(IsoAtlas* atlas, uint32_t seed)
+{
+    const uint32_t frames = 5;
+    const uint32_t w = (uint32_t)(2.0f * GLCHECK_TILE_SIZE);
+    const uint32_t h = (uint32_t)(GLCHECK_TILE_SIZE + GLCHECK_TILE_OFFSET);
+    const float half = GLCHECK_TILE_SIZE * .5f;
+
+    uint8_t* pixels = malloc((size_t)frames * w * h * 4);
+    if (!pixels) return 0;
+
+    for (uint32_t y = 0; y < h; y++)
+    {
+        for (uint32_t x = 0; x < frames * w; x++)
+        {
+            uint32_t frame = x / w;
+            float dx = (x % w + .5f) - GLCHECK_TILE_SIZE;
+            float dy = y + .5f;
+
+            uint8_t* texel = pixels + ((size_t)y * frames * w + x) * 4;
+            int top = fabsf(dx) / GLCHECK_TILE_SIZE + fabsf(dy - half) / half <= 1.0f;
+            int side = !top && dy > half && fabsf(dx) / GLCHECK_TILE_SIZE + fabsf(dy - GLCHECK_TILE_OFFSET - half) / half <= 1.0f;
+
+            if (frame == 0 || (!top && !side))
+            {
+                memset(texel, 0, 4);
+                continue;
+            }
+
+            uint8_t shade = top ? 255 : (dx < 0.0f ? 170 : 110);
+            texel[0] = (uint8_t)((frame * 60 + seed * 35 + x % w) * shade / 255);
+            texel[1] = (uint8_t)((y * 4 + seed * 90) * shade / 255);
+            texel[2] = (uint8_t)((255 - frame * 40 - (x & 7) * 8) * shade / 255);
+            texel[3] = side && frame == 3 ? 192 : 255;
+        }
+    }
+
+    IgnisTexture2D texture = { 0 };
+    texture.width = (int)(frames * w);
+    texture.height = (int)h;
+    texture.rows = 1;
+    texture.columns = (int)frames;
+
+    glGenTextures(1, &texture.name);
+    glBindTexture(GL_TEXTURE_2D, texture.name);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, texture.width, texture.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    free(pixels);
+
+    if (!isoAtlasInitGrid(atlas, texture))
+    {
+        glDeleteTextures(1, &texture.name);
+        return 0;
+    }
+
+    const char* names[] = { "empty", "grass", "sand", "water", "foam" };
+    for (uint32_t i = 0; i < atlas->frame_count && i < frames; i++)
+        strcpy(atlas->frames[i].name, names[i]);
+
+    return 1;
+}
+
+static void glCheckAtlasDestroy(IsoAtlas* atlas)
+{
+    glDeleteTextures(1, &atlas->texture.name);
+    isoAtlasDestroy(atlas);
+}
+
+static uint32_t glCheckHash(uint32_t x, uint32_t y)
+{
+    uint32_t h = x * 0x8da6b343u ^ y * 0xd8163841u;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    return h ^ (h >> 15);
+}
+
+/* water border and grass with patches of sand, hills up to max_elevation, sparse static decoration on top */
+static int glCheckSceneInit(GLCheckScene* scene, uint32_t size, uint32_t max_elevation, const IsoAtlas* tiles, const IsoAtlas* decoration)
+{
+    IsoMap* map = &scene->map;
+    if (!isoMapInit(map, NULL, size, size, GLCHECK_TILE_SIZE, GLCHECK_TILE_OFFSET))
+        return 0;
+
+    isoLayerStackInit(&scene->stack, map, tiles);
+
+    for (uint32_t row = 0; row < size; row++)
+    {
+        for (uint32_t col = 0; col < size; col++)
+        {
+            uint32_t tile = (glCheckHash(col >> 3, row >> 3) & 7) == 0 ? 2 : 1;
+            uint32_t elevation = max_elevation ? (glCheckHash(col >> 2, row >> 2) >> 8) % (max_elevation + 1) : 0;
+
+            if (col == 0 || row == 0 || col == size - 1 || row == size - 1 || (glCheckHash(col >> 4, row >> 4) & 15) == 1)
+            {
+                tile = 3;
+                elevation = 0;
+            }
+
+            if (!isoMapSetTile(map, col, row, tile) || !isoMapSetElevation(map, col, row, elevation))
+                return 0;
+        }
+    }
+
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        IsoMap* layer = &scene->layers[i];
+        if (!isoMapInit(layer, NULL, size, size, GLCHECK_TILE_SIZE, GLCHECK_TILE_OFFSET))
+            return 0;
+
+        for (uint32_t row = 0; row < size; row++)
+        {
+            for (uint32_t col = 0; col < size; col++)
+            {
+                uint32_t h = glCheckHash(col + (i + 1) * 7919, row);
+                if (h & 7) continue;
+
+                if (!isoMapSetTile(layer, col, row, 1 + i) || !isoMapSetElevation(layer, col, row, (h >> 3) & 1))
+                    return 0;
+            }
+        }
+
+        if (!isoLayerStackPush(&scene->stack, i ? "rocks" : "plants", layer, decoration, ISO_LAYER_STATIC))
+            return 0;
+    }
+
+    return 1;
+}
+
+static void glCheckSceneDestroy(GLCheckScene* scene)
+{
+    isoMapDestroy(&scene->layers[1]);
+    isoMapDestroy(&scene->layers[0]);
+    isoMapDestroy(&scene->map);
+}
+
+static void glCheckRead(uint8_t* pixels)
+{
+    glFinish();
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, GLCHECK_WIDTH, GLCHECK_HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+}
+
+/* the view drawn through both paths, 1 if they left the same pixels */
+static int glCheckView(IsoMapCache* cache, IsoTileBuilder* builder, IsoTileStream* stream, GLCheckScene* scene, const char* name)
+{
+    size_t size = (size_t)GLCHECK_WIDTH * GLCHECK_HEIGHT * 4;
+    uint8_t* threaded = malloc(size);
+    uint8_t* instanced = malloc(size);
+
+    int result = threaded && instanced;
+    if (result)
+    {
+        rect view = scene->view;
+        mat4 view_projection = mat4_ortho(view.min.x, view.max.x, view.max.y, view.min.y, -1.0f, 1.0f);
+        isoMapCacheSetViewProjection(cache, view_projection.v);
+
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+
+        glClear(GL_COLOR_BUFFER_BIT);
+        result = isoTileBuilderBuild(builder, &scene->stack, view);
+        if (result) isoMapCacheRenderVertices(cache, &scene->stack, builder->vertices, builder->quads);
+        glCheckRead(threaded);
+
+        glClear(GL_COLOR_BUFFER_BIT);
+        result = result && isoTileStreamBuild(stream, &scene->stack, view, ISO_LAYER_STATIC);
+        if (result) isoMapCacheRenderStream(cache, &scene->stack, stream);
+        glCheckRead(instanced);
+    }
+
+    GLenum error = glGetError();
+    uint64_t drawn = 0, mismatches = 0;
+    if (result)
+    {
+        for (size_t i = 0; i < size; i += 4)
+        {
+            if (memcmp(threaded + i, instanced + i, 4) != 0) mismatches++;
+            if (threaded[i + 3]) drawn++;
+        }
+    }
+
+    printf("{\"check\":\"instanced\",\"scene\":\"%s\",\"quads\":%u,\"words\":%u,\"draws\":%u,\"dropped\":%u,"
+           "\"pixels_drawn\":%llu,\"mismatched_pixels\":%llu,\"gl_error\":%u}\n",
+           name, result ? builder->quads : 0, result ? stream->count : 0, result ? stream->draw_count : 0, result ? stream->dropped : 0,
+           (unsigned long long)drawn, (unsigned long long)mismatches, (unsigned)error);
+
+    if (mismatches)
+    {
+        char path[256];
+        snprintf(path, sizeof(path), "glcheck_%s_threaded.png", name);
+        isoImageWrite(path, threaded, GLCHECK_WIDTH, GLCHECK_HEIGHT);
+        snprintf(path, sizeof(path), "glcheck_%s_instanced.png", name);
+        isoImageWrite(path, instanced, GLCHECK_WIDTH, GLCHECK_HEIGHT);
+    }
+
+    free(threaded);
+    free(instanced);
+
+    // an empty frame would compare equal as well
+    return result && error == GL_NO_ERROR && drawn && !mismatches && builder->quads == stream->count;
+}
+
+static int glCheckRun(const char* shaders)
+{
+    char batch_vert[256], batch_frag[256], tiles_vert[256];
+    snprintf(batch_vert, sizeof(batch_vert), "%s/batch.vert", shaders);
+    snprintf(batch_frag, sizeof(batch_frag), "%s/batch.frag", shaders);
+    snprintf(tiles_vert, sizeof(tiles_vert), "%s/tiles.vert", shaders);
+
+    IsoAtlas tiles, decoration;
+    if (!glCheckAtlasInit(&tiles, 0)) return 0;
+    if (!glCheckAtlasInit(&decoration, 1))
+    {
+        glCheckAtlasDestroy(&tiles);
+        return 0;
+    }
+
+    // water runs on its own frame, the second one so animation is not a no-op
+    const char* water[] = { "water", "foam" };
+    int result = isoAtlasAddAnimation(&tiles, 3, water, 2, .5f);
+    isoAtlasAnimate(&tiles, .75);
+
+    // maps left zeroed by a failed init are fine to destroy
+    GLCheckScene hills, full;
+    memset(&hills, 0, sizeof(GLCheckScene));
+    memset(&full, 0, sizeof(GLCheckScene));
+
+    result = result && glCheckSceneInit(&hills, GLCHECK_HILLS_SIZE, 3, &tiles, &decoration);
+    result = result && glCheckSceneInit(&full, GLCHECK_FULL_SIZE, 0, &tiles, &decoration);
+
+    IsoMapCache cache;
+    IsoTileBuilder builder;
+    IsoTileStream stream;
+    int cache_ready = 0, builder_ready = 0, stream_ready = 0;
+
+    if (result)
+    {
+        cache_ready = isoMapCacheInit(&cache, &hills.map, batch_vert, batch_frag, 16);
+        if (!cache_ready) fprintf(stderr, "failed to load %s with %s\n", batch_vert, batch_frag);
+
+        // the tile shader has to link against the fragment shader of the batch
+        int shader = cache_ready && isoMapCacheInitStream(&cache, tiles_vert, batch_frag);
+        if (cache_ready && !shader) fprintf(stderr, "failed to load %s with %s\n", tiles_vert, batch_frag);
+
+        builder_ready = isoTileBuilderInit(&builder, NULL, 4);
+        stream_ready = isoTileStreamInit(&stream);
+        result = shader && builder_ready && stream_ready;
+    }
+
+    if (result)
+    {
+        // one to one around the center of the hills
+        vec2 center = cartesianToIso((vec2){ GLCHECK_HILLS_SIZE * GLCHECK_TILE_SIZE * .5f, GLCHECK_HILLS_SIZE * GLCHECK_TILE_SIZE * .5f });
+        isoMapSetOrigin(&hills.map, (vec2){ GLCHECK_WIDTH * .5f - center.x, GLCHECK_HEIGHT * .5f - center.y });
+        hills.view = (rect){ { 0.0f, 0.0f }, { GLCHECK_WIDTH, GLCHECK_HEIGHT } };
+
+        // the whole flat map squeezed into the framebuffer
+        float extent = GLCHECK_FULL_SIZE * GLCHECK_TILE_SIZE;
+        isoMapSetOrigin(&full.map, (vec2){ extent + GLCHECK_TILE_SIZE, 0.0f });
+        full.view = (rect){ { 0.0f, 0.0f }, { 2.0f * (extent + GLCHECK_TILE_SIZE), extent + GLCHECK_TILE_SIZE + GLCHECK_TILE_OFFSET } };
+
+        if (!glCheckView(&cache, &builder, &stream, &hills, "hills")) result = 0;
+        if (!glCheckView(&cache, &builder, &stream, &full, "full")) result = 0;
+    }
+
+    if (stream_ready) isoTileStreamDestroy(&stream);
+    if (builder_ready) isoTileBuilderDestroy(&builder);
+    if (cache_ready) isoMapCacheDestroy(&cache);
+    glCheckSceneDestroy(&full);
+    glCheckSceneDestroy(&hills);
+
+    glCheckAtlasDestroy(&decoration);
+    glCheckAtlasDestroy(&tiles);
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    const char* shaders = "res/shaders";
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (i + 1 < argc && strcmp(argv[i], "--shaders") == 0)
+        {
+            shaders = argv[++i];
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--shaders dir]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (!isoMemInit(GLCHECK_FRAME_ARENA))
+    {
+        fprintf(stderr, "failed to allocate the frame arena\n");
+        return 1;
+    }
+
+    GLCheckContext gl;
+    if (!glCheckContextInit(&gl))
+    {
+        fprintf(stderr, "failed to create a headless GL 3.3 context (EGL error 0x%x)\n", (unsigned)eglGetError());
+        glCheckContextDestroy(&gl);
+        return 1;
+    }
+
+    printf("{\"check\":\"context\",\"renderer\":\"%s\",\"version\":\"%s\"}\n", (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION));
+
+    int result = glCheckRun(shaders);
+    glCheckContextDestroy(&gl);
+    isoMemShutdown();
+
+    if (!result)
+    {
+        fprintf(stderr, "the instanced tiles do not match the threaded path\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include "recorder.h"
+
+#include "alloc.h"
+
+#include <Ignis/Renderer/Renderer.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+BenchRecorder bench_recorder;
+
+const IgnisColorRGBA IGNIS_WHITE = { 1.0f, 1.0f, 1.0f, 1.0f };
+const IgnisColorRGBA IGNIS_BLACK = { 0.0f, 0.0f, 0.0f, 1.0f };
+const IgnisColorRGBA IGNIS_RED   = { 1.0f, 0.0f, 0.0f, 1.0f };
+const IgnisColorRGBA IGNIS_BLUE  = { 0.0f, 0.0f, 1.0f, 1.0f };
+
+void benchRecorderReset()
+{
+    memset(&bench_recorder, 0, sizeof(BenchRecorder));
+}
+
+void ignisBatch2DRenderTextureFrame(const IgnisTexture2D* texture, IgnisRect rect, uint32_t frame)
+{
+    bench_recorder.quads++;
+    bench_recorder.checksum += rect.x + rect.y + frame;
+}
+
+void ignisBatch2DRenderTextureSrc(const IgnisTexture2D* texture, IgnisRect rect, IgnisRect src)
+{
+    if (bench_recorder.positions && bench_recorder.quads < bench_recorder.position_max)
+    {
+        bench_recorder.positions[bench_recorder.quads * 2 + 0] = rect.x;
+        bench_recorder.positions[bench_recorder.quads * 2 + 1] = rect.y;
+    }
+
+    bench_recorder.quads++;
+    bench_recorder.checksum += rect.x + rect.y + src.x + src.y;
+}
+
+void ignisBatch2DFlush()
+{
+    bench_recorder.flushes++;
+}
+
+void ignisPrimitives2DRenderRect(float x, float y, float w, float h, IgnisColorRGBA color)
+{
+    bench_recorder.primitives++;
+    bench_recorder.checksum += x + y;
+}
+
+void ignisPrimitives2DRenderRhombus(float x, float y, float w, float h, IgnisColorRGBA color)
+{
+    bench_recorder.primitives++;
+    bench_recorder.checksum += x + y;
+}
+
+void ignisPrimitives2DFillCircle(float x, float y, float radius, IgnisColorRGBA color)
+{
+    bench_recorder.primitives++;
+    bench_recorder.checksum += x + y;
+}
+
+void ignisPrimitives2DFlush()
+{
+    bench_recorder.flushes++;
+}
+
+void ignisFontRendererRenderTextFormat(float x, float y, const char* fmt, ...)
+{
+    bench_recorder.texts++;
+    bench_recorder.checksum += x + y;
+}
+
+void ignisFontRendererFlush()
+{
+    bench_recorder.flushes++;
+}
+
+/*
+ * On Linux the bench is linked with --wrap for the allocation functions, so
+ * every call from the iso code lands here first.
+ */
+#ifdef BENCH_WRAP_ALLOC
+
+static int64_t allocations = 0;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* block, size_t size);
+
+void* __wrap_malloc(size_t size)
+{
+    allocations++;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size)
+{
+    allocations++;
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* block, size_t size)
+{
+    allocations++;
+    return __real_realloc(block, size);
+}
+
+int64_t benchAllocations() { return allocations; }
+
+#else
+
+/* without the wrapper only what goes through the iso allocator is seen */
+int64_t benchAllocations() { return (int64_t)isoMemAllocCount(); }
+
+#endif
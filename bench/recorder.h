@@ -0,0 +1,27 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <stdint.h>
+
+/* what the Ignis stub saw since the last reset */
+typedef struct
+{
+    uint64_t quads;
+    uint64_t primitives;
+    uint64_t texts;
+    uint64_t flushes;
+
+    double checksum; /* keeps the compiler from dropping submitted geometry */
+
+    float* positions; /* x, y of the textured quads while set, up to position_max */
+    uint64_t position_max;
+} BenchRecorder;
+
+extern BenchRecorder bench_recorder;
+
+void benchRecorderReset();
+
+/* number of heap allocations so far */
+int64_t benchAllocations();
+
+#endif // !RECORDER_H
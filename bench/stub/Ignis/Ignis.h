@@ -0,0 +1,61 @@
+#ifndef IGNIS_STUB_H
+#define IGNIS_STUB_H
+
+/*
+ * Headless stand-in for the parts of Ignis the iso code uses. Types mirror
+ * the real library, calls are recorded by bench/recorder.c instead of
+ * reaching OpenGL.
+ *
+ * With BENCH_GL the GL types and calls are real, for the code that draws with
+ * OpenGL itself (cache.c) in a context without a window, see bench/glcheck.c.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef BENCH_GL
+#define GL_GLEXT_PROTOTYPES
+#include <GL/glcorearb.h>
+#else
+typedef unsigned int GLuint;
+typedef int GLint;
+typedef float GLfloat;
+#endif
+
+typedef struct
+{
+    GLuint name;
+    GLint width;
+    GLint height;
+
+    GLuint rows;
+    GLuint columns;
+} IgnisTexture2D;
+
+typedef struct
+{
+    float x, y;
+    float w, h;
+} IgnisRect;
+
+typedef struct
+{
+    float r, g, b, a;
+} IgnisColorRGBA;
+
+extern const IgnisColorRGBA IGNIS_WHITE;
+extern const IgnisColorRGBA IGNIS_BLACK;
+extern const IgnisColorRGBA IGNIS_RED;
+extern const IgnisColorRGBA IGNIS_BLUE;
+
+#ifdef BENCH_GL
+typedef struct
+{
+    GLuint program;
+} IgnisShader;
+
+int ignisCreateShadervf(IgnisShader* shader, const char* vert, const char* frag);
+void ignisDeleteShader(IgnisShader* shader);
+#endif
+
+#endif // !IGNIS_STUB_H
@@ -0,0 +1,18 @@
+#ifndef IGNIS_RENDERER_STUB_H
+#define IGNIS_RENDERER_STUB_H
+
+#include <Ignis/Ignis.h>
+
+void ignisBatch2DRenderTextureFrame(const IgnisTexture2D* texture, IgnisRect rect, uint32_t frame);
+void ignisBatch2DRenderTextureSrc(const IgnisTexture2D* texture, IgnisRect rect, IgnisRect src);
+void ignisBatch2DFlush();
+
+void ignisPrimitives2DRenderRect(float x, float y, float w, float h, IgnisColorRGBA color);
+void ignisPrimitives2DRenderRhombus(float x, float y, float w, float h, IgnisColorRGBA color);
+void ignisPrimitives2DFillCircle(float x, float y, float radius, IgnisColorRGBA color);
+void ignisPrimitives2DFlush();
+
+void ignisFontRendererRenderTextFormat(float x, float y, const char* fmt, ...);
+void ignisFontRendererFlush();
+
+#endif // !IGNIS_RENDERER_STUB_H
@@ -76,3 +76,135 @@ project "Iso"
     filter "system:windows"
         systemversion "latest"
         defines { "WINDOWS", "_CRT_SECURE_NO_WARNINGS" }
+
+project "IsoBench"
+    kind "ConsoleApp"
+    language "C"
+    cdialect "C99"
+    staticruntime "On"
+
+    targetdir ("build/bin/" .. output_dir .. "/%{prj.name}")
+    objdir ("build/bin-int/" .. output_dir .. "/%{prj.name}")
+
+    files
+    {
+        --Benchmark and Ignis stub
+        "bench/**.h",
+        "bench/**.c",
+        --Headless iso sources
+        "src/iso.h",
+        "src/iso.c",
+        "src/alloc.h",
+        "src/alloc.c",
+        "src/profile.h",
+        "src/profile.c",
+        "src/atlas.h",
+        "src/atlas.c",
+        "src/render.h",
+        "src/render.c",
+        "src/queue.h",
+        "src/queue.c",
+        "src/raster.h",
+        "src/raster.c",
+        "src/image.h",
+        "src/image.c",
+        "src/chunk.h",
+        "src/chunk.c",
+        "src/occlusion.h",
+        "src/occlusion.c",
+        "src/layer.h",
+        "src/layer.c",
+        "src/impostor.h",
+        "src/impostor.c",
+        "src/mapfile.h",
+        "src/mapfile.c",
+        "src/stream.h",
+        "src/stream.c",
+        "src/player.h",
+        "src/player.c",
+        "src/entity.h",
+        "src/entity.c",
+        "src/spatial.h",
+        "src/spatial.c",
+        "src/pick.h",
+        "src/pick.c",
+        "src/path.h",
+        "src/path.c",
+        "src/collision.h",
+        "src/collision.c",
+        "src/sim.h",
+        "src/sim.c",
+        "src/transform.h",
+        "src/transform.c",
+        "src/thread.h",
+        "src/thread.c",
+        "src/jobs.h",
+        "src/jobs.c",
+        "src/tilegen.h",
+        "src/tilegen.c",
+        "src/tilestream.h",
+        "src/tilestream.c",
+        "src/math/**.h",
+        "src/math/**.c"
+    }
+
+    --Built by IsoGLCheck
+    removefiles { "bench/glcheck.c" }
+
+    includedirs
+    {
+        "bench/stub",
+        "src"
+    }
+
+    filter "system:linux"
+        links { "m", "pthread" }
+        defines { "BENCH_WRAP_ALLOC" }
+        linkoptions { "-Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc" }
+
+    filter "system:windows"
+        systemversion "latest"
+        defines { "WINDOWS", "_CRT_SECURE_NO_WARNINGS" }
+
+--Needs EGL with the surfaceless platform, e.g. Mesa
+if os.istarget("linux") then
+
+    project "IsoGLCheck"
+        kind "ConsoleApp"
+        language "C"
+        cdialect "C99"
+        staticruntime "On"
+
+        targetdir ("build/bin/" .. output_dir .. "/%{prj.name}")
+        objdir ("build/bin-int/" .. output_dir .. "/%{prj.name}")
+
+        files
+        {
+            --GL check and Ignis stub with real GL
+            "bench/glcheck.c",
+            "bench/recorder.h",
+            "bench/recorder.c",
+            "bench/stub/**.h",
+            --Iso sources without the window
+            "src/**.h",
+            "src/**.c"
+        }
+
+        removefiles
+        {
+            "src/main.c",
+            "src/atlasfile.h",
+            "src/atlasfile.c"
+        }
+
+        includedirs
+        {
+            "bench/stub",
+            "src"
+        }
+
+        defines { "BENCH_GL" }
+
+        links { "EGL", "OpenGL", "m", "pthread" }
+
+end
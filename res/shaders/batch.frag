@@ -7,8 +7,23 @@ in float v_TexIndex;
 
 uniform sampler2D u_Textures[8];
 
+// GLSL 330 only indexes sampler arrays with constants
+vec4 sampleTexture(int index)
+{
+	switch (index)
+	{
+	case 0: return texture(u_Textures[0], v_TexCoords);
+	case 1: return texture(u_Textures[1], v_TexCoords);
+	case 2: return texture(u_Textures[2], v_TexCoords);
+	case 3: return texture(u_Textures[3], v_TexCoords);
+	case 4: return texture(u_Textures[4], v_TexCoords);
+	case 5: return texture(u_Textures[5], v_TexCoords);
+	case 6: return texture(u_Textures[6], v_TexCoords);
+	default: return texture(u_Textures[7], v_TexCoords);
+	}
+}
+
 void main()
 {
-	int index = int(v_TexIndex);
-	f_Color = texture(u_Textures[index], v_TexCoords);
+	f_Color = sampleTexture(int(v_TexIndex));
 }
\ No newline at end of file
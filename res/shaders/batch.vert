@@ -6,12 +6,28 @@ layout (location = 2) in float a_TexIndex;
 
 uniform mat4 u_ViewProjection;
 
+// current frame of every animation, 16 per texture unit (see isoAtlasTileAnimation)
+uniform vec4 u_Frames[8 * 16];
+
 out vec2 v_TexCoords;
 out float v_TexIndex;
 
 void main()
 {
 	gl_Position = u_ViewProjection * vec4(a_Position, 1.0);
+
+	int index = int(a_TexIndex + 0.5);
+	int unit = index % 8;
+	int animation = index / 8;
+
 	v_TexCoords = a_TexCoords;
-	v_TexIndex = a_TexIndex;
+	v_TexIndex = float(unit);
+
+	// animated quads take the corner of their vertex in the current frame
+	if (animation > 0)
+	{
+		int corner = gl_VertexID % 4;
+		vec4 frame = u_Frames[unit * 16 + animation - 1];
+		v_TexCoords = frame.xy + vec2(corner == 1 || corner == 2, corner >= 2) * frame.zw;
+	}
 }
\ No newline at end of file
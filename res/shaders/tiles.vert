@@ -0,0 +1,34 @@
+#version 330 core
+
+// one tile level per instance: col - row (9 bits), col + row (10), level (8) and frame entry (5), see tilestream.h
+layout (location = 0) in uint a_Tile;
+
+uniform mat4 u_ViewProjection;
+uniform vec2 u_TileSize; // tile size and level offset
+uniform vec2 u_Base;     // col - row and col + row of the draw's window
+
+// frame table of the draw, src rects and texture units
+uniform vec4 u_Frames[32];
+uniform int u_Units[32];
+
+out vec2 v_TexCoords;
+out float v_TexIndex;
+
+void main()
+{
+	float diff = u_Base.x + float(a_Tile & 511u);
+	float sum = u_Base.y + float((a_Tile >> 9) & 1023u);
+	float level = float((a_Tile >> 19) & 255u);
+	int entry = int(a_Tile >> 27);
+
+	// a strip of top right, top left, bottom right, bottom left splits the quad like the batch indices
+	vec2 corner = vec2(1 - (gl_VertexID & 1), gl_VertexID >> 1);
+
+	vec2 position = vec2((diff - 1.0) * u_TileSize.x, sum * u_TileSize.x * 0.5 - level * u_TileSize.y);
+	position += corner * vec2(2.0 * u_TileSize.x, u_TileSize.x + u_TileSize.y);
+	gl_Position = u_ViewProjection * vec4(position, 0.0, 1.0);
+
+	vec4 frame = u_Frames[entry];
+	v_TexCoords = frame.xy + corner * frame.zw;
+	v_TexIndex = float(u_Units[entry]);
+}
\ No newline at end of file
@@ -0,0 +1,327 @@
+#include "alloc.h"
+
+#include "thread.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define ISO_MEM_ALIGN 16
+
+static size_t isoMemAlign(size_t size) { return (size + ISO_MEM_ALIGN - 1) & ~(size_t)(ISO_MEM_ALIGN - 1); }
+
+/* keeps the block behind it aligned */
+typedef struct
+{
+    uint64_t size;
+    uint32_t tag;
+    uint32_t reserved;
+} IsoMemHeader;
+
+static IsoMemStats mem_stats[ISO_MEM_TAGS];
+
+static const char* mem_tag_names[ISO_MEM_TAGS] = {
+    "general", "render", "map", "stream", "entity", "path", "sim", "jobs", "frame"
+};
+
+static void isoMemGrow(IsoMemTag tag, uint64_t size)
+{
+    IsoMemStats* stats = &mem_stats[tag];
+    uint64_t bytes = isoAtomicAdd64(&stats->bytes, size) + size;
+
+    uint64_t peak = stats->peak;
+    while (bytes > peak)
+    {
+        uint64_t previous = isoAtomicCompareExchange64(&stats->peak, peak, bytes);
+        if (previous == peak) break;
+        peak = previous;
+    }
+}
+
+static void isoMemShrink(IsoMemTag tag, uint64_t size)
+{
+    isoAtomicAdd64(&mem_stats[tag].bytes, (uint64_t)0 - size);
+}
+
+static void* isoMemTrack(IsoMemHeader* header, IsoMemTag tag, size_t size)
+{
+    header->size = size;
+    header->tag = tag;
+    header->reserved = 0;
+
+    isoAtomicAdd64(&mem_stats[tag].allocs, 1);
+    isoMemGrow(tag, size);
+    return header + 1;
+}
+
+void* isoMalloc(IsoMemTag tag, size_t size)
+{
+    IsoMemHeader* header = malloc(sizeof(IsoMemHeader) + size);
+    if (!header) return NULL;
+    return isoMemTrack(header, tag, size);
+}
+
+void* isoCalloc(IsoMemTag tag, size_t count, size_t size)
+{
+    if (size && count > (SIZE_MAX - sizeof(IsoMemHeader)) / size) return NULL;
+
+    IsoMemHeader* header = calloc(1, sizeof(IsoMemHeader) + count * size);
+    if (!header) return NULL;
+    return isoMemTrack(header, tag, count * size);
+}
+
+void* isoRealloc(IsoMemTag tag, void* block, size_t size)
+{
+    if (!block) return isoMalloc(tag, size);
+
+    IsoMemHeader* header = (IsoMemHeader*)block - 1;
+    IsoMemTag old_tag = header->tag;
+    uint64_t old_size = header->size;
+
+    header = realloc(header, sizeof(IsoMemHeader) + size);
+    if (!header) return NULL;
+
+    isoMemShrink(old_tag, old_size);
+    return isoMemTrack(header, tag, size);
+}
+
+void isoFree(void* block)
+{
+    if (!block) return;
+
+    IsoMemHeader* header = (IsoMemHeader*)block - 1;
+    isoAtomicAdd64(&mem_stats[header->tag].frees, 1);
+    isoMemShrink(header->tag, header->size);
+    free(header);
+}
+
+const IsoMemStats* isoMemStats(IsoMemTag tag) { return &mem_stats[tag]; }
+const char* isoMemTagName(IsoMemTag tag)      { return mem_tag_names[tag]; }
+
+uint64_t isoMemAllocCount()
+{
+    uint64_t count = 0;
+    for (uint32_t i = 0; i < ISO_MEM_TAGS; i++)
+        count += isoAtomicAdd64(&mem_stats[i].allocs, 0);
+    return count;
+}
+
+void* isoMemIgnisAllocator(IsoMemTag tag) { return &mem_stats[tag]; }
+
+static IsoMemTag isoMemIgnisTag(void* allocator)
+{
+    return allocator ? (IsoMemTag)((IsoMemStats*)allocator - mem_stats) : ISO_MEM_GENERAL;
+}
+
+void* isoMemIgnisMalloc(void* allocator, size_t size)              { return isoMalloc(isoMemIgnisTag(allocator), size); }
+void* isoMemIgnisRealloc(void* allocator, void* block, size_t size) { return isoRealloc(isoMemIgnisTag(allocator), block, size); }
+void isoMemIgnisFree(void* allocator, void* block)                  { isoFree(block); }
+
+/* ---------------------------------------------------------------------------
+ * arena
+ */
+struct IsoArenaBlock
+{
+    IsoArenaBlock* next;
+    size_t mark;
+};
+
+#define ISO_ARENA_BLOCK_HEADER isoMemAlign(sizeof(IsoArenaBlock))
+#define ISO_ARENA_GRANULARITY  4096
+
+int isoArenaInit(IsoArena* arena, IsoMemTag tag, size_t size)
+{
+    memset(arena, 0, sizeof(IsoArena));
+    arena->tag = tag;
+    if (!size) return 1;
+
+    arena->base = isoMalloc(tag, size);
+    if (!arena->base) return 0;
+
+    arena->size = size;
+    return 1;
+}
+
+void isoArenaDestroy(IsoArena* arena)
+{
+    isoArenaRelease(arena, 0);
+    isoFree(arena->base);
+
+    arena->base = NULL;
+    arena->size = 0;
+}
+
+void* isoArenaAlloc(IsoArena* arena, size_t size)
+{
+    size = isoMemAlign(size ? size : 1);
+
+    size_t mark = arena->used;
+    void* block = NULL;
+    if (mark + size <= arena->size)
+    {
+        block = arena->base + mark;
+    }
+    else
+    {
+        IsoArenaBlock* overflow = isoMalloc(arena->tag, ISO_ARENA_BLOCK_HEADER + size);
+        if (!overflow) return NULL;
+
+        overflow->next = arena->overflow;
+        overflow->mark = mark;
+        arena->overflow = overflow;
+        block = (uint8_t*)overflow + ISO_ARENA_BLOCK_HEADER;
+    }
+
+    arena->used = mark + size;
+    if (arena->used > arena->peak) arena->peak = arena->used;
+    return block;
+}
+
+size_t isoArenaMark(const IsoArena* arena) { return arena->used; }
+
+void isoArenaRelease(IsoArena* arena, size_t mark)
+{
+    while (arena->overflow && arena->overflow->mark >= mark)
+    {
+        IsoArenaBlock* next = arena->overflow->next;
+        isoFree(arena->overflow);
+        arena->overflow = next;
+    }
+
+    if (mark < arena->used) arena->used = mark;
+}
+
+void isoArenaReset(IsoArena* arena)
+{
+    isoArenaRelease(arena, 0);
+    if (arena->peak <= arena->size) return;
+
+    // grow once to what was needed instead of overflowing every frame
+    size_t size = (arena->peak + ISO_ARENA_GRANULARITY - 1) & ~(size_t)(ISO_ARENA_GRANULARITY - 1);
+    uint8_t* base = isoMalloc(arena->tag, size);
+    if (!base) return;
+
+    isoFree(arena->base);
+    arena->base = base;
+    arena->size = size;
+}
+
+static IsoArena frame_arena = { ISO_MEM_FRAME, NULL, 0, 0, 0, NULL };
+static uint64_t frame_allocs = 0;
+
+int isoMemInit(size_t frame_size)
+{
+    isoArenaDestroy(&frame_arena);
+    frame_allocs = isoMemAllocCount();
+    return isoArenaInit(&frame_arena, ISO_MEM_FRAME, frame_size);
+}
+
+void isoMemShutdown() { isoArenaDestroy(&frame_arena); }
+
+void* isoFrameAlloc(size_t size)     { return isoArenaAlloc(&frame_arena, size); }
+size_t isoFrameMark()                { return isoArenaMark(&frame_arena); }
+void isoFrameRelease(size_t mark)    { isoArenaRelease(&frame_arena, mark); }
+const IsoArena* isoMemFrameArena()   { return &frame_arena; }
+
+uint64_t isoMemFrame()
+{
+    isoArenaReset(&frame_arena);
+
+    uint64_t allocs = isoMemAllocCount();
+    uint64_t count = allocs - frame_allocs;
+    frame_allocs = allocs;
+    return count;
+}
+
+/* ---------------------------------------------------------------------------
+ * pool
+ */
+struct IsoPoolBlock
+{
+    IsoPoolBlock* next;
+};
+
+#define ISO_POOL_BLOCK_HEADER isoMemAlign(sizeof(IsoPoolBlock))
+
+static size_t isoPoolStride(const IsoPool* pool)
+{
+    return isoMemAlign(pool->size < sizeof(void*) ? sizeof(void*) : pool->size);
+}
+
+static void isoPoolLock(IsoPool* pool)
+{
+    while (isoAtomicExchange(&pool->lock, 1))
+        ;
+}
+
+static void isoPoolUnlock(IsoPool* pool) { isoAtomicStore(&pool->lock, 0); }
+
+void isoPoolInit(IsoPool* pool, IsoMemTag tag, size_t size, uint32_t per_block)
+{
+    memset(pool, 0, sizeof(IsoPool));
+    pool->tag = tag;
+    pool->size = size;
+    pool->per_block = per_block;
+}
+
+void isoPoolDestroy(IsoPool* pool)
+{
+    while (pool->blocks)
+    {
+        IsoPoolBlock* next = pool->blocks->next;
+        isoFree(pool->blocks);
+        pool->blocks = next;
+    }
+
+    pool->free_list = NULL;
+    pool->used = 0;
+    pool->capacity = 0;
+}
+
+void* isoPoolAlloc(IsoPool* pool)
+{
+    isoPoolLock(pool);
+
+    if (!pool->free_list)
+    {
+        size_t stride = isoPoolStride(pool);
+        uint32_t count = pool->per_block ? pool->per_block : 1;
+
+        IsoPoolBlock* block = isoMalloc(pool->tag, ISO_POOL_BLOCK_HEADER + stride * count);
+        if (!block)
+        {
+            isoPoolUnlock(pool);
+            return NULL;
+        }
+
+        block->next = pool->blocks;
+        pool->blocks = block;
+        pool->capacity += count;
+
+        // thread the free list through the new objects, first object on top
+        uint8_t* objects = (uint8_t*)block + ISO_POOL_BLOCK_HEADER;
+        for (uint32_t i = count; i-- > 0;)
+        {
+            void** object = (void**)(objects + i * stride);
+            *object = pool->free_list;
+            pool->free_list = object;
+        }
+    }
+
+    void** object = pool->free_list;
+    pool->free_list = *object;
+    pool->used++;
+
+    isoPoolUnlock(pool);
+    return object;
+}
+
+void isoPoolFree(IsoPool* pool, void* object)
+{
+    if (!object) return;
+
+    isoPoolLock(pool);
+    *(void**)object = pool->free_list;
+    pool->free_list = object;
+    pool->used--;
+    isoPoolUnlock(pool);
+}
@@ -0,0 +1,124 @@
+#ifndef ALLOC_H
+#define ALLOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Heap allocations of the iso code go through isoMalloc and friends, which
+ * count bytes, calls and the peak per subsystem. A small header in front of
+ * every block remembers its size and tag, so isoFree needs neither. The
+ * counters are atomic, any thread may allocate.
+ */
+typedef enum
+{
+    ISO_MEM_GENERAL,
+    ISO_MEM_RENDER, /* Ignis, map cache, tile builder, atlas */
+    ISO_MEM_MAP,    /* map, chunks, map files */
+    ISO_MEM_STREAM,
+    ISO_MEM_ENTITY, /* entities, spatial hash */
+    ISO_MEM_PATH,
+    ISO_MEM_SIM,
+    ISO_MEM_JOBS,
+    ISO_MEM_FRAME,  /* frame arena, including what did not fit */
+    ISO_MEM_TAGS
+} IsoMemTag;
+
+typedef struct
+{
+    volatile uint64_t bytes;
+    volatile uint64_t peak;
+    volatile uint64_t allocs; /* malloc, calloc and realloc calls */
+    volatile uint64_t frees;
+} IsoMemStats;
+
+void* isoMalloc(IsoMemTag tag, size_t size);
+void* isoCalloc(IsoMemTag tag, size_t count, size_t size);
+void* isoRealloc(IsoMemTag tag, void* block, size_t size);
+void isoFree(void* block);
+
+const IsoMemStats* isoMemStats(IsoMemTag tag);
+const char* isoMemTagName(IsoMemTag tag);
+
+/* allocation calls of all tags so far */
+uint64_t isoMemAllocCount();
+
+/* callbacks for ignisSetAllocator, pass isoMemIgnisAllocator(tag) as the allocator */
+void* isoMemIgnisAllocator(IsoMemTag tag);
+void* isoMemIgnisMalloc(void* allocator, size_t size);
+void* isoMemIgnisRealloc(void* allocator, void* block, size_t size);
+void isoMemIgnisFree(void* allocator, void* block);
+
+/*
+ * Bump allocator for scratch memory, 16 byte aligned. Allocations are
+ * released together, back to a mark or all at once. What does not fit goes
+ * into heap blocks that are freed on release, and the next reset grows the
+ * arena to the peak, so it settles at the size it needs.
+ */
+typedef struct IsoArenaBlock IsoArenaBlock;
+
+typedef struct
+{
+    IsoMemTag tag;
+    uint8_t* base;
+    size_t size;
+    size_t used; /* including the overflow blocks */
+    size_t peak;
+    IsoArenaBlock* overflow;
+} IsoArena;
+
+int isoArenaInit(IsoArena* arena, IsoMemTag tag, size_t size);
+void isoArenaDestroy(IsoArena* arena);
+
+void* isoArenaAlloc(IsoArena* arena, size_t size);
+size_t isoArenaMark(const IsoArena* arena);
+void isoArenaRelease(IsoArena* arena, size_t mark);
+void isoArenaReset(IsoArena* arena);
+
+/*
+ * Frame arena of the main thread, reset by isoMemFrame. Code that may run
+ * outside of a frame releases its scratch to a mark itself. Works without
+ * isoMemInit, everything just overflows.
+ */
+int isoMemInit(size_t frame_size);
+void isoMemShutdown();
+
+void* isoFrameAlloc(size_t size);
+size_t isoFrameMark();
+void isoFrameRelease(size_t mark);
+
+/* resets the frame arena and returns the heap allocations since the last call */
+uint64_t isoMemFrame();
+const IsoArena* isoMemFrameArena();
+
+/*
+ * Fixed size objects carved from blocks of per_block objects. Freed objects
+ * go to a free list, blocks are only returned by isoPoolDestroy. A spin lock
+ * guards the lists, so a pool can be shared between threads and set up
+ * statically with ISO_POOL_INIT.
+ */
+typedef struct IsoPoolBlock IsoPoolBlock;
+
+typedef struct
+{
+    IsoMemTag tag;
+    size_t size;
+    uint32_t per_block;
+
+    void* free_list;
+    IsoPoolBlock* blocks;
+    uint32_t used;
+    uint32_t capacity;
+
+    volatile uint32_t lock;
+} IsoPool;
+
+#define ISO_POOL_INIT(tag, size, per_block) { (tag), (size), (per_block), NULL, NULL, 0, 0, 0 }
+
+void isoPoolInit(IsoPool* pool, IsoMemTag tag, size_t size, uint32_t per_block);
+void isoPoolDestroy(IsoPool* pool);
+
+void* isoPoolAlloc(IsoPool* pool);
+void isoPoolFree(IsoPool* pool, void* object);
+
+#endif // !ALLOC_H
@@ -0,0 +1,342 @@
+#include "atlas.h"
+#include "alloc.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int isoAtlasAllocLookup(IsoAtlas* atlas, uint32_t count)
+{
+    uint32_t* lookup = isoRealloc(ISO_MEM_RENDER, atlas->lookup, (count ? count : 1) * sizeof(uint32_t));
+    if (!lookup) return 0;
+
+    atlas->lookup = lookup;
+    atlas->tile_count = count;
+    return 1;
+}
+
+int isoAtlasInitGrid(IsoAtlas* atlas, IgnisTexture2D texture)
+{
+    memset(atlas, 0, sizeof(IsoAtlas));
+    atlas->texture = texture;
+
+    uint32_t count = texture.columns * texture.rows;
+    atlas->frames = isoCalloc(ISO_MEM_RENDER, count ? count : 1, sizeof(IsoAtlasFrame));
+    if (!atlas->frames || !isoAtlasAllocLookup(atlas, count))
+    {
+        isoAtlasDestroy(atlas);
+        return 0;
+    }
+    atlas->frame_count = count;
+
+    uint32_t w = texture.columns ? (uint32_t)texture.width / texture.columns : 0;
+    uint32_t h = texture.rows ? (uint32_t)texture.height / texture.rows : 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        IsoAtlasFrame* frame = &atlas->frames[i];
+        uint32_t col = i % texture.columns;
+        uint32_t row = i / texture.columns;
+
+        frame->x = col * w;
+        frame->y = row * h;
+        frame->w = w;
+        frame->h = h;
+        frame->src = (IgnisRect){
+            (float)col / texture.columns, (float)row / texture.rows,
+            1.0f / texture.columns, 1.0f / texture.rows
+        };
+
+        atlas->lookup[i] = i;
+    }
+
+    return 1;
+}
+
+static void isoAtlasClearAnimations(IsoAtlas* atlas)
+{
+    isoFree(atlas->sequence);
+    isoFree(atlas->tile_animation);
+
+    atlas->animation_count = 0;
+    atlas->sequence = NULL;
+    atlas->sequence_count = 0;
+    atlas->tile_animation = NULL;
+}
+
+void isoAtlasDestroy(IsoAtlas* atlas)
+{
+    isoAtlasClearAnimations(atlas);
+    isoFree(atlas->pixels);
+    isoFree(atlas->frames);
+    isoFree(atlas->lookup);
+
+    atlas->pixels = NULL;
+    atlas->frames = NULL;
+    atlas->frame_count = 0;
+    atlas->lookup = NULL;
+    atlas->tile_count = 0;
+}
+
+uint32_t isoAtlasFind(const IsoAtlas* atlas, const char* name)
+{
+    for (uint32_t i = 0; i < atlas->frame_count; i++)
+    {
+        if (strncmp(atlas->frames[i].name, name, ISO_ATLAS_NAME_MAX) == 0)
+            return i;
+    }
+    return ISO_ATLAS_NONE;
+}
+
+int isoAtlasSetTiles(IsoAtlas* atlas, const char* const* names, uint32_t count)
+{
+    isoAtlasClearAnimations(atlas);
+    if (!isoAtlasAllocLookup(atlas, count)) return 0;
+
+    for (uint32_t i = 0; i < count; i++)
+        atlas->lookup[i] = names[i] ? isoAtlasFind(atlas, names[i]) : ISO_ATLAS_NONE;
+
+    return 1;
+}
+
+const IsoAtlasFrame* isoAtlasTileFrame(const IsoAtlas* atlas, uint32_t tile)
+{
+    if (tile >= atlas->tile_count || atlas->lookup[tile] == ISO_ATLAS_NONE) return NULL;
+    return &atlas->frames[atlas->lookup[tile]];
+}
+
+int isoAtlasAddAnimation(IsoAtlas* atlas, uint32_t tile, const char* const* names, uint32_t count, float frame_time)
+{
+    if (tile >= atlas->tile_count || atlas->animation_count >= ISO_ATLAS_ANIMATION_MAX || frame_time <= 0.0f)
+        return 0;
+
+    if (!atlas->tile_animation)
+    {
+        atlas->tile_animation = isoCalloc(ISO_MEM_RENDER, atlas->tile_count ? atlas->tile_count : 1, sizeof(uint32_t));
+        if (!atlas->tile_animation) return 0;
+    }
+    if (atlas->tile_animation[tile]) return 0;
+
+    uint32_t* sequence = isoRealloc(ISO_MEM_RENDER, atlas->sequence, (atlas->sequence_count + count) * sizeof(uint32_t));
+    if (!sequence) return 0;
+    atlas->sequence = sequence;
+
+    IsoAtlasAnimation* animation = &atlas->animations[atlas->animation_count];
+    animation->tile = tile;
+    animation->first = atlas->sequence_count;
+    animation->count = 0;
+    animation->frame_time = frame_time;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t frame = names[i] ? isoAtlasFind(atlas, names[i]) : ISO_ATLAS_NONE;
+        if (frame != ISO_ATLAS_NONE) sequence[animation->first + animation->count++] = frame;
+    }
+    if (!animation->count) return 0;
+
+    atlas->sequence_count += animation->count;
+    atlas->tile_animation[tile] = ++atlas->animation_count;
+    atlas->lookup[tile] = sequence[animation->first];
+    return 1;
+}
+
+void isoAtlasAnimate(IsoAtlas* atlas, double time)
+{
+    if (time < 0.0) time = 0.0;
+
+    for (uint32_t i = 0; i < atlas->animation_count; i++)
+    {
+        const IsoAtlasAnimation* animation = &atlas->animations[i];
+        uint64_t step = (uint64_t)(time / animation->frame_time);
+        atlas->lookup[animation->tile] = atlas->sequence[animation->first + step % animation->count];
+    }
+}
+
+uint32_t isoAtlasTileAnimation(const IsoAtlas* atlas, uint32_t tile)
+{
+    if (!atlas->tile_animation || tile >= atlas->tile_count) return 0;
+    return atlas->tile_animation[tile];
+}
+
+/* ---------------------------------------------------------------------------
+ * skyline packer
+ */
+typedef struct
+{
+    uint32_t x, y, w;
+} IsoSkylineNode;
+
+static int isoSkylineFit(const IsoSkylineNode* nodes, uint32_t count, uint32_t i, uint32_t w, uint32_t h, uint32_t width, uint32_t height, uint32_t* y)
+{
+    if (nodes[i].x + w > width) return 0;
+
+    // the rect rests on the highest node it spans
+    uint32_t top = nodes[i].y;
+    uint32_t left = w;
+    for (uint32_t j = i; left > 0 && j < count; j++)
+    {
+        if (nodes[j].y > top) top = nodes[j].y;
+        if (top + h > height) return 0;
+        left -= nodes[j].w < left ? nodes[j].w : left;
+    }
+
+    *y = top;
+    return 1;
+}
+
+static void isoSkylineInsert(IsoSkylineNode* nodes, uint32_t* count, uint32_t i, uint32_t x, uint32_t y, uint32_t w)
+{
+    memmove(nodes + i + 1, nodes + i, (*count - i) * sizeof(IsoSkylineNode));
+    nodes[i] = (IsoSkylineNode){ x, y, w };
+    (*count)++;
+
+    // cut the nodes now covered by the new one
+    uint32_t end = x + w;
+    uint32_t j = i + 1;
+    while (j < *count && nodes[j].x < end)
+    {
+        uint32_t covered = end - nodes[j].x;
+        if (covered < nodes[j].w)
+        {
+            nodes[j].x += covered;
+            nodes[j].w -= covered;
+            break;
+        }
+
+        memmove(nodes + j, nodes + j + 1, (*count - j - 1) * sizeof(IsoSkylineNode));
+        (*count)--;
+    }
+
+    // merge neighbours at the same height
+    for (uint32_t k = 0; k + 1 < *count;)
+    {
+        if (nodes[k].y == nodes[k + 1].y)
+        {
+            nodes[k].w += nodes[k + 1].w;
+            memmove(nodes + k + 1, nodes + k + 2, (*count - k - 2) * sizeof(IsoSkylineNode));
+            (*count)--;
+        }
+        else k++;
+    }
+}
+
+static int isoAtlasPackInto(IsoAtlasFrame* frames, const uint64_t* order, uint32_t count, uint32_t padding,
+                            uint32_t width, uint32_t height, IsoSkylineNode* nodes)
+{
+    uint32_t node_count = 1;
+    nodes[0] = (IsoSkylineNode){ 0, 0, width };
+
+    for (uint32_t n = 0; n < count; n++)
+    {
+        IsoAtlasFrame* frame = &frames[(uint32_t)order[n]];
+        uint32_t w = frame->w + padding;
+        uint32_t h = frame->h + padding;
+
+        // lowest position first, leftmost on ties
+        uint32_t best = UINT32_MAX, best_y = UINT32_MAX;
+        for (uint32_t i = 0; i < node_count; i++)
+        {
+            uint32_t y;
+            if (isoSkylineFit(nodes, node_count, i, w, h, width, height, &y) && y < best_y)
+            {
+                best = i;
+                best_y = y;
+            }
+        }
+
+        if (best == UINT32_MAX) return 0;
+
+        frame->x = nodes[best].x;
+        frame->y = best_y;
+        isoSkylineInsert(nodes, &node_count, best, frame->x, best_y + h, w);
+    }
+
+    return 1;
+}
+
+static int isoAtlasCompareOrder(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t isoAtlasPow2(uint32_t value)
+{
+    uint32_t pow2 = 1;
+    while (pow2 < value) pow2 <<= 1;
+    return pow2;
+}
+
+int isoAtlasPack(IsoAtlasFrame* frames, uint32_t count, uint32_t padding, uint32_t max_size, uint32_t* width, uint32_t* height)
+{
+    if (max_size > 0xffff) max_size = 0xffff;
+
+    // tallest first, then widest; the index rides in the low bits
+    uint64_t* order = isoMalloc(ISO_MEM_RENDER, (count ? count : 1) * sizeof(uint64_t));
+    IsoSkylineNode* nodes = isoMalloc(ISO_MEM_RENDER, (count + 1) * sizeof(IsoSkylineNode));
+    if (!order || !nodes)
+    {
+        isoFree(order);
+        isoFree(nodes);
+        return 0;
+    }
+
+    uint64_t area = 0;
+    uint32_t min_w = 1, min_h = 1;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t w = frames[i].w + padding;
+        uint32_t h = frames[i].h + padding;
+        if (w > max_size || h > max_size)
+        {
+            isoFree(order);
+            isoFree(nodes);
+            return 0;
+        }
+
+        order[i] = ((uint64_t)(0xffff - h) << 48) | ((uint64_t)(0xffff - w) << 32) | i;
+        area += (uint64_t)w * h;
+        if (w > min_w) min_w = w;
+        if (h > min_h) min_h = h;
+    }
+    qsort(order, count, sizeof(uint64_t), isoAtlasCompareOrder);
+
+    // the smallest square or 2:1 power of two that holds the area
+    uint32_t side = isoAtlasPow2((uint32_t)ceil(sqrt((double)area)));
+    uint32_t w = side;
+    uint32_t h = (uint64_t)side * (side / 2) >= area ? side / 2 : side;
+    if (w < isoAtlasPow2(min_w)) w = isoAtlasPow2(min_w);
+    if (h < isoAtlasPow2(min_h)) h = isoAtlasPow2(min_h);
+
+    int result = 0;
+    while (w <= max_size && h <= max_size)
+    {
+        if (isoAtlasPackInto(frames, order, count, padding, w, h, nodes))
+        {
+            result = 1;
+            break;
+        }
+
+        // grow the shorter side
+        if (w <= h) w <<= 1;
+        else        h <<= 1;
+    }
+
+    isoFree(order);
+    isoFree(nodes);
+    if (!result) return 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        IsoAtlasFrame* frame = &frames[i];
+        frame->src = (IgnisRect){
+            (float)frame->x / w, (float)frame->y / h,
+            (float)frame->w / w, (float)frame->h / h
+        };
+    }
+
+    *width = w;
+    *height = h;
+    return 1;
+}
@@ -0,0 +1,90 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <Ignis/Ignis.h>
+
+#include <stdint.h>
+
+#define ISO_ATLAS_NAME_MAX      32
+#define ISO_ATLAS_NONE          UINT32_MAX
+#define ISO_ATLAS_ANIMATION_MAX 16 /* per atlas, see res/shaders/batch.vert */
+
+typedef struct
+{
+    char name[ISO_ATLAS_NAME_MAX];
+    uint32_t x, y; /* pixels */
+    uint32_t w, h;
+    IgnisRect src; /* normalized, for ignisBatch2DRenderTextureSrc and vertex uvs */
+} IsoAtlasFrame;
+
+/* a tile cycling through count frames of sequence, starting at first */
+typedef struct
+{
+    uint32_t tile;
+    uint32_t first;
+    uint32_t count;
+    float frame_time; /* seconds */
+} IsoAtlasAnimation;
+
+/*
+ * Frames of a texture, either packed rects (see atlasfile.h) or a uniform
+ * grid. lookup maps tile ids to frames, tiles without a frame are not drawn.
+ *
+ * Animated tiles keep their id in the map, isoAtlasAnimate points their
+ * lookup at the current frame once per frame. Cached geometry marks animated
+ * quads instead (see isoMapTileQuad) and the vertex shader picks the frame,
+ * so animation never touches the tiles or the cache.
+ */
+typedef struct
+{
+    IgnisTexture2D texture;
+    uint8_t* pixels; /* rgba copy of the texture for rendering on the cpu, may be NULL */
+
+    IsoAtlasFrame* frames;
+    uint32_t frame_count;
+
+    uint32_t* lookup;
+    uint32_t tile_count;
+
+    IsoAtlasAnimation animations[ISO_ATLAS_ANIMATION_MAX];
+    uint32_t animation_count;
+    uint32_t* sequence;       /* frame indices of all animations */
+    uint32_t sequence_count;
+    uint32_t* tile_animation; /* per tile, index + 1 or 0, NULL without animations */
+} IsoAtlas;
+
+/* columns * rows frames of texture, tile ids are frame indices */
+int isoAtlasInitGrid(IsoAtlas* atlas, IgnisTexture2D texture);
+
+/* frees the tables and pixels, the texture is left to its owner */
+void isoAtlasDestroy(IsoAtlas* atlas);
+
+uint32_t isoAtlasFind(const IsoAtlas* atlas, const char* name);
+
+/* tile i is drawn with the frame called names[i], NULL or unknown names are not drawn. Drops all animations */
+int isoAtlasSetTiles(IsoAtlas* atlas, const char* const* names, uint32_t count);
+
+/*
+ * Animates tile through the frames called names, unknown names are skipped.
+ * Returns 0 if the tile has no lookup entry, is already animated, none of the
+ * names is known or the table is full.
+ */
+int isoAtlasAddAnimation(IsoAtlas* atlas, uint32_t tile, const char* const* names, uint32_t count, float frame_time);
+
+/* points animated tiles at their frame for time in seconds since any fixed start */
+void isoAtlasAnimate(IsoAtlas* atlas, double time);
+
+/* index + 1 of the animation of a tile, 0 if it is not animated */
+uint32_t isoAtlasTileAnimation(const IsoAtlas* atlas, uint32_t tile);
+
+/* NULL if the tile has no frame */
+const IsoAtlasFrame* isoAtlasTileFrame(const IsoAtlas* atlas, uint32_t tile);
+
+/*
+ * Skyline bottom-left packing of the frames' w * h plus padding into the
+ * smallest power of two texture, at most max_size on each side. Sets x, y
+ * and src of every frame. Returns 0 if they do not fit.
+ */
+int isoAtlasPack(IsoAtlasFrame* frames, uint32_t count, uint32_t padding, uint32_t max_size, uint32_t* width, uint32_t* height);
+
+#endif // !ATLAS_H
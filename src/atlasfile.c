@@ -0,0 +1,380 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "atlasfile.h"
+#include "alloc.h"
+
+#include "mapfile.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int isoAtlasAddName(char*** names, uint32_t* count, uint32_t* capacity, const char* name)
+{
+    if (*count == *capacity)
+    {
+        uint32_t grown = *capacity ? *capacity * 2 : 64;
+        char** resized = isoRealloc(ISO_MEM_RENDER, *names, grown * sizeof(char*));
+        if (!resized) return 0;
+
+        *names = resized;
+        *capacity = grown;
+    }
+
+    size_t length = strlen(name) + 1;
+    char* copy = isoMalloc(ISO_MEM_RENDER, length);
+    if (!copy) return 0;
+
+    memcpy(copy, name, length);
+    (*names)[(*count)++] = copy;
+    return 1;
+}
+
+#ifdef _WIN32
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+static char** isoAtlasListDir(const char* dir, uint32_t* count)
+{
+    char pattern[MAX_PATH];
+    snprintf(pattern, sizeof(pattern), "%s\\*.png", dir);
+
+    char** names = NULL;
+    uint32_t capacity = 0;
+    *count = 0;
+
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA(pattern, &data);
+    if (find == INVALID_HANDLE_VALUE) return NULL;
+
+    do
+    {
+        if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && !isoAtlasAddName(&names, count, &capacity, data.cFileName))
+            break;
+    } while (FindNextFileA(find, &data));
+
+    FindClose(find);
+    return names;
+}
+
+#else
+
+#include <dirent.h>
+
+static char** isoAtlasListDir(const char* dir, uint32_t* count)
+{
+    char** names = NULL;
+    uint32_t capacity = 0;
+    *count = 0;
+
+    DIR* handle = opendir(dir);
+    if (!handle) return NULL;
+
+    struct dirent* entry;
+    while ((entry = readdir(handle)) != NULL)
+    {
+        size_t length = strlen(entry->d_name);
+        if (length <= 4 || strcmp(entry->d_name + length - 4, ".png") != 0) continue;
+        if (!isoAtlasAddName(&names, count, &capacity, entry->d_name)) break;
+    }
+
+    closedir(handle);
+    return names;
+}
+
+#endif
+
+static void isoAtlasFreeNames(char** names, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+        isoFree(names[i]);
+    isoFree(names);
+}
+
+static int isoAtlasCompareNames(const void* a, const void* b)
+{
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+/* FNV-1a */
+static uint64_t isoAtlasHash(uint64_t hash, const uint8_t* data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= data[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+/* hashes names and contents of the sources, without decoding them */
+static int isoAtlasSourceKey(const char* dir, char** names, uint32_t count, uint64_t* key)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    char path[1024];
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        snprintf(path, sizeof(path), "%s/%s", dir, names[i]);
+
+        IsoMappedFile* file = isoFileMap(path);
+        if (!file) return 0;
+
+        hash = isoAtlasHash(hash, (const uint8_t*)names[i], strlen(names[i]) + 1);
+        hash = isoAtlasHash(hash, isoMappedFileData(file), (size_t)isoMappedFileSize(file));
+        isoFileUnmap(file);
+    }
+
+    *key = hash;
+    return 1;
+}
+
+static int isoAtlasUpload(IsoAtlas* atlas, uint32_t width, uint32_t height, const void* pixels)
+{
+    GLuint name;
+    glGenTextures(1, &name);
+    if (!name) return 0;
+
+    glBindTexture(GL_TEXTURE_2D, name);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, (GLsizei)width, (GLsizei)height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    atlas->texture = (IgnisTexture2D){ 0 };
+    atlas->texture.name = name;
+    atlas->texture.width = (GLint)width;
+    atlas->texture.height = (GLint)height;
+    atlas->texture.rows = 1;
+    atlas->texture.columns = 1;
+    return 1;
+}
+
+static void isoAtlasFrameSrc(IsoAtlasFrame* frame, uint32_t width, uint32_t height)
+{
+    frame->src = (IgnisRect){
+        (float)frame->x / width, (float)frame->y / height,
+        (float)frame->w / width, (float)frame->h / height
+    };
+}
+
+static int isoAtlasReadCache(IsoAtlas* atlas, const char* path, uint64_t key)
+{
+    IsoMappedFile* file = isoFileMap(path);
+    if (!file) return 0;
+
+    const uint8_t* data = isoMappedFileData(file);
+    uint64_t size = isoMappedFileSize(file);
+    const IsoAtlasCacheHeader* header = (const IsoAtlasCacheHeader*)data;
+
+    int valid = size >= sizeof(IsoAtlasCacheHeader)
+        && header->magic == ISO_ATLAS_CACHE_MAGIC && header->version == ISO_ATLAS_CACHE_VERSION && header->key == key
+        && header->width <= ISO_ATLAS_MAX_SIZE && header->height <= ISO_ATLAS_MAX_SIZE
+        && size == sizeof(IsoAtlasCacheHeader) + (uint64_t)header->frame_count * sizeof(IsoAtlasCacheFrame)
+                   + (uint64_t)header->width * header->height * 4;
+
+    if (valid) atlas->frames = isoCalloc(ISO_MEM_RENDER, header->frame_count ? header->frame_count : 1, sizeof(IsoAtlasFrame));
+    if (!valid || !atlas->frames)
+    {
+        isoFileUnmap(file);
+        return 0;
+    }
+
+    const IsoAtlasCacheFrame* frames = (const IsoAtlasCacheFrame*)(header + 1);
+    for (uint32_t i = 0; i < header->frame_count; i++)
+    {
+        IsoAtlasFrame* frame = &atlas->frames[i];
+        memcpy(frame->name, frames[i].name, ISO_ATLAS_NAME_MAX);
+        frame->name[ISO_ATLAS_NAME_MAX - 1] = '\0';
+        frame->x = frames[i].x;
+        frame->y = frames[i].y;
+        frame->w = frames[i].w;
+        frame->h = frames[i].h;
+        isoAtlasFrameSrc(frame, header->width, header->height);
+    }
+    atlas->frame_count = header->frame_count;
+
+    // straight from the mapping, nothing is decoded
+    size_t bytes = (size_t)header->width * header->height * 4;
+    atlas->pixels = isoMalloc(ISO_MEM_RENDER, bytes ? bytes : 1);
+    int result = atlas->pixels && isoAtlasUpload(atlas, header->width, header->height, frames + header->frame_count);
+    if (result) memcpy(atlas->pixels, frames + header->frame_count, bytes);
+    isoFileUnmap(file);
+
+    if (!result)
+    {
+        isoFree(atlas->pixels);
+        isoFree(atlas->frames);
+        atlas->pixels = NULL;
+        atlas->frames = NULL;
+        atlas->frame_count = 0;
+    }
+    return result;
+}
+
+static void isoAtlasWriteCache(const IsoAtlas* atlas, const char* path, uint64_t key, const uint8_t* pixels)
+{
+    FILE* file = fopen(path, "wb");
+    if (!file) return;
+
+    IsoAtlasCacheHeader header = {
+        .magic = ISO_ATLAS_CACHE_MAGIC,
+        .version = ISO_ATLAS_CACHE_VERSION,
+        .key = key,
+        .width = (uint32_t)atlas->texture.width,
+        .height = (uint32_t)atlas->texture.height,
+        .frame_count = atlas->frame_count
+    };
+
+    int result = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (uint32_t i = 0; i < atlas->frame_count && result; i++)
+    {
+        const IsoAtlasFrame* frame = &atlas->frames[i];
+        IsoAtlasCacheFrame entry = { { 0 }, frame->x, frame->y, frame->w, frame->h };
+        memcpy(entry.name, frame->name, ISO_ATLAS_NAME_MAX);
+        result = fwrite(&entry, sizeof(entry), 1, file) == 1;
+    }
+
+    size_t bytes = (size_t)header.width * header.height * 4;
+    if (result) result = fwrite(pixels, 1, bytes, file) == bytes;
+
+    // a partial cache would only be rejected later
+    if (fclose(file) != 0 || !result) remove(path);
+}
+
+/* decodes through Ignis and reads the pixels back */
+static uint8_t* isoAtlasDecode(const char* path, uint32_t* width, uint32_t* height)
+{
+    IgnisTexture2D image;
+    if (!ignisCreateTexture2D(&image, path, 1, 1, 0, NULL)) return NULL;
+
+    uint8_t* pixels = isoMalloc(ISO_MEM_RENDER, (size_t)image.width * image.height * 4);
+    if (pixels)
+    {
+        glBindTexture(GL_TEXTURE_2D, image.name);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        *width = (uint32_t)image.width;
+        *height = (uint32_t)image.height;
+    }
+
+    ignisDeleteTexture2D(&image);
+    return pixels;
+}
+
+static int isoAtlasPackSources(IsoAtlas* atlas, const char* dir, char** names, uint32_t count, uint8_t** out)
+{
+    atlas->frames = isoCalloc(ISO_MEM_RENDER, count ? count : 1, sizeof(IsoAtlasFrame));
+    uint8_t** images = isoCalloc(ISO_MEM_RENDER, count ? count : 1, sizeof(uint8_t*));
+    if (!atlas->frames || !images)
+    {
+        isoFree(images);
+        return 0;
+    }
+    atlas->frame_count = count;
+
+    int result = 1;
+    char path[1024];
+    for (uint32_t i = 0; i < count && result; i++)
+    {
+        IsoAtlasFrame* frame = &atlas->frames[i];
+
+        // names without the extension
+        size_t length = strlen(names[i]) - 4;
+        if (length >= ISO_ATLAS_NAME_MAX) length = ISO_ATLAS_NAME_MAX - 1;
+        memcpy(frame->name, names[i], length);
+
+        snprintf(path, sizeof(path), "%s/%s", dir, names[i]);
+        images[i] = isoAtlasDecode(path, &frame->w, &frame->h);
+        result = images[i] != NULL;
+    }
+
+    uint32_t width = 0, height = 0;
+    if (result) result = isoAtlasPack(atlas->frames, count, ISO_ATLAS_PADDING, ISO_ATLAS_MAX_SIZE, &width, &height);
+
+    uint8_t* pixels = result ? isoCalloc(ISO_MEM_RENDER, (size_t)width * height, 4) : NULL;
+    if (pixels)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const IsoAtlasFrame* frame = &atlas->frames[i];
+            for (uint32_t y = 0; y < frame->h; y++)
+            {
+                memcpy(pixels + ((size_t)(frame->y + y) * width + frame->x) * 4,
+                       images[i] + (size_t)y * frame->w * 4, (size_t)frame->w * 4);
+            }
+        }
+        result = isoAtlasUpload(atlas, width, height, pixels);
+    }
+    else result = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+        isoFree(images[i]);
+    isoFree(images);
+
+    if (!result)
+    {
+        isoFree(pixels);
+        return 0;
+    }
+
+    *out = pixels;
+    return 1;
+}
+
+int isoAtlasLoad(IsoAtlas* atlas, const char* dir, const char* cache_path)
+{
+    memset(atlas, 0, sizeof(IsoAtlas));
+
+    uint32_t count;
+    char** names = isoAtlasListDir(dir, &count);
+    if (!names) return 0;
+
+    qsort(names, count, sizeof(char*), isoAtlasCompareNames);
+
+    uint64_t key = 0;
+    int result = isoAtlasSourceKey(dir, names, count, &key);
+
+    if (result && cache_path && isoAtlasReadCache(atlas, cache_path, key))
+    {
+        result = ISO_ATLAS_CACHED;
+    }
+    else if (result)
+    {
+        uint8_t* pixels = NULL;
+        result = isoAtlasPackSources(atlas, dir, names, count, &pixels) ? ISO_ATLAS_PACKED : 0;
+
+        if (result && cache_path) isoAtlasWriteCache(atlas, cache_path, key, pixels);
+        atlas->pixels = pixels;
+    }
+
+    isoAtlasFreeNames(names, count);
+
+    // tile ids are frame indices until isoAtlasSetTiles
+    if (result) atlas->lookup = isoMalloc(ISO_MEM_RENDER, (atlas->frame_count ? atlas->frame_count : 1) * sizeof(uint32_t));
+    if (result && atlas->lookup)
+    {
+        for (uint32_t i = 0; i < atlas->frame_count; i++)
+            atlas->lookup[i] = i;
+        atlas->tile_count = atlas->frame_count;
+        return result;
+    }
+
+    isoAtlasUnload(atlas);
+    return 0;
+}
+
+void isoAtlasUnload(IsoAtlas* atlas)
+{
+    if (atlas->texture.name) glDeleteTextures(1, &atlas->texture.name);
+    atlas->texture = (IgnisTexture2D){ 0 };
+    isoAtlasDestroy(atlas);
+}
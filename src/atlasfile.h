@@ -0,0 +1,52 @@
+#ifndef ATLASFILE_H
+#define ATLASFILE_H
+
+#include "atlas.h"
+
+/*
+ * Atlas built from a directory of png files, one frame per file named
+ * after it without the extension, in name order. The packed result is kept
+ * in a cache file:
+ *
+ *   header  IsoAtlasCacheHeader
+ *   frames  frame_count IsoAtlasCacheFrame
+ *   pixels  width * height rgba
+ *
+ * key hashes the names and bytes of the sources, while it matches later
+ * loads skip decoding and packing and upload the cached pixels as they are.
+ */
+#define ISO_ATLAS_CACHE_MAGIC   0x41534f49 /* "ISOA" */
+#define ISO_ATLAS_CACHE_VERSION 1
+
+#define ISO_ATLAS_PADDING  1
+#define ISO_ATLAS_MAX_SIZE 8192
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t width;
+    uint32_t height;
+    uint32_t frame_count;
+    uint32_t reserved;
+} IsoAtlasCacheHeader;
+
+typedef struct
+{
+    char name[ISO_ATLAS_NAME_MAX];
+    uint32_t x, y;
+    uint32_t w, h;
+} IsoAtlasCacheFrame;
+
+#define ISO_ATLAS_PACKED 1
+#define ISO_ATLAS_CACHED 2
+
+/*
+ * Returns ISO_ATLAS_CACHED or ISO_ATLAS_PACKED, 0 on failure. cache_path may
+ * be NULL to always pack. The texture is owned by the atlas.
+ */
+int isoAtlasLoad(IsoAtlas* atlas, const char* dir, const char* cache_path);
+void isoAtlasUnload(IsoAtlas* atlas);
+
+#endif // !ATLASFILE_H
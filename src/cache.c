@@ -0,0 +1,581 @@
+#include "cache.h"
+#include "layer.h"
+#include "alloc.h"
+#include "occlusion.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ISO_CACHE_SLOT_QUADS ISO_CHUNK_TILES
+
+/* raised chunks need more quads, up to what 16 bit indices can reach */
+#define ISO_CACHE_MAX_QUADS (65536 / ISO_QUAD_VERTICES)
+
+static void isoMapCacheVertexLayout()
+{
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(IsoVertex), (void*)offsetof(IsoVertex, x));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(IsoVertex), (void*)offsetof(IsoVertex, u));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(IsoVertex), (void*)offsetof(IsoVertex, texture));
+}
+
+static int isoMapCacheCreateSlot(IsoMapCache* cache, IsoCacheSlot* slot)
+{
+    glGenVertexArrays(1, &slot->vao);
+    glBindVertexArray(slot->vao);
+
+    glGenBuffers(1, &slot->vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, slot->vbo);
+    glBufferData(GL_ARRAY_BUFFER, ISO_CACHE_SLOT_QUADS * ISO_QUAD_VERTICES * sizeof(IsoVertex), NULL, GL_STATIC_DRAW);
+
+    isoMapCacheVertexLayout();
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cache->ibo);
+
+    glBindVertexArray(0);
+
+    slot->chunk = 0;
+    slot->version = 0;
+    slot->quads = 0;
+    slot->capacity = ISO_CACHE_SLOT_QUADS;
+    slot->last_used = 0;
+
+    return slot->vao && slot->vbo;
+}
+
+int isoMapCacheInit(IsoMapCache* cache, const IsoMap* map, const char* vert, const char* frag, uint32_t slots)
+{
+    memset(cache, 0, sizeof(IsoMapCache));
+
+    if (!ignisCreateShadervf(&cache->shader, vert, frag))
+        return 0;
+
+    cache->uniform_view_projection = glGetUniformLocation(cache->shader.program, "u_ViewProjection");
+    cache->view_projection = mat4_indentity();
+
+    for (uint32_t i = 0; i < ISO_TEXTURE_UNITS; i++)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "u_Frames[%u]", i * ISO_ATLAS_ANIMATION_MAX);
+        cache->uniform_frames[i] = glGetUniformLocation(cache->shader.program, name);
+    }
+
+    // layer i samples texture unit i
+    GLint units[ISO_LAYER_MAX];
+    for (GLint i = 0; i < ISO_LAYER_MAX; i++)
+        units[i] = i;
+
+    glUseProgram(cache->shader.program);
+    glUniform1iv(glGetUniformLocation(cache->shader.program, "u_Textures"), ISO_LAYER_MAX, units);
+    glUseProgram(0);
+
+    cache->chunk_count = map->chunk_cols * map->chunk_rows;
+    cache->slot_count = slots;
+
+    cache->slots = isoCalloc(ISO_MEM_RENDER, slots, sizeof(IsoCacheSlot));
+    cache->lookup = isoMalloc(ISO_MEM_RENDER, cache->chunk_count * sizeof(int32_t));
+    cache->vertices = isoMalloc(ISO_MEM_RENDER, ISO_CACHE_SLOT_QUADS * ISO_QUAD_VERTICES * sizeof(IsoVertex));
+    cache->vertex_capacity = ISO_CACHE_SLOT_QUADS;
+
+    if (!cache->slots || !cache->lookup || !cache->vertices)
+    {
+        isoMapCacheDestroy(cache);
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < cache->chunk_count; i++)
+        cache->lookup[i] = -1;
+
+    // every slot shares one index buffer since all quads are laid out the same
+    size_t mark = isoFrameMark();
+    GLushort* indices = isoFrameAlloc(ISO_CACHE_MAX_QUADS * ISO_QUAD_INDICES * sizeof(GLushort));
+    if (!indices)
+    {
+        isoMapCacheDestroy(cache);
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < ISO_CACHE_MAX_QUADS; i++)
+    {
+        GLushort offset = (GLushort)(i * ISO_QUAD_VERTICES);
+        GLushort* quad = indices + i * ISO_QUAD_INDICES;
+
+        quad[0] = offset + 0;
+        quad[1] = offset + 1;
+        quad[2] = offset + 2;
+        quad[3] = offset + 2;
+        quad[4] = offset + 3;
+        quad[5] = offset + 0;
+    }
+
+    glGenBuffers(1, &cache->ibo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cache->ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, ISO_CACHE_MAX_QUADS * ISO_QUAD_INDICES * sizeof(GLushort), indices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    isoFrameRelease(mark);
+
+    for (uint32_t i = 0; i < slots; i++)
+    {
+        if (!isoMapCacheCreateSlot(cache, &cache->slots[i]))
+        {
+            isoMapCacheDestroy(cache);
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+void isoMapCacheDestroy(IsoMapCache* cache)
+{
+    if (cache->slots)
+    {
+        for (uint32_t i = 0; i < cache->slot_count; i++)
+        {
+            glDeleteBuffers(1, &cache->slots[i].vbo);
+            glDeleteVertexArrays(1, &cache->slots[i].vao);
+        }
+        isoFree(cache->slots);
+    }
+
+    if (cache->ibo) glDeleteBuffers(1, &cache->ibo);
+
+    if (cache->stream_vao)
+    {
+        glDeleteBuffers(1, &cache->stream_vbo);
+        glDeleteBuffers(1, &cache->stream_ibo);
+        glDeleteVertexArrays(1, &cache->stream_vao);
+    }
+    if (cache->impostor_texture) glDeleteTextures(1, &cache->impostor_texture);
+    if (cache->words_vao)
+    {
+        glDeleteBuffers(1, &cache->words_vbo);
+        glDeleteVertexArrays(1, &cache->words_vao);
+    }
+    if (cache->stream_shader.program) ignisDeleteShader(&cache->stream_shader);
+    if (cache->lookup) isoFree(cache->lookup);
+    if (cache->vertices) isoFree(cache->vertices);
+
+    ignisDeleteShader(&cache->shader);
+
+    memset(cache, 0, sizeof(IsoMapCache));
+}
+
+void isoMapCacheInvalidate(IsoMapCache* cache)
+{
+    for (uint32_t i = 0; i < cache->slot_count; i++)
+    {
+        IsoCacheSlot* slot = &cache->slots[i];
+        if (slot->last_used) cache->lookup[slot->chunk] = -1;
+
+        slot->quads = 0;
+        slot->last_used = 0;
+    }
+}
+
+void isoMapCacheSetViewProjection(IsoMapCache* cache, const float* view_projection)
+{
+    memcpy(cache->view_projection.v, view_projection, sizeof(mat4));
+}
+
+static void isoMapCacheBuild(IsoMapCache* cache, const IsoLayerStack* layers, IsoCacheSlot* slot, uint32_t index)
+{
+    const IsoMap* map = layers->layers[0].map;
+
+    uint32_t col_min = (index % map->chunk_cols) << ISO_CHUNK_SHIFT;
+    uint32_t row_min = (index / map->chunk_cols) << ISO_CHUNK_SHIFT;
+
+    uint32_t cols = map->width - col_min < ISO_CHUNK_SIZE ? map->width - col_min : ISO_CHUNK_SIZE;
+    uint32_t rows = map->height - row_min < ISO_CHUNK_SIZE ? map->height - row_min : ISO_CHUNK_SIZE;
+
+    // only tiles of the chunk itself occlude, so the result does not depend on the view
+    size_t mark = isoFrameMark();
+    IsoOcclusion occlusion = { 0 };
+    uint32_t capacity = ISO_CACHE_SLOT_QUADS;
+    if (map->max_elevation && isoOcclusionBuild(&occlusion, map, layers->layers[0].texture_atlas, NULL, col_min, row_min, col_min + cols - 1, row_min + rows - 1))
+        capacity = occlusion.levels - occlusion.levels_culled;
+
+    // upper static layers are never culled
+    for (uint32_t i = 1; i < layers->count; i++)
+    {
+        const IsoTileLayer* layer = &layers->layers[i];
+        const IsoChunk* chunk = &layer->map->chunks[index];
+        if (!(layer->mode & ISO_LAYER_STATIC) || (!chunk->tiles && chunk->value == ISO_TILE_EMPTY))
+            continue;
+
+        capacity += cols * rows * (layer->map->max_elevation + 1);
+    }
+    if (capacity > ISO_CACHE_MAX_QUADS) capacity = ISO_CACHE_MAX_QUADS;
+
+    // room for the last tile to spill over the capacity
+    uint32_t tile_quads = isoLayerStackMaxQuads(layers, ISO_LAYER_STATIC);
+    if (capacity + tile_quads > cache->vertex_capacity)
+    {
+        IsoVertex* vertices = isoRealloc(ISO_MEM_RENDER, cache->vertices, (size_t)(capacity + tile_quads) * ISO_QUAD_VERTICES * sizeof(IsoVertex));
+        if (vertices)
+        {
+            cache->vertices = vertices;
+            cache->vertex_capacity = capacity + tile_quads;
+        }
+    }
+    if (capacity + tile_quads > cache->vertex_capacity)
+        capacity = cache->vertex_capacity > tile_quads ? cache->vertex_capacity - tile_quads : 0;
+
+    // levels beyond the capacity are dropped
+    uint32_t quads = 0;
+    for (uint32_t y = 0; y < rows && quads < capacity; y++)
+    {
+        for (uint32_t x = 0; x < cols && quads < capacity; x++)
+        {
+            uint32_t col = col_min + x, row = row_min + y;
+            uint32_t first = isoOcclusionFirst(&occlusion, col, row);
+            quads += isoLayerTileQuads(layers, col, row, first, ISO_LAYER_STATIC, cache->vertices + (size_t)quads * ISO_QUAD_VERTICES);
+        }
+    }
+    if (quads > capacity) quads = capacity;
+
+    isoFrameRelease(mark);
+
+    if (quads)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, slot->vbo);
+        if (quads > slot->capacity)
+        {
+            glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)quads * ISO_QUAD_VERTICES * sizeof(IsoVertex), cache->vertices, GL_STATIC_DRAW);
+            slot->capacity = quads;
+        }
+        else
+        {
+            glBufferSubData(GL_ARRAY_BUFFER, 0, quads * ISO_QUAD_VERTICES * sizeof(IsoVertex), cache->vertices);
+        }
+    }
+
+    slot->quads = quads;
+    slot->version = isoLayerStackChunkVersion(layers, index);
+
+    cache->chunks_rebuilt++;
+}
+
+static IsoCacheSlot* isoMapCacheFetch(IsoMapCache* cache, const IsoLayerStack* layers, uint32_t index)
+{
+    IsoCacheSlot* slot = NULL;
+    if (cache->lookup[index] >= 0)
+    {
+        slot = &cache->slots[cache->lookup[index]];
+        if (slot->version != isoLayerStackChunkVersion(layers, index))
+            isoMapCacheBuild(cache, layers, slot, index);
+    }
+    else
+    {
+        // evict the least recently used slot
+        uint32_t lru = 0;
+        for (uint32_t i = 1; i < cache->slot_count; i++)
+        {
+            if (cache->slots[i].last_used < cache->slots[lru].last_used)
+                lru = i;
+        }
+
+        slot = &cache->slots[lru];
+        if (slot->last_used) cache->lookup[slot->chunk] = -1;
+
+        slot->chunk = index;
+        cache->lookup[index] = (int32_t)lru;
+
+        isoMapCacheBuild(cache, layers, slot, index);
+    }
+
+    slot->last_used = cache->frame;
+    return slot;
+}
+
+/* map space to clip space */
+static mat4 isoMapCacheModelViewProjection(const IsoMapCache* cache, const IsoMap* map)
+{
+    mat4 model = mat4_translate(mat4_indentity(), (vec3) { map->origin.x, map->origin.y, 0.0f });
+    mat4 mvp;
+    psmat4_multiply(&mvp, &cache->view_projection, &model);
+    return mvp;
+}
+
+static void isoMapCacheBindShader(IsoMapCache* cache, const IsoLayerStack* layers)
+{
+    mat4 mvp = isoMapCacheModelViewProjection(cache, layers->layers[0].map);
+
+    glUseProgram(cache->shader.program);
+    glUniformMatrix4fv(cache->uniform_view_projection, 1, GL_FALSE, mvp.v);
+
+    for (uint32_t i = 0; i < layers->count; i++)
+    {
+        const IsoAtlas* atlas = layers->layers[i].texture_atlas;
+
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, atlas->texture.name);
+
+        if (!atlas->animation_count || cache->uniform_frames[i] < 0) continue;
+
+        // the lookup already points at the current frames
+        GLfloat frames[ISO_ATLAS_ANIMATION_MAX * 4];
+        for (uint32_t a = 0; a < atlas->animation_count; a++)
+        {
+            IgnisRect src = atlas->frames[atlas->lookup[atlas->animations[a].tile]].src;
+            frames[a * 4 + 0] = src.x;
+            frames[a * 4 + 1] = src.y;
+            frames[a * 4 + 2] = src.w;
+            frames[a * 4 + 3] = src.h;
+        }
+        glUniform4fv(cache->uniform_frames[i], atlas->animation_count, frames);
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+/* grows the stream buffers, the index buffer only changes with the capacity */
+static int isoMapCacheReserveStream(IsoMapCache* cache, uint32_t quads)
+{
+    if (quads <= cache->stream_capacity) return 1;
+
+    uint32_t capacity = quads + quads / 2;
+    size_t mark = isoFrameMark();
+    GLuint* indices = isoFrameAlloc((size_t)capacity * ISO_QUAD_INDICES * sizeof(GLuint));
+    if (!indices) return 0;
+
+    for (uint32_t i = 0; i < capacity; i++)
+    {
+        GLuint offset = i * ISO_QUAD_VERTICES;
+        GLuint* quad = indices + (size_t)i * ISO_QUAD_INDICES;
+
+        quad[0] = offset + 0;
+        quad[1] = offset + 1;
+        quad[2] = offset + 2;
+        quad[3] = offset + 2;
+        quad[4] = offset + 3;
+        quad[5] = offset + 0;
+    }
+
+    if (!cache->stream_vao)
+    {
+        glGenVertexArrays(1, &cache->stream_vao);
+        glGenBuffers(1, &cache->stream_vbo);
+        glGenBuffers(1, &cache->stream_ibo);
+    }
+
+    glBindVertexArray(cache->stream_vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, cache->stream_vbo);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)capacity * ISO_QUAD_VERTICES * sizeof(IsoVertex), NULL, GL_STREAM_DRAW);
+    isoMapCacheVertexLayout();
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cache->stream_ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)capacity * ISO_QUAD_INDICES * sizeof(GLuint), indices, GL_STATIC_DRAW);
+
+    glBindVertexArray(0);
+    isoFrameRelease(mark);
+
+    cache->stream_capacity = capacity;
+    return 1;
+}
+
+static void isoMapCacheDrawStream(IsoMapCache* cache, const IsoVertex* vertices, uint32_t quads)
+{
+    // orphan the old storage so the upload does not wait for the last draw
+    glBindBuffer(GL_ARRAY_BUFFER, cache->stream_vbo);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)cache->stream_capacity * ISO_QUAD_VERTICES * sizeof(IsoVertex), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)quads * ISO_QUAD_VERTICES * sizeof(IsoVertex), vertices);
+
+    glBindVertexArray(cache->stream_vao);
+    glDrawElements(GL_TRIANGLES, quads * ISO_QUAD_INDICES, GL_UNSIGNED_INT, NULL);
+
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
+
+void isoMapCacheRenderVertices(IsoMapCache* cache, const IsoLayerStack* layers, const IsoVertex* vertices, uint32_t quads)
+{
+    if (!quads || !isoMapCacheReserveStream(cache, quads))
+        return;
+
+    isoMapCacheBindShader(cache, layers);
+    isoMapCacheDrawStream(cache, vertices, quads);
+}
+
+void isoMapCacheRenderImpostors(IsoMapCache* cache, const IsoLayerStack* layers, IsoImpostorCache* impostors)
+{
+    if (!cache->impostor_texture)
+    {
+        glGenTextures(1, &cache->impostor_texture);
+        glBindTexture(GL_TEXTURE_2D, cache->impostor_texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, impostors->columns * ISO_IMPOSTOR_WIDTH, impostors->rows * ISO_IMPOSTOR_HEIGHT,
+                     0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, cache->impostor_texture);
+    for (uint32_t i = 0; i < impostors->upload_count; i++)
+    {
+        uint32_t slot = impostors->uploads[i];
+        glTexSubImage2D(GL_TEXTURE_2D, 0, (slot % impostors->columns) * ISO_IMPOSTOR_WIDTH, (slot / impostors->columns) * ISO_IMPOSTOR_HEIGHT,
+                        ISO_IMPOSTOR_WIDTH, ISO_IMPOSTOR_HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, isoImpostorPixels(impostors, slot));
+    }
+    impostors->upload_count = 0;
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (!impostors->quads || !isoMapCacheReserveStream(cache, impostors->quads))
+        return;
+
+    // the impostors take the place of layer 0, their pixels are premultiplied
+    isoMapCacheBindShader(cache, layers);
+    glBindTexture(GL_TEXTURE_2D, cache->impostor_texture);
+
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    isoMapCacheDrawStream(cache, impostors->vertices, impostors->quads);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+void isoMapCacheRender(IsoMapCache* cache, const IsoLayerStack* layers, rect view)
+{
+    const IsoMap* map = layers->layers[0].map;
+
+    cache->chunks_drawn = 0;
+    cache->chunks_rebuilt = 0;
+    cache->frame++;
+
+    IsoTileRange range;
+    if (!cache->slot_count || !isoLayerStackVisibleRange(layers, view, ISO_LAYER_STATIC, &range))
+        return;
+
+    isoMapCacheBindShader(cache, layers);
+
+    uint32_t chunk_row_min = range.row_min >> ISO_CHUNK_SHIFT;
+    uint32_t chunk_row_max = range.row_max >> ISO_CHUNK_SHIFT;
+
+    for (uint32_t chunk_row = chunk_row_min; chunk_row <= chunk_row_max; chunk_row++)
+    {
+        uint32_t row_min = chunk_row << ISO_CHUNK_SHIFT;
+        uint32_t row_max = row_min | ISO_CHUNK_MASK;
+
+        if (row_min < range.row_min) row_min = range.row_min;
+        if (row_max > range.row_max) row_max = range.row_max;
+
+        // union of the visible spans of all rows in this chunk row
+        uint32_t col_min = map->width, col_max = 0;
+        for (uint32_t row = row_min; row <= row_max; row++)
+        {
+            uint32_t min, max;
+            if (!isoTileRangeRow(map, &range, row, &min, &max))
+                continue;
+
+            if (min < col_min) col_min = min;
+            if (max > col_max) col_max = max;
+        }
+
+        if (col_min > col_max) continue;
+
+        for (uint32_t chunk_col = col_min >> ISO_CHUNK_SHIFT; chunk_col <= col_max >> ISO_CHUNK_SHIFT; chunk_col++)
+        {
+            uint32_t index = chunk_row * map->chunk_cols + chunk_col;
+
+            if (!isoLayerChunkUsed(layers, chunk_col << ISO_CHUNK_SHIFT, chunk_row << ISO_CHUNK_SHIFT, ISO_LAYER_STATIC))
+                continue;
+
+            IsoCacheSlot* slot = isoMapCacheFetch(cache, layers, index);
+            if (!slot->quads) continue;
+
+            glBindVertexArray(slot->vao);
+            glDrawElements(GL_TRIANGLES, slot->quads * ISO_QUAD_INDICES, GL_UNSIGNED_SHORT, NULL);
+
+            cache->chunks_drawn++;
+        }
+    }
+
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
+
+int isoMapCacheInitStream(IsoMapCache* cache, const char* vert, const char* frag)
+{
+    if (!ignisCreateShadervf(&cache->stream_shader, vert, frag))
+        return 0;
+
+    GLuint program = cache->stream_shader.program;
+    cache->uniform_stream_view_projection = glGetUniformLocation(program, "u_ViewProjection");
+    cache->uniform_stream_tile_size = glGetUniformLocation(program, "u_TileSize");
+    cache->uniform_stream_base = glGetUniformLocation(program, "u_Base");
+    cache->uniform_stream_frames = glGetUniformLocation(program, "u_Frames");
+    cache->uniform_stream_units = glGetUniformLocation(program, "u_Units");
+
+    GLint units[ISO_LAYER_MAX];
+    for (GLint i = 0; i < ISO_LAYER_MAX; i++)
+        units[i] = i;
+
+    glUseProgram(program);
+    glUniform1iv(glGetUniformLocation(program, "u_Textures"), ISO_LAYER_MAX, units);
+    glUseProgram(0);
+
+    return 1;
+}
+
+void isoMapCacheRenderStream(IsoMapCache* cache, const IsoLayerStack* layers, const IsoTileStream* stream)
+{
+    if (!cache->stream_shader.program || !stream->count)
+        return;
+
+    if (!cache->words_vao)
+    {
+        glGenVertexArrays(1, &cache->words_vao);
+        glGenBuffers(1, &cache->words_vbo);
+
+        glBindVertexArray(cache->words_vao);
+        glEnableVertexAttribArray(0);
+        glVertexAttribDivisor(0, 1);
+        glBindVertexArray(0);
+    }
+
+    // orphaned like the quad stream, a word is all a tile level uploads
+    if (stream->count > cache->words_capacity)
+        cache->words_capacity = stream->count + stream->count / 2;
+
+    glBindBuffer(GL_ARRAY_BUFFER, cache->words_vbo);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)cache->words_capacity * sizeof(uint32_t), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)stream->count * sizeof(uint32_t), stream->words);
+
+    mat4 mvp = isoMapCacheModelViewProjection(cache, layers->layers[0].map);
+
+    glUseProgram(cache->stream_shader.program);
+    glUniformMatrix4fv(cache->uniform_stream_view_projection, 1, GL_FALSE, mvp.v);
+    glUniform2f(cache->uniform_stream_tile_size, stream->tile_size, stream->tile_offset);
+
+    for (uint32_t i = 0; i < layers->count; i++)
+    {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, layers->layers[i].texture_atlas->texture.name);
+    }
+    glActiveTexture(GL_TEXTURE0);
+
+    glBindVertexArray(cache->words_vao);
+    for (uint32_t i = 0; i < stream->draw_count; i++)
+    {
+        const IsoTileStreamDraw* draw = &stream->draws[i];
+        if (!draw->count) continue;
+
+        GLint units[ISO_TILE_WORD_FRAMES];
+        for (uint32_t f = 0; f < draw->frame_count; f++)
+            units[f] = (GLint)draw->units[f];
+
+        glUniform2f(cache->uniform_stream_base, (float)draw->diff_base, (float)draw->sum_base);
+        glUniform4fv(cache->uniform_stream_frames, draw->frame_count, &draw->frames[0].x);
+        glUniform1iv(cache->uniform_stream_units, draw->frame_count, units);
+
+        // every quad is a strip of four corners generated from the word of its instance
+        glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, sizeof(uint32_t), (void*)((size_t)draw->first * sizeof(uint32_t)));
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, draw->count);
+    }
+
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
@@ -0,0 +1,101 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "iso.h"
+#include "layer.h"
+#include "impostor.h"
+#include "tilestream.h"
+
+/*
+ * Static terrain geometry. A cached chunk keeps its tile quads in a GPU buffer
+ * in map space and the origin is applied through the view projection, so
+ * moving the map never rebuilds anything. A chunk is rebuilt only when its
+ * version changes. Slots are recycled least recently used first. Levels of
+ * raised tiles hidden by other tiles of the same chunk are left out.
+ *
+ * The static layers of a stack are merged into the same chunk geometry, each
+ * one sampling its own texture unit. Dynamic layers are not cached. The current
+ * frames of animated tiles are uploaded with every render, see atlas.h.
+ *
+ * Geometry built every frame is streamed either as quads or, with the tile
+ * shader, as one word per tile level that is expanded on the GPU.
+ */
+typedef struct
+{
+    GLuint vao;
+    GLuint vbo;
+
+    uint32_t chunk;
+    uint32_t version; /* see isoLayerStackChunkVersion */
+    uint32_t quads;
+    uint32_t capacity; /* of the vbo in quads, grows for raised chunks */
+    uint32_t last_used;
+} IsoCacheSlot;
+
+typedef struct
+{
+    IgnisShader shader;
+    GLint uniform_view_projection;
+    GLint uniform_frames[ISO_TEXTURE_UNITS]; /* first animation frame of each unit */
+    mat4 view_projection;
+
+    GLuint ibo;
+
+    IsoCacheSlot* slots;
+    uint32_t slot_count;
+
+    int32_t* lookup; /* chunk index -> slot or -1 */
+    uint32_t chunk_count;
+
+    IsoVertex* vertices;
+    uint32_t vertex_capacity; /* in quads */
+    uint32_t frame;
+
+    /* buffers for geometry uploaded every frame */
+    GLuint stream_vao;
+    GLuint stream_vbo;
+    GLuint stream_ibo;
+    uint32_t stream_capacity; /* in quads */
+
+    GLuint impostor_texture; /* slots of an IsoImpostorCache */
+
+    /* instanced tile levels of an IsoTileStream, see isoMapCacheInitStream */
+    IgnisShader stream_shader;
+    GLint uniform_stream_view_projection;
+    GLint uniform_stream_tile_size;
+    GLint uniform_stream_base;
+    GLint uniform_stream_frames;
+    GLint uniform_stream_units;
+    GLuint words_vao;
+    GLuint words_vbo;
+    uint32_t words_capacity;
+
+    /* stats of the last render */
+    uint32_t chunks_drawn;
+    uint32_t chunks_rebuilt;
+} IsoMapCache;
+
+int isoMapCacheInit(IsoMapCache* cache, const IsoMap* map, const char* vert, const char* frag, uint32_t slots);
+void isoMapCacheDestroy(IsoMapCache* cache);
+
+/* drops all cached geometry, e.g. after switching the atlas */
+void isoMapCacheInvalidate(IsoMapCache* cache);
+
+void isoMapCacheSetViewProjection(IsoMapCache* cache, const float* view_projection);
+
+/* draws the static layers, layers must not change between calls except for their tiles */
+void isoMapCacheRender(IsoMapCache* cache, const IsoLayerStack* layers, rect view);
+
+/* uploads map space quads (e.g. from an IsoTileBuilder) in one go and draws them */
+void isoMapCacheRenderVertices(IsoMapCache* cache, const IsoLayerStack* layers, const IsoVertex* vertices, uint32_t quads);
+
+/* uploads the impostors built since they were last drawn and draws the quads of the last update */
+void isoMapCacheRenderImpostors(IsoMapCache* cache, const IsoLayerStack* layers, IsoImpostorCache* impostors);
+
+/* loads the tile shader for isoMapCacheRenderStream, e.g. res/shaders/tiles.vert with batch.frag */
+int isoMapCacheInitStream(IsoMapCache* cache, const char* vert, const char* frag);
+
+/* uploads the words of stream and draws each of its draws as instanced quads */
+void isoMapCacheRenderStream(IsoMapCache* cache, const IsoLayerStack* layers, const IsoTileStream* stream);
+
+#endif // !CACHE_H
@@ -0,0 +1,108 @@
+#include "chunk.h"
+#include "alloc.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static IsoPool chunk_pool = ISO_POOL_INIT(ISO_MEM_MAP, ISO_CHUNK_TILES * sizeof(uint32_t), 64);
+
+uint32_t* isoChunkAllocTiles()          { return isoPoolAlloc(&chunk_pool); }
+void isoChunkFreeTiles(uint32_t* tiles)   { isoPoolFree(&chunk_pool, tiles); }
+
+static uint32_t* isoChunkFillTiles(uint32_t value)
+{
+    uint32_t* tiles = isoChunkAllocTiles();
+    if (!tiles) return NULL;
+
+    for (uint32_t i = 0; i < ISO_CHUNK_TILES; i++)
+        tiles[i] = value;
+
+    return tiles;
+}
+
+uint32_t isoChunkGet(const IsoChunk* chunk, uint32_t x, uint32_t y)
+{
+    if (!chunk->tiles) return chunk->value;
+    return chunk->tiles[(y << ISO_CHUNK_SHIFT) + x];
+}
+
+int isoChunkSet(IsoChunk* chunk, uint32_t x, uint32_t y, uint32_t tile)
+{
+    if (!chunk->tiles)
+    {
+        if (chunk->value == tile) return 1;
+
+        chunk->tiles = isoChunkFillTiles(chunk->value);
+        if (!chunk->tiles) return 0;
+    }
+
+    uint32_t* dst = &chunk->tiles[(y << ISO_CHUNK_SHIFT) + x];
+    if (*dst != tile)
+    {
+        *dst = tile;
+        chunk->version++;
+    }
+    return 1;
+}
+
+const uint32_t* isoChunkRow(const IsoChunk* chunk, uint32_t y)
+{
+    if (!chunk->tiles) return NULL;
+    return chunk->tiles + (y << ISO_CHUNK_SHIFT);
+}
+
+int isoChunkLoad(IsoChunk* chunk, const uint32_t* grid, uint32_t stride, uint32_t w, uint32_t h)
+{
+    isoChunkFree(chunk);
+    chunk->version++;
+
+    // chunks at the map border are padded with empty tiles
+    int uniform = (w == ISO_CHUNK_SIZE && h == ISO_CHUNK_SIZE);
+    chunk->value = uniform ? grid[0] : ISO_TILE_EMPTY;
+
+    for (uint32_t y = 0; y < h && uniform; y++)
+    {
+        for (uint32_t x = 0; x < w; x++)
+        {
+            if (grid[y * stride + x] != chunk->value)
+            {
+                uniform = 0;
+                break;
+            }
+        }
+    }
+
+    if (uniform) return 1;
+
+    chunk->tiles = isoChunkFillTiles(ISO_TILE_EMPTY);
+    if (!chunk->tiles) return 0;
+
+    for (uint32_t y = 0; y < h; y++)
+        memcpy(chunk->tiles + (y << ISO_CHUNK_SHIFT), grid + y * stride, w * sizeof(uint32_t));
+
+    return isoChunkCompact(chunk);
+}
+
+int isoChunkCompact(IsoChunk* chunk)
+{
+    if (!chunk->tiles) return 1;
+
+    uint32_t value = chunk->tiles[0];
+    for (uint32_t i = 1; i < ISO_CHUNK_TILES; i++)
+    {
+        if (chunk->tiles[i] != value)
+            return 1;
+    }
+
+    isoChunkFree(chunk);
+    chunk->value = value;
+    return 1;
+}
+
+void isoChunkFree(IsoChunk* chunk)
+{
+    if (chunk->tiles && !chunk->mapped) isoChunkFreeTiles(chunk->tiles);
+    chunk->tiles = NULL;
+    chunk->value = ISO_TILE_EMPTY;
+    chunk->mapped = 0;
+}
@@ -0,0 +1,55 @@
+#ifndef CHUNK_H
+#define CHUNK_H
+
+#include <stdint.h>
+
+#define ISO_CHUNK_SHIFT 5
+#define ISO_CHUNK_SIZE  (1 << ISO_CHUNK_SHIFT)
+#define ISO_CHUNK_MASK  (ISO_CHUNK_SIZE - 1)
+#define ISO_CHUNK_TILES (ISO_CHUNK_SIZE * ISO_CHUNK_SIZE)
+
+#define ISO_TILE_EMPTY  0
+
+/* stands in for chunks that are not loaded yet, see stream.h */
+#define ISO_TILE_PLACEHOLDER 4
+
+/* the top byte of a tile holds its elevation in levels, the rest its id */
+#define ISO_TILE_ELEVATION_SHIFT 24
+#define ISO_TILE_ID_MASK         ((1u << ISO_TILE_ELEVATION_SHIFT) - 1)
+#define ISO_TILE_MAX_ELEVATION   255
+
+#define ISO_TILE_ID(tile)        ((tile) & ISO_TILE_ID_MASK)
+#define ISO_TILE_ELEVATION(tile) ((tile) >> ISO_TILE_ELEVATION_SHIFT)
+
+/*
+ * A chunk either owns ISO_CHUNK_TILES row-major tiles or, if tiles is NULL,
+ * every tile in it is value. Empty chunks are uniform with ISO_TILE_EMPTY.
+ * version is bumped whenever a tile changes, so caches can detect stale data.
+ * Mapped chunks point into a map file (see mapfile.h) and are not freed.
+ */
+typedef struct
+{
+    uint32_t* tiles;
+    uint32_t value;
+    uint32_t version;
+    uint32_t mapped;
+} IsoChunk;
+
+uint32_t isoChunkGet(const IsoChunk* chunk, uint32_t x, uint32_t y);
+int isoChunkSet(IsoChunk* chunk, uint32_t x, uint32_t y, uint32_t tile);
+
+/* returns NULL for uniform chunks */
+const uint32_t* isoChunkRow(const IsoChunk* chunk, uint32_t y);
+
+/* copies a w * h block out of a row-major grid with the given stride */
+int isoChunkLoad(IsoChunk* chunk, const uint32_t* grid, uint32_t stride, uint32_t w, uint32_t h);
+
+/* collapses the chunk to a single value if all its tiles are equal */
+int isoChunkCompact(IsoChunk* chunk);
+void isoChunkFree(IsoChunk* chunk);
+
+/* uninitialized tile arrays from a pool shared by all maps, safe from any thread */
+uint32_t* isoChunkAllocTiles();
+void isoChunkFreeTiles(uint32_t* tiles);
+
+#endif // !CHUNK_H
@@ -0,0 +1,202 @@
+#include "collision.h"
+
+#include "path.h"
+
+/* gap kept to a blocking grid line, in tiles */
+#define ISO_SWEEP_SKIN 2e-3f
+
+/* float slack when placing an edge on the grid, in tiles */
+#define ISO_SWEEP_EPSILON 1e-4f
+
+static int isoSweepBlocked(const IsoMap* map, int32_t col, int32_t row)
+{
+    if (col < 0 || row < 0 || col >= (int32_t)map->width || row >= (int32_t)map->height) return 1;
+    return !isoTileWalkable(isoMapGetTile(map, (uint32_t)col, (uint32_t)row));
+}
+
+/* cells covered by [min, max) on one axis */
+static void isoSweepSpan(float min, float max, float inv_tile_size, int32_t* first, int32_t* last)
+{
+    *first = (int32_t)floorf(min * inv_tile_size);
+    *last = (int32_t)ceilf(max * inv_tile_size) - 1;
+    if (*last < *first) *last = *first;
+}
+
+/*
+ * The leading cell on the other axis was entered already, even if its edge
+ * sits right on the grid line at this time (crossings at the same time).
+ */
+static void isoSweepSpanLead(int32_t lead, int32_t step, int32_t* first, int32_t* last)
+{
+    if (step > 0 && lead > *last) *last = lead;
+    if (step < 0 && lead < *first) *first = lead;
+}
+
+static int isoSweepColumnBlocked(const IsoMap* map, int32_t col, int32_t row_first, int32_t row_last)
+{
+    for (int32_t row = row_first; row <= row_last; row++)
+    {
+        if (isoSweepBlocked(map, col, row)) return 1;
+    }
+    return 0;
+}
+
+static int isoSweepRowBlocked(const IsoMap* map, int32_t row, int32_t col_first, int32_t col_last)
+{
+    for (int32_t col = col_first; col <= col_last; col++)
+    {
+        if (isoSweepBlocked(map, col, row)) return 1;
+    }
+    return 0;
+}
+
+/*
+ * Leading cell on one axis and the time until the leading edge crosses the
+ * next grid line. An edge within ISO_SWEEP_EPSILON past a line counts as on
+ * it, so contacts that rounded over the line are not lost.
+ */
+static void isoSweepAxis(float center, float half, float delta, float tile_size, int32_t* cell, int32_t* step, float* next, float* step_time)
+{
+    float inv = 1.0f / tile_size;
+
+    if (delta > 0.0f)
+    {
+        float lead = center + half;
+        *cell = (int32_t)ceilf(lead * inv - ISO_SWEEP_EPSILON) - 1;
+        *step = 1;
+        *next = ((*cell + 1) * tile_size - lead) / delta;
+        *step_time = tile_size / delta;
+    }
+    else if (delta < 0.0f)
+    {
+        float lead = center - half;
+        *cell = (int32_t)floorf(lead * inv + ISO_SWEEP_EPSILON);
+        *step = -1;
+        *next = (*cell * tile_size - lead) / delta;
+        *step_time = -tile_size / delta;
+    }
+    else
+    {
+        *cell = 0;
+        *step = 0;
+        *next = INFINITY;
+        *step_time = INFINITY;
+    }
+}
+
+/*
+ * Center of a box resting against line. Keeps a small gap, but never backs
+ * off further than where the pass started, which could already be touching
+ * a line on the other side.
+ */
+static float isoSweepContact(float line, float half, float skin, int32_t step, float start)
+{
+    if (step > 0) return fmaxf(line - half - skin, fminf(start, line - half));
+    return fminf(line + half + skin, fmaxf(start, line + half));
+}
+
+int isoMapSweep(const IsoMap* map, vec2* position, vec2 half_extent, vec2 delta)
+{
+    float tile_size = map->tile_size;
+    float inv = 1.0f / tile_size;
+    float skin = tile_size * ISO_SWEEP_SKIN;
+
+    vec2 pos = *position;
+    int hits = 0;
+
+    // every contact stops one axis, so there are at most two passes
+    for (int pass = 0; pass < 2 && (delta.x != 0.0f || delta.y != 0.0f); pass++)
+    {
+        int32_t col, row, step_x, step_y;
+        float next_x, next_y, step_tx, step_ty;
+        isoSweepAxis(pos.x, half_extent.x, delta.x, tile_size, &col, &step_x, &next_x, &step_tx);
+        isoSweepAxis(pos.y, half_extent.y, delta.y, tile_size, &row, &step_y, &next_y, &step_ty);
+
+        float t = 0.0f;
+        int hit = 0;
+        while (!hit)
+        {
+            float tx = next_x;
+            float ty = next_y;
+
+            // lines reached right at the end still count, the final add may round past them
+            t = tx < ty ? tx : ty;
+            if (t > 1.0f + ISO_SWEEP_EPSILON) break;
+
+            int32_t first, last;
+            if (tx <= ty)
+            {
+                // the leading x edge enters the next column
+                isoSweepSpan(pos.y - half_extent.y + delta.y * t, pos.y + half_extent.y + delta.y * t, inv, &first, &last);
+                isoSweepSpanLead(row, step_y, &first, &last);
+
+                if (isoSweepColumnBlocked(map, col + step_x, first, last))
+                    hit = ISO_SWEEP_HIT_X;
+                else
+                {
+                    col += step_x;
+                    next_x += step_tx;
+                }
+            }
+
+            if (!hit && ty <= tx)
+            {
+                isoSweepSpan(pos.x - half_extent.x + delta.x * t, pos.x + half_extent.x + delta.x * t, inv, &first, &last);
+                isoSweepSpanLead(col, step_x, &first, &last);
+
+                if (isoSweepRowBlocked(map, row + step_y, first, last))
+                    hit = ISO_SWEEP_HIT_Y;
+                else
+                {
+                    row += step_y;
+                    next_y += step_ty;
+                }
+            }
+        }
+
+        if (!hit)
+        {
+            pos = vec2_add(pos, delta);
+            break;
+        }
+
+        // move up to the contact and slide along the other axis with the rest
+        vec2 start = pos;
+        pos = vec2_add(pos, vec2_mult(delta, t));
+        if (hit == ISO_SWEEP_HIT_X)
+        {
+            float line = (col + (step_x > 0 ? 1 : 0)) * tile_size;
+            pos.x = isoSweepContact(line, half_extent.x, skin, step_x, start.x);
+            delta.x = 0.0f;
+            delta.y *= 1.0f - t;
+        }
+        else
+        {
+            float line = (row + (step_y > 0 ? 1 : 0)) * tile_size;
+            pos.y = isoSweepContact(line, half_extent.y, skin, step_y, start.y);
+            delta.x *= 1.0f - t;
+            delta.y = 0.0f;
+        }
+
+        hits |= hit;
+    }
+
+    *position = pos;
+    return hits;
+}
+
+void isoMapSweepArray(const IsoMap* map, float* x, float* y, float* vx, float* vy, vec2 half_extent, float deltatime, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        vec2 pos = { x[i], y[i] };
+        vec2 delta = { vx[i] * deltatime, vy[i] * deltatime };
+
+        int hits = isoMapSweep(map, &pos, half_extent, delta);
+
+        x[i] = pos.x;
+        y[i] = pos.y;
+        if (hits & ISO_SWEEP_HIT_X) vx[i] = 0.0f;
+        if (hits & ISO_SWEEP_HIT_Y) vy[i] = 0.0f;
+    }
+}
@@ -0,0 +1,26 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include "iso.h"
+
+/*
+ * Swept axis aligned boxes against the tile grid in world space. The box is
+ * walked through the cells its leading edges enter (DDA), so fast movers
+ * cannot tunnel. On contact the blocked axis stops and the rest of the move
+ * slides along the other one. Tiles outside the map and tiles that are not
+ * walkable (see isoTileWalkable) block.
+ */
+#define ISO_SWEEP_HIT_X 1
+#define ISO_SWEEP_HIT_Y 2
+
+/* moves the box centered at position by delta, returns ISO_SWEEP_HIT_* flags */
+int isoMapSweep(const IsoMap* map, vec2* position, vec2 half_extent, vec2 delta);
+
+/*
+ * Batched version over structure-of-arrays movers sharing one box size.
+ * Positions are advanced by velocity * deltatime and blocked velocity
+ * components are set to zero.
+ */
+void isoMapSweepArray(const IsoMap* map, float* x, float* y, float* vx, float* vy, vec2 half_extent, float deltatime, size_t count);
+
+#endif // !COLLISION_H
@@ -0,0 +1,255 @@
+#include "entity.h"
+#include "alloc.h"
+#include "occlusion.h"
+#include "render.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define ISO_RADIX_BITS    11
+#define ISO_RADIX_BUCKETS (1 << ISO_RADIX_BITS)
+#define ISO_RADIX_MASK    (ISO_RADIX_BUCKETS - 1)
+
+int isoEntityLayerInit(IsoEntityLayer* layer, uint32_t capacity)
+{
+    memset(layer, 0, sizeof(IsoEntityLayer));
+
+    layer->capacity = capacity ? capacity : 16;
+    layer->entities = isoMalloc(ISO_MEM_ENTITY, layer->capacity * sizeof(IsoEntity));
+    layer->order = isoMalloc(ISO_MEM_ENTITY, layer->capacity * sizeof(IsoDepthKey));
+    layer->scratch = isoMalloc(ISO_MEM_ENTITY, layer->capacity * sizeof(IsoDepthKey));
+
+    if (!layer->entities || !layer->order || !layer->scratch)
+    {
+        isoEntityLayerDestroy(layer);
+        return 0;
+    }
+
+    return 1;
+}
+
+void isoEntityLayerDestroy(IsoEntityLayer* layer)
+{
+    if (layer->entities) isoFree(layer->entities);
+    if (layer->order) isoFree(layer->order);
+    if (layer->scratch) isoFree(layer->scratch);
+
+    memset(layer, 0, sizeof(IsoEntityLayer));
+}
+
+static int isoEntityLayerGrow(IsoEntityLayer* layer)
+{
+    uint32_t capacity = layer->capacity * 2;
+
+    IsoEntity* entities = isoRealloc(ISO_MEM_ENTITY, layer->entities, capacity * sizeof(IsoEntity));
+    if (!entities) return 0;
+    layer->entities = entities;
+
+    IsoDepthKey* order = isoRealloc(ISO_MEM_ENTITY, layer->order, capacity * sizeof(IsoDepthKey));
+    if (!order) return 0;
+    layer->order = order;
+
+    IsoDepthKey* scratch = isoRealloc(ISO_MEM_ENTITY, layer->scratch, capacity * sizeof(IsoDepthKey));
+    if (!scratch) return 0;
+    layer->scratch = scratch;
+
+    layer->capacity = capacity;
+    return 1;
+}
+
+uint32_t isoEntityLayerAdd(IsoEntityLayer* layer, IsoEntity entity)
+{
+    if (layer->count >= layer->capacity && !isoEntityLayerGrow(layer))
+        return ISO_ENTITY_NONE;
+
+    uint32_t index = layer->count++;
+    layer->entities[index] = entity;
+
+    // the depth is filled in by the next sort
+    layer->order[index] = (IsoDepthKey){ 0.0f, index };
+
+    return index;
+}
+
+void isoEntityLayerRemove(IsoEntityLayer* layer, uint32_t index)
+{
+    if (index >= layer->count) return;
+
+    uint32_t last = --layer->count;
+    layer->entities[index] = layer->entities[last];
+
+    // drop the key and rename the moved entity, keeping the order intact
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i <= last; i++)
+    {
+        IsoDepthKey key = layer->order[i];
+        if (key.entity == index) continue;
+        if (key.entity == last) key.entity = index;
+        layer->order[kept++] = key;
+    }
+}
+
+/* stops once more than budget shifts were needed, leaving a valid permutation */
+static int isoDepthInsertionSort(IsoDepthKey* keys, uint32_t count, uint32_t budget, uint32_t* shifts)
+{
+    uint32_t moved = 0;
+    for (uint32_t i = 1; i < count; i++)
+    {
+        IsoDepthKey key = keys[i];
+
+        uint32_t j = i;
+        while (j > 0 && keys[j - 1].depth > key.depth)
+        {
+            keys[j] = keys[j - 1];
+            j--;
+        }
+        keys[j] = key;
+
+        moved += i - j;
+        if (moved > budget)
+        {
+            *shifts = moved;
+            return 0;
+        }
+    }
+
+    *shifts = moved;
+    return 1;
+}
+
+/* maps the float bits to an unsigned key with the same order */
+static uint32_t isoDepthBits(float depth)
+{
+    uint32_t bits;
+    memcpy(&bits, &depth, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+/* stable lsd radix sort, returns the buffer holding the result */
+static IsoDepthKey* isoDepthRadixSort(IsoDepthKey* keys, IsoDepthKey* scratch, uint32_t count)
+{
+    uint32_t offsets[ISO_RADIX_BUCKETS];
+
+    for (uint32_t shift = 0; shift < 32; shift += ISO_RADIX_BITS)
+    {
+        memset(offsets, 0, sizeof(offsets));
+
+        for (uint32_t i = 0; i < count; i++)
+            offsets[(isoDepthBits(keys[i].depth) >> shift) & ISO_RADIX_MASK]++;
+
+        uint32_t sum = 0;
+        for (uint32_t b = 0; b < ISO_RADIX_BUCKETS; b++)
+        {
+            uint32_t n = offsets[b];
+            offsets[b] = sum;
+            sum += n;
+        }
+
+        for (uint32_t i = 0; i < count; i++)
+            scratch[offsets[(isoDepthBits(keys[i].depth) >> shift) & ISO_RADIX_MASK]++] = keys[i];
+
+        IsoDepthKey* tmp = keys;
+        keys = scratch;
+        scratch = tmp;
+    }
+
+    return keys;
+}
+
+void isoEntityLayerSort(IsoEntityLayer* layer, const IsoMap* map)
+{
+    float scale = 1.0f / map->tile_size;
+
+    for (uint32_t i = 0; i < layer->count; i++)
+    {
+        vec2 pos = layer->entities[layer->order[i].entity].position;
+        layer->order[i].depth = (pos.x + pos.y) * scale;
+    }
+
+    // past a few shifts per key the radix sort is cheaper
+    uint32_t budget = 2 * layer->count + 64;
+
+    layer->sort_radix = !isoDepthInsertionSort(layer->order, layer->count, budget, &layer->sort_shifts);
+    if (layer->sort_radix)
+    {
+        IsoDepthKey* sorted = isoDepthRadixSort(layer->order, layer->scratch, layer->count);
+        if (sorted != layer->order)
+        {
+            layer->scratch = layer->order;
+            layer->order = sorted;
+        }
+    }
+}
+
+int isoEntityLayerIsSorted(const IsoEntityLayer* layer)
+{
+    for (uint32_t i = 1; i < layer->count; i++)
+    {
+        if (layer->order[i - 1].depth > layer->order[i].depth) return 0;
+    }
+    return 1;
+}
+
+/* draws the entities in order up to (excluding) depth, returns the next one */
+static uint32_t isoEntityLayerRenderUntil(const IsoEntityLayer* layer, const IsoMap* map, rect view, uint32_t next, float depth, int above_map)
+{
+    for (; next < layer->count && layer->order[next].depth < depth; next++)
+    {
+        const IsoEntity* entity = &layer->entities[layer->order[next].entity];
+
+        vec2 foot = worldToScreen(map, entity->position);
+        IgnisRect rect = {
+            foot.x - entity->size.x * .5f, foot.y - entity->size.y,
+            entity->size.x, entity->size.y
+        };
+
+        if (rect.x > view.max.x || rect.x + rect.w < view.min.x) continue;
+        if (rect.y > view.max.y || rect.y + rect.h < view.min.y) continue;
+
+        isoRenderSetEntityOrder(layer->order[next].depth, above_map);
+        isoRenderTextureFrame(entity->texture, rect, entity->frame);
+    }
+
+    return next;
+}
+
+void isoEntityLayerRender(const IsoEntityLayer* layer, const IsoMap* map, const IsoLayerStack* tiles, rect view)
+{
+    uint32_t next = 0;
+    size_t mark = isoFrameMark();
+
+    IsoTileRange range;
+    if (tiles && isoLayerStackVisibleRange(tiles, view, ISO_LAYER_ALL, &range))
+    {
+        const IsoMap* ground = tiles->layers[0].map;
+
+        IsoOcclusion occlusion = { 0 };
+        if (ground->max_elevation)
+            isoOcclusionBuild(&occlusion, ground, tiles->layers[0].texture_atlas, &range, 0, range.row_min, ground->width - 1, range.row_max);
+
+        for (int32_t sum = range.sum_min; sum <= range.sum_max; sum++)
+        {
+            // entities standing on earlier diagonals go before this one
+            next = isoEntityLayerRenderUntil(layer, map, view, next, (float)sum, 0);
+
+            // rows of the diagonal that lie inside the visible diamond
+            int32_t row_min = (int32_t)ceilf((sum - range.diff_max) * .5f);
+            int32_t row_max = (int32_t)floorf((sum - range.diff_min) * .5f);
+
+            if (row_min < (int32_t)range.row_min) row_min = (int32_t)range.row_min;
+            if (row_max > (int32_t)range.row_max) row_max = (int32_t)range.row_max;
+            if (row_min < sum - (int32_t)ground->width + 1) row_min = sum - (int32_t)ground->width + 1;
+            if (row_max > sum) row_max = sum;
+
+            for (int32_t row = row_min; row <= row_max; row++)
+            {
+                uint32_t col = (uint32_t)(sum - row);
+                renderLayerTile(tiles, col, (uint32_t)row, isoOcclusionFirst(&occlusion, col, (uint32_t)row), ISO_LAYER_ALL);
+            }
+        }
+    }
+
+    isoEntityLayerRenderUntil(layer, map, view, next, INFINITY, !tiles);
+    isoFrameRelease(mark);
+}
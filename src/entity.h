@@ -0,0 +1,62 @@
+#ifndef ENTITY_H
+#define ENTITY_H
+
+#include "iso.h"
+#include "layer.h"
+
+#define ISO_ENTITY_NONE 0xffffffff
+
+typedef struct
+{
+    vec2 position;  /* world space foot point */
+    vec2 size;      /* sprite size in screen space */
+    const IgnisTexture2D* texture;
+    uint32_t frame;
+} IsoEntity;
+
+typedef struct
+{
+    float depth;    /* (x + y) / tile_size, the iso row of the foot point */
+    uint32_t entity;
+} IsoDepthKey;
+
+/*
+ * Entities drawn in isometric depth order. The sorted order is kept between
+ * frames and refreshed with an insertion sort, which is close to linear as
+ * long as entities only move a little. If too many keys move at once (spawns,
+ * teleports) the sort falls back to a radix sort on the depth bits.
+ */
+typedef struct
+{
+    IsoEntity* entities;
+    uint32_t count;
+    uint32_t capacity;
+
+    IsoDepthKey* order;   /* back to front after isoEntityLayerSort */
+    IsoDepthKey* scratch; /* radix sort buffer */
+
+    /* stats of the last sort */
+    uint32_t sort_shifts;
+    int sort_radix;
+} IsoEntityLayer;
+
+int isoEntityLayerInit(IsoEntityLayer* layer, uint32_t capacity);
+void isoEntityLayerDestroy(IsoEntityLayer* layer);
+
+/* returns the index of the new entity or ISO_ENTITY_NONE if out of memory */
+uint32_t isoEntityLayerAdd(IsoEntityLayer* layer, IsoEntity entity);
+
+/* the last entity takes over the index of the removed one */
+void isoEntityLayerRemove(IsoEntityLayer* layer, uint32_t index);
+
+void isoEntityLayerSort(IsoEntityLayer* layer, const IsoMap* map);
+int isoEntityLayerIsSorted(const IsoEntityLayer* layer);
+
+/*
+ * Draws the visible tiles diagonal by diagonal and puts every entity right
+ * after the diagonal it stands on, so tiles in front of an entity cover it.
+ * All layers of tiles are drawn, with tiles NULL only the entities (on top of the map).
+ */
+void isoEntityLayerRender(const IsoEntityLayer* layer, const IsoMap* map, const IsoLayerStack* tiles, rect view);
+
+#endif // !ENTITY_H
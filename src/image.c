@@ -0,0 +1,412 @@
+#include "image.h"
+#include "alloc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ISO_DEFLATE_WINDOW    32768
+#define ISO_DEFLATE_HASH_BITS 15
+#define ISO_DEFLATE_CHAIN     32 /* candidates tried per match */
+#define ISO_DEFLATE_MIN_MATCH 3
+#define ISO_DEFLATE_MAX_MATCH 258
+
+int isoImageWritePPM(const char* path, const uint8_t* pixels, uint32_t width, uint32_t height)
+{
+    FILE* file = fopen(path, "wb");
+    if (!file) return 0;
+
+    uint8_t* row = isoMalloc(ISO_MEM_RENDER, (size_t)width * 3 + 1);
+    int result = row && fprintf(file, "P6\n%u %u\n255\n", width, height) > 0;
+
+    for (uint32_t y = 0; y < height && result; y++)
+    {
+        const uint8_t* src = pixels + (size_t)y * width * 4;
+        for (uint32_t x = 0; x < width; x++)
+        {
+            row[x * 3 + 0] = src[x * 4 + 0];
+            row[x * 3 + 1] = src[x * 4 + 1];
+            row[x * 3 + 2] = src[x * 4 + 2];
+        }
+        result = fwrite(row, 3, width, file) == width;
+    }
+
+    isoFree(row);
+    if (fclose(file) != 0) result = 0;
+    return result;
+}
+
+/* growing byte buffer with an lsb first bit writer on top */
+typedef struct
+{
+    uint8_t* data;
+    size_t size;
+    size_t capacity;
+    int failed;
+
+    uint64_t bits;
+    uint32_t count;
+} IsoImageBuffer;
+
+static int isoImageReserve(IsoImageBuffer* buffer, size_t bytes)
+{
+    if (buffer->failed) return 0;
+    if (buffer->size + bytes <= buffer->capacity) return 1;
+
+    size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+    while (capacity < buffer->size + bytes) capacity *= 2;
+
+    uint8_t* data = isoRealloc(ISO_MEM_RENDER, buffer->data, capacity);
+    if (!data)
+    {
+        buffer->failed = 1;
+        return 0;
+    }
+
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return 1;
+}
+
+static void isoImagePutBytes(IsoImageBuffer* buffer, const void* bytes, size_t count)
+{
+    if (!isoImageReserve(buffer, count)) return;
+
+    memcpy(buffer->data + buffer->size, bytes, count);
+    buffer->size += count;
+}
+
+static void isoImagePut32(IsoImageBuffer* buffer, uint32_t value)
+{
+    uint8_t bytes[4] = { (uint8_t)(value >> 24), (uint8_t)(value >> 16), (uint8_t)(value >> 8), (uint8_t)value };
+    isoImagePutBytes(buffer, bytes, 4);
+}
+
+static void isoImagePutBits(IsoImageBuffer* buffer, uint32_t bits, uint32_t count)
+{
+    buffer->bits |= (uint64_t)bits << buffer->count;
+    buffer->count += count;
+
+    if (buffer->count < 32) return;
+    if (!isoImageReserve(buffer, 8)) return;
+
+    while (buffer->count >= 8)
+    {
+        buffer->data[buffer->size++] = (uint8_t)buffer->bits;
+        buffer->bits >>= 8;
+        buffer->count -= 8;
+    }
+}
+
+/* huffman codes are sent msb first */
+static void isoImagePutCode(IsoImageBuffer* buffer, uint32_t code, uint32_t length)
+{
+    uint32_t reversed = 0;
+    for (uint32_t i = 0; i < length; i++)
+        reversed |= ((code >> i) & 1) << (length - 1 - i);
+
+    isoImagePutBits(buffer, reversed, length);
+}
+
+static void isoImageFlushBits(IsoImageBuffer* buffer)
+{
+    if (!isoImageReserve(buffer, 8)) return;
+
+    while (buffer->count > 0)
+    {
+        buffer->data[buffer->size++] = (uint8_t)buffer->bits;
+        buffer->bits >>= 8;
+        buffer->count = buffer->count > 8 ? buffer->count - 8 : 0;
+    }
+    buffer->bits = 0;
+}
+
+/* literal or length symbol with the fixed codes */
+static void isoDeflateSymbol(IsoImageBuffer* buffer, uint32_t symbol)
+{
+    if (symbol < 144)      isoImagePutCode(buffer, 0x30 + symbol, 8);
+    else if (symbol < 256) isoImagePutCode(buffer, 0x190 + symbol - 144, 9);
+    else if (symbol < 280) isoImagePutCode(buffer, symbol - 256, 7);
+    else                   isoImagePutCode(buffer, 0xc0 + symbol - 280, 8);
+}
+
+static const uint16_t iso_length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const uint8_t iso_length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+static const uint16_t iso_distance_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+
+static const uint8_t iso_distance_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static void isoDeflateMatch(IsoImageBuffer* buffer, uint32_t length, uint32_t distance)
+{
+    uint32_t l = 28;
+    while (iso_length_base[l] > length) l--;
+
+    isoDeflateSymbol(buffer, 257 + l);
+    isoImagePutBits(buffer, length - iso_length_base[l], iso_length_extra[l]);
+
+    uint32_t d = 29;
+    while (iso_distance_base[d] > distance) d--;
+
+    isoImagePutCode(buffer, d, 5);
+    isoImagePutBits(buffer, distance - iso_distance_base[d], iso_distance_extra[d]);
+}
+
+static uint32_t isoDeflateHash(const uint8_t* bytes)
+{
+    uint32_t key = (uint32_t)bytes[0] << 16 | (uint32_t)bytes[1] << 8 | bytes[2];
+    return (key * 2654435761u) >> (32 - ISO_DEFLATE_HASH_BITS);
+}
+
+/* one final block with the fixed codes, matches are found through hash chains */
+static int isoDeflate(IsoImageBuffer* buffer, const uint8_t* data, size_t size)
+{
+    uint32_t* head = isoMalloc(ISO_MEM_RENDER, ((size_t)1 << ISO_DEFLATE_HASH_BITS) * sizeof(uint32_t));
+    uint32_t* prev = isoMalloc(ISO_MEM_RENDER, ISO_DEFLATE_WINDOW * sizeof(uint32_t));
+    if (!head || !prev)
+    {
+        isoFree(head);
+        isoFree(prev);
+        return 0;
+    }
+
+    // positions are stored + 1, 0 ends a chain
+    memset(head, 0, ((size_t)1 << ISO_DEFLATE_HASH_BITS) * sizeof(uint32_t));
+
+    isoImagePutBits(buffer, 1, 1); // final
+    isoImagePutBits(buffer, 1, 2); // fixed codes
+
+    size_t i = 0;
+    while (i < size)
+    {
+        uint32_t best = 0, distance = 0;
+        if (i + ISO_DEFLATE_MIN_MATCH <= size)
+        {
+            uint32_t hash = isoDeflateHash(data + i);
+            size_t max = size - i < ISO_DEFLATE_MAX_MATCH ? size - i : ISO_DEFLATE_MAX_MATCH;
+
+            uint32_t candidate = head[hash];
+            for (uint32_t tries = 0; candidate && tries < ISO_DEFLATE_CHAIN; tries++)
+            {
+                size_t pos = candidate - 1;
+                if (i - pos > ISO_DEFLATE_WINDOW) break;
+
+                const uint8_t* a = data + pos;
+                const uint8_t* b = data + i;
+                uint32_t length = 0;
+                while (length < max && a[length] == b[length]) length++;
+
+                if (length > best)
+                {
+                    best = length;
+                    distance = (uint32_t)(i - pos);
+                    if (length == max) break;
+                }
+                candidate = prev[pos & (ISO_DEFLATE_WINDOW - 1)];
+            }
+
+            prev[i & (ISO_DEFLATE_WINDOW - 1)] = head[hash];
+            head[hash] = (uint32_t)(i + 1);
+        }
+
+        if (best >= ISO_DEFLATE_MIN_MATCH)
+        {
+            isoDeflateMatch(buffer, best, distance);
+
+            // the rest of the match goes into the chains too
+            for (size_t end = i + best, j = i + 1; j < end; j++)
+            {
+                if (j + ISO_DEFLATE_MIN_MATCH > size) break;
+
+                uint32_t hash = isoDeflateHash(data + j);
+                prev[j & (ISO_DEFLATE_WINDOW - 1)] = head[hash];
+                head[hash] = (uint32_t)(j + 1);
+            }
+            i += best;
+        }
+        else
+        {
+            isoDeflateSymbol(buffer, data[i]);
+            i++;
+        }
+    }
+
+    isoDeflateSymbol(buffer, 256);
+    isoImageFlushBits(buffer);
+
+    isoFree(head);
+    isoFree(prev);
+    return !buffer->failed;
+}
+
+static uint32_t iso_crc_table[256];
+
+static uint32_t isoImageCrc(uint32_t crc, const uint8_t* bytes, size_t count)
+{
+    if (!iso_crc_table[1])
+    {
+        for (uint32_t n = 0; n < 256; n++)
+        {
+            uint32_t c = n;
+            for (uint32_t k = 0; k < 8; k++)
+                c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            iso_crc_table[n] = c;
+        }
+    }
+
+    crc = ~crc;
+    for (size_t i = 0; i < count; i++)
+        crc = iso_crc_table[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+static uint32_t isoImageAdler(const uint8_t* bytes, size_t count)
+{
+    uint32_t a = 1, b = 0;
+    while (count)
+    {
+        // largest run before the sums can overflow
+        size_t run = count < 5552 ? count : 5552;
+        count -= run;
+
+        while (run--)
+        {
+            a += *bytes++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return b << 16 | a;
+}
+
+static uint8_t isoImagePaeth(uint8_t a, uint8_t b, uint8_t c)
+{
+    int p = (int)a + b - c;
+    int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+/* filters a row with the type that gives the smallest sum of signed bytes */
+static void isoImageFilterRow(uint8_t* out, const uint8_t* row, const uint8_t* above, size_t stride, uint8_t* scratch)
+{
+    uint32_t best_cost = UINT32_MAX;
+    for (uint8_t type = 0; type < 5; type++)
+    {
+        uint32_t cost = 0;
+        for (size_t i = 0; i < stride; i++)
+        {
+            uint8_t a = i >= 4 ? row[i - 4] : 0;
+            uint8_t b = above ? above[i] : 0;
+            uint8_t c = i >= 4 && above ? above[i - 4] : 0;
+
+            uint8_t value = row[i];
+            if (type == 1)      value -= a;
+            else if (type == 2) value -= b;
+            else if (type == 3) value -= (uint8_t)((a + b) >> 1);
+            else if (type == 4) value -= isoImagePaeth(a, b, c);
+
+            scratch[i] = value;
+            cost += value < 128 ? value : 256 - value;
+        }
+
+        if (cost < best_cost)
+        {
+            best_cost = cost;
+            out[0] = type;
+            memcpy(out + 1, scratch, stride);
+        }
+    }
+}
+
+static void isoImageChunk(IsoImageBuffer* file, const char* type, const uint8_t* data, size_t size)
+{
+    isoImagePut32(file, (uint32_t)size);
+
+    size_t start = file->size;
+    isoImagePutBytes(file, type, 4);
+    if (size) isoImagePutBytes(file, data, size);
+
+    if (!file->failed) isoImagePut32(file, isoImageCrc(0, file->data + start, size + 4));
+}
+
+int isoImageWritePNG(const char* path, const uint8_t* pixels, uint32_t width, uint32_t height)
+{
+    size_t stride = (size_t)width * 4;
+    size_t size = (stride + 1) * height;
+
+    uint8_t* filtered = isoMalloc(ISO_MEM_RENDER, size ? size : 1);
+    uint8_t* scratch = isoMalloc(ISO_MEM_RENDER, stride ? stride : 1);
+
+    IsoImageBuffer zlib = { 0 };
+    IsoImageBuffer png = { 0 };
+    int result = filtered && scratch;
+
+    if (result)
+    {
+        for (uint32_t y = 0; y < height; y++)
+        {
+            const uint8_t* above = y ? pixels + (size_t)(y - 1) * stride : NULL;
+            isoImageFilterRow(filtered + y * (stride + 1), pixels + (size_t)y * stride, above, stride, scratch);
+        }
+
+        const uint8_t header[2] = { 0x78, 0x01 };
+        isoImagePutBytes(&zlib, header, 2);
+        result = isoDeflate(&zlib, filtered, size);
+        isoImagePut32(&zlib, isoImageAdler(filtered, size));
+        result = result && !zlib.failed;
+    }
+
+    if (result)
+    {
+        // 8 bit rgba, deflate, adaptive filters, no interlace
+        uint8_t ihdr[13] = {
+            (uint8_t)(width >> 24), (uint8_t)(width >> 16), (uint8_t)(width >> 8), (uint8_t)width,
+            (uint8_t)(height >> 24), (uint8_t)(height >> 16), (uint8_t)(height >> 8), (uint8_t)height,
+            8, 6, 0, 0, 0
+        };
+
+        const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+        isoImagePutBytes(&png, signature, 8);
+        isoImageChunk(&png, "IHDR", ihdr, sizeof(ihdr));
+        isoImageChunk(&png, "IDAT", zlib.data, zlib.size);
+        isoImageChunk(&png, "IEND", NULL, 0);
+        result = !png.failed;
+    }
+
+    if (result)
+    {
+        FILE* file = fopen(path, "wb");
+        result = file && fwrite(png.data, 1, png.size, file) == png.size;
+        if (file && fclose(file) != 0) result = 0;
+    }
+
+    isoFree(filtered);
+    isoFree(scratch);
+    isoFree(zlib.data);
+    isoFree(png.data);
+    return result;
+}
+
+int isoImageWrite(const char* path, const uint8_t* pixels, uint32_t width, uint32_t height)
+{
+    size_t length = strlen(path);
+    if (length >= 4 && strcmp(path + length - 4, ".ppm") == 0)
+        return isoImageWritePPM(path, pixels, width, height);
+
+    return isoImageWritePNG(path, pixels, width, height);
+}
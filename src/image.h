@@ -0,0 +1,18 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <stdint.h>
+
+/*
+ * Writers for rgba images, pixels row by row from the top. PPM drops the
+ * alpha and is written as is, PNG keeps it and is deflated with the fixed
+ * codes, which is small enough for tiled maps without pulling in zlib. All
+ * return 0 if the file could not be written.
+ */
+int isoImageWritePPM(const char* path, const uint8_t* pixels, uint32_t width, uint32_t height);
+int isoImageWritePNG(const char* path, const uint8_t* pixels, uint32_t width, uint32_t height);
+
+/* PPM for paths ending in .ppm, PNG otherwise */
+int isoImageWrite(const char* path, const uint8_t* pixels, uint32_t width, uint32_t height);
+
+#endif // !IMAGE_H
@@ -0,0 +1,482 @@
+#include "impostor.h"
+#include "alloc.h"
+
+#include <math.h>
+#include <string.h>
+
+#define ISO_IMPOSTOR_PIXELS  (ISO_IMPOSTOR_WIDTH * ISO_IMPOSTOR_HEIGHT * 4)
+#define ISO_IMPOSTOR_TEXTURE 4096 /* max width of the texture the slots are laid out in */
+#define ISO_IMPOSTOR_BUDGET  16
+
+/* premultiplied over */
+static void isoImpostorBlend(uint8_t* dst, const uint8_t* src)
+{
+    // most pixels are opaque or drawn on nothing
+    if (src[3] == 255 || !dst[3])
+    {
+        memcpy(dst, src, 4);
+        return;
+    }
+
+    uint32_t inverse = 255 - src[3];
+    for (uint32_t c = 0; c < 4; c++)
+        dst[c] = (uint8_t)(src[c] + (dst[c] * inverse + 127) / 255);
+}
+
+/* box filters the frames of an atlas down to swatches */
+static uint8_t* isoImpostorSwatches(const IsoAtlas* atlas, uint32_t w, uint32_t h)
+{
+    size_t size = (size_t)w * h * 4;
+    uint8_t* swatches = isoCalloc(ISO_MEM_RENDER, atlas->frame_count ? atlas->frame_count : 1, size);
+    if (!swatches) return NULL;
+
+    uint32_t stride = (uint32_t)atlas->texture.width;
+    for (uint32_t f = 0; f < atlas->frame_count; f++)
+    {
+        const IsoAtlasFrame* frame = &atlas->frames[f];
+        uint8_t* swatch = swatches + f * size;
+
+        for (uint32_t y = 0; y < h; y++)
+        {
+            uint32_t y0 = frame->y + y * frame->h / h;
+            uint32_t y1 = frame->y + (y + 1) * frame->h / h;
+            if (y1 <= y0) y1 = y0 + 1;
+
+            for (uint32_t x = 0; x < w; x++)
+            {
+                uint32_t x0 = frame->x + x * frame->w / w;
+                uint32_t x1 = frame->x + (x + 1) * frame->w / w;
+                if (x1 <= x0) x1 = x0 + 1;
+
+                uint32_t sum[4] = { 0 };
+                for (uint32_t sy = y0; sy < y1; sy++)
+                {
+                    const uint8_t* src = atlas->pixels + ((size_t)sy * stride + x0) * 4;
+                    for (uint32_t sx = x0; sx < x1; sx++, src += 4)
+                    {
+                        sum[0] += src[0] * src[3] / 255;
+                        sum[1] += src[1] * src[3] / 255;
+                        sum[2] += src[2] * src[3] / 255;
+                        sum[3] += src[3];
+                    }
+                }
+
+                uint32_t count = (y1 - y0) * (x1 - x0);
+                for (uint32_t c = 0; c < 4; c++)
+                    swatch[(y * w + x) * 4 + c] = (uint8_t)((sum[c] + count / 2) / count);
+            }
+        }
+    }
+    return swatches;
+}
+
+int isoImpostorCacheInit(IsoImpostorCache* cache, const IsoLayerStack* layers, uint32_t slots)
+{
+    memset(cache, 0, sizeof(IsoImpostorCache));
+
+    const IsoMap* map = layers->layers[0].map;
+    if (!slots || map->tile_size <= 0.0f) return 0;
+
+    // enough levels for one impostor to cover the map
+    uint32_t chunks = map->chunk_cols > map->chunk_rows ? map->chunk_cols : map->chunk_rows;
+    while (cache->level_count < ISO_IMPOSTOR_LEVELS && (1u << cache->level_count) < chunks)
+        cache->level_count++;
+    if (cache->level_count < ISO_IMPOSTOR_LEVELS) cache->level_count++;
+
+    for (uint32_t level = 0; level < cache->level_count; level++)
+    {
+        uint32_t size = 1u << level;
+        cache->blocks_x[level] = (map->chunk_cols + size - 1) >> level;
+        cache->blocks_y[level] = (map->chunk_rows + size - 1) >> level;
+
+        uint32_t blocks = cache->blocks_x[level] * cache->blocks_y[level];
+        cache->lookup[level] = isoMalloc(ISO_MEM_RENDER, (blocks ? blocks : 1) * sizeof(int32_t));
+        if (!cache->lookup[level])
+        {
+            isoImpostorCacheDestroy(cache);
+            return 0;
+        }
+
+        for (uint32_t i = 0; i < blocks; i++)
+            cache->lookup[level][i] = -1;
+    }
+
+    // a level 0 impostor is exactly as wide as its chunk
+    cache->scale = ISO_IMPOSTOR_WIDTH / (2.0f * ISO_CHUNK_SIZE * map->tile_size);
+    cache->swatch_w = ISO_IMPOSTOR_WIDTH / ISO_CHUNK_SIZE;
+    cache->swatch_h = (uint32_t)((map->tile_size + map->tile_offset) * cache->scale + .5f);
+    if (!cache->swatch_h) cache->swatch_h = 1;
+
+    for (uint32_t i = 0; i < layers->count; i++)
+    {
+        const IsoAtlas* atlas = layers->layers[i].texture_atlas;
+        if (!(layers->layers[i].mode & ISO_LAYER_STATIC)) continue;
+
+        cache->swatches[i] = atlas->pixels ? isoImpostorSwatches(atlas, cache->swatch_w, cache->swatch_h) : NULL;
+        if (!cache->swatches[i])
+        {
+            isoImpostorCacheDestroy(cache);
+            return 0;
+        }
+    }
+
+    cache->slot_count = slots;
+    cache->columns = ISO_IMPOSTOR_TEXTURE / ISO_IMPOSTOR_WIDTH;
+    cache->rows = (slots + cache->columns - 1) / cache->columns;
+
+    cache->slots = isoCalloc(ISO_MEM_RENDER, slots, sizeof(IsoImpostorSlot));
+    cache->pixels = isoMalloc(ISO_MEM_RENDER, (size_t)slots * ISO_IMPOSTOR_PIXELS);
+    cache->uploads = isoMalloc(ISO_MEM_RENDER, slots * sizeof(uint32_t));
+    if (!cache->slots || !cache->pixels || !cache->uploads)
+    {
+        isoImpostorCacheDestroy(cache);
+        return 0;
+    }
+
+    cache->frame = 1;
+    cache->budget = ISO_IMPOSTOR_BUDGET;
+    return 1;
+}
+
+void isoImpostorCacheDestroy(IsoImpostorCache* cache)
+{
+    for (uint32_t i = 0; i < ISO_IMPOSTOR_LEVELS; i++)
+        isoFree(cache->lookup[i]);
+
+    for (uint32_t i = 0; i < ISO_LAYER_MAX; i++)
+        isoFree(cache->swatches[i]);
+
+    isoFree(cache->slots);
+    isoFree(cache->pixels);
+    isoFree(cache->uploads);
+    isoFree(cache->vertices);
+
+    memset(cache, 0, sizeof(IsoImpostorCache));
+}
+
+uint32_t isoImpostorLevel(const IsoImpostorCache* cache, const IsoMap* map, float zoom)
+{
+    // screen width of a level 0 impostor
+    float footprint = 2.0f * ISO_CHUNK_SIZE * map->tile_size * zoom;
+    if (!cache->level_count || footprint > ISO_IMPOSTOR_WIDTH) return ISO_IMPOSTOR_NONE;
+
+    // the level whose image size is closest to its size on screen
+    uint32_t level = 0;
+    while (footprint < ISO_IMPOSTOR_WIDTH * .7071f && level + 1 < cache->level_count)
+    {
+        footprint *= 2.0f;
+        level++;
+    }
+    return level;
+}
+
+const uint8_t* isoImpostorPixels(const IsoImpostorCache* cache, uint32_t slot)
+{
+    return cache->pixels + (size_t)slot * ISO_IMPOSTOR_PIXELS;
+}
+
+static uint32_t isoImpostorVersion(const IsoLayerStack* layers, uint32_t level, uint32_t bx, uint32_t by)
+{
+    const IsoMap* map = layers->layers[0].map;
+
+    uint32_t col_min = bx << level, row_min = by << level;
+    uint32_t col_max = (bx + 1) << level, row_max = (by + 1) << level;
+    if (col_max > map->chunk_cols) col_max = map->chunk_cols;
+    if (row_max > map->chunk_rows) row_max = map->chunk_rows;
+
+    uint32_t version = 0;
+    for (uint32_t row = row_min; row < row_max; row++)
+    {
+        for (uint32_t col = col_min; col < col_max; col++)
+            version += isoLayerStackChunkVersion(layers, row * map->chunk_cols + col);
+    }
+    return version;
+}
+
+static void isoImpostorSwatch(const IsoImpostorCache* cache, uint8_t* image, const uint8_t* swatch, uint32_t px, float y)
+{
+    int32_t py = (int32_t)floorf(y + .5f);
+    for (uint32_t sy = 0; sy < cache->swatch_h; sy++)
+    {
+        int32_t iy = py + (int32_t)sy;
+        if (iy < 0 || iy >= ISO_IMPOSTOR_HEIGHT) continue;
+
+        uint8_t* dst = image + ((size_t)iy * ISO_IMPOSTOR_WIDTH + px) * 4;
+        const uint8_t* src = swatch + (size_t)sy * cache->swatch_w * 4;
+        for (uint32_t sx = 0; sx < cache->swatch_w; sx++, dst += 4, src += 4)
+        {
+            if (src[3]) isoImpostorBlend(dst, src);
+        }
+    }
+}
+
+/* draws the static layers of a chunk like renderLayers, without culling */
+static void isoImpostorRasterize(const IsoImpostorCache* cache, const IsoLayerStack* layers, uint32_t chunk_col, uint32_t chunk_row, uint8_t* image)
+{
+    const IsoMap* map = layers->layers[0].map;
+    memset(image, 0, ISO_IMPOSTOR_PIXELS);
+
+    uint32_t col_min = chunk_col << ISO_CHUNK_SHIFT;
+    uint32_t row_min = chunk_row << ISO_CHUNK_SHIFT;
+    uint32_t cols = map->width - col_min < ISO_CHUNK_SIZE ? map->width - col_min : ISO_CHUNK_SIZE;
+    uint32_t rows = map->height - row_min < ISO_CHUNK_SIZE ? map->height - row_min : ISO_CHUNK_SIZE;
+
+    const IsoChunk* chunks[ISO_LAYER_MAX];
+    for (uint32_t i = 0; i < layers->count; i++)
+        chunks[i] = isoMapGetChunk(layers->layers[i].map, col_min, row_min);
+
+    size_t swatch_size = (size_t)cache->swatch_w * cache->swatch_h * 4;
+    float half = map->tile_size * .5f * cache->scale;
+    float level_step = map->tile_offset * cache->scale;
+
+    for (uint32_t y = 0; y < rows; y++)
+    {
+        for (uint32_t x = 0; x < cols; x++)
+        {
+            // the bottom of the block is the bottom of the image
+            uint32_t px = (x + ISO_CHUNK_SIZE - 1 - y) * cache->swatch_w / 2;
+            float py = ISO_IMPOSTOR_HEIGHT - (2 * ISO_CHUNK_SIZE - x - y) * half - level_step;
+
+            uint32_t base = 0;
+            for (uint32_t i = 0; i < layers->count; i++)
+            {
+                const IsoTileLayer* layer = &layers->layers[i];
+                if (!(layer->mode & ISO_LAYER_STATIC)) continue;
+
+                uint32_t tile = isoChunkGet(chunks[i], x, y);
+                if (ISO_TILE_ID(tile) == ISO_TILE_EMPTY)
+                    continue;
+
+                const IsoAtlasFrame* frame = isoAtlasTileFrame(layer->texture_atlas, ISO_TILE_ID(tile));
+                if (frame)
+                {
+                    const uint8_t* swatch = cache->swatches[i] + (frame - layer->texture_atlas->frames) * swatch_size;
+                    for (uint32_t level = base; level <= base + ISO_TILE_ELEVATION(tile); level++)
+                        isoImpostorSwatch(cache, image, swatch, px, py - level * level_step);
+                }
+
+                if (i == 0) base = isoLayerBase(tile);
+            }
+        }
+    }
+}
+
+/* draws a child at half size into its quarter of the parent */
+static void isoImpostorDownsample(uint8_t* parent, const uint8_t* child, uint32_t i, uint32_t j)
+{
+    uint32_t ox = (i + 1 - j) * ISO_IMPOSTOR_WIDTH / 4;
+    uint32_t oy = ISO_IMPOSTOR_HEIGHT / 2 - ISO_IMPOSTOR_WIDTH / 4 + (i + j) * ISO_IMPOSTOR_WIDTH / 8;
+
+    for (uint32_t y = 0; y < ISO_IMPOSTOR_HEIGHT / 2; y++)
+    {
+        const uint8_t* top = child + (size_t)(2 * y) * ISO_IMPOSTOR_WIDTH * 4;
+        const uint8_t* bottom = top + ISO_IMPOSTOR_WIDTH * 4;
+        uint8_t* dst = parent + ((size_t)(oy + y) * ISO_IMPOSTOR_WIDTH + ox) * 4;
+
+        for (uint32_t x = 0; x < ISO_IMPOSTOR_WIDTH / 2; x++, top += 8, bottom += 8, dst += 4)
+        {
+            if (!(top[3] | top[7] | bottom[3] | bottom[7])) continue;
+
+            uint8_t src[4];
+            for (uint32_t c = 0; c < 4; c++)
+                src[c] = (uint8_t)((top[c] + top[c + 4] + bottom[c] + bottom[c + 4] + 2) / 4);
+
+            isoImpostorBlend(dst, src);
+        }
+    }
+}
+
+/* least recently used slot not used this frame, -1 if there is none */
+static int32_t isoImpostorEvict(IsoImpostorCache* cache)
+{
+    uint32_t lru = 0;
+    for (uint32_t i = 1; i < cache->slot_count; i++)
+    {
+        if (cache->slots[i].last_used < cache->slots[lru].last_used)
+            lru = i;
+    }
+
+    IsoImpostorSlot* slot = &cache->slots[lru];
+    if (slot->last_used == cache->frame) return -1;
+
+    if (cache->lookup[slot->level][slot->block] == (int32_t)lru)
+        cache->lookup[slot->level][slot->block] = -1;
+
+    return (int32_t)lru;
+}
+
+static int32_t isoImpostorFetch(IsoImpostorCache* cache, const IsoLayerStack* layers, uint32_t level, uint32_t bx, uint32_t by, int visible);
+
+static int isoImpostorBuild(IsoImpostorCache* cache, const IsoLayerStack* layers, uint32_t index, uint32_t level, uint32_t bx, uint32_t by)
+{
+    uint8_t* image = cache->pixels + (size_t)index * ISO_IMPOSTOR_PIXELS;
+    if (!level)
+    {
+        isoImpostorRasterize(cache, layers, bx, by, image);
+        cache->budget_left--;
+        cache->rasterized++;
+        return 1;
+    }
+
+    // children in draw order, each one is free to go once it is drawn
+    memset(image, 0, ISO_IMPOSTOR_PIXELS);
+    for (uint32_t j = 0; j < 2; j++)
+    {
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            uint32_t x = bx * 2 + i, y = by * 2 + j;
+            if (x >= cache->blocks_x[level - 1] || y >= cache->blocks_y[level - 1])
+                continue;
+
+            int32_t child = isoImpostorFetch(cache, layers, level - 1, x, y, 0);
+            if (child < 0) return 0;
+
+            isoImpostorDownsample(image, cache->pixels + (size_t)child * ISO_IMPOSTOR_PIXELS, i, j);
+            cache->slots[child].last_used = cache->frame - 1;
+        }
+    }
+    return 1;
+}
+
+/*
+ * An up to date impostor, -1 if out of slots. Visible impostors are not built
+ * once the budget is used up, stale ones are drawn as they are until then.
+ */
+static int32_t isoImpostorFetch(IsoImpostorCache* cache, const IsoLayerStack* layers, uint32_t level, uint32_t bx, uint32_t by, int visible)
+{
+    uint32_t block = by * cache->blocks_x[level] + bx;
+    uint32_t version = isoImpostorVersion(layers, level, bx, by);
+    int32_t index = cache->lookup[level][block];
+
+    if (index >= 0)
+    {
+        IsoImpostorSlot* slot = &cache->slots[index];
+        slot->last_used = cache->frame;
+        if (slot->version == version || (visible && cache->budget_left <= 0))
+            return index;
+    }
+    else
+    {
+        if (visible && cache->budget_left <= 0) return -1;
+
+        index = isoImpostorEvict(cache);
+        if (index < 0) return -1;
+
+        IsoImpostorSlot* slot = &cache->slots[index];
+        slot->level = level;
+        slot->block = block;
+        slot->last_used = cache->frame;
+        cache->lookup[level][block] = index;
+    }
+
+    IsoImpostorSlot* slot = &cache->slots[index];
+    if (!isoImpostorBuild(cache, layers, (uint32_t)index, level, bx, by))
+    {
+        // half built, the next fetch starts over
+        cache->lookup[level][block] = -1;
+        slot->last_used = 0;
+        return -1;
+    }
+
+    slot->version = version;
+    slot->uploaded = 0;
+    cache->rebuilt++;
+    return index;
+}
+
+static int isoImpostorQuad(IsoImpostorCache* cache, const IsoMap* map, uint32_t index, uint32_t level, uint32_t bx, uint32_t by)
+{
+    if (cache->quads >= cache->capacity)
+    {
+        uint32_t capacity = cache->capacity ? cache->capacity * 2 : 256;
+        IsoVertex* vertices = isoRealloc(ISO_MEM_RENDER, cache->vertices, (size_t)capacity * ISO_QUAD_VERTICES * sizeof(IsoVertex));
+        if (!vertices) return 0;
+
+        cache->vertices = vertices;
+        cache->capacity = capacity;
+    }
+
+    // bounds of the block's tile images with the image's headroom above
+    float size = (float)(ISO_CHUNK_SIZE << level);
+    float col = (float)((bx << level) << ISO_CHUNK_SHIFT);
+    float row = (float)((by << level) << ISO_CHUNK_SHIFT);
+    float scale = cache->scale / (float)(1u << level);
+
+    float w = ISO_IMPOSTOR_WIDTH / scale;
+    float h = ISO_IMPOSTOR_HEIGHT / scale;
+    float x = (col - row - size) * map->tile_size;
+    float y = (col + row) * map->tile_size * .5f + size * map->tile_size + map->tile_offset - h;
+
+    float texture_w = (float)(cache->columns * ISO_IMPOSTOR_WIDTH);
+    float texture_h = (float)(cache->rows * ISO_IMPOSTOR_HEIGHT);
+    float u = (index % cache->columns) * ISO_IMPOSTOR_WIDTH / texture_w;
+    float v = (index / cache->columns) * ISO_IMPOSTOR_HEIGHT / texture_h;
+    float du = ISO_IMPOSTOR_WIDTH / texture_w;
+    float dv = ISO_IMPOSTOR_HEIGHT / texture_h;
+
+    IsoVertex* quad = cache->vertices + (size_t)cache->quads * ISO_QUAD_VERTICES;
+    quad[0] = (IsoVertex){ x,     y,     0.0f, u,      v,      0.0f };
+    quad[1] = (IsoVertex){ x + w, y,     0.0f, u + du, v,      0.0f };
+    quad[2] = (IsoVertex){ x + w, y + h, 0.0f, u + du, v + dv, 0.0f };
+    quad[3] = (IsoVertex){ x,     y + h, 0.0f, u,      v + dv, 0.0f };
+
+    cache->quads++;
+    return 1;
+}
+
+int isoImpostorCacheUpdate(IsoImpostorCache* cache, const IsoLayerStack* layers, rect view, uint32_t level)
+{
+    const IsoMap* map = layers->layers[0].map;
+
+    cache->quads = 0;
+    cache->rebuilt = 0;
+    cache->rasterized = 0;
+    cache->budget_left = (int32_t)cache->budget;
+    cache->frame++;
+
+    IsoTileRange range;
+    if (level >= cache->level_count || !isoLayerStackVisibleRange(layers, view, ISO_LAYER_STATIC, &range))
+        return 1;
+
+    uint32_t shift = ISO_CHUNK_SHIFT + level;
+    for (uint32_t by = range.row_min >> shift; by <= range.row_max >> shift; by++)
+    {
+        uint32_t row_min = by << shift;
+        uint32_t row_max = row_min + (1u << shift) - 1;
+
+        if (row_min < range.row_min) row_min = range.row_min;
+        if (row_max > range.row_max) row_max = range.row_max;
+
+        // union of the visible spans of all rows of the block row
+        uint32_t col_min = map->width, col_max = 0;
+        for (uint32_t row = row_min; row <= row_max; row++)
+        {
+            uint32_t min, max;
+            if (!isoTileRangeRow(map, &range, row, &min, &max))
+                continue;
+
+            if (min < col_min) col_min = min;
+            if (max > col_max) col_max = max;
+        }
+
+        if (col_min > col_max) continue;
+
+        for (uint32_t bx = col_min >> shift; bx <= col_max >> shift; bx++)
+        {
+            int32_t index = isoImpostorFetch(cache, layers, level, bx, by, 1);
+            if (index < 0) continue;
+
+            IsoImpostorSlot* slot = &cache->slots[index];
+            if (!slot->uploaded && cache->upload_count < cache->slot_count)
+            {
+                cache->uploads[cache->upload_count++] = (uint32_t)index;
+                slot->uploaded = 1;
+            }
+
+            if (!isoImpostorQuad(cache, map, (uint32_t)index, level, bx, by))
+                return 0;
+        }
+    }
+
+    return 1;
+}
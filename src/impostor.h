@@ -0,0 +1,87 @@
+#ifndef IMPOSTOR_H
+#define IMPOSTOR_H
+
+#include "iso.h"
+#include "layer.h"
+
+#define ISO_IMPOSTOR_WIDTH  256 /* pixels of an impostor at every level */
+#define ISO_IMPOSTOR_HEIGHT 160
+#define ISO_IMPOSTOR_LEVELS 10  /* level l covers 2^l * 2^l chunks */
+#define ISO_IMPOSTOR_NONE   UINT32_MAX
+
+/*
+ * Pre-rendered images of whole blocks of chunks for views zoomed out too far
+ * for tiles. The images form a pyramid: a level 0 impostor is one chunk drawn
+ * from tile swatches, box filtered down from the atlas pixels, and every level
+ * above is made of the four impostors below it at half size. A block is drawn
+ * as one quad, so zooming out never costs more quads than fit on the screen.
+ *
+ * Impostors keep the version of their chunks (see isoLayerStackChunkVersion)
+ * and are rebuilt lazily the next time they are drawn after one of them
+ * changed, within a budget of rasterized chunks per update. Images live on
+ * the cpu so parents can be built from their children and are uploaded by
+ * isoMapCacheRenderImpostors when drawn. Slots are recycled least recently
+ * used first.
+ *
+ * Only static layers are drawn, animated tiles keep the frame they had when
+ * their impostor was built. Stacks higher than the headroom above the ground
+ * diamond are clipped.
+ */
+typedef struct
+{
+    uint32_t level;
+    uint32_t block;
+    uint32_t version;
+    uint32_t last_used; /* 0 for free slots */
+    uint32_t uploaded;
+} IsoImpostorSlot;
+
+typedef struct
+{
+    IsoImpostorSlot* slots;
+    uint32_t slot_count;
+    uint8_t* pixels;  /* per slot, premultiplied rgba */
+    uint32_t columns; /* slots per row of the texture */
+    uint32_t rows;
+
+    int32_t* lookup[ISO_IMPOSTOR_LEVELS]; /* block -> slot or -1 */
+    uint32_t blocks_x[ISO_IMPOSTOR_LEVELS];
+    uint32_t blocks_y[ISO_IMPOSTOR_LEVELS];
+    uint32_t level_count;
+
+    /* per layer and atlas frame, premultiplied rgba */
+    uint8_t* swatches[ISO_LAYER_MAX];
+    uint32_t swatch_w;
+    uint32_t swatch_h;
+    float scale; /* impostor pixels per map pixel at level 0 */
+
+    uint32_t* uploads; /* slots to upload before drawing */
+    uint32_t upload_count;
+
+    IsoVertex* vertices;
+    uint32_t capacity; /* in quads */
+    uint32_t quads;
+
+    uint32_t frame;
+    uint32_t budget; /* chunks rasterized per update */
+    int32_t budget_left;
+
+    /* stats of the last update */
+    uint32_t rebuilt;
+    uint32_t rasterized;
+} IsoImpostorCache;
+
+/* layers must not change afterwards except for their tiles. Returns 0 if an atlas has no pixels or out of memory */
+int isoImpostorCacheInit(IsoImpostorCache* cache, const IsoLayerStack* layers, uint32_t slots);
+void isoImpostorCacheDestroy(IsoImpostorCache* cache);
+
+/* level to draw at zoom (screen pixels per map pixel), ISO_IMPOSTOR_NONE while tiles are small enough */
+uint32_t isoImpostorLevel(const IsoImpostorCache* cache, const IsoMap* map, float zoom);
+
+/* brings the impostors of level visible in view up to date and writes their map space quads */
+int isoImpostorCacheUpdate(IsoImpostorCache* cache, const IsoLayerStack* layers, rect view, uint32_t level);
+
+/* premultiplied rgba of a slot, ISO_IMPOSTOR_WIDTH * ISO_IMPOSTOR_HEIGHT pixels */
+const uint8_t* isoImpostorPixels(const IsoImpostorCache* cache, uint32_t slot);
+
+#endif // !IMPOSTOR_H
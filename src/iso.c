@@ -1,6 +1,10 @@
 #include "iso.h"
+#include "alloc.h"
+#include "mapfile.h"
+#include "occlusion.h"
+#include "render.h"
 
-#include <ignis/renderer/renderer.h>
+#include <stdlib.h>
 
 vec2 isoToCartesian(vec2 iso)
 {
@@ -20,14 +24,124 @@ vec2 cartesianToIso(vec2 cartesian)
     return iso;
 }
 
-void isoMapInit(IsoMap* map, uint32_t* grid, uint32_t width, uint32_t height, float tile_size, float tile_offset)
+void isoToCartesianArray(const float* x, const float* y, float* out_x, float* out_y, size_t count)
+{
+    IsoAffine affine = {
+         .5f, 1.0f, 0.0f,
+        -.5f, 1.0f, 0.0f
+    };
+    isoAffineTransform(&affine, x, y, out_x, out_y, count);
+}
+
+void cartesianToIsoArray(const float* x, const float* y, float* out_x, float* out_y, size_t count)
+{
+    IsoAffine affine = {
+        1.0f, -1.0f, 0.0f,
+         .5f,   .5f, 0.0f
+    };
+    isoAffineTransform(&affine, x, y, out_x, out_y, count);
+}
+
+int isoMapInit(IsoMap* map, const uint32_t* grid, uint32_t width, uint32_t height, float tile_size, float tile_offset)
 {
-    map->grid = grid;
     map->width = width;
     map->height = height;
     map->tile_size = tile_size;
     map->tile_offset = tile_offset;
+    map->max_elevation = 0;
     map->origin = vec2_zero();
+    map->file = NULL;
+
+    map->chunk_cols = (width + ISO_CHUNK_MASK) >> ISO_CHUNK_SHIFT;
+    map->chunk_rows = (height + ISO_CHUNK_MASK) >> ISO_CHUNK_SHIFT;
+
+    // calloc leaves every chunk uniform and empty
+    map->chunks = isoCalloc(ISO_MEM_MAP, (size_t)map->chunk_cols * map->chunk_rows, sizeof(IsoChunk));
+    if (!map->chunks) return 0;
+
+    if (!grid) return 1;
+
+    for (size_t i = 0; i < (size_t)width * height; i++)
+    {
+        if (ISO_TILE_ELEVATION(grid[i]) > map->max_elevation)
+            map->max_elevation = ISO_TILE_ELEVATION(grid[i]);
+    }
+
+    for (uint32_t y = 0; y < map->chunk_rows; y++)
+    {
+        for (uint32_t x = 0; x < map->chunk_cols; x++)
+        {
+            uint32_t col = x << ISO_CHUNK_SHIFT;
+            uint32_t row = y << ISO_CHUNK_SHIFT;
+
+            uint32_t w = width - col < ISO_CHUNK_SIZE ? width - col : ISO_CHUNK_SIZE;
+            uint32_t h = height - row < ISO_CHUNK_SIZE ? height - row : ISO_CHUNK_SIZE;
+
+            IsoChunk* chunk = &map->chunks[y * map->chunk_cols + x];
+            if (!isoChunkLoad(chunk, grid + (size_t)row * width + col, width, w, h))
+            {
+                isoMapDestroy(map);
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+void isoMapDestroy(IsoMap* map)
+{
+    if (!map->chunks) return;
+
+    for (uint32_t i = 0; i < map->chunk_cols * map->chunk_rows; i++)
+        isoChunkFree(&map->chunks[i]);
+
+    isoFree(map->chunks);
+    map->chunks = NULL;
+
+    // after the chunks, they may point into the file
+    if (map->file) isoFileUnmap(map->file);
+    map->file = NULL;
+}
+
+IsoChunk* isoMapGetChunk(const IsoMap* map, uint32_t col, uint32_t row)
+{
+    return &map->chunks[(row >> ISO_CHUNK_SHIFT) * map->chunk_cols + (col >> ISO_CHUNK_SHIFT)];
+}
+
+uint32_t isoMapGetTile(const IsoMap* map, uint32_t col, uint32_t row)
+{
+    if (col >= map->width || row >= map->height) return ISO_TILE_EMPTY;
+    return ISO_TILE_ID(isoChunkGet(isoMapGetChunk(map, col, row), col & ISO_CHUNK_MASK, row & ISO_CHUNK_MASK));
+}
+
+int isoMapSetTile(IsoMap* map, uint32_t col, uint32_t row, uint32_t tile)
+{
+    if (col >= map->width || row >= map->height) return 0;
+
+    IsoChunk* chunk = isoMapGetChunk(map, col, row);
+    uint32_t old = isoChunkGet(chunk, col & ISO_CHUNK_MASK, row & ISO_CHUNK_MASK);
+    return isoChunkSet(chunk, col & ISO_CHUNK_MASK, row & ISO_CHUNK_MASK, (old & ~ISO_TILE_ID_MASK) | ISO_TILE_ID(tile));
+}
+
+uint32_t isoMapGetElevation(const IsoMap* map, uint32_t col, uint32_t row)
+{
+    if (col >= map->width || row >= map->height) return 0;
+    return ISO_TILE_ELEVATION(isoChunkGet(isoMapGetChunk(map, col, row), col & ISO_CHUNK_MASK, row & ISO_CHUNK_MASK));
+}
+
+int isoMapSetElevation(IsoMap* map, uint32_t col, uint32_t row, uint32_t elevation)
+{
+    if (col >= map->width || row >= map->height || elevation > ISO_TILE_MAX_ELEVATION) return 0;
+
+    IsoChunk* chunk = isoMapGetChunk(map, col, row);
+    uint32_t old = isoChunkGet(chunk, col & ISO_CHUNK_MASK, row & ISO_CHUNK_MASK);
+    if (!isoChunkSet(chunk, col & ISO_CHUNK_MASK, row & ISO_CHUNK_MASK, ISO_TILE_ID(old) | (elevation << ISO_TILE_ELEVATION_SHIFT)))
+        return 0;
+
+    // only ever grows, lowering tiles keeps the bound conservative
+    if (elevation > map->max_elevation) map->max_elevation = elevation;
+    return 1;
 }
 
 void isoMapSetOrigin(IsoMap* map, vec2 origin)
@@ -45,6 +159,25 @@ vec2 worldToScreen(const IsoMap* map, vec2 point)
     return vec2_add(cartesianToIso(point), map->origin);
 }
 
+void screenToWorldArray(const IsoMap* map, const float* x, const float* y, float* out_x, float* out_y, size_t count)
+{
+    vec2 o = map->origin;
+    IsoAffine affine = {
+         .5f, 1.0f, -.5f * o.x - o.y,
+        -.5f, 1.0f,  .5f * o.x - o.y
+    };
+    isoAffineTransform(&affine, x, y, out_x, out_y, count);
+}
+
+void worldToScreenArray(const IsoMap* map, const float* x, const float* y, float* out_x, float* out_y, size_t count)
+{
+    IsoAffine affine = {
+        1.0f, -1.0f, map->origin.x,
+         .5f,   .5f, map->origin.y
+    };
+    isoAffineTransform(&affine, x, y, out_x, out_y, count);
+}
+
 uint32_t tileClip(const IsoMap* map, float f) { return (uint32_t)floorf(f / map->tile_size); }
 
 vec2 getTileScreenPos(const IsoMap* map, uint32_t col, uint32_t row)
@@ -53,28 +186,161 @@ vec2 getTileScreenPos(const IsoMap* map, uint32_t col, uint32_t row)
     return worldToScreen(map, vec2_mult(point, map->tile_size));
 }
 
+void getTileScreenPosArray(const IsoMap* map, const uint32_t* cols, const uint32_t* rows, float* out_x, float* out_y, size_t count)
+{
+    // worldToScreen of ((col - .5) * tile_size, (row + .5) * tile_size)
+    float ts = map->tile_size;
+    IsoAffine affine = {
+        ts,        -ts,       map->origin.x - ts,
+        ts * .5f,  ts * .5f,  map->origin.y
+    };
+    isoAffineTransformU32(&affine, cols, rows, out_x, out_y, count);
+}
+
 vec2 getTileScreenCenter(const IsoMap* map, uint32_t col, uint32_t row)
 {
     vec2 point = { col + .5f, row + .5f };
     return worldToScreen(map, vec2_mult(point, map->tile_size));
 }
 
-void renderMap(const IsoMap* map, const IgnisTexture2D* texture_atlas)
+int isoMapGetVisibleRange(const IsoMap* map, rect view, IsoTileRange* range)
 {
-    for (uint32_t i = 0; i < map->width * map->height; i++)
+    float tile_size = map->tile_size;
+
+    // viewport corners in world space give the diamond bounds
+    vec2 min = vec2_div(screenToWorld(map, view.min), tile_size);
+    vec2 max = vec2_div(screenToWorld(map, view.max), tile_size);
+
+    // a tile image spans one tile left and right of its top corner
+    // and reaches tile_size + tile_offset below it
+    range->diff_min = (int32_t)floorf(min.x - min.y);
+    range->diff_max = (int32_t)ceilf(max.x - max.y);
+    range->sum_min = (int32_t)floorf(min.x + min.y - 2.0f - 2.0f * map->tile_offset / tile_size) + 1;
+    range->sum_max = (int32_t)ceilf(max.x + max.y + 2.0f * map->max_elevation * map->tile_offset / tile_size) - 1;
+
+    float row_min = ceilf((range->sum_min - range->diff_max) * .5f);
+    float row_max = floorf((range->sum_max - range->diff_min) * .5f);
+
+    if (row_max < 0.0f || row_min >= (float)map->height || row_min > row_max)
+        return 0;
+
+    range->row_min = row_min > 0.0f ? (uint32_t)row_min : 0;
+    range->row_max = row_max < (float)map->height ? (uint32_t)row_max : map->height - 1;
+
+    return 1;
+}
+
+int isoTileRangeRow(const IsoMap* map, const IsoTileRange* range, uint32_t row, uint32_t* col_min, uint32_t* col_max)
+{
+    int32_t r = (int32_t)row;
+
+    int32_t min = r + range->diff_min;
+    int32_t max = r + range->diff_max;
+
+    if (range->sum_min - r > min) min = range->sum_min - r;
+    if (range->sum_max - r < max) max = range->sum_max - r;
+
+    if (min < 0) min = 0;
+    if (max >= (int32_t)map->width) max = (int32_t)map->width - 1;
+
+    if (min > max) return 0;
+
+    *col_min = (uint32_t)min;
+    *col_max = (uint32_t)max;
+    return 1;
+}
+
+int isoMapTileQuad(const IsoMap* map, const IsoAtlas* texture_atlas, uint32_t col, uint32_t row, uint32_t level, uint32_t frame, IsoVertex* vertices)
+{
+    const IsoAtlasFrame* src = isoAtlasTileFrame(texture_atlas, frame);
+    if (!src) return 0;
+
+    vec2 point = { col - .5f, row + .5f };
+    vec2 pos = cartesianToIso(vec2_mult(point, map->tile_size));
+    pos.y -= level * map->tile_offset;
+
+    float w = map->tile_size * 2.0f;
+    float h = map->tile_size + map->tile_offset;
+
+    float u = src->src.x;
+    float v = src->src.y;
+    float frame_w = src->src.w;
+    float frame_h = src->src.h;
+    float t = (float)(ISO_TEXTURE_UNITS * isoAtlasTileAnimation(texture_atlas, frame));
+
+    vertices[0] = (IsoVertex){ pos.x,     pos.y,     0.0f, u,           v,           t };
+    vertices[1] = (IsoVertex){ pos.x + w, pos.y,     0.0f, u + frame_w, v,           t };
+    vertices[2] = (IsoVertex){ pos.x + w, pos.y + h, 0.0f, u + frame_w, v + frame_h, t };
+    vertices[3] = (IsoVertex){ pos.x,     pos.y + h, 0.0f, u,           v + frame_h, t };
+    return 1;
+}
+
+void renderTile(const IsoMap* map, const IsoAtlas* texture_atlas, uint32_t col, uint32_t row, uint32_t tile, uint32_t first)
+{
+    const IsoAtlasFrame* src = isoAtlasTileFrame(texture_atlas, ISO_TILE_ID(tile));
+    if (!src) return;
+
+    vec2 pos = getTileScreenPos(map, col, row);
+    IgnisRect rect = {
+        pos.x, pos.y - first * map->tile_offset,
+        map->tile_size * 2.0f,
+        map->tile_size + map->tile_offset
+    };
+
+    // bottom up, each level hides the top of the one below
+    for (uint32_t level = first; level <= ISO_TILE_ELEVATION(tile); level++)
+    {
+        isoRenderSetTileOrder(col, row, level, 0);
+        isoRenderTextureSrc(&texture_atlas->texture, rect, src->src);
+        rect.y -= map->tile_offset;
+    }
+}
+
+void renderMap(const IsoMap* map, const IsoAtlas* texture_atlas, rect view)
+{
+    IsoTileRange range;
+    if (!isoMapGetVisibleRange(map, view, &range))
+        return;
+
+    // flat maps have nothing to hide
+    size_t mark = isoFrameMark();
+    IsoOcclusion occlusion = { 0 };
+    if (map->max_elevation)
+        isoOcclusionBuild(&occlusion, map, texture_atlas, &range, 0, range.row_min, map->width - 1, range.row_max);
+
+    for (uint32_t row = range.row_min; row <= range.row_max; row++)
     {
-        uint32_t col = i % map->width;
-        uint32_t row = i / map->width;
-
-        vec2 pos = getTileScreenPos(map, col, row);
-        IgnisRect rect = {
-            pos.x, pos.y,
-            map->tile_size * 2.0f,
-            map->tile_size + map->tile_offset
-        };
-        uint32_t frame = map->grid[i];
-        ignisBatch2DRenderTextureFrame(texture_atlas, rect, frame);
+        uint32_t col_min, col_max;
+        if (!isoTileRangeRow(map, &range, row, &col_min, &col_max))
+            continue;
+
+        // walk the span chunk by chunk so each segment is one contiguous row
+        uint32_t col = col_min;
+        while (col <= col_max)
+        {
+            const IsoChunk* chunk = isoMapGetChunk(map, col, row);
+            const uint32_t* tiles = isoChunkRow(chunk, row & ISO_CHUNK_MASK);
+
+            uint32_t end = col | ISO_CHUNK_MASK;
+            if (end > col_max) end = col_max;
+
+            if (!tiles && chunk->value == ISO_TILE_EMPTY)
+            {
+                col = end + 1;
+                continue;
+            }
+
+            for (; col <= end; col++)
+            {
+                uint32_t tile = tiles ? tiles[col & ISO_CHUNK_MASK] : chunk->value;
+                if (ISO_TILE_ID(tile) == ISO_TILE_EMPTY) continue;
+
+                renderTile(map, texture_atlas, col, row, tile, isoOcclusionFirst(&occlusion, col, row));
+            }
+        }
     }
+
+    isoFrameRelease(mark);
 }
 
 void highlightTile(const IsoMap* map, vec2 world)
@@ -87,11 +353,11 @@ void highlightTile(const IsoMap* map, vec2 world)
 
     // hightlight isometric version / screen
     vec2 center = getTileScreenCenter(map, col, row);
-    ignisPrimitives2DRenderRhombus(center.x, center.y, 2 * map->tile_size, map->tile_size, IGNIS_WHITE);
-    ignisPrimitives2DFillCircle(center.x, center.y, 2, IGNIS_WHITE);
+    isoRenderRhombus(center.x, center.y, 2 * map->tile_size, map->tile_size, IGNIS_WHITE);
+    isoRenderFillCircle(center.x, center.y, 2, IGNIS_WHITE);
 
     // hightlight cartesian version / world
     float tile_size = map->tile_size;
-    ignisPrimitives2DRenderRect(col * tile_size, row * tile_size, tile_size, tile_size, IGNIS_WHITE);
-    ignisPrimitives2DFillCircle(world.x, world.y, 3, IGNIS_BLUE);
+    isoRenderRect(col * tile_size, row * tile_size, tile_size, tile_size, IGNIS_WHITE);
+    isoRenderFillCircle(world.x, world.y, 3, IGNIS_BLUE);
 }
\ No newline at end of file
@@ -4,30 +4,105 @@
 #include <Ignis/Ignis.h>
 
 #include "math/math.h"
+#include "chunk.h"
+#include "atlas.h"
+#include "transform.h"
 
 vec2 isoToCartesian(vec2 iso);
 vec2 cartesianToIso(vec2 cartesian);
 
+/* batched versions over structure-of-arrays points, see transform.h */
+void isoToCartesianArray(const float* x, const float* y, float* out_x, float* out_y, size_t count);
+void cartesianToIsoArray(const float* x, const float* y, float* out_x, float* out_y, size_t count);
+
 typedef struct
 {
     vec2 origin;
 
-    uint32_t* grid;
+    IsoChunk* chunks;
+    uint32_t chunk_cols;
+    uint32_t chunk_rows;
+
     uint32_t width;
     uint32_t height;
 
     float tile_size;
-    float tile_offset;
+    float tile_offset;      /* also the height of one elevation level */
+    uint32_t max_elevation; /* upper bound of all tile elevations */
+
+    struct IsoMappedFile* file; /* backs mapped chunks, see isoMapOpen */
 } IsoMap;
 
-void isoMapInit(IsoMap* map, uint32_t* grid, uint32_t width, uint32_t height, float tile_size, float tile_offset);
+/* grid is copied into chunks and may be NULL for an empty map */
+int isoMapInit(IsoMap* map, const uint32_t* grid, uint32_t width, uint32_t height, float tile_size, float tile_offset);
+void isoMapDestroy(IsoMap* map);
+
+IsoChunk* isoMapGetChunk(const IsoMap* map, uint32_t col, uint32_t row);
+
+/* tile ids without the elevation, setting a tile keeps its elevation */
+uint32_t isoMapGetTile(const IsoMap* map, uint32_t col, uint32_t row);
+int isoMapSetTile(IsoMap* map, uint32_t col, uint32_t row, uint32_t tile);
+
+/* a tile of elevation e is drawn e levels of tile_offset above the ground */
+uint32_t isoMapGetElevation(const IsoMap* map, uint32_t col, uint32_t row);
+int isoMapSetElevation(IsoMap* map, uint32_t col, uint32_t row, uint32_t elevation);
 
 void isoMapSetOrigin(IsoMap* map, vec2 origin);
 
 vec2 screenToWorld(const IsoMap* map, vec2 point);
 vec2 worldToScreen(const IsoMap* map, vec2 point);
 
-void renderMap(const IsoMap* map, const IgnisTexture2D* texture_atlas);
+void screenToWorldArray(const IsoMap* map, const float* x, const float* y, float* out_x, float* out_y, size_t count);
+void worldToScreenArray(const IsoMap* map, const float* x, const float* y, float* out_x, float* out_y, size_t count);
+
+/* top left corner of the tile images */
+vec2 getTileScreenPos(const IsoMap* map, uint32_t col, uint32_t row);
+void getTileScreenPosArray(const IsoMap* map, const uint32_t* cols, const uint32_t* rows, float* out_x, float* out_y, size_t count);
+
+/*
+ * Tiles that can touch a screen rect form a diamond in tile space, bounded by
+ * col - row (screen x) and col + row (screen y). Rows are clamped to the map.
+ * Raised tiles reach up to max_elevation levels further down the diamond.
+ */
+typedef struct
+{
+    uint32_t row_min;
+    uint32_t row_max;
+
+    int32_t diff_min; /* col - row */
+    int32_t diff_max;
+    int32_t sum_min;  /* col + row */
+    int32_t sum_max;
+} IsoTileRange;
+
+int isoMapGetVisibleRange(const IsoMap* map, rect view, IsoTileRange* range);
+int isoTileRangeRow(const IsoMap* map, const IsoTileRange* range, uint32_t row, uint32_t* col_min, uint32_t* col_max);
+
+/* layout of res/shaders/batch.vert */
+typedef struct
+{
+    float x, y, z;
+    float u, v;
+    float texture; /* unit + ISO_TEXTURE_UNITS * (animation index + 1), see isoAtlasTileAnimation */
+} IsoVertex;
+
+#define ISO_TEXTURE_UNITS 8 /* samplers of res/shaders/batch.frag */
+
+#define ISO_QUAD_VERTICES 4
+#define ISO_QUAD_INDICES  6
+
+/*
+ * Writes the textured quad of a tile in map space, i.e. relative to the
+ * origin, raised by level * tile_offset. Returns 0 and writes nothing if the
+ * tile has no frame. Quads of animated tiles are marked for the shader to
+ * pick the current frame and use texture unit 0.
+ */
+int isoMapTileQuad(const IsoMap* map, const IsoAtlas* texture_atlas, uint32_t col, uint32_t row, uint32_t level, uint32_t frame, IsoVertex* vertices);
+
+/* draws the levels of a tile from first up to its elevation */
+void renderTile(const IsoMap* map, const IsoAtlas* texture_atlas, uint32_t col, uint32_t row, uint32_t tile, uint32_t first);
+
+void renderMap(const IsoMap* map, const IsoAtlas* texture_atlas, rect view);
 void highlightTile(const IsoMap* map, vec2 world);
 
 #endif // !ISO_H
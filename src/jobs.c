@@ -0,0 +1,120 @@
+#include "jobs.h"
+#include "alloc.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* called and returns with the mutex held */
+static void isoJobPoolWork(IsoJobPool* pool)
+{
+    while (pool->next_job < pool->job_count)
+    {
+        uint32_t job = pool->next_job++;
+
+        isoMutexUnlock(pool->mutex);
+        pool->fn(pool->context, job);
+        isoMutexLock(pool->mutex);
+
+        if (++pool->jobs_done == pool->job_count)
+            isoCondBroadcast(pool->done);
+    }
+}
+
+static int isoJobWorker(void* arg)
+{
+    IsoJobPool* pool = arg;
+
+    isoMutexLock(pool->mutex);
+    uint32_t generation = pool->generation;
+    while (1)
+    {
+        while (pool->running && pool->generation == generation)
+            isoCondWait(pool->wake, pool->mutex);
+
+        if (!pool->running) break;
+
+        generation = pool->generation;
+        isoJobPoolWork(pool);
+    }
+    isoMutexUnlock(pool->mutex);
+
+    return 0;
+}
+
+int isoJobPoolInit(IsoJobPool* pool, uint32_t threads)
+{
+    memset(pool, 0, sizeof(IsoJobPool));
+    if (!threads) return 1;
+
+    pool->mutex = isoMutexCreate();
+    pool->wake = isoCondCreate();
+    pool->done = isoCondCreate();
+    pool->threads = isoCalloc(ISO_MEM_JOBS, threads, sizeof(IsoThread*));
+
+    if (!pool->mutex || !pool->wake || !pool->done || !pool->threads)
+    {
+        isoJobPoolDestroy(pool);
+        return 0;
+    }
+
+    pool->running = 1;
+    for (uint32_t i = 0; i < threads; i++)
+    {
+        pool->threads[i] = isoThreadCreate(isoJobWorker, pool);
+        if (!pool->threads[i])
+        {
+            isoJobPoolDestroy(pool);
+            return 0;
+        }
+        pool->thread_count++;
+    }
+
+    return 1;
+}
+
+void isoJobPoolDestroy(IsoJobPool* pool)
+{
+    if (pool->thread_count)
+    {
+        isoMutexLock(pool->mutex);
+        pool->running = 0;
+        isoCondBroadcast(pool->wake);
+        isoMutexUnlock(pool->mutex);
+
+        for (uint32_t i = 0; i < pool->thread_count; i++)
+            isoThreadJoin(pool->threads[i]);
+    }
+
+    if (pool->threads) isoFree(pool->threads);
+    if (pool->mutex) isoMutexDestroy(pool->mutex);
+    if (pool->wake) isoCondDestroy(pool->wake);
+    if (pool->done) isoCondDestroy(pool->done);
+
+    memset(pool, 0, sizeof(IsoJobPool));
+}
+
+void isoJobPoolRun(IsoJobPool* pool, IsoJobFn fn, void* context, uint32_t count)
+{
+    if (!pool || !pool->thread_count || count < 2)
+    {
+        for (uint32_t i = 0; i < count; i++)
+            fn(context, i);
+        return;
+    }
+
+    isoMutexLock(pool->mutex);
+
+    pool->fn = fn;
+    pool->context = context;
+    pool->job_count = count;
+    pool->next_job = 0;
+    pool->jobs_done = 0;
+    pool->generation++;
+    isoCondBroadcast(pool->wake);
+
+    isoJobPoolWork(pool);
+    while (pool->jobs_done < pool->job_count)
+        isoCondWait(pool->done, pool->mutex);
+
+    isoMutexUnlock(pool->mutex);
+}
@@ -0,0 +1,38 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include "thread.h"
+
+typedef void (*IsoJobFn)(void* context, uint32_t index);
+
+/*
+ * Fixed pool of worker threads running parallel for loops. The calling
+ * thread works along, so a pool without workers just runs the loop inline.
+ */
+typedef struct
+{
+    IsoThread** threads;
+    uint32_t thread_count;
+
+    IsoMutex* mutex;
+    IsoCond* wake;
+    IsoCond* done;
+
+    IsoJobFn fn;
+    void* context;
+
+    uint32_t job_count;
+    uint32_t next_job;
+    uint32_t jobs_done;
+    uint32_t generation;
+    int running;
+} IsoJobPool;
+
+/* threads are the workers besides the calling thread */
+int isoJobPoolInit(IsoJobPool* pool, uint32_t threads);
+void isoJobPoolDestroy(IsoJobPool* pool);
+
+/* runs fn(context, i) for every i in [0, count) and returns once all are done */
+void isoJobPoolRun(IsoJobPool* pool, IsoJobFn fn, void* context, uint32_t count);
+
+#endif // !JOBS_H
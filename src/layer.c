@@ -0,0 +1,215 @@
+#include "layer.h"
+#include "alloc.h"
+#include "occlusion.h"
+#include "render.h"
+
+#include <string.h>
+
+void isoLayerStackInit(IsoLayerStack* stack, IsoMap* ground, const IsoAtlas* texture_atlas)
+{
+    memset(stack, 0, sizeof(IsoLayerStack));
+
+    stack->layers[0].name = "ground";
+    stack->layers[0].map = ground;
+    stack->layers[0].texture_atlas = texture_atlas;
+    stack->layers[0].mode = ISO_LAYER_STATIC;
+    stack->count = 1;
+}
+
+uint32_t isoLayerStackPush(IsoLayerStack* stack, const char* name, IsoMap* map, const IsoAtlas* texture_atlas, uint32_t mode)
+{
+    const IsoMap* ground = stack->layers[0].map;
+    if (stack->count >= ISO_LAYER_MAX || map->width != ground->width || map->height != ground->height)
+        return 0;
+
+    IsoTileLayer* layer = &stack->layers[stack->count];
+    layer->name = name;
+    layer->map = map;
+    layer->texture_atlas = texture_atlas;
+    layer->mode = mode == ISO_LAYER_DYNAMIC ? ISO_LAYER_DYNAMIC : ISO_LAYER_STATIC;
+
+    return stack->count++;
+}
+
+uint32_t isoLayerTile(const IsoLayerStack* stack, uint32_t index, uint32_t col, uint32_t row)
+{
+    const IsoChunk* chunk = isoMapGetChunk(stack->layers[index].map, col, row);
+    return isoChunkGet(chunk, col & ISO_CHUNK_MASK, row & ISO_CHUNK_MASK);
+}
+
+uint32_t isoLayerBase(uint32_t ground)
+{
+    return ISO_TILE_ID(ground) != ISO_TILE_EMPTY ? ISO_TILE_ELEVATION(ground) : 0;
+}
+
+int isoLayerChunkUsed(const IsoLayerStack* stack, uint32_t col, uint32_t row, uint32_t modes)
+{
+    for (uint32_t i = 0; i < stack->count; i++)
+    {
+        if (!(stack->layers[i].mode & modes)) continue;
+
+        const IsoChunk* chunk = isoMapGetChunk(stack->layers[i].map, col, row);
+        if (chunk->tiles || chunk->value != ISO_TILE_EMPTY) return 1;
+    }
+    return 0;
+}
+
+uint32_t isoLayerStackMaxElevation(const IsoLayerStack* stack, uint32_t modes)
+{
+    uint32_t upper = 0;
+    for (uint32_t i = 1; i < stack->count; i++)
+    {
+        const IsoTileLayer* layer = &stack->layers[i];
+        if ((layer->mode & modes) && layer->map->max_elevation > upper)
+            upper = layer->map->max_elevation;
+    }
+
+    // every upper tile can have a ground tile below it
+    return stack->layers[0].map->max_elevation + upper;
+}
+
+int isoLayerStackVisibleRange(const IsoLayerStack* stack, rect view, uint32_t modes, IsoTileRange* range)
+{
+    IsoMap ground = *stack->layers[0].map;
+    ground.max_elevation = isoLayerStackMaxElevation(stack, modes);
+    return isoMapGetVisibleRange(&ground, view, range);
+}
+
+uint32_t isoLayerStackChunkVersion(const IsoLayerStack* stack, uint32_t index)
+{
+    uint32_t version = 0;
+    for (uint32_t i = 0; i < stack->count; i++)
+    {
+        if (stack->layers[i].mode & ISO_LAYER_STATIC)
+            version += stack->layers[i].map->chunks[index].version;
+    }
+    return version;
+}
+
+uint32_t isoLayerStackMaxQuads(const IsoLayerStack* stack, uint32_t modes)
+{
+    uint32_t quads = 0;
+    for (uint32_t i = 0; i < stack->count; i++)
+    {
+        if (stack->layers[i].mode & modes)
+            quads += stack->layers[i].map->max_elevation + 1;
+    }
+    return quads;
+}
+
+uint32_t isoLayerTileQuads(const IsoLayerStack* stack, uint32_t col, uint32_t row, uint32_t first, uint32_t modes, IsoVertex* vertices)
+{
+    const IsoMap* ground = stack->layers[0].map;
+    uint32_t tile = isoLayerTile(stack, 0, col, row);
+    uint32_t quads = 0;
+
+    if ((stack->layers[0].mode & modes) && ISO_TILE_ID(tile) != ISO_TILE_EMPTY)
+    {
+        for (uint32_t level = first; level <= ISO_TILE_ELEVATION(tile); level++)
+        {
+            if (!isoMapTileQuad(ground, stack->layers[0].texture_atlas, col, row, level, ISO_TILE_ID(tile), vertices + quads * ISO_QUAD_VERTICES))
+                break;
+            quads++;
+        }
+    }
+
+    uint32_t base = isoLayerBase(tile);
+    for (uint32_t i = 1; i < stack->count; i++)
+    {
+        const IsoTileLayer* layer = &stack->layers[i];
+        if (!(layer->mode & modes)) continue;
+
+        uint32_t upper = isoLayerTile(stack, i, col, row);
+        if (ISO_TILE_ID(upper) == ISO_TILE_EMPTY) continue;
+
+        for (uint32_t level = base; level <= base + ISO_TILE_ELEVATION(upper); level++)
+        {
+            IsoVertex* quad = vertices + quads * ISO_QUAD_VERTICES;
+            if (!isoMapTileQuad(ground, layer->texture_atlas, col, row, level, ISO_TILE_ID(upper), quad))
+                break;
+
+            for (uint32_t v = 0; v < ISO_QUAD_VERTICES; v++)
+                quad[v].texture += (float)i;
+            quads++;
+        }
+    }
+
+    return quads;
+}
+
+void renderLayerTile(const IsoLayerStack* stack, uint32_t col, uint32_t row, uint32_t first, uint32_t modes)
+{
+    const IsoMap* ground = stack->layers[0].map;
+    uint32_t tile = isoLayerTile(stack, 0, col, row);
+
+    if ((stack->layers[0].mode & modes) && ISO_TILE_ID(tile) != ISO_TILE_EMPTY)
+        renderTile(ground, stack->layers[0].texture_atlas, col, row, tile, first);
+
+    vec2 pos = getTileScreenPos(ground, col, row);
+    uint32_t base = isoLayerBase(tile);
+
+    for (uint32_t i = 1; i < stack->count; i++)
+    {
+        const IsoTileLayer* layer = &stack->layers[i];
+        if (!(layer->mode & modes)) continue;
+
+        uint32_t upper = isoLayerTile(stack, i, col, row);
+        if (ISO_TILE_ID(upper) == ISO_TILE_EMPTY) continue;
+
+        const IsoAtlasFrame* src = isoAtlasTileFrame(layer->texture_atlas, ISO_TILE_ID(upper));
+        if (!src) continue;
+
+        IgnisRect rect = {
+            pos.x, pos.y - base * ground->tile_offset,
+            ground->tile_size * 2.0f,
+            ground->tile_size + ground->tile_offset
+        };
+
+        for (uint32_t level = 0; level <= ISO_TILE_ELEVATION(upper); level++)
+        {
+            isoRenderSetTileOrder(col, row, base + level, i);
+            isoRenderTextureSrc(&layer->texture_atlas->texture, rect, src->src);
+            rect.y -= ground->tile_offset;
+        }
+    }
+}
+
+void renderLayers(const IsoLayerStack* stack, rect view, uint32_t modes)
+{
+    const IsoMap* ground = stack->layers[0].map;
+
+    IsoTileRange range;
+    if (!isoLayerStackVisibleRange(stack, view, modes, &range))
+        return;
+
+    size_t mark = isoFrameMark();
+    IsoOcclusion occlusion = { 0 };
+    if ((stack->layers[0].mode & modes) && ground->max_elevation)
+        isoOcclusionBuild(&occlusion, ground, stack->layers[0].texture_atlas, &range, 0, range.row_min, ground->width - 1, range.row_max);
+
+    for (uint32_t row = range.row_min; row <= range.row_max; row++)
+    {
+        uint32_t col_min, col_max;
+        if (!isoTileRangeRow(ground, &range, row, &col_min, &col_max))
+            continue;
+
+        // skip chunks none of the drawn layers has tiles in
+        uint32_t col = col_min;
+        while (col <= col_max)
+        {
+            uint32_t end = col | ISO_CHUNK_MASK;
+            if (end > col_max) end = col_max;
+
+            if (!isoLayerChunkUsed(stack, col, row, modes))
+            {
+                col = end + 1;
+                continue;
+            }
+
+            for (; col <= end; col++)
+                renderLayerTile(stack, col, row, isoOcclusionFirst(&occlusion, col, row), modes);
+        }
+    }
+
+    isoFrameRelease(mark);
+}
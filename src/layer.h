@@ -0,0 +1,77 @@
+#ifndef LAYER_H
+#define LAYER_H
+
+#include "iso.h"
+
+#define ISO_LAYER_MAX ISO_TEXTURE_UNITS /* one texture unit each */
+
+/* how often a layer changes, used as a mask to pick layers */
+#define ISO_LAYER_STATIC  1
+#define ISO_LAYER_DYNAMIC 2
+#define ISO_LAYER_ALL     (ISO_LAYER_STATIC | ISO_LAYER_DYNAMIC)
+
+typedef struct
+{
+    const char* name;
+    IsoMap* map; /* same size as the ground, positions come from the ground */
+    const IsoAtlas* texture_atlas;
+    uint32_t mode;
+} IsoTileLayer;
+
+/*
+ * Ordered tile layers, e.g. ground, decoration, objects and overlays. The
+ * first layer is the ground, it is always static and the only one that is
+ * culled and occludes. Tiles of the other layers sit on top of the ground
+ * tile below them, a tile of elevation e covers e more levels above that.
+ * Layers do not own their maps.
+ *
+ * Static layers are merged into the cached chunk geometry, so they cost one
+ * draw per chunk however many there are and only chunks whose static tiles
+ * changed are rebuilt. Dynamic layers are drawn every frame, in the cached
+ * and threaded render paths on top of the static ones.
+ */
+typedef struct
+{
+    IsoTileLayer layers[ISO_LAYER_MAX];
+    uint32_t count;
+} IsoLayerStack;
+
+void isoLayerStackInit(IsoLayerStack* stack, IsoMap* ground, const IsoAtlas* texture_atlas);
+
+/* returns the index of the layer, 0 if the stack is full or map does not match the ground */
+uint32_t isoLayerStackPush(IsoLayerStack* stack, const char* name, IsoMap* map, const IsoAtlas* texture_atlas, uint32_t mode);
+
+/* highest level any tile of the layers of modes reaches */
+uint32_t isoLayerStackMaxElevation(const IsoLayerStack* stack, uint32_t modes);
+
+/* like isoMapGetVisibleRange on the ground with the elevation of the layers of modes */
+int isoLayerStackVisibleRange(const IsoLayerStack* stack, rect view, uint32_t modes, IsoTileRange* range);
+
+/* sum of the chunk versions of the static layers, grows whenever one of their tiles changes */
+uint32_t isoLayerStackChunkVersion(const IsoLayerStack* stack, uint32_t index);
+
+/* the tile of layer index at col, row */
+uint32_t isoLayerTile(const IsoLayerStack* stack, uint32_t index, uint32_t col, uint32_t row);
+
+/* the level upper tiles stand on, ground is the ground tile below them; a tile of elevation e covers base to base + e */
+uint32_t isoLayerBase(uint32_t ground);
+
+/* 1 if a layer of modes has tiles in the chunk of col, row */
+int isoLayerChunkUsed(const IsoLayerStack* stack, uint32_t col, uint32_t row, uint32_t modes);
+
+/* an upper bound for the quads of a tile in the layers of modes */
+uint32_t isoLayerStackMaxQuads(const IsoLayerStack* stack, uint32_t modes);
+
+/*
+ * Writes the quads of a tile in the layers of modes in draw order, the ground
+ * from level first. vertices needs room for isoLayerStackMaxQuads quads, the
+ * texture unit of each vertex is the index of its layer. Returns the quads written.
+ */
+uint32_t isoLayerTileQuads(const IsoLayerStack* stack, uint32_t col, uint32_t row, uint32_t first, uint32_t modes, IsoVertex* vertices);
+
+/* draws a tile in the layers of modes, the ground from level first */
+void renderLayerTile(const IsoLayerStack* stack, uint32_t col, uint32_t row, uint32_t first, uint32_t modes);
+
+void renderLayers(const IsoLayerStack* stack, rect view, uint32_t modes);
+
+#endif // !LAYER_H
@@ -4,6 +4,44 @@
 #include <minimal/application.h>
 
 #include "iso.h"
+#include "layer.h"
+#include "cache.h"
+#include "impostor.h"
+#include "sim.h"
+#include "entity.h"
+#include "spatial.h"
+#include "pick.h"
+#include "path.h"
+#include "tilegen.h"
+#include "mapfile.h"
+#include "stream.h"
+#include "atlasfile.h"
+#include "profile.h"
+#include "alloc.h"
+#include "raster.h"
+#include "image.h"
+#include "queue.h"
+#include "tilestream.h"
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SIM_TICK_RATE 60.0f
+#define SIM_MAX_TICKS 8  /* per frame, slower frames drop simulation time */
+#define SIM_AGENTS    12
+
+#define STREAM_RADIUS 3         /* chunks */
+#define STREAM_BUDGET (8 << 20) /* bytes */
+
+#define ZOOM_MIN  (1.0f / 256.0f)
+#define ZOOM_MAX  4.0f
+#define ZOOM_STEP 1.25f
+
+#define IMPOSTOR_SLOTS 384 /* enough to fill a 1080p screen at any zoom */
 
 static void IgnisErrorCallback(ignisErrorLevel level, const char* desc)
 {
@@ -15,12 +53,78 @@ static void IgnisErrorCallback(ignisErrorLevel level, const char* desc)
     }
 }
 
+typedef enum
+{
+    RENDER_SORTED,  /* tiles and entities interleaved in depth order */
+    RENDER_CACHED,  /* cached terrain, entities on top */
+    RENDER_THREADED, /* terrain generated in parallel each frame, entities on top */
+    RENDER_INSTANCED /* static layers expanded from one word per tile level on the gpu */
+} RenderMode;
+
+#define RENDER_MODES 4
+
+static const char* render_mode_names[] = { "sorted", "cached", "threaded", "instanced" };
+
+typedef enum
+{
+    PROFILE_FRAME,
+    PROFILE_UPDATE,
+    PROFILE_MAP,
+    PROFILE_PRIMITIVES,
+    PROFILE_HIGHLIGHT,
+    PROFILE_SUBMIT,
+    PROFILE_ZONES
+} ProfileZone;
+
+static const char* profile_names[] = { "frame", "update", "renderMap", "primitives", "pick", "submit" };
+
+#define PROFILE_EVENTS (1 << 16)
+#define PROFILE_TRACE  "iso_trace.json"
+
+#define SCREENSHOT "iso_screenshot.png"
+
+IsoProfiler profiler;
+const char* trace_path = NULL; /* written at exit if set */
+
+#define FRAME_ARENA_SIZE (256 << 10)
+
+uint64_t frame_heap_allocs = 0; /* heap allocations in the last frame, 0 once warmed up */
+
 int show_info = 0;
+RenderMode render_mode = RENDER_SORTED;
 
 float width, height;
 mat4 screen_projection;
 
+float zoom = 1.0f; /* screen pixels per map pixel */
+rect camera;       /* visible part of the map's screen space */
+
 IgnisFont font;
+IsoRenderQueue render_queue; /* the whole frame, sorted into as few draws as possible */
+
+IsoMap map;
+IsoMap path_overlay; /* dynamic layer marking the player path */
+IsoLayerStack layers;
+IsoMapCache map_cache;
+IsoImpostorCache impostors;
+int impostors_ready = 0; /* needs the atlas pixels */
+IsoJobPool job_pool;
+IsoTileBuilder tile_builder;
+IsoTileStream tile_stream;
+int instanced_ready = 0; /* needs the tile shader */
+IsoAtlas tile_atlas;
+IgnisTexture2D sprite_atlas;
+
+IsoEntityLayer entities;
+IsoSpatialHash entity_hash;
+IsoPicker picker;
+uint32_t player_entity;
+uint32_t first_agent_entity;
+
+IsoPathfinder pathfinder;
+IsoPath player_path;
+
+IsoSim sim;
 
 uint32_t grid[] = {
     3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
@@ -35,18 +139,64 @@ uint32_t grid[] = {
     3, 3, 3, 3, 3, 3, 3, 3, 3, 3
 };
 
+const char* map_path = NULL;    /* --map, falls back to grid */
+const char* stream_path = NULL; /* --stream */
+
+IsoStreamer streamer;
+
+static vec2 PlayerStart()
+{
+    return (vec2){ 5 * map.tile_size, 5 * map.tile_size };
+}
+
+static int LoadMap()
+{
+    if (map_path) return isoMapOpen(&map, map_path);
+    if (!stream_path) return isoMapInit(&map, grid, 10, 10, 50, 8.0f);
+
+    if (!isoStreamOpen(&streamer, &map, stream_path, STREAM_RADIUS, STREAM_BUDGET))
+        return 0;
 
-typedef struct
+    // wait for the start area only
+    isoStreamUpdate(&streamer, PlayerStart(), vec2_zero());
+    isoStreamFlush(&streamer);
+    return 1;
+}
+
+static void UnloadMap()
+{
+    if (stream_path) isoStreamClose(&streamer);
+    isoMapDestroy(&map);
+}
+
+static void UpdateStreaming()
 {
-    vec2 position;
-    float speed;
-} Player;
+    if (!stream_path) return;
+
+    vec2 velocity = vec2_mult(vec2_sub(sim.player.position, sim.player_previous), 1.0f / sim.step);
+    isoStreamUpdate(&streamer, sim.player.position, velocity);
 
+    // headless runs have no pathfinder
+    if (!pathfinder.map) return;
 
-void renderPlayer(const IsoMap* map, const Player* player)
+    for (uint32_t i = 0; i < streamer.changed_count; i++)
+        isoPathfinderChunkChanged(&pathfinder, streamer.changed[i]);
+}
+
+/* zooms about the center of the window, text stays in screen space */
+static void SetCamera()
 {
-    vec2 screen = worldToScreen(map, player->position);
-    ignisPrimitives2DFillCircle(screen.x, screen.y, 3, IGNIS_BLACK);
+    vec2 center = { width * .5f, height * .5f };
+    vec2 half = { center.x / zoom, center.y / zoom };
+
+    camera.min = vec2_sub(center, half);
+    camera.max = vec2_add(center, half);
+    mat4 view_projection = mat4_ortho(camera.min.x, camera.max.x, camera.max.y, camera.min.y, -1.0f, 1.0f);
+
+    ignisRenderer2DSetViewProjection(view_projection.v);
+    ignisPrimitives2DSetViewProjection(view_projection.v);
+    ignisBatch2DSetViewProjection(view_projection.v);
+    isoMapCacheSetViewProjection(&map_cache, view_projection.v);
 }
 
 static void SetViewport(float w, float h)
@@ -55,21 +205,33 @@ static void SetViewport(float w, float h)
     height = h;
     screen_projection = mat4_ortho(0.0f, w, h, 0.0f, -1.0f, 1.0f);
 
-    ignisRenderer2DSetViewProjection(screen_projection.v);
-    ignisPrimitives2DSetViewProjection(screen_projection.v);
     ignisFontRendererSetProjection(screen_projection.v);
-    ignisBatch2DSetViewProjection(screen_projection.v);
+    SetCamera();
 }
 
-IsoMap map;
-IgnisTexture2D tile_texture_atlas;
+static void Zoom(float factor)
+{
+    zoom *= factor;
+    if (zoom < ZOOM_MIN) zoom = ZOOM_MIN;
+    if (zoom > ZOOM_MAX) zoom = ZOOM_MAX;
+    SetCamera();
+}
 
-Player player;
+/* the cursor in the map's screen space */
+static vec2 CursorPosition()
+{
+    return (vec2){ camera.min.x + minimalCursorX() / zoom, camera.min.y + minimalCursorY() / zoom };
+}
 
 int OnLoad(MinimalApp* app, uint32_t w, uint32_t h)
 {
     /* ingis initialization */
-    // ignisSetAllocator(FrostMemoryGetAllocator(), tb_mem_malloc, tb_mem_realloc, tb_mem_free);
+    if (!isoMemInit(FRAME_ARENA_SIZE))
+    {
+        MINIMAL_ERROR("[Iso] Failed to initialize frame arena");
+        return MINIMAL_FAIL;
+    }
+    ignisSetAllocator(isoMemIgnisAllocator(ISO_MEM_RENDER), isoMemIgnisMalloc, isoMemIgnisRealloc, isoMemIgnisFree);
     ignisSetErrorCallback(IgnisErrorCallback);
 
 #ifdef _DEBUG
@@ -105,25 +267,243 @@ int OnLoad(MinimalApp* app, uint32_t w, uint32_t h)
     MINIMAL_INFO("[OpenGL] GLSL Version: %s", ignisGetGLSLVersion());
     MINIMAL_INFO("[Ignis] Version:       %s", ignisGetVersionString());
 
-    ignisCreateTexture2D(&tile_texture_atlas, "res/tiles.png", 1, 4, 0, NULL);
+    uint64_t atlas_start = isoClockNs();
+    int atlas = isoAtlasLoad(&tile_atlas, "res/tiles", "res/tiles.atlas");
+    if (!atlas)
+    {
+        MINIMAL_ERROR("[Iso] Failed to load tile atlas");
+        return MINIMAL_FAIL;
+    }
+    MINIMAL_INFO("[Iso] Tile atlas %ux%u with %u frames %s in %.2f ms", tile_atlas.texture.width, tile_atlas.texture.height,
+        tile_atlas.frame_count, atlas == ISO_ATLAS_CACHED ? "cached" : "packed", (isoClockNs() - atlas_start) / 1e6);
+
+    // tile ids of the map format
+    const char* tile_names[] = { NULL, "grass", "sand", "water", "placeholder" };
+    isoAtlasSetTiles(&tile_atlas, tile_names, sizeof(tile_names) / sizeof(tile_names[0]));
+
+    // water animates as soon as its frames show up in res/tiles
+    const char* water_frames[] = { "water", "water_1", "water_2", "water_3" };
+    isoAtlasAddAnimation(&tile_atlas, 3, water_frames, sizeof(water_frames) / sizeof(water_frames[0]), .25f);
+
+    ignisCreateTexture2D(&sprite_atlas, "res/sprites.png", 1, 2, 0, NULL);
+
+    if (!LoadMap())
+    {
+        MINIMAL_ERROR("[Iso] Failed to initialize map");
+        return MINIMAL_FAIL;
+    }
 
-    isoMapInit(&map, grid, 10, 10, 50, 8.0f);
     isoMapSetOrigin(&map, (vec2) { width * 0.5f, 100.0f });
 
-    player.position = (vec2){ 5 * map.tile_size, 5 * map.tile_size };
-    player.speed = 60.0f;
+    if (!isoMapInit(&path_overlay, NULL, map.width, map.height, map.tile_size, map.tile_offset))
+    {
+        MINIMAL_ERROR("[Iso] Failed to initialize path overlay");
+        return MINIMAL_FAIL;
+    }
+
+    isoLayerStackInit(&layers, &map, &tile_atlas);
+    isoLayerStackPush(&layers, "path", &path_overlay, &tile_atlas, ISO_LAYER_DYNAMIC);
+
+    if (!isoMapCacheInit(&map_cache, &map, "res/shaders/batch.vert", "res/shaders/batch.frag", 64))
+    {
+        MINIMAL_ERROR("[Iso] Failed to initialize map cache");
+        return MINIMAL_FAIL;
+    }
+
+    if (!isoRenderQueueInit(&render_queue, 4096))
+    {
+        MINIMAL_ERROR("[Iso] Failed to initialize render queue");
+        return MINIMAL_FAIL;
+    }
+    SetCamera();
+
+    instanced_ready = isoMapCacheInitStream(&map_cache, "res/shaders/tiles.vert", "res/shaders/batch.frag")
+                   && isoTileStreamInit(&tile_stream);
+    if (!instanced_ready) MINIMAL_WARN("[Iso] Instanced render mode disabled");
+
+    // far out views draw impostors instead of tiles
+    impostors_ready = isoImpostorCacheInit(&impostors, &layers, IMPOSTOR_SLOTS);
+    if (!impostors_ready) MINIMAL_WARN("[Iso] Impostors disabled, zoom is limited to tiles");
+
+    uint32_t workers = isoCpuCount() - 1;
+    if (!isoJobPoolInit(&job_pool, workers) || !isoTileBuilderInit(&tile_builder, &job_pool, 4 * (workers + 1)))
+    {
+        MINIMAL_ERROR("[Iso] Failed to initialize tile builder");
+        return MINIMAL_FAIL;
+    }
+
+    if (!isoSimInit(&sim, &map, SIM_TICK_RATE, SIM_AGENTS, 1))
+    {
+        MINIMAL_ERROR("[Iso] Failed to initialize simulation");
+        return MINIMAL_FAIL;
+    }
+    sim.player.position = PlayerStart();
+    sim.player_previous = sim.player.position;
+
+    if (!isoEntityLayerInit(&entities, 16) || !isoSpatialHashInit(&entity_hash, &map, 1, 256))
+    {
+        MINIMAL_ERROR("[Iso] Failed to initialize entity layer");
+        return MINIMAL_FAIL;
+    }
+
+    IsoEntity entity = { sim.player.position, { 32.0f, 64.0f }, &sprite_atlas, 0 };
+    player_entity = isoEntityLayerAdd(&entities, entity);
+
+    first_agent_entity = entities.count;
+    for (uint32_t i = 0; i < sim.agent_count; i++)
+    {
+        entity.position = isoSimAgentPosition(&sim, i, 0.0f);
+        entity.size = (vec2){ 24.0f, 48.0f };
+        isoEntityLayerAdd(&entities, entity);
+    }
+
+    /* a few pillars to walk behind */
+    uint32_t pillars[][2] = { { 2, 2 }, { 6, 3 }, { 4, 6 }, { 7, 6 }, { 3, 8 } };
+    for (size_t i = 0; i < sizeof(pillars) / sizeof(pillars[0]); i++)
+    {
+        entity.position = (vec2){ (pillars[i][0] + .5f) * map.tile_size, (pillars[i][1] + .5f) * map.tile_size };
+        entity.size = (vec2){ 32.0f, 64.0f };
+        entity.frame = 1;
+        isoEntityLayerAdd(&entities, entity);
+    }
+
+    for (uint32_t i = 0; i < entities.count; i++)
+        isoSpatialHashInsert(&entity_hash, i, entities.entities[i].position);
+
+    picker = (IsoPicker){ &layers, &entities, &entity_hash, { 32.0f, 64.0f } };
+
+    if (!isoPathfinderInit(&pathfinder, &map))
+    {
+        MINIMAL_ERROR("[Iso] Failed to initialize pathfinder");
+        return MINIMAL_FAIL;
+    }
+
+    if (!isoProfilerInit(&profiler, profile_names, PROFILE_ZONES, PROFILE_EVENTS))
+    {
+        MINIMAL_ERROR("[Iso] Failed to initialize profiler");
+        return MINIMAL_FAIL;
+    }
 
     return MINIMAL_OK;
 }
 
+static void WriteTrace(const char* path)
+{
+    if (isoProfilerWriteTrace(&profiler, path))
+        MINIMAL_INFO("[Iso] Wrote trace to %s", path);
+    else
+        MINIMAL_ERROR("[Iso] Failed to write trace to %s", path);
+}
+
+/* the sorted render of the camera drawn on the cpu, works without touching GL state */
+static void WriteScreenshot(const char* path)
+{
+    IsoRaster raster;
+    if (!isoRasterInit(&raster, &job_pool, (uint32_t)width, (uint32_t)height))
+    {
+        MINIMAL_ERROR("[Iso] Failed to allocate %ux%u screenshot", (uint32_t)width, (uint32_t)height);
+        return;
+    }
+
+    for (uint32_t i = 0; i < layers.count; i++)
+    {
+        const IsoAtlas* atlas = layers.layers[i].texture_atlas;
+        if (atlas->pixels) isoRasterAddTexture(&raster, &atlas->texture, atlas->pixels);
+    }
+
+    isoRasterBegin(&raster, camera, IGNIS_BLACK);
+    isoRenderSetBackend(isoRasterBackend(&raster));
+
+    isoEntityLayerRender(&entities, &map, &layers, camera);
+    isoRenderFillCircle(map.origin.x, map.origin.y, 3, IGNIS_RED);
+    isoRenderFlush();
+
+    isoRenderSetBackend(NULL);
+
+    if (raster.missing)
+        MINIMAL_WARN("[Iso] %u quads without cpu pixels left out of the screenshot", raster.missing);
+
+    if (isoImageWrite(path, raster.pixels, raster.width, raster.height))
+        MINIMAL_INFO("[Iso] Wrote screenshot to %s", path);
+    else
+        MINIMAL_ERROR("[Iso] Failed to write screenshot to %s", path);
+
+    isoRasterDestroy(&raster);
+}
+
 void OnDestroy(MinimalApp* app)
 {
+    if (trace_path) WriteTrace(trace_path);
+    isoProfilerDestroy(&profiler);
+
+    isoPathFree(&player_path);
+    isoPathfinderDestroy(&pathfinder);
+    isoSpatialHashDestroy(&entity_hash);
+    isoEntityLayerDestroy(&entities);
+    isoSimDestroy(&sim);
+    isoTileBuilderDestroy(&tile_builder);
+    isoTileStreamDestroy(&tile_stream);
+    isoJobPoolDestroy(&job_pool);
+    isoImpostorCacheDestroy(&impostors);
+    isoRenderQueueDestroy(&render_queue);
+    isoMapCacheDestroy(&map_cache);
+    isoMapDestroy(&path_overlay);
+    UnloadMap();
+
+    isoAtlasUnload(&tile_atlas);
     ignisDeleteFont(&font);
 
     ignisBatch2DDestroy();
     ignisFontRendererDestroy();
     ignisPrimitives2DDestroy();
     ignisRenderer2DDestroy();
+
+    for (uint32_t i = 0; i < ISO_MEM_TAGS; i++)
+    {
+        const IsoMemStats* stats = isoMemStats(i);
+        MINIMAL_INFO("[Iso] Memory %-8s peak %8llu bytes, %llu allocations, %llu bytes left", isoMemTagName(i),
+            (unsigned long long)stats->peak, (unsigned long long)stats->allocs, (unsigned long long)stats->bytes);
+    }
+    isoMemShutdown();
+}
+
+static void MarkPlayerPath(uint32_t tile)
+{
+    for (uint32_t i = 0; i < player_path.count; i++)
+        isoMapSetTile(&path_overlay, player_path.points[i].col, player_path.points[i].row, tile);
+}
+
+static void FindPlayerPath()
+{
+    IsoPick pick;
+    isoPickPoint(&picker, CursorPosition(), &pick);
+    if (pick.col == ISO_PICK_NONE) return;
+
+    vec2 position = sim.player.position;
+    IsoPathPoint start = { (uint32_t)(position.x / map.tile_size), (uint32_t)(position.y / map.tile_size) };
+    IsoPathPoint goal = { pick.col, pick.row };
+
+    MarkPlayerPath(ISO_TILE_EMPTY);
+    if (!isoPathFind(&pathfinder, start, goal, &player_path))
+        MINIMAL_INFO("[Iso] No path to (%u, %u)", goal.col, goal.row);
+    MarkPlayerPath(2);
+}
+
+static void RaiseTile(int32_t levels)
+{
+    IsoPick pick;
+    isoPickPoint(&picker, CursorPosition(), &pick);
+    if (pick.col == ISO_PICK_NONE) return;
+
+    int32_t elevation = (int32_t)isoMapGetElevation(&map, pick.col, pick.row) + levels;
+    if (elevation >= 0) isoMapSetElevation(&map, pick.col, pick.row, (uint32_t)elevation);
+}
+
+static void CycleRenderMode()
+{
+    render_mode = (render_mode + 1) % RENDER_MODES;
+    if (render_mode == RENDER_INSTANCED && !instanced_ready)
+        render_mode = (render_mode + 1) % RENDER_MODES;
 }
 
 int OnEvent(MinimalApp* app, const MinimalEvent* e)
@@ -140,57 +520,313 @@ int OnEvent(MinimalApp* app, const MinimalEvent* e)
     case GLFW_KEY_ESCAPE:    minimalClose(app); break;
     case GLFW_KEY_F6:        minimalToggleVsync(app); break;
     case GLFW_KEY_F7:        minimalToggleDebug(app); break;
+    case GLFW_KEY_F8:        CycleRenderMode(); break;
     case GLFW_KEY_F9:        show_info = !show_info; break;
+    case GLFW_KEY_F10:       WriteTrace(trace_path ? trace_path : PROFILE_TRACE); break;
+    case GLFW_KEY_F12:       WriteScreenshot(SCREENSHOT); break;
+    case GLFW_KEY_P:         FindPlayerPath(); break;
+    case GLFW_KEY_R:         RaiseTile(1); break;
+    case GLFW_KEY_F:         RaiseTile(-1); break;
+    case GLFW_KEY_EQUAL:     Zoom(ZOOM_STEP); break;
+    case GLFW_KEY_MINUS:     Zoom(1.0f / ZOOM_STEP); break;
     }
 
     return MINIMAL_OK;
 }
 
-void OnUpdate(MinimalApp* app, float deltatime)
+/* moves the entities to where the simulation is at render time */
+static void SyncEntities(float alpha)
 {
-    vec2 velocity;
-    velocity.x = (-minimalKeyDown(GLFW_KEY_A) + minimalKeyDown(GLFW_KEY_D)) * player.speed;
-    velocity.y = (-minimalKeyDown(GLFW_KEY_W) + minimalKeyDown(GLFW_KEY_S)) * player.speed;
+    vec2 position = isoSimPlayerPosition(&sim, alpha);
+    entities.entities[player_entity].position = position;
+    isoSpatialHashMove(&entity_hash, player_entity, position);
 
-    velocity = vec2_normalize(isoToCartesian(velocity));
+    for (uint32_t i = 0; i < sim.agent_count; i++)
+    {
+        position = isoSimAgentPosition(&sim, i, alpha);
+        entities.entities[first_agent_entity + i].position = position;
+        isoSpatialHashMove(&entity_hash, first_agent_entity + i, position);
+    }
+}
 
-    player.position = vec2_add(player.position, vec2_mult(velocity, deltatime));
+#define INFO_LINE_HEIGHT 24.0f /* font size */
+
+static float info_x, info_y, info_spacing;
+
+/* lines of debug text, one below the other */
+static void InfoBegin(float x, float y, float spacing)
+{
+    info_x = x;
+    info_y = y;
+    info_spacing = spacing;
+}
+
+static void InfoLine(const char* fmt, ...)
+{
+    char line[128];
+
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+
+    isoRenderText(info_x, info_y, line);
+    info_y += INFO_LINE_HEIGHT + info_spacing;
+}
+
+void OnUpdate(MinimalApp* app, float deltatime)
+{
+    uint64_t frame_start = isoClockNs();
+
+    ISO_PROFILE(&profiler, PROFILE_UPDATE)
+    {
+        IsoSimInput input;
+        input.move.x = (float)(-minimalKeyDown(GLFW_KEY_A) + minimalKeyDown(GLFW_KEY_D));
+        input.move.y = (float)(-minimalKeyDown(GLFW_KEY_W) + minimalKeyDown(GLFW_KEY_S));
+
+        if (isoSimAdvance(&sim, &input, deltatime, SIM_MAX_TICKS))
+            UpdateStreaming();
+        SyncEntities(isoSimAlpha(&sim));
+        isoAtlasAnimate(&tile_atlas, frame_start / 1e9);
+    }
 
     // clear screen
     glClear(GL_COLOR_BUFFER_BIT);
 
-    // render debug info
+    // everything but the cached terrain goes through the queue
+    isoRenderSetBackend(isoRenderQueueBackend(&render_queue));
+
+    ISO_PROFILE(&profiler, PROFILE_MAP)
+    {
+        rect view = camera;
+        isoEntityLayerSort(&entities, &map);
+
+        uint32_t level = impostors_ready ? isoImpostorLevel(&impostors, &map, zoom) : ISO_IMPOSTOR_NONE;
+        if (level != ISO_IMPOSTOR_NONE)
+        {
+            // too far out for dynamic layers to matter
+            if (isoImpostorCacheUpdate(&impostors, &layers, view, level))
+                isoMapCacheRenderImpostors(&map_cache, &layers, &impostors);
+            isoEntityLayerRender(&entities, &map, NULL, view);
+        }
+        else
+        {
+            switch (render_mode)
+            {
+            case RENDER_SORTED:
+                isoEntityLayerRender(&entities, &map, &layers, view);
+                break;
+            case RENDER_CACHED:
+                isoMapCacheRender(&map_cache, &layers, view);
+                renderLayers(&layers, view, ISO_LAYER_DYNAMIC);
+                isoEntityLayerRender(&entities, &map, NULL, view);
+                break;
+            case RENDER_THREADED:
+                if (isoTileBuilderBuild(&tile_builder, &layers, view))
+                    isoMapCacheRenderVertices(&map_cache, &layers, tile_builder.vertices, tile_builder.quads);
+                renderLayers(&layers, view, ISO_LAYER_DYNAMIC);
+                isoEntityLayerRender(&entities, &map, NULL, view);
+                break;
+            case RENDER_INSTANCED:
+                if (isoTileStreamBuild(&tile_stream, &layers, view, ISO_LAYER_STATIC))
+                    isoMapCacheRenderStream(&map_cache, &layers, &tile_stream);
+                renderLayers(&layers, view, ISO_LAYER_DYNAMIC);
+                isoEntityLayerRender(&entities, &map, NULL, view);
+                break;
+            }
+        }
+    }
+
+    ISO_PROFILE(&profiler, PROFILE_PRIMITIVES)
+    {
+        isoRenderSetOrder(ISO_RENDER_LAYER_OVERLAY, 0);
+        isoRenderFillCircle(map.origin.x, map.origin.y, 3, IGNIS_RED);
+
+        IsoPick pick;
+        ISO_PROFILE(&profiler, PROFILE_HIGHLIGHT)
+        {
+            isoPickPoint(&picker, CursorPosition(), &pick);
+            highlightPick(&map, &pick);
+        }
+
+        for (uint32_t i = 0; i < player_path.count; i++)
+        {
+            vec2 center = { (player_path.points[i].col + .5f) * map.tile_size, (player_path.points[i].row + .5f) * map.tile_size };
+            center = worldToScreen(&map, center);
+            isoRenderFillCircle(center.x, center.y, 2, IGNIS_BLUE);
+        }
+
+        /* entities standing on the hovered tile */
+        if (pick.col != ISO_PICK_NONE)
+        {
+            vec2 tile = { (pick.col + .5f) * map.tile_size, (pick.row + .5f) * map.tile_size };
+            uint32_t picked[16];
+            uint32_t picked_count = isoSpatialHashQueryCell(&entity_hash, tile, picked, 16);
+            for (uint32_t i = 0; i < picked_count && i < 16; i++)
+            {
+                vec2 foot = worldToScreen(&map, entities.entities[picked[i]].position);
+                isoRenderFillCircle(foot.x, foot.y, 4, IGNIS_WHITE);
+            }
+        }
+
+        /* the entity under the cursor */
+        if (pick.entity != ISO_ENTITY_NONE)
+        {
+            vec2 foot = worldToScreen(&map, entities.entities[pick.entity].position);
+            isoRenderFillCircle(foot.x, foot.y, 6, IGNIS_RED);
+        }
+    }
+
+    // debug info over everything
+    isoRenderSetOrder(ISO_RENDER_LAYER_UI, 0);
+
     /* fps */
-    ignisFontRendererRenderTextFormat(8.0f, 8.0f, "FPS: %d", minimalGetFps(app));
+    InfoBegin(8.0f, 8.0f, 0.0f);
+    InfoLine("FPS: %d", minimalGetFps(app));
+    InfoLine("Render: %s", render_mode_names[render_mode]);
 
     if (show_info)
     {
         /* Settings */
-        ignisFontRendererTextFieldBegin(width - 220.0f, 8.0f, 8.0f);
+        InfoBegin(width - 300.0f, 8.0f, 8.0f);
+
+        InfoLine("F6: Toggle Vsync");
+        InfoLine("F7: Toggle debug mode");
+        InfoLine("F8: Cycle render mode");
+
+        InfoLine("F9: Toggle overlay");
+        InfoLine("F10: Write trace");
+        InfoLine("F12: Write screenshot");
+        InfoLine("P: Path to cursor");
+        InfoLine("+/-: Zoom (%.3f)", zoom);
+
+        /* rolling frame phases */
+        InfoLine("ms min / avg / p99");
+        for (uint32_t i = 0; i < PROFILE_ZONES; i++)
+        {
+            IsoProfileStats stats;
+            isoProfilerStats(&profiler, i, &stats);
+            InfoLine("%s: %.2f / %.2f / %.2f", profile_names[i], stats.min, stats.avg, stats.p99);
+        }
+
+        /* draw calls of the last frame, sorted and as submitted */
+        InfoLine("Draws: %u (unsorted %u)", render_queue.draws, render_queue.unsorted_draws);
+        InfoLine("State changes: %u (unsorted %u)", render_queue.state_changes, render_queue.unsorted_state_changes);
+        if (render_mode == RENDER_INSTANCED)
+            InfoLine("Tile words: %u in %u draws (%u levels too high)", tile_stream.count, tile_stream.draw_count, tile_stream.dropped);
+
+        /* heap per subsystem */
+        InfoLine("Heap allocs/frame: %llu", (unsigned long long)frame_heap_allocs);
+        InfoLine("Frame arena: %u / %u KB", (uint32_t)(isoMemFrameArena()->peak >> 10), (uint32_t)(isoMemFrameArena()->size >> 10));
+        for (uint32_t i = 0; i < ISO_MEM_TAGS; i++)
+        {
+            const IsoMemStats* stats = isoMemStats(i);
+            InfoLine("%s: %u KB (peak %u KB)", isoMemTagName(i), (uint32_t)(stats->bytes >> 10), (uint32_t)(stats->peak >> 10));
+        }
+
+        if (stream_path)
+        {
+            const IsoStreamStats* stats = &streamer.stats;
+            uint64_t lookups = stats->hits + stats->misses;
+            InfoLine("Stream hits: %.1f%%", lookups ? 100.0 * stats->hits / lookups : 100.0);
+            InfoLine("Stream load: %.2f ms", stats->loads ? stats->latency_total / (1e6 * stats->loads) : 0.0);
+            InfoLine("Stream memory: %u KB", (uint32_t)(stats->resident_bytes >> 10));
+        }
+    }
 
-        ignisFontRendererTextFieldLine("F6: Toggle Vsync");
-        ignisFontRendererTextFieldLine("F7: Toggle debug mode");
+    ISO_PROFILE(&profiler, PROFILE_SUBMIT)
+    {
+        isoRenderSetBackend(NULL);
+        isoRenderQueueSubmit(&render_queue, isoRenderIgnisBackend());
+    }
+
+    isoProfileEnd(&profiler, PROFILE_FRAME, frame_start);
+    isoProfilerFrame(&profiler);
+    frame_heap_allocs = isoMemFrame();
+}
 
-        ignisFontRendererTextFieldLine("F9: Toggle overlay");
+/* runs the simulation without a window, as fast as possible */
+static int RunHeadless(uint32_t ticks, uint32_t agents)
+{
+    if (!LoadMap() || !isoSimInit(&sim, &map, SIM_TICK_RATE, agents, 1))
+    {
+        fprintf(stderr, "failed to initialize the simulation\n");
+        return 1;
     }
+    sim.player.position = PlayerStart();
+    sim.player_previous = sim.player.position;
 
-    ignisFontRendererFlush();
+    IsoSimInput input = { { 1.0f, 0.0f } };
 
-    renderMap(&map, &tile_texture_atlas);
+    clock_t start = clock();
+    for (uint32_t i = 0; i < ticks; i++)
+    {
+        isoSimTick(&sim, &input);
+        UpdateStreaming();
+    }
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
 
-    ignisBatch2DFlush();
+    printf("%u ticks with %u agents in %.3f s (%.0f ticks/s, %.1f s simulated)\n",
+           ticks, agents, seconds, seconds > 0.0 ? ticks / seconds : 0.0, ticks * sim.step);
 
-    ignisPrimitives2DFillCircle(map.origin.x, map.origin.y, 3, IGNIS_RED);
+    isoSimDestroy(&sim);
+    UnloadMap();
+    return 0;
+}
 
-    renderPlayer(&map, &player);
+/* writes the current map as a map file */
+static int SaveMap(const char* path)
+{
+    if (!LoadMap())
+    {
+        fprintf(stderr, "failed to load map\n");
+        return 1;
+    }
 
-    highlightTile(&map, screenToWorld(&map, (vec2) { minimalCursorX(), minimalCursorY() }));
+    int result = isoMapSave(&map, path);
+    if (!result) fprintf(stderr, "failed to write %s\n", path);
 
-    ignisPrimitives2DFlush();
+    UnloadMap();
+    return result ? 0 : 1;
 }
 
-int main()
+int main(int argc, char** argv)
 {
+    /* iso [--map file | --stream file] [--save file] [--trace file] [--headless [ticks] [agents]] */
+    const char* save_path = NULL;
+    int headless = 0;
+    uint32_t ticks = 10000;
+    uint32_t agents = SIM_AGENTS;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--map") == 0 && i + 1 < argc)         map_path = argv[++i];
+        else if (strcmp(argv[i], "--stream") == 0 && i + 1 < argc) stream_path = argv[++i];
+        else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc)   save_path = argv[++i];
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)  trace_path = argv[++i];
+        else if (strcmp(argv[i], "--headless") == 0)
+        {
+            headless = 1;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) ticks = (uint32_t)strtoul(argv[++i], NULL, 10);
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) agents = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--map file | --stream file] [--save file] [--trace file] [--headless [ticks] [agents]]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // chunks that are not streamed in yet are placeholders, saving would persist them
+    if (save_path && stream_path)
+    {
+        fprintf(stderr, "--save needs a fully loaded map, use --map instead of --stream\n");
+        return 1;
+    }
+
+    if (save_path) return SaveMap(save_path);
+    if (headless) return RunHeadless(ticks, agents);
+
     MinimalApp app = { 
         .on_load = OnLoad,
         .on_destroy = OnDestroy,
@@ -0,0 +1,304 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "mapfile.h"
+#include "alloc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+struct IsoMappedFile
+{
+    HANDLE file;
+    HANDLE mapping;
+    uint8_t* data;
+    uint64_t size;
+};
+
+IsoMappedFile* isoFileMap(const char* path)
+{
+    IsoMappedFile* mapped = isoCalloc(ISO_MEM_MAP, 1, sizeof(IsoMappedFile));
+    if (!mapped) return NULL;
+
+    // sharing delete lets isoMapSave move the file aside while it is mapped
+    mapped->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (mapped->file == INVALID_HANDLE_VALUE)
+    {
+        isoFree(mapped);
+        return NULL;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(mapped->file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(mapped->file);
+        isoFree(mapped);
+        return NULL;
+    }
+    mapped->size = (uint64_t)size.QuadPart;
+
+    // write copy keeps edits private to the process
+    mapped->mapping = CreateFileMappingA(mapped->file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    if (mapped->mapping)
+        mapped->data = MapViewOfFile(mapped->mapping, FILE_MAP_COPY, 0, 0, 0);
+
+    if (!mapped->data)
+    {
+        if (mapped->mapping) CloseHandle(mapped->mapping);
+        CloseHandle(mapped->file);
+        isoFree(mapped);
+        return NULL;
+    }
+    return mapped;
+}
+
+void isoFileUnmap(IsoMappedFile* file)
+{
+    UnmapViewOfFile(file->data);
+    CloseHandle(file->mapping);
+    CloseHandle(file->file);
+    isoFree(file);
+}
+
+#else
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct IsoMappedFile
+{
+    uint8_t* data;
+    uint64_t size;
+};
+
+IsoMappedFile* isoFileMap(const char* path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    // private mappings copy pages on write, the file is never changed
+    void* data = mmap(NULL, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return NULL;
+
+    IsoMappedFile* mapped = isoMalloc(ISO_MEM_MAP, sizeof(IsoMappedFile));
+    if (!mapped)
+    {
+        munmap(data, (size_t)info.st_size);
+        return NULL;
+    }
+
+    mapped->data = data;
+    mapped->size = (uint64_t)info.st_size;
+    return mapped;
+}
+
+void isoFileUnmap(IsoMappedFile* file)
+{
+    munmap(file->data, (size_t)file->size);
+    isoFree(file);
+}
+
+#endif
+
+uint8_t* isoMappedFileData(const IsoMappedFile* file) { return file->data; }
+uint64_t isoMappedFileSize(const IsoMappedFile* file) { return file->size; }
+
+static int isoMapFilePad(FILE* file, uint64_t* offset)
+{
+    static const uint8_t zeros[ISO_MAP_FILE_ALIGN] = { 0 };
+
+    size_t pad = (size_t)((ISO_MAP_FILE_ALIGN - *offset % ISO_MAP_FILE_ALIGN) % ISO_MAP_FILE_ALIGN);
+    if (pad && fwrite(zeros, 1, pad, file) != pad) return 0;
+
+    *offset += pad;
+    return 1;
+}
+
+static int isoMapWrite(const IsoMap* map, FILE* file)
+{
+    IsoMapFileHeader header = {
+        .magic = ISO_MAP_FILE_MAGIC,
+        .version = ISO_MAP_FILE_VERSION,
+        .width = map->width,
+        .height = map->height,
+        .tile_size = map->tile_size,
+        .tile_offset = map->tile_offset,
+        .chunk_shift = ISO_CHUNK_SHIFT,
+        .chunk_cols = map->chunk_cols,
+        .chunk_rows = map->chunk_rows,
+        .max_elevation = map->max_elevation,
+        .directory = sizeof(IsoMapFileHeader)
+    };
+
+    int result = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    uint32_t count = map->chunk_cols * map->chunk_rows;
+    uint64_t offset = header.directory + (uint64_t)count * sizeof(IsoMapFileChunk);
+    offset += (ISO_MAP_FILE_ALIGN - offset % ISO_MAP_FILE_ALIGN) % ISO_MAP_FILE_ALIGN;
+
+    // payloads follow in directory order
+    for (uint32_t i = 0; i < count && result; i++)
+    {
+        const IsoChunk* chunk = &map->chunks[i];
+        IsoMapFileChunk entry = { 0, chunk->value, 0 };
+        if (chunk->tiles)
+        {
+            entry.offset = offset;
+            entry.value = ISO_TILE_EMPTY;
+            offset += ISO_CHUNK_TILES * sizeof(uint32_t);
+        }
+        result = fwrite(&entry, sizeof(entry), 1, file) == 1;
+    }
+
+    offset = header.directory + (uint64_t)count * sizeof(IsoMapFileChunk);
+    if (result) result = isoMapFilePad(file, &offset);
+
+    for (uint32_t i = 0; i < count && result; i++)
+    {
+        const IsoChunk* chunk = &map->chunks[i];
+        if (chunk->tiles)
+            result = fwrite(chunk->tiles, sizeof(uint32_t), ISO_CHUNK_TILES, file) == ISO_CHUNK_TILES;
+    }
+
+    return result;
+}
+
+/* replaces path with the temporary file, path may still be mapped */
+static int isoMapFileReplace(const char* temp, const char* path)
+{
+#ifdef _WIN32
+    if (MoveFileExA(temp, path, MOVEFILE_REPLACE_EXISTING)) return 1;
+
+    // a mapped file cannot be replaced, only renamed, it is deleted once unmapped
+    char old[1024];
+    if (snprintf(old, sizeof(old), "%s.old", path) >= (int)sizeof(old)) return 0;
+    if (!MoveFileExA(path, old, MOVEFILE_REPLACE_EXISTING)) return 0;
+
+    if (!MoveFileExA(temp, path, 0))
+    {
+        MoveFileExA(old, path, 0);
+        return 0;
+    }
+
+    DeleteFileA(old);
+    return 1;
+#else
+    return rename(temp, path) == 0;
+#endif
+}
+
+int isoMapSave(const IsoMap* map, const char* path)
+{
+    // the chunks of map can be mapped from path, so it is only replaced once complete
+    char temp[1024];
+    if (snprintf(temp, sizeof(temp), "%s.tmp", path) >= (int)sizeof(temp)) return 0;
+
+    FILE* file = fopen(temp, "wb");
+    if (!file) return 0;
+
+    int result = isoMapWrite(map, file);
+    if (fclose(file) != 0) result = 0;
+
+    // nothing is left behind if the write or the replace failed
+    if (result) result = isoMapFileReplace(temp, path);
+    if (!result) remove(temp);
+    return result;
+}
+
+static int isoMapFileValid(const IsoMapFileHeader* header, uint64_t size)
+{
+    if (header->magic != ISO_MAP_FILE_MAGIC || header->version != ISO_MAP_FILE_VERSION) return 0;
+    if (header->chunk_shift != ISO_CHUNK_SHIFT) return 0;
+    if (header->max_elevation > ISO_TILE_MAX_ELEVATION) return 0;
+
+    if (header->chunk_cols != (header->width + ISO_CHUNK_MASK) >> ISO_CHUNK_SHIFT) return 0;
+    if (header->chunk_rows != (header->height + ISO_CHUNK_MASK) >> ISO_CHUNK_SHIFT) return 0;
+
+    uint64_t directory_size = (uint64_t)header->chunk_cols * header->chunk_rows * sizeof(IsoMapFileChunk);
+    if (header->directory % sizeof(uint64_t) != 0) return 0;
+    return header->directory <= size && directory_size <= size - header->directory;
+}
+
+const IsoMapFileHeader* isoMapFileHeader(const IsoMappedFile* file)
+{
+    const IsoMapFileHeader* header = (const IsoMapFileHeader*)file->data;
+    if (file->size < sizeof(IsoMapFileHeader) || !isoMapFileValid(header, file->size)) return NULL;
+    return header;
+}
+
+const IsoMapFileChunk* isoMapFileDirectory(const IsoMappedFile* file)
+{
+    const IsoMapFileHeader* header = (const IsoMapFileHeader*)file->data;
+    return (const IsoMapFileChunk*)(file->data + header->directory);
+}
+
+uint32_t* isoMapFileTiles(const IsoMappedFile* file, const IsoMapFileChunk* entry)
+{
+    if (!entry->offset || entry->offset % ISO_MAP_FILE_ALIGN != 0 || entry->offset > file->size) return NULL;
+    if (file->size - entry->offset < ISO_CHUNK_TILES * sizeof(uint32_t)) return NULL;
+    return (uint32_t*)(file->data + entry->offset);
+}
+
+int isoMapOpen(IsoMap* map, const char* path)
+{
+    IsoMappedFile* file = isoFileMap(path);
+    if (!file) return 0;
+
+    const IsoMapFileHeader* header = isoMapFileHeader(file);
+    if (!header)
+    {
+        isoFileUnmap(file);
+        return 0;
+    }
+
+    if (!isoMapInit(map, NULL, header->width, header->height, header->tile_size, header->tile_offset))
+    {
+        isoFileUnmap(file);
+        return 0;
+    }
+    map->file = file;
+    map->max_elevation = header->max_elevation;
+
+    // only the directory is read, payload pages are left alone
+    const IsoMapFileChunk* directory = isoMapFileDirectory(file);
+    uint32_t count = map->chunk_cols * map->chunk_rows;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        IsoChunk* chunk = &map->chunks[i];
+        const IsoMapFileChunk* entry = &directory[i];
+
+        if (!entry->offset)
+        {
+            chunk->value = entry->value;
+            continue;
+        }
+
+        chunk->tiles = isoMapFileTiles(file, entry);
+        chunk->mapped = 1;
+        if (!chunk->tiles)
+        {
+            isoMapDestroy(map);
+            return 0;
+        }
+    }
+
+    return 1;
+}
@@ -0,0 +1,69 @@
+#ifndef MAPFILE_H
+#define MAPFILE_H
+
+#include "iso.h"
+
+/*
+ * Binary map files, all values little endian:
+ *
+ *   header     IsoMapFileHeader
+ *   directory  chunk_cols * chunk_rows IsoMapFileChunk, row-major
+ *   payloads   ISO_CHUNK_TILES uint32_t tiles per non-uniform chunk
+ *
+ * Payloads start at page aligned offsets and one chunk of 32 * 32 tiles is
+ * exactly one 4k page, so each chunk faults in on its own when first touched.
+ */
+#define ISO_MAP_FILE_MAGIC   0x4d4f5349 /* "ISOM" */
+#define ISO_MAP_FILE_VERSION 1
+#define ISO_MAP_FILE_ALIGN   4096
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    float tile_size;
+    float tile_offset;
+    uint32_t chunk_shift; /* has to match ISO_CHUNK_SHIFT */
+    uint32_t chunk_cols;
+    uint32_t chunk_rows;
+    uint32_t max_elevation;
+    uint64_t directory;   /* file offset of the chunk directory */
+} IsoMapFileHeader;
+
+typedef struct
+{
+    uint64_t offset; /* file offset of the tiles, 0 for uniform chunks */
+    uint32_t value;  /* tile of uniform chunks */
+    uint32_t reserved;
+} IsoMapFileChunk;
+
+/* copy-on-write view of a whole file, writes never reach the disk */
+typedef struct IsoMappedFile IsoMappedFile;
+
+IsoMappedFile* isoFileMap(const char* path);
+void isoFileUnmap(IsoMappedFile* file);
+
+uint8_t* isoMappedFileData(const IsoMappedFile* file);
+uint64_t isoMappedFileSize(const IsoMappedFile* file);
+
+/* NULL unless file holds a map of this version and chunk size */
+const IsoMapFileHeader* isoMapFileHeader(const IsoMappedFile* file);
+const IsoMapFileChunk* isoMapFileDirectory(const IsoMappedFile* file);
+
+/* NULL for uniform chunks and payloads that are not inside the file */
+uint32_t* isoMapFileTiles(const IsoMappedFile* file, const IsoMapFileChunk* entry);
+
+/* written next to path and moved over it when complete, so map may be mapped from path */
+int isoMapSave(const IsoMap* map, const char* path);
+
+/*
+ * Maps the file and points the chunks of map straight at their payloads.
+ * Only the header and the chunk directory are read here, tiles are paged in
+ * by the os on first access. Edited chunks get private copies of their pages.
+ * The file stays mapped until isoMapDestroy.
+ */
+int isoMapOpen(IsoMap* map, const char* path);
+
+#endif // !MAPFILE_H
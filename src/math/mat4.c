@@ -344,4 +344,221 @@ mat4 mat4_look_at(vec3 position, vec3 target, vec3 up)
     result.v[15] = 1.0f;
 
     return result;
-}
\ No newline at end of file
+}
+
+static void mat4_transform_vec3_scalar(const mat4* mat, const vec3* points, vec3* result, size_t count)
+{
+    const float* v = mat->v;
+    for (size_t i = 0; i < count; i++)
+    {
+        vec3 p = points[i];
+        float w = 1.0f / (v[3] * p.x + v[7] * p.y + v[11] * p.z + v[15]);
+        result[i].x = (v[0] * p.x + v[4] * p.y + v[8] * p.z + v[12]) * w;
+        result[i].y = (v[1] * p.x + v[5] * p.y + v[9] * p.z + v[13]) * w;
+        result[i].z = (v[2] * p.x + v[6] * p.y + v[10] * p.z + v[14]) * w;
+    }
+}
+
+static void mat4_transform_vec2_scalar(const mat4* mat, const vec2* points, vec2* result, size_t count)
+{
+    const float* v = mat->v;
+    for (size_t i = 0; i < count; i++)
+    {
+        vec2 p = points[i];
+        float w = 1.0f / (v[3] * p.x + v[7] * p.y + v[15]);
+        result[i].x = (v[0] * p.x + v[4] * p.y + v[12]) * w;
+        result[i].y = (v[1] * p.x + v[5] * p.y + v[13]) * w;
+    }
+}
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MAT4_SSE
+#include <xmmintrin.h>
+#endif
+
+#ifdef MAT4_SSE
+
+mat4* psmat4_multiply(mat4* result, const mat4* left, const mat4* right)
+{
+    __m128 l0 = _mm_load_ps(left->v + 0);
+    __m128 l1 = _mm_load_ps(left->v + 4);
+    __m128 l2 = _mm_load_ps(left->v + 8);
+    __m128 l3 = _mm_load_ps(left->v + 12);
+
+    __m128 r[4];
+    for (int i = 0; i < 4; i++)
+    {
+        const float* c = right->v + i * 4;
+        r[i] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(l0, _mm_set1_ps(c[0])), _mm_mul_ps(l1, _mm_set1_ps(c[1]))),
+                          _mm_add_ps(_mm_mul_ps(l2, _mm_set1_ps(c[2])), _mm_mul_ps(l3, _mm_set1_ps(c[3]))));
+    }
+
+    for (int i = 0; i < 4; i++)
+        _mm_store_ps(result->v + i * 4, r[i]);
+
+    return result;
+}
+
+/*
+ * Laplace expansion by complementary minors. With a[i][j] = v[i * 4 + j],
+ * s are the 2x2 minors of a[0], a[1] and c the ones of a[2], a[3]. The
+ * vectors k0..k5 hold (c, c, s, s) so every output lane is a signed sum of
+ * three products.
+ */
+mat4* psmat4_inverse(mat4* result, const mat4* mat)
+{
+    __m128 t0 = _mm_load_ps(mat->v + 0);
+    __m128 t1 = _mm_load_ps(mat->v + 4);
+    __m128 t2 = _mm_load_ps(mat->v + 8);
+    __m128 t3 = _mm_load_ps(mat->v + 12);
+    __m128 row0 = t0;
+
+    // t[j] = (a0j, a1j, a2j, a3j)
+    _MM_TRANSPOSE4_PS(t0, t1, t2, t3);
+
+    // h[j] = (a2j, a2j, a0j, a0j), g[j] = (a3j, a3j, a1j, a1j)
+    __m128 h0 = _mm_shuffle_ps(t0, t0, _MM_SHUFFLE(0, 0, 2, 2));
+    __m128 h1 = _mm_shuffle_ps(t1, t1, _MM_SHUFFLE(0, 0, 2, 2));
+    __m128 h2 = _mm_shuffle_ps(t2, t2, _MM_SHUFFLE(0, 0, 2, 2));
+    __m128 g0 = _mm_shuffle_ps(t0, t0, _MM_SHUFFLE(1, 1, 3, 3));
+    __m128 g1 = _mm_shuffle_ps(t1, t1, _MM_SHUFFLE(1, 1, 3, 3));
+    __m128 g2 = _mm_shuffle_ps(t2, t2, _MM_SHUFFLE(1, 1, 3, 3));
+    __m128 h3 = _mm_shuffle_ps(t3, t3, _MM_SHUFFLE(0, 0, 2, 2));
+    __m128 g3 = _mm_shuffle_ps(t3, t3, _MM_SHUFFLE(1, 1, 3, 3));
+
+    __m128 k0 = _mm_sub_ps(_mm_mul_ps(h0, g1), _mm_mul_ps(g0, h1));
+    __m128 k1 = _mm_sub_ps(_mm_mul_ps(h0, g2), _mm_mul_ps(g0, h2));
+    __m128 k2 = _mm_sub_ps(_mm_mul_ps(h0, g3), _mm_mul_ps(g0, h3));
+    __m128 k3 = _mm_sub_ps(_mm_mul_ps(h1, g2), _mm_mul_ps(g1, h2));
+    __m128 k4 = _mm_sub_ps(_mm_mul_ps(h1, g3), _mm_mul_ps(g1, h3));
+    __m128 k5 = _mm_sub_ps(_mm_mul_ps(h2, g3), _mm_mul_ps(g2, h3));
+
+    // a[j] = (a1j, a0j, a3j, a2j)
+    __m128 a0 = _mm_shuffle_ps(t0, t0, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 a1 = _mm_shuffle_ps(t1, t1, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 a2 = _mm_shuffle_ps(t2, t2, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 a3 = _mm_shuffle_ps(t3, t3, _MM_SHUFFLE(2, 3, 0, 1));
+
+    const __m128 sign_even = _mm_set_ps(-0.0f, 0.0f, -0.0f, 0.0f);
+    const __m128 sign_odd = _mm_set_ps(0.0f, -0.0f, 0.0f, -0.0f);
+
+    __m128 r0 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(a1, k5), _mm_mul_ps(a2, k4)), _mm_mul_ps(a3, k3));
+    __m128 r1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(a0, k5), _mm_mul_ps(a2, k2)), _mm_mul_ps(a3, k1));
+    __m128 r2 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(a0, k4), _mm_mul_ps(a1, k2)), _mm_mul_ps(a3, k0));
+    __m128 r3 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(a0, k3), _mm_mul_ps(a1, k1)), _mm_mul_ps(a2, k0));
+
+    r0 = _mm_xor_ps(r0, sign_even);
+    r1 = _mm_xor_ps(r1, sign_odd);
+    r2 = _mm_xor_ps(r2, sign_even);
+    r3 = _mm_xor_ps(r3, sign_odd);
+
+    // determinant from the first row and the first column of the adjugate
+    __m128 column = _mm_movelh_ps(_mm_unpacklo_ps(r0, r1), _mm_unpacklo_ps(r2, r3));
+    __m128 det = _mm_mul_ps(row0, column);
+    det = _mm_add_ps(det, _mm_shuffle_ps(det, det, _MM_SHUFFLE(2, 3, 0, 1)));
+    det = _mm_add_ps(det, _mm_shuffle_ps(det, det, _MM_SHUFFLE(1, 0, 3, 2)));
+
+    __m128 inverted_determinant = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+    _mm_store_ps(result->v + 0, _mm_mul_ps(r0, inverted_determinant));
+    _mm_store_ps(result->v + 4, _mm_mul_ps(r1, inverted_determinant));
+    _mm_store_ps(result->v + 8, _mm_mul_ps(r2, inverted_determinant));
+    _mm_store_ps(result->v + 12, _mm_mul_ps(r3, inverted_determinant));
+
+    return result;
+}
+
+/* four points at a time: deinterleave, transform as x, y, z, w lanes, interleave */
+void mat4_transform_vec3_array(const mat4* mat, const vec3* points, vec3* result, size_t count)
+{
+    __m128 m[16];
+    for (int i = 0; i < 16; i++)
+        m[i] = _mm_set1_ps(mat->v[i]);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const float* in = &points[i].x;
+        __m128 a = _mm_loadu_ps(in + 0); /* x0 y0 z0 x1 */
+        __m128 b = _mm_loadu_ps(in + 4); /* y1 z1 x2 y2 */
+        __m128 c = _mm_loadu_ps(in + 8); /* z2 x3 y3 z3 */
+
+        __m128 x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+        __m128 y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+
+        __m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0], x), _mm_mul_ps(m[4], y)), _mm_add_ps(_mm_mul_ps(m[8], z), m[12]));
+        __m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[1], x), _mm_mul_ps(m[5], y)), _mm_add_ps(_mm_mul_ps(m[9], z), m[13]));
+        __m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[2], x), _mm_mul_ps(m[6], y)), _mm_add_ps(_mm_mul_ps(m[10], z), m[14]));
+        __m128 rw = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[3], x), _mm_mul_ps(m[7], y)), _mm_add_ps(_mm_mul_ps(m[11], z), m[15]));
+
+        __m128 w = _mm_div_ps(_mm_set1_ps(1.0f), rw);
+        rx = _mm_mul_ps(rx, w);
+        ry = _mm_mul_ps(ry, w);
+        rz = _mm_mul_ps(rz, w);
+
+        float* out = &result[i].x;
+        __m128 xy = _mm_unpacklo_ps(rx, ry);
+        _mm_storeu_ps(out + 0, _mm_shuffle_ps(xy, _mm_shuffle_ps(rz, rx, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 1, 0)));
+        _mm_storeu_ps(out + 4, _mm_shuffle_ps(_mm_shuffle_ps(ry, rz, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(rx, ry, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(out + 8, _mm_shuffle_ps(_mm_shuffle_ps(rz, rx, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(ry, rz, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+    }
+
+    mat4_transform_vec3_scalar(mat, points + i, result + i, count - i);
+}
+
+void mat4_transform_vec2_array(const mat4* mat, const vec2* points, vec2* result, size_t count)
+{
+    __m128 m0 = _mm_set1_ps(mat->v[0]), m1 = _mm_set1_ps(mat->v[1]), m3 = _mm_set1_ps(mat->v[3]);
+    __m128 m4 = _mm_set1_ps(mat->v[4]), m5 = _mm_set1_ps(mat->v[5]), m7 = _mm_set1_ps(mat->v[7]);
+    __m128 m12 = _mm_set1_ps(mat->v[12]), m13 = _mm_set1_ps(mat->v[13]), m15 = _mm_set1_ps(mat->v[15]);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const float* in = &points[i].x;
+        __m128 a = _mm_loadu_ps(in + 0); /* x0 y0 x1 y1 */
+        __m128 b = _mm_loadu_ps(in + 4); /* x2 y2 x3 y3 */
+
+        __m128 x = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 y = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+
+        __m128 w = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m3, x), _mm_mul_ps(m7, y)), m15);
+        w = _mm_div_ps(_mm_set1_ps(1.0f), w);
+
+        __m128 rx = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, x), _mm_mul_ps(m4, y)), m12), w);
+        __m128 ry = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m1, x), _mm_mul_ps(m5, y)), m13), w);
+
+        float* out = &result[i].x;
+        _mm_storeu_ps(out + 0, _mm_unpacklo_ps(rx, ry));
+        _mm_storeu_ps(out + 4, _mm_unpackhi_ps(rx, ry));
+    }
+
+    mat4_transform_vec2_scalar(mat, points + i, result + i, count - i);
+}
+
+#else
+
+mat4* psmat4_multiply(mat4* result, const mat4* left, const mat4* right)
+{
+    *result = mat4_multiply(*left, *right);
+    return result;
+}
+
+mat4* psmat4_inverse(mat4* result, const mat4* mat)
+{
+    *result = mat4_inverse(*mat);
+    return result;
+}
+
+void mat4_transform_vec3_array(const mat4* mat, const vec3* points, vec3* result, size_t count)
+{
+    mat4_transform_vec3_scalar(mat, points, result, count);
+}
+
+void mat4_transform_vec2_array(const mat4* mat, const vec2* points, vec2* result, size_t count)
+{
+    mat4_transform_vec2_scalar(mat, points, result, count);
+}
+
+#endif
@@ -1,11 +1,21 @@
 #ifndef MAT4_H
 #define MAT4_H
 
+#include <stddef.h>
+
+#include "vec2.h"
 #include "vec3.h"
 
+/* column major, 16 byte aligned so the ps functions can use aligned loads */
+#if defined(_MSC_VER)
+#define MAT4_ALIGN __declspec(align(16))
+#else
+#define MAT4_ALIGN __attribute__((aligned(16)))
+#endif
+
 typedef struct
 {
-    float v[4 * 4];
+    MAT4_ALIGN float v[4 * 4];
 } mat4;
 
 float mat4_determinant(mat4 mat);
@@ -26,4 +36,12 @@ mat4 mat4_perspective(float fov_y, float aspect, float near, float far);
 mat4 mat4_ortho(float left, float right, float bottom, float top, float near, float far);
 mat4 mat4_look_at(vec3 position, vec3 target, vec3 up);
 
+/* pointer versions, vectorized with SSE where available; result may alias the inputs */
+mat4* psmat4_multiply(mat4* result, const mat4* left, const mat4* right);
+mat4* psmat4_inverse(mat4* result, const mat4* mat);
+
+/* transforms points as (x, y, z, 1) including the perspective divide */
+void mat4_transform_vec3_array(const mat4* mat, const vec3* points, vec3* result, size_t count);
+void mat4_transform_vec2_array(const mat4* mat, const vec2* points, vec2* result, size_t count);
+
 #endif /* !MAT4_H */
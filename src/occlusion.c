@@ -0,0 +1,198 @@
+#include "occlusion.h"
+#include "alloc.h"
+
+#include <math.h>
+#include <string.h>
+
+#define ISO_OCCLUSION_SPAN (2 * ISO_OCCLUSION_SUBCOLUMNS) /* subcolumns of a tile */
+
+/* spans of a tile image per subcolumn, relative to its top */
+typedef struct
+{
+    float cover_top[ISO_OCCLUSION_SPAN]; /* covered over the whole subcolumn */
+    float cover_bottom[ISO_OCCLUSION_SPAN];
+    float reach_top[ISO_OCCLUSION_SPAN]; /* touched anywhere in the subcolumn */
+    float reach_bottom[ISO_OCCLUSION_SPAN];
+} IsoOcclusionShape;
+
+static void isoOcclusionShape(const IsoMap* map, IsoOcclusionShape* shape)
+{
+    float size = map->tile_size;
+    float step = size / ISO_OCCLUSION_SUBCOLUMNS;
+
+    // the diamond is widest in the middle, both halves mirror each other
+    for (uint32_t s = 0; s < ISO_OCCLUSION_SUBCOLUMNS; s++)
+    {
+        float inner = s * step;
+        float outer = (s + 1) * step;
+
+        uint32_t left = s;
+        uint32_t right = ISO_OCCLUSION_SPAN - 1 - s;
+
+        shape->cover_top[left]    = shape->cover_top[right]    = (size - inner) * .5f;
+        shape->cover_bottom[left] = shape->cover_bottom[right] = (size + inner) * .5f + map->tile_offset;
+        shape->reach_top[left]    = shape->reach_top[right]    = (size - outer) * .5f;
+        shape->reach_bottom[left] = shape->reach_bottom[right] = (size + outer) * .5f + map->tile_offset;
+    }
+}
+
+int isoOcclusionBuild(IsoOcclusion* occlusion, const IsoMap* map, const IsoAtlas* texture_atlas, const IsoTileRange* range,
+                      uint32_t col_min, uint32_t row_min, uint32_t col_max, uint32_t row_max)
+{
+    memset(occlusion, 0, sizeof(IsoOcclusion));
+
+    if (!map->width || !map->height) return 0;
+
+    if (col_max >= map->width) col_max = map->width - 1;
+    if (row_max >= map->height) row_max = map->height - 1;
+
+    if (range)
+    {
+        if (row_min < range->row_min) row_min = range->row_min;
+        if (row_max > range->row_max) row_max = range->row_max;
+    }
+
+    if (col_min > col_max || row_min > row_max) return 0;
+
+    uint32_t rows = row_max - row_min + 1;
+    occlusion->row_min = row_min;
+    occlusion->row_max = row_max;
+
+    occlusion->col_min = isoFrameAlloc(rows * sizeof(uint32_t));
+    occlusion->col_max = isoFrameAlloc(rows * sizeof(uint32_t));
+    occlusion->offset = isoFrameAlloc(rows * sizeof(uint32_t));
+    occlusion->quads = isoFrameAlloc(rows * sizeof(uint32_t));
+    if (!occlusion->col_min || !occlusion->col_max || !occlusion->offset || !occlusion->quads) return 0;
+
+    uint32_t tiles = 0;
+    for (uint32_t i = 0; i < rows; i++)
+    {
+        uint32_t min = col_min, max = col_max;
+        if (range && !isoTileRangeRow(map, range, row_min + i, &min, &max))
+            min = 1, max = 0;
+
+        if (min < col_min) min = col_min;
+        if (max > col_max) max = col_max;
+        if (min > max) min = 1, max = 0;
+
+        occlusion->col_min[i] = min;
+        occlusion->col_max[i] = max;
+        occlusion->offset[i] = tiles;
+        occlusion->quads[i] = 0;
+        tiles += max + 1 - min;
+    }
+
+    // half tile columns from the left half of the top right tile to the right half of the bottom left one
+    int32_t column_min = (int32_t)col_min - (int32_t)row_max - 1;
+    uint32_t columns = (col_max - col_min) + (row_max - row_min) + 2;
+
+    // every subcolumn keeps one covered span, empty while top > bottom
+    size_t subcolumn_count = (size_t)columns * ISO_OCCLUSION_SUBCOLUMNS;
+    occlusion->first = isoFrameAlloc(tiles * sizeof(uint16_t));
+    float* horizon_top = isoFrameAlloc(subcolumn_count * sizeof(float));
+    float* horizon_bottom = isoFrameAlloc(subcolumn_count * sizeof(float));
+    if (!occlusion->first || !horizon_top || !horizon_bottom) return 0;
+
+    for (size_t i = 0; i < subcolumn_count; i++)
+    {
+        horizon_top[i] = INFINITY;
+        horizon_bottom[i] = -INFINITY;
+    }
+
+    IsoOcclusionShape shape;
+    isoOcclusionShape(map, &shape);
+
+    float half = map->tile_size * .5f;
+    float level = map->tile_offset;
+    float per_level = level > 0.0f ? 1.0f / level : INFINITY;
+
+    // front to back, i.e. draw order reversed
+    for (uint32_t i = rows; i-- > 0;)
+    {
+        uint32_t row = row_min + i;
+        uint16_t* first = occlusion->first + occlusion->offset[i];
+        uint32_t min = occlusion->col_min[i];
+
+        // chunk segments of the row from right to left
+        uint32_t col = occlusion->col_max[i] + 1;
+        while (col > min)
+        {
+            const IsoChunk* chunk = isoMapGetChunk(map, col - 1, row);
+            const uint32_t* tiles = isoChunkRow(chunk, row & ISO_CHUNK_MASK);
+
+            uint32_t start = (col - 1) & ~(uint32_t)ISO_CHUNK_MASK;
+            if (start < min) start = min;
+
+            while (col-- > start)
+            {
+                uint32_t tile = tiles ? tiles[col & ISO_CHUNK_MASK] : chunk->value;
+
+                // nothing drawn, nothing covered
+                first[col - min] = 0;
+                if (ISO_TILE_ID(tile) == ISO_TILE_EMPTY || !isoAtlasTileFrame(texture_atlas, ISO_TILE_ID(tile)))
+                    continue;
+
+                uint32_t elevation = ISO_TILE_ELEVATION(tile);
+                size_t subcolumn = (size_t)((int32_t)col - (int32_t)row - 1 - column_min) * ISO_OCCLUSION_SUBCOLUMNS;
+                float* top = horizon_top + subcolumn;
+                float* bottom = horizon_bottom + subcolumn;
+                float y = (col + row) * half;
+
+                // the bottom level has to be hidden in every subcolumn, levels above as long as they stay below the horizon top
+                float above = INFINITY;
+                int below = 0;
+                for (uint32_t s = 0; s < ISO_OCCLUSION_SPAN; s++)
+                {
+                    float room = y + shape.reach_top[s] - top[s];
+                    above = room < above ? room : above;
+                    below |= y + shape.reach_bottom[s] > bottom[s];
+                }
+
+                uint32_t hidden = 0;
+                if (!below && above >= 0.0f)
+                {
+                    float levels = above * per_level;
+                    hidden = levels < (float)elevation ? (uint32_t)levels + 1 : elevation + 1;
+                }
+
+                first[col - min] = (uint16_t)hidden;
+                occlusion->levels += elevation + 1;
+                occlusion->levels_culled += hidden;
+                occlusion->quads[i] += elevation + 1 - hidden;
+
+                // the whole stack covers its column, hidden levels included. Spans that
+                // overlap the horizon extend it, spans above it replace it
+                float lift = elevation * level;
+                for (uint32_t s = 0; s < ISO_OCCLUSION_SPAN; s++)
+                {
+                    float span_top = y + shape.cover_top[s] - lift;
+                    float span_bottom = y + shape.cover_bottom[s];
+
+                    int overlap = (span_top <= bottom[s]) & (span_bottom >= top[s]);
+                    int higher = span_bottom < top[s];
+
+                    float merged_top = span_top < top[s] ? span_top : top[s];
+                    float merged_bottom = span_bottom > bottom[s] ? span_bottom : bottom[s];
+
+                    top[s] = overlap ? merged_top : higher ? span_top : top[s];
+                    bottom[s] = overlap ? merged_bottom : higher ? span_bottom : bottom[s];
+                }
+            }
+            col = start;
+        }
+    }
+
+    return 1;
+}
+
+uint32_t isoOcclusionFirst(const IsoOcclusion* occlusion, uint32_t col, uint32_t row)
+{
+    if (!occlusion->first || row < occlusion->row_min || row > occlusion->row_max)
+        return 0;
+
+    uint32_t i = row - occlusion->row_min;
+    if (col < occlusion->col_min[i] || col > occlusion->col_max[i])
+        return 0;
+
+    return occlusion->first[occlusion->offset[i] + col - occlusion->col_min[i]];
+}
@@ -0,0 +1,47 @@
+#ifndef OCCLUSION_H
+#define OCCLUSION_H
+
+#include "iso.h"
+
+#define ISO_OCCLUSION_SUBCOLUMNS 2 /* per half tile */
+
+/*
+ * Culling of elevation levels hidden behind raised tiles in front of them.
+ * Every half tile wide screen column is split into subcolumns that each keep
+ * a horizon, one span of screen y known to be covered. The tiles are swept
+ * front to back, i.e. in reverse draw order: each tile is tested against the
+ * horizons of its subcolumns before its own column of levels is added to them.
+ * Only the bottom levels can be hidden like this, so the result is the first
+ * level of each tile that may be visible, above its elevation if none is.
+ *
+ * The side faces of the tile images are taken as opaque. Scratch memory comes
+ * from the frame arena, so the result is valid until the caller releases it.
+ */
+typedef struct
+{
+    uint32_t row_min;
+    uint32_t row_max;
+
+    uint32_t* col_min; /* per row */
+    uint32_t* col_max;
+    uint32_t* offset;  /* per row, of its first tile in first */
+    uint32_t* quads;   /* per row, levels left to draw */
+    uint16_t* first;
+
+    /* stats */
+    uint32_t levels;
+    uint32_t levels_culled;
+} IsoOcclusion;
+
+/*
+ * Sweeps the tiles of range inside the rect of tiles from col_min, row_min to
+ * col_max, row_max. range may be NULL for the whole rect. Returns 0 if there
+ * is nothing to sweep or no memory.
+ */
+int isoOcclusionBuild(IsoOcclusion* occlusion, const IsoMap* map, const IsoAtlas* texture_atlas, const IsoTileRange* range,
+                      uint32_t col_min, uint32_t row_min, uint32_t col_max, uint32_t row_max);
+
+/* the first level of a tile that may be visible, 0 for tiles outside the sweep */
+uint32_t isoOcclusionFirst(const IsoOcclusion* occlusion, uint32_t col, uint32_t row);
+
+#endif // !OCCLUSION_H
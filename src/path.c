@@ -0,0 +1,951 @@
+#include "path.h"
+#include "alloc.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define ISO_PATH_CLOSED  0xffffffff
+#define ISO_PATH_NONE    0xffffffff
+#define ISO_PATH_NO_EDGE 0xffff
+
+#define ISO_PATH_START_KEY 0xfffffffe
+#define ISO_PATH_GOAL_KEY  0xfffffffd
+
+#define ISO_PATH_MAX_EDGES (ISO_PATH_CLUSTER_NODES + 8)
+
+/* transitions on a border segment at least this long are placed at both ends */
+#define ISO_PATH_WIDE_ENTRANCE 6
+
+static const int32_t iso_path_dx[8] = { 1, 0, -1, 0, 1, -1, -1, 1 };
+static const int32_t iso_path_dy[8] = { 0, 1, 0, -1, 1, 1, -1, -1 };
+
+int isoTileWalkable(uint32_t tile)
+{
+    return tile != ISO_TILE_EMPTY && tile != ISO_TILE_WATER && tile != ISO_TILE_PLACEHOLDER;
+}
+
+void isoPathFree(IsoPath* path)
+{
+    if (path->points) isoFree(path->points);
+    memset(path, 0, sizeof(IsoPath));
+}
+
+static int isoPathPush(IsoPath* path, uint32_t col, uint32_t row)
+{
+    if (path->count >= path->capacity)
+    {
+        uint32_t capacity = path->capacity ? path->capacity * 2 : 64;
+        IsoPathPoint* points = isoRealloc(ISO_MEM_PATH, path->points, capacity * sizeof(IsoPathPoint));
+        if (!points) return 0;
+
+        path->points = points;
+        path->capacity = capacity;
+    }
+
+    path->points[path->count++] = (IsoPathPoint){ col, row };
+    return 1;
+}
+
+/* ---------------------------------------------------------------------------
+ * generic A*
+ */
+typedef struct
+{
+    uint32_t key;
+    uint32_t cost;
+} IsoPathEdge;
+
+typedef uint32_t (*IsoPathNeighbours)(void* context, uint32_t key, IsoPathEdge* edges);
+typedef uint32_t (*IsoPathHeuristic)(void* context, uint32_t key);
+
+static uint32_t isoPathHashKey(uint32_t key)
+{
+    key ^= key >> 16;
+    key *= 0x85ebca6bu;
+    key ^= key >> 13;
+    key *= 0xc2b2ae35u;
+    return key ^ (key >> 16);
+}
+
+static void isoPathSearchFree(IsoPathSearch* search)
+{
+    if (search->records) isoFree(search->records);
+    if (search->slots) isoFree(search->slots);
+    if (search->heap) isoFree(search->heap);
+
+    memset(search, 0, sizeof(IsoPathSearch));
+}
+
+static void isoPathSearchReset(IsoPathSearch* search)
+{
+    // only the used slots are cleared, so reuse stays cheap for big tables
+    for (uint32_t i = 0; i < search->record_count; i++)
+        search->slots[search->records[i].slot] = 0;
+
+    search->record_count = 0;
+    search->heap_count = 0;
+    search->expansions = 0;
+}
+
+static uint32_t isoPathSearchSlot(const IsoPathSearch* search, uint32_t key)
+{
+    uint32_t slot = isoPathHashKey(key) & search->slot_mask;
+    while (search->slots[slot] && search->records[search->slots[slot] - 1].key != key)
+        slot = (slot + 1) & search->slot_mask;
+    return slot;
+}
+
+static int isoPathSearchGrow(IsoPathSearch* search)
+{
+    uint32_t capacity = search->record_capacity ? search->record_capacity * 2 : 1024;
+
+    IsoPathRecord* records = isoRealloc(ISO_MEM_PATH, search->records, capacity * sizeof(IsoPathRecord));
+    if (!records) return 0;
+    search->records = records;
+
+    uint32_t* heap = isoRealloc(ISO_MEM_PATH, search->heap, capacity * sizeof(uint32_t));
+    if (!heap) return 0;
+    search->heap = heap;
+
+    // keep the table at most half full
+    uint32_t* slots = isoCalloc(ISO_MEM_PATH, (size_t)capacity * 2, sizeof(uint32_t));
+    if (!slots) return 0;
+
+    if (search->slots) isoFree(search->slots);
+    search->slots = slots;
+    search->slot_mask = capacity * 2 - 1;
+    search->record_capacity = capacity;
+
+    for (uint32_t i = 0; i < search->record_count; i++)
+    {
+        uint32_t slot = isoPathSearchSlot(search, search->records[i].key);
+        search->slots[slot] = i + 1;
+        search->records[i].slot = slot;
+    }
+
+    return 1;
+}
+
+static int isoPathHeapLess(const IsoPathSearch* search, uint32_t a, uint32_t b)
+{
+    const IsoPathRecord* ra = &search->records[a];
+    const IsoPathRecord* rb = &search->records[b];
+
+    // prefer deeper nodes on ties, which cuts down expansions on open ground
+    return ra->f < rb->f || (ra->f == rb->f && ra->g > rb->g);
+}
+
+static void isoPathHeapUp(IsoPathSearch* search, uint32_t pos)
+{
+    uint32_t record = search->heap[pos];
+    while (pos > 0)
+    {
+        uint32_t parent = (pos - 1) / 2;
+        if (!isoPathHeapLess(search, record, search->heap[parent])) break;
+
+        search->heap[pos] = search->heap[parent];
+        search->records[search->heap[pos]].heap = pos;
+        pos = parent;
+    }
+    search->heap[pos] = record;
+    search->records[record].heap = pos;
+}
+
+static uint32_t isoPathHeapPop(IsoPathSearch* search)
+{
+    uint32_t top = search->heap[0];
+    uint32_t record = search->heap[--search->heap_count];
+
+    uint32_t pos = 0;
+    uint32_t count = search->heap_count;
+    while (count)
+    {
+        uint32_t child = pos * 2 + 1;
+        if (child >= count) break;
+        if (child + 1 < count && isoPathHeapLess(search, search->heap[child + 1], search->heap[child])) child++;
+        if (!isoPathHeapLess(search, search->heap[child], record)) break;
+
+        search->heap[pos] = search->heap[child];
+        search->records[search->heap[pos]].heap = pos;
+        pos = child;
+    }
+
+    if (count)
+    {
+        search->heap[pos] = record;
+        search->records[record].heap = pos;
+    }
+
+    search->records[top].heap = ISO_PATH_CLOSED;
+    return top;
+}
+
+/* returns the record of the goal or ISO_PATH_NONE */
+static uint32_t isoPathSearchRun(IsoPathSearch* search, uint32_t start, uint32_t goal,
+                                 IsoPathNeighbours neighbours, IsoPathHeuristic heuristic, void* context)
+{
+    isoPathSearchReset(search);
+
+    if (search->record_count >= search->record_capacity && !isoPathSearchGrow(search))
+        return ISO_PATH_NONE;
+
+    uint32_t slot = isoPathSearchSlot(search, start);
+    search->records[0] = (IsoPathRecord){ start, 0, heuristic(context, start), ISO_PATH_NONE, slot, 0 };
+    search->slots[slot] = 1;
+    search->heap[0] = 0;
+    search->record_count = 1;
+    search->heap_count = 1;
+
+    IsoPathEdge edges[ISO_PATH_MAX_EDGES];
+
+    while (search->heap_count)
+    {
+        uint32_t current = isoPathHeapPop(search);
+        if (search->records[current].key == goal)
+            return current;
+
+        search->expansions++;
+
+        uint32_t g = search->records[current].g;
+        uint32_t count = neighbours(context, search->records[current].key, edges);
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint32_t cost = g + edges[i].cost;
+
+            slot = isoPathSearchSlot(search, edges[i].key);
+            if (search->slots[slot])
+            {
+                IsoPathRecord* record = &search->records[search->slots[slot] - 1];
+                if (record->heap == ISO_PATH_CLOSED || cost >= record->g) continue;
+
+                record->f -= record->g - cost;
+                record->g = cost;
+                record->parent = current;
+                isoPathHeapUp(search, record->heap);
+                continue;
+            }
+
+            if (search->record_count >= search->record_capacity)
+            {
+                if (!isoPathSearchGrow(search)) return ISO_PATH_NONE;
+                slot = isoPathSearchSlot(search, edges[i].key);
+            }
+
+            uint32_t index = search->record_count++;
+            search->records[index] = (IsoPathRecord){
+                edges[i].key, cost, cost + heuristic(context, edges[i].key), current, slot, search->heap_count
+            };
+            search->slots[slot] = index + 1;
+            search->heap[search->heap_count++] = index;
+            isoPathHeapUp(search, search->records[index].heap);
+        }
+    }
+
+    return ISO_PATH_NONE;
+}
+
+/* ---------------------------------------------------------------------------
+ * tile grid
+ */
+static int isoPathWalkable(const IsoMap* map, int32_t col, int32_t row)
+{
+    if (col < 0 || row < 0 || col >= (int32_t)map->width || row >= (int32_t)map->height) return 0;
+    return isoTileWalkable(isoMapGetTile(map, (uint32_t)col, (uint32_t)row));
+}
+
+static uint32_t isoPathOctile(uint32_t dx, uint32_t dy)
+{
+    uint32_t lo = dx < dy ? dx : dy;
+    uint32_t hi = dx < dy ? dy : dx;
+    return ISO_PATH_COST_DIAGONAL * lo + ISO_PATH_COST_STRAIGHT * (hi - lo);
+}
+
+static uint32_t isoPathDistance(uint32_t col_a, uint32_t row_a, uint32_t col_b, uint32_t row_b)
+{
+    uint32_t dx = col_a > col_b ? col_a - col_b : col_b - col_a;
+    uint32_t dy = row_a > row_b ? row_a - row_b : row_b - row_a;
+    return isoPathOctile(dx, dy);
+}
+
+static uint32_t isoPathGridNeighbours(void* context, uint32_t key, IsoPathEdge* edges)
+{
+    const IsoPathfinder* pathfinder = context;
+    const IsoMap* map = pathfinder->map;
+
+    int32_t col = (int32_t)(key % map->width);
+    int32_t row = (int32_t)(key / map->width);
+
+    int open[4];
+    uint32_t count = 0;
+    for (int dir = 0; dir < 4; dir++)
+    {
+        int32_t c = col + iso_path_dx[dir];
+        int32_t r = row + iso_path_dy[dir];
+
+        open[dir] = isoPathWalkable(map, c, r);
+        if (open[dir]) edges[count++] = (IsoPathEdge){ (uint32_t)r * map->width + (uint32_t)c, ISO_PATH_COST_STRAIGHT };
+    }
+
+    // diagonals need both orthogonal neighbours free
+    for (int dir = 4; dir < 8; dir++)
+    {
+        int32_t dx = iso_path_dx[dir];
+        int32_t dy = iso_path_dy[dir];
+        if (!open[dx > 0 ? 0 : 2] || !open[dy > 0 ? 1 : 3]) continue;
+
+        int32_t c = col + dx;
+        int32_t r = row + dy;
+        if (isoPathWalkable(map, c, r))
+            edges[count++] = (IsoPathEdge){ (uint32_t)r * map->width + (uint32_t)c, ISO_PATH_COST_DIAGONAL };
+    }
+
+    return count;
+}
+
+static uint32_t isoPathGridHeuristic(void* context, uint32_t key)
+{
+    const IsoPathfinder* pathfinder = context;
+    uint32_t width = pathfinder->map->width;
+    return isoPathDistance(key % width, key / width, pathfinder->goal_key % width, pathfinder->goal_key / width);
+}
+
+static int isoPathTrace(const IsoPathSearch* search, uint32_t record, uint32_t width, IsoPath* path)
+{
+    // records are walked goal to start, so reverse afterwards
+    uint32_t first = path->count;
+    for (uint32_t r = record; r != ISO_PATH_NONE; r = search->records[r].parent)
+    {
+        uint32_t key = search->records[r].key;
+        if (!isoPathPush(path, key % width, key / width)) return 0;
+    }
+
+    for (uint32_t i = first, j = path->count - 1; i < j; i++, j--)
+    {
+        IsoPathPoint tmp = path->points[i];
+        path->points[i] = path->points[j];
+        path->points[j] = tmp;
+    }
+
+    return 1;
+}
+
+int isoPathFindGrid(IsoPathfinder* pathfinder, IsoPathPoint start, IsoPathPoint goal, IsoPath* path)
+{
+    const IsoMap* map = pathfinder->map;
+
+    path->count = 0;
+    path->cost = 0;
+    path->expansions = 0;
+
+    if (!isoPathWalkable(map, (int32_t)start.col, (int32_t)start.row)) return 0;
+    if (!isoPathWalkable(map, (int32_t)goal.col, (int32_t)goal.row)) return 0;
+
+    pathfinder->goal_key = goal.row * map->width + goal.col;
+    uint32_t record = isoPathSearchRun(&pathfinder->search, start.row * map->width + start.col, pathfinder->goal_key,
+                                       isoPathGridNeighbours, isoPathGridHeuristic, pathfinder);
+
+    path->expansions = pathfinder->search.expansions;
+    if (record == ISO_PATH_NONE) return 0;
+
+    path->cost = pathfinder->search.records[record].g;
+    return isoPathTrace(&pathfinder->search, record, map->width, path);
+}
+
+/* ---------------------------------------------------------------------------
+ * clusters
+ */
+typedef struct
+{
+    uint32_t col; /* first tile */
+    uint32_t row;
+    uint32_t w;
+    uint32_t h;
+    uint8_t walkable[ISO_PATH_CLUSTER_CELLS];
+} IsoPathArea;
+
+static void isoPathAreaLoad(const IsoPathfinder* pathfinder, uint32_t cluster, IsoPathArea* area)
+{
+    const IsoMap* map = pathfinder->map;
+
+    area->col = (cluster % pathfinder->cluster_cols) << ISO_PATH_CLUSTER_SHIFT;
+    area->row = (cluster / pathfinder->cluster_cols) << ISO_PATH_CLUSTER_SHIFT;
+    area->w = map->width - area->col < ISO_PATH_CLUSTER_SIZE ? map->width - area->col : ISO_PATH_CLUSTER_SIZE;
+    area->h = map->height - area->row < ISO_PATH_CLUSTER_SIZE ? map->height - area->row : ISO_PATH_CLUSTER_SIZE;
+
+    memset(area->walkable, 0, sizeof(area->walkable));
+    for (uint32_t y = 0; y < area->h; y++)
+    {
+        for (uint32_t x = 0; x < area->w; x++)
+            area->walkable[y * ISO_PATH_CLUSTER_SIZE + x] = (uint8_t)isoTileWalkable(isoMapGetTile(map, area->col + x, area->row + y));
+    }
+}
+
+static void isoPathLocalPush(uint32_t* heap, uint32_t* count, uint32_t entry)
+{
+    uint32_t pos = (*count)++;
+    while (pos > 0 && heap[(pos - 1) / 2] > entry)
+    {
+        heap[pos] = heap[(pos - 1) / 2];
+        pos = (pos - 1) / 2;
+    }
+    heap[pos] = entry;
+}
+
+static uint32_t isoPathLocalPop(uint32_t* heap, uint32_t* count)
+{
+    uint32_t top = heap[0];
+    uint32_t entry = heap[--(*count)];
+
+    uint32_t pos = 0;
+    for (;;)
+    {
+        uint32_t child = pos * 2 + 1;
+        if (child >= *count) break;
+        if (child + 1 < *count && heap[child + 1] < heap[child]) child++;
+        if (heap[child] >= entry) break;
+
+        heap[pos] = heap[child];
+        pos = child;
+    }
+    if (*count) heap[pos] = entry;
+
+    return top;
+}
+
+/*
+ * Dijkstra restricted to one cluster, or A* if there is a target cell.
+ * Heap entries pack priority and cell, so the heap is a plain array of
+ * integers. parent may be NULL.
+ */
+static uint32_t isoPathAreaHeuristic(uint32_t cell, uint32_t target)
+{
+    if (target == ISO_PATH_NONE) return 0;
+    return isoPathDistance(cell & ISO_PATH_CLUSTER_MASK, cell >> ISO_PATH_CLUSTER_SHIFT,
+                           target & ISO_PATH_CLUSTER_MASK, target >> ISO_PATH_CLUSTER_SHIFT);
+}
+
+static uint32_t isoPathAreaSearch(const IsoPathArea* area, uint32_t source, uint32_t target, uint16_t* dist, uint16_t* parent)
+{
+    uint32_t heap[ISO_PATH_CLUSTER_CELLS * 8];
+    uint32_t count = 0;
+    uint32_t expansions = 0;
+
+    for (uint32_t i = 0; i < ISO_PATH_CLUSTER_CELLS; i++) dist[i] = ISO_PATH_NO_EDGE;
+    if (parent) parent[source] = ISO_PATH_NO_EDGE;
+
+    dist[source] = 0;
+    isoPathLocalPush(heap, &count, (isoPathAreaHeuristic(source, target) << (2 * ISO_PATH_CLUSTER_SHIFT)) | source);
+
+    while (count)
+    {
+        uint32_t entry = isoPathLocalPop(heap, &count);
+        uint32_t cell = entry & (ISO_PATH_CLUSTER_CELLS - 1);
+        uint32_t d = (entry >> (2 * ISO_PATH_CLUSTER_SHIFT)) - isoPathAreaHeuristic(cell, target);
+
+        if (d > dist[cell]) continue; // stale entry
+        if (cell == target) break;
+
+        expansions++;
+
+        int32_t x = (int32_t)(cell & ISO_PATH_CLUSTER_MASK);
+        int32_t y = (int32_t)(cell >> ISO_PATH_CLUSTER_SHIFT);
+
+        int open[4];
+        for (int dir = 0; dir < 8; dir++)
+        {
+            int32_t nx = x + iso_path_dx[dir];
+            int32_t ny = y + iso_path_dy[dir];
+
+            int walkable = nx >= 0 && ny >= 0 && nx < (int32_t)area->w && ny < (int32_t)area->h
+                && area->walkable[ny * ISO_PATH_CLUSTER_SIZE + nx];
+
+            if (dir < 4)
+            {
+                open[dir] = walkable;
+            }
+            else if (!open[iso_path_dx[dir] > 0 ? 0 : 2] || !open[iso_path_dy[dir] > 0 ? 1 : 3])
+            {
+                continue;
+            }
+
+            if (!walkable) continue;
+
+            uint32_t next = (uint32_t)(ny * ISO_PATH_CLUSTER_SIZE + nx);
+            uint32_t cost = d + (dir < 4 ? ISO_PATH_COST_STRAIGHT : ISO_PATH_COST_DIAGONAL);
+            if (cost >= dist[next]) continue;
+
+            dist[next] = (uint16_t)cost;
+            if (parent) parent[next] = (uint16_t)cell;
+            uint32_t priority = cost + isoPathAreaHeuristic(next, target);
+            isoPathLocalPush(heap, &count, (priority << (2 * ISO_PATH_CLUSTER_SHIFT)) | next);
+        }
+    }
+
+    return expansions;
+}
+
+static void isoPathClusterFree(IsoPathCluster* cluster)
+{
+    if (cluster->nodes) isoFree(cluster->nodes);
+    if (cluster->costs) isoFree(cluster->costs);
+
+    memset(cluster, 0, sizeof(IsoPathCluster));
+}
+
+static int isoPathClusterAddNode(uint8_t* nodes, uint32_t* count, uint32_t cell)
+{
+    for (uint32_t i = 0; i < *count; i++)
+    {
+        if (nodes[i] == cell) return 1;
+    }
+
+    if (*count >= ISO_PATH_CLUSTER_NODES) return 0;
+
+    nodes[(*count)++] = (uint8_t)cell;
+    return 1;
+}
+
+/*
+ * Transitions on the border behind the last column (vertical) or row of the
+ * given cluster. Both clusters next to a border derive the same transitions
+ * from it, so they can be rebuilt independently. Returns the number of
+ * offsets along the border.
+ */
+static uint32_t isoPathBorderTransitions(const IsoPathfinder* pathfinder, uint32_t cx, uint32_t cy, int vertical, uint32_t* offsets)
+{
+    const IsoMap* map = pathfinder->map;
+
+    uint32_t col = cx << ISO_PATH_CLUSTER_SHIFT;
+    uint32_t row = cy << ISO_PATH_CLUSTER_SHIFT;
+    uint32_t length;
+
+    if (vertical)
+    {
+        col += ISO_PATH_CLUSTER_SIZE - 1;
+        length = map->height - row < ISO_PATH_CLUSTER_SIZE ? map->height - row : ISO_PATH_CLUSTER_SIZE;
+    }
+    else
+    {
+        row += ISO_PATH_CLUSTER_SIZE - 1;
+        length = map->width - col < ISO_PATH_CLUSTER_SIZE ? map->width - col : ISO_PATH_CLUSTER_SIZE;
+    }
+
+    uint32_t count = 0;
+    uint32_t begin = 0;
+    int inside = 0;
+
+    for (uint32_t i = 0; i <= length; i++)
+    {
+        int open = 0;
+        if (i < length)
+        {
+            uint32_t c = vertical ? col : col + i;
+            uint32_t r = vertical ? row + i : row;
+            open = isoPathWalkable(map, (int32_t)c, (int32_t)r)
+                && isoPathWalkable(map, (int32_t)(c + (vertical ? 1 : 0)), (int32_t)(r + (vertical ? 0 : 1)));
+        }
+
+        if (open && !inside) begin = i;
+        if (!open && inside)
+        {
+            uint32_t end = i - 1;
+            if (end - begin + 1 >= ISO_PATH_WIDE_ENTRANCE)
+            {
+                offsets[count++] = begin;
+                offsets[count++] = end;
+            }
+            else
+            {
+                offsets[count++] = (begin + end) / 2;
+            }
+        }
+        inside = open;
+    }
+
+    return count;
+}
+
+static int isoPathClusterBuild(IsoPathfinder* pathfinder, uint32_t index)
+{
+    IsoPathCluster* cluster = &pathfinder->clusters[index];
+    isoPathClusterFree(cluster);
+
+    uint32_t cx = index % pathfinder->cluster_cols;
+    uint32_t cy = index / pathfinder->cluster_cols;
+
+    uint8_t nodes[ISO_PATH_CLUSTER_NODES];
+    uint32_t node_count = 0;
+
+    uint32_t offsets[ISO_PATH_CLUSTER_SIZE];
+    uint32_t count;
+    const uint32_t last = ISO_PATH_CLUSTER_SIZE - 1;
+
+    // right and bottom borders are owned by this cluster, left and top by the neighbours
+    if (cx + 1 < pathfinder->cluster_cols)
+    {
+        count = isoPathBorderTransitions(pathfinder, cx, cy, 1, offsets);
+        for (uint32_t i = 0; i < count; i++) isoPathClusterAddNode(nodes, &node_count, offsets[i] * ISO_PATH_CLUSTER_SIZE + last);
+    }
+    if (cy + 1 < pathfinder->cluster_rows)
+    {
+        count = isoPathBorderTransitions(pathfinder, cx, cy, 0, offsets);
+        for (uint32_t i = 0; i < count; i++) isoPathClusterAddNode(nodes, &node_count, last * ISO_PATH_CLUSTER_SIZE + offsets[i]);
+    }
+    if (cx > 0)
+    {
+        count = isoPathBorderTransitions(pathfinder, cx - 1, cy, 1, offsets);
+        for (uint32_t i = 0; i < count; i++) isoPathClusterAddNode(nodes, &node_count, offsets[i] * ISO_PATH_CLUSTER_SIZE);
+    }
+    if (cy > 0)
+    {
+        count = isoPathBorderTransitions(pathfinder, cx, cy - 1, 0, offsets);
+        for (uint32_t i = 0; i < count; i++) isoPathClusterAddNode(nodes, &node_count, offsets[i]);
+    }
+
+    cluster->built = 1;
+    pathfinder->clusters_built++;
+
+    if (!node_count) return 1;
+
+    cluster->nodes = isoMalloc(ISO_MEM_PATH, node_count);
+    cluster->costs = isoMalloc(ISO_MEM_PATH, node_count * node_count * sizeof(uint16_t));
+    if (!cluster->nodes || !cluster->costs)
+    {
+        isoPathClusterFree(cluster);
+        return 0;
+    }
+
+    memcpy(cluster->nodes, nodes, node_count);
+    cluster->node_count = node_count;
+
+    IsoPathArea area;
+    isoPathAreaLoad(pathfinder, index, &area);
+
+    uint16_t dist[ISO_PATH_CLUSTER_CELLS];
+    for (uint32_t i = 0; i < node_count; i++)
+    {
+        isoPathAreaSearch(&area, nodes[i], ISO_PATH_NONE, dist, NULL);
+        for (uint32_t j = 0; j < node_count; j++)
+            cluster->costs[i * node_count + j] = dist[nodes[j]];
+    }
+
+    return 1;
+}
+
+static IsoPathCluster* isoPathGetCluster(IsoPathfinder* pathfinder, uint32_t index)
+{
+    IsoPathCluster* cluster = &pathfinder->clusters[index];
+    if (!cluster->built) isoPathClusterBuild(pathfinder, index);
+    return cluster;
+}
+
+static uint32_t isoPathClusterOf(const IsoPathfinder* pathfinder, uint32_t col, uint32_t row)
+{
+    return (row >> ISO_PATH_CLUSTER_SHIFT) * pathfinder->cluster_cols + (col >> ISO_PATH_CLUSTER_SHIFT);
+}
+
+int isoPathfinderInit(IsoPathfinder* pathfinder, const IsoMap* map)
+{
+    memset(pathfinder, 0, sizeof(IsoPathfinder));
+
+    pathfinder->map = map;
+    pathfinder->cluster_cols = (map->width + ISO_PATH_CLUSTER_MASK) >> ISO_PATH_CLUSTER_SHIFT;
+    pathfinder->cluster_rows = (map->height + ISO_PATH_CLUSTER_MASK) >> ISO_PATH_CLUSTER_SHIFT;
+
+    // clusters are built on first use
+    pathfinder->clusters = isoCalloc(ISO_MEM_PATH, (size_t)pathfinder->cluster_cols * pathfinder->cluster_rows, sizeof(IsoPathCluster));
+    return pathfinder->clusters != NULL;
+}
+
+void isoPathfinderDestroy(IsoPathfinder* pathfinder)
+{
+    uint32_t count = pathfinder->cluster_cols * pathfinder->cluster_rows;
+    for (uint32_t i = 0; pathfinder->clusters && i < count; i++)
+        isoPathClusterFree(&pathfinder->clusters[i]);
+
+    if (pathfinder->clusters) isoFree(pathfinder->clusters);
+    isoPathSearchFree(&pathfinder->search);
+
+    memset(pathfinder, 0, sizeof(IsoPathfinder));
+}
+
+static void isoPathfinderInvalidate(IsoPathfinder* pathfinder, int32_t cx, int32_t cy)
+{
+    if (cx < 0 || cy < 0 || cx >= (int32_t)pathfinder->cluster_cols || cy >= (int32_t)pathfinder->cluster_rows)
+        return;
+
+    IsoPathCluster* cluster = &pathfinder->clusters[cy * pathfinder->cluster_cols + cx];
+    isoPathClusterFree(cluster);
+}
+
+void isoPathfinderTileChanged(IsoPathfinder* pathfinder, uint32_t col, uint32_t row)
+{
+    if (col >= pathfinder->map->width || row >= pathfinder->map->height) return;
+
+    int32_t cx = (int32_t)(col >> ISO_PATH_CLUSTER_SHIFT);
+    int32_t cy = (int32_t)(row >> ISO_PATH_CLUSTER_SHIFT);
+    uint32_t x = col & ISO_PATH_CLUSTER_MASK;
+    uint32_t y = row & ISO_PATH_CLUSTER_MASK;
+
+    isoPathfinderInvalidate(pathfinder, cx, cy);
+
+    // border tiles also move the transitions of the cluster next to them
+    if (x == 0)                         isoPathfinderInvalidate(pathfinder, cx - 1, cy);
+    if (x == ISO_PATH_CLUSTER_MASK)     isoPathfinderInvalidate(pathfinder, cx + 1, cy);
+    if (y == 0)                         isoPathfinderInvalidate(pathfinder, cx, cy - 1);
+    if (y == ISO_PATH_CLUSTER_MASK)     isoPathfinderInvalidate(pathfinder, cx, cy + 1);
+}
+
+void isoPathfinderChunkChanged(IsoPathfinder* pathfinder, uint32_t chunk)
+{
+    const IsoMap* map = pathfinder->map;
+    int32_t col = (int32_t)((chunk % map->chunk_cols) << ISO_CHUNK_SHIFT);
+    int32_t row = (int32_t)((chunk / map->chunk_cols) << ISO_CHUNK_SHIFT);
+
+    // the clusters covering the chunk and the ones bordering them
+    int32_t cx_min = (col >> ISO_PATH_CLUSTER_SHIFT) - 1;
+    int32_t cy_min = (row >> ISO_PATH_CLUSTER_SHIFT) - 1;
+    int32_t cx_max = ((col + ISO_CHUNK_MASK) >> ISO_PATH_CLUSTER_SHIFT) + 1;
+    int32_t cy_max = ((row + ISO_CHUNK_MASK) >> ISO_PATH_CLUSTER_SHIFT) + 1;
+
+    for (int32_t cy = cy_min; cy <= cy_max; cy++)
+    {
+        for (int32_t cx = cx_min; cx <= cx_max; cx++)
+            isoPathfinderInvalidate(pathfinder, cx, cy);
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * abstract graph
+ */
+static void isoPathNodeTile(const IsoPathfinder* pathfinder, uint32_t key, uint32_t* col, uint32_t* row)
+{
+    uint32_t cluster = key / ISO_PATH_CLUSTER_NODES;
+    uint32_t cell = pathfinder->clusters[cluster].nodes[key % ISO_PATH_CLUSTER_NODES];
+
+    *col = ((cluster % pathfinder->cluster_cols) << ISO_PATH_CLUSTER_SHIFT) + (cell & ISO_PATH_CLUSTER_MASK);
+    *row = ((cluster / pathfinder->cluster_cols) << ISO_PATH_CLUSTER_SHIFT) + (cell >> ISO_PATH_CLUSTER_SHIFT);
+}
+
+static void isoPathKeyTile(const IsoPathfinder* pathfinder, uint32_t key, uint32_t* col, uint32_t* row)
+{
+    uint32_t width = pathfinder->map->width;
+
+    if (key == ISO_PATH_START_KEY)     key = pathfinder->start_key;
+    else if (key == ISO_PATH_GOAL_KEY) key = pathfinder->goal_key;
+    else
+    {
+        isoPathNodeTile(pathfinder, key, col, row);
+        return;
+    }
+
+    *col = key % width;
+    *row = key / width;
+}
+
+static uint32_t isoPathAbstractNeighbours(void* context, uint32_t key, IsoPathEdge* edges)
+{
+    IsoPathfinder* pathfinder = context;
+    uint32_t count = 0;
+
+    if (key == ISO_PATH_START_KEY)
+    {
+        const IsoPathCluster* cluster = &pathfinder->clusters[pathfinder->start_cluster];
+        for (uint32_t i = 0; i < cluster->node_count; i++)
+        {
+            if (pathfinder->start_costs[i] == ISO_PATH_NO_EDGE) continue;
+            edges[count++] = (IsoPathEdge){ pathfinder->start_cluster * ISO_PATH_CLUSTER_NODES + i, pathfinder->start_costs[i] };
+        }
+        return count;
+    }
+
+    uint32_t index = key / ISO_PATH_CLUSTER_NODES;
+    uint32_t node = key % ISO_PATH_CLUSTER_NODES;
+    const IsoPathCluster* cluster = &pathfinder->clusters[index];
+
+    // paths inside the cluster
+    const uint16_t* costs = cluster->costs + node * cluster->node_count;
+    for (uint32_t i = 0; i < cluster->node_count; i++)
+    {
+        if (i == node || costs[i] == ISO_PATH_NO_EDGE) continue;
+        edges[count++] = (IsoPathEdge){ index * ISO_PATH_CLUSTER_NODES + i, costs[i] };
+    }
+
+    if (index == pathfinder->goal_cluster && pathfinder->goal_costs[node] != ISO_PATH_NO_EDGE)
+        edges[count++] = (IsoPathEdge){ ISO_PATH_GOAL_KEY, pathfinder->goal_costs[node] };
+
+    // steps over the border onto a node of the neighbour
+    uint32_t col, row;
+    isoPathNodeTile(pathfinder, key, &col, &row);
+
+    for (int dir = 0; dir < 4; dir++)
+    {
+        int32_t c = (int32_t)col + iso_path_dx[dir];
+        int32_t r = (int32_t)row + iso_path_dy[dir];
+        if (c < 0 || r < 0 || c >= (int32_t)pathfinder->map->width || r >= (int32_t)pathfinder->map->height) continue;
+
+        uint32_t other = isoPathClusterOf(pathfinder, (uint32_t)c, (uint32_t)r);
+        if (other == index) continue;
+
+        const IsoPathCluster* neighbour = isoPathGetCluster(pathfinder, other);
+        uint32_t cell = ((uint32_t)r & ISO_PATH_CLUSTER_MASK) * ISO_PATH_CLUSTER_SIZE + ((uint32_t)c & ISO_PATH_CLUSTER_MASK);
+
+        for (uint32_t i = 0; i < neighbour->node_count; i++)
+        {
+            if (neighbour->nodes[i] != cell) continue;
+
+            edges[count++] = (IsoPathEdge){ other * ISO_PATH_CLUSTER_NODES + i, ISO_PATH_COST_STRAIGHT };
+            break;
+        }
+    }
+
+    return count;
+}
+
+static uint32_t isoPathAbstractHeuristic(void* context, uint32_t key)
+{
+    const IsoPathfinder* pathfinder = context;
+
+    uint32_t col, row;
+    isoPathKeyTile(pathfinder, key, &col, &row);
+
+    uint32_t width = pathfinder->map->width;
+    return isoPathDistance(col, row, pathfinder->goal_key % width, pathfinder->goal_key / width);
+}
+
+/* appends the path inside one cluster from a to b, without a itself */
+static int isoPathRefine(IsoPathfinder* pathfinder, uint32_t col_a, uint32_t row_a, uint32_t col_b, uint32_t row_b, IsoPath* path)
+{
+    IsoPathArea area;
+    isoPathAreaLoad(pathfinder, isoPathClusterOf(pathfinder, col_a, row_a), &area);
+
+    uint32_t source = (row_a - area.row) * ISO_PATH_CLUSTER_SIZE + (col_a - area.col);
+    uint32_t target = (row_b - area.row) * ISO_PATH_CLUSTER_SIZE + (col_b - area.col);
+
+    uint16_t dist[ISO_PATH_CLUSTER_CELLS];
+    uint16_t parent[ISO_PATH_CLUSTER_CELLS];
+    path->expansions += isoPathAreaSearch(&area, source, target, dist, parent);
+
+    if (dist[target] == ISO_PATH_NO_EDGE) return 0;
+
+    uint32_t first = path->count;
+    for (uint32_t cell = target; cell != source; cell = parent[cell])
+    {
+        if (!isoPathPush(path, area.col + (cell & ISO_PATH_CLUSTER_MASK), area.row + (cell >> ISO_PATH_CLUSTER_SHIFT)))
+            return 0;
+    }
+
+    for (uint32_t i = first, j = path->count - 1; i < j; i++, j--)
+    {
+        IsoPathPoint tmp = path->points[i];
+        path->points[i] = path->points[j];
+        path->points[j] = tmp;
+    }
+
+    return 1;
+}
+
+/* sums up the steps, the abstract costs do not match the refined path */
+static void isoPathSumCost(IsoPath* path)
+{
+    path->cost = 0;
+    for (uint32_t i = 1; i < path->count; i++)
+    {
+        const IsoPathPoint* a = &path->points[i - 1];
+        const IsoPathPoint* b = &path->points[i];
+        path->cost += (a->col != b->col && a->row != b->row) ? ISO_PATH_COST_DIAGONAL : ISO_PATH_COST_STRAIGHT;
+    }
+}
+
+/* costs from a tile to every node of its cluster */
+static void isoPathNodeCosts(IsoPathfinder* pathfinder, uint32_t cluster_index, uint32_t col, uint32_t row, uint16_t* costs, uint32_t* expansions)
+{
+    const IsoPathCluster* cluster = isoPathGetCluster(pathfinder, cluster_index);
+
+    IsoPathArea area;
+    isoPathAreaLoad(pathfinder, cluster_index, &area);
+
+    uint16_t dist[ISO_PATH_CLUSTER_CELLS];
+    *expansions += isoPathAreaSearch(&area, (row - area.row) * ISO_PATH_CLUSTER_SIZE + (col - area.col), ISO_PATH_NONE, dist, NULL);
+
+    for (uint32_t i = 0; i < cluster->node_count; i++)
+        costs[i] = dist[cluster->nodes[i]];
+}
+
+int isoPathFind(IsoPathfinder* pathfinder, IsoPathPoint start, IsoPathPoint goal, IsoPath* path)
+{
+    const IsoMap* map = pathfinder->map;
+
+    path->count = 0;
+    path->cost = 0;
+    path->expansions = 0;
+
+    if (!isoPathWalkable(map, (int32_t)start.col, (int32_t)start.row)) return 0;
+    if (!isoPathWalkable(map, (int32_t)goal.col, (int32_t)goal.row)) return 0;
+
+    if (!isoPathPush(path, start.col, start.row)) return 0;
+
+    pathfinder->start_cluster = isoPathClusterOf(pathfinder, start.col, start.row);
+    pathfinder->goal_cluster = isoPathClusterOf(pathfinder, goal.col, goal.row);
+    pathfinder->start_key = start.row * map->width + start.col;
+    pathfinder->goal_key = goal.row * map->width + goal.col;
+
+    // short paths never leave the cluster
+    if (pathfinder->start_cluster == pathfinder->goal_cluster)
+    {
+        if (isoPathRefine(pathfinder, start.col, start.row, goal.col, goal.row, path))
+        {
+            isoPathSumCost(path);
+            return 1;
+        }
+        path->count = 1;
+    }
+
+    isoPathNodeCosts(pathfinder, pathfinder->start_cluster, start.col, start.row, pathfinder->start_costs, &path->expansions);
+    isoPathNodeCosts(pathfinder, pathfinder->goal_cluster, goal.col, goal.row, pathfinder->goal_costs, &path->expansions);
+
+    uint32_t record = isoPathSearchRun(&pathfinder->search, ISO_PATH_START_KEY, ISO_PATH_GOAL_KEY,
+                                       isoPathAbstractNeighbours, isoPathAbstractHeuristic, pathfinder);
+
+    path->expansions += pathfinder->search.expansions;
+    if (record == ISO_PATH_NONE)
+    {
+        path->count = 0;
+        return 0;
+    }
+
+    // collect the abstract nodes start to goal, then refine each hop
+    const IsoPathSearch* search = &pathfinder->search;
+    uint32_t hops = 0;
+    for (uint32_t r = record; r != ISO_PATH_NONE; r = search->records[r].parent) hops++;
+
+    size_t mark = isoFrameMark();
+    uint32_t* keys = isoFrameAlloc(hops * sizeof(uint32_t));
+    if (!keys) return 0;
+
+    uint32_t i = hops;
+    for (uint32_t r = record; r != ISO_PATH_NONE; r = search->records[r].parent)
+        keys[--i] = search->records[r].key;
+
+    int result = 1;
+    for (i = 1; i < hops && result; i++)
+    {
+        uint32_t col_a, row_a, col_b, row_b;
+        isoPathKeyTile(pathfinder, keys[i - 1], &col_a, &row_a);
+        isoPathKeyTile(pathfinder, keys[i], &col_b, &row_b);
+
+        if (col_a == col_b && row_a == row_b) continue;
+
+        if (isoPathClusterOf(pathfinder, col_a, row_a) != isoPathClusterOf(pathfinder, col_b, row_b))
+            result = isoPathPush(path, col_b, row_b);
+        else
+            result = isoPathRefine(pathfinder, col_a, row_a, col_b, row_b, path);
+    }
+
+    isoFrameRelease(mark);
+    if (!result) return 0;
+
+    isoPathSumCost(path);
+    return 1;
+}
@@ -0,0 +1,116 @@
+#ifndef PATH_H
+#define PATH_H
+
+#include "iso.h"
+
+#define ISO_TILE_WATER 3
+
+#define ISO_PATH_CLUSTER_SHIFT 4
+#define ISO_PATH_CLUSTER_SIZE  (1 << ISO_PATH_CLUSTER_SHIFT)
+#define ISO_PATH_CLUSTER_MASK  (ISO_PATH_CLUSTER_SIZE - 1)
+#define ISO_PATH_CLUSTER_CELLS (ISO_PATH_CLUSTER_SIZE * ISO_PATH_CLUSTER_SIZE)
+#define ISO_PATH_CLUSTER_NODES 64
+
+/* straight and diagonal step costs */
+#define ISO_PATH_COST_STRAIGHT 10
+#define ISO_PATH_COST_DIAGONAL 14
+
+/* empty tiles, water and placeholders of chunks not loaded yet are blocked */
+int isoTileWalkable(uint32_t tile);
+
+typedef struct
+{
+    uint32_t col;
+    uint32_t row;
+} IsoPathPoint;
+
+typedef struct
+{
+    IsoPathPoint* points; /* start to goal, both included */
+    uint32_t count;
+    uint32_t capacity;
+
+    uint32_t cost;        /* in ISO_PATH_COST units */
+    uint32_t expansions;  /* nodes expanded by the search(es) */
+} IsoPath;
+
+void isoPathFree(IsoPath* path);
+
+/* A* over arbitrary graphs with uint32_t node keys, reused between searches */
+typedef struct
+{
+    uint32_t key;
+    uint32_t g;
+    uint32_t f;
+    uint32_t parent; /* record index */
+    uint32_t slot;   /* hash slot */
+    uint32_t heap;   /* heap position or ISO_PATH_CLOSED */
+} IsoPathRecord;
+
+typedef struct
+{
+    IsoPathRecord* records;
+    uint32_t record_count;
+    uint32_t record_capacity;
+
+    uint32_t* slots; /* record index + 1, 0 for free slots */
+    uint32_t slot_mask;
+
+    uint32_t* heap;
+    uint32_t heap_count;
+
+    uint32_t expansions;
+} IsoPathSearch;
+
+/*
+ * Clusters of ISO_PATH_CLUSTER_SIZE^2 tiles. The abstract nodes of a cluster
+ * are the tiles next to its transitions, points where its border can be
+ * crossed. costs holds the shortest path inside the cluster between every
+ * pair of nodes. Clusters are built lazily and rebuilt after a tile in them
+ * (or on the border to them) changed.
+ */
+typedef struct
+{
+    uint8_t* nodes;  /* local cell index, y * ISO_PATH_CLUSTER_SIZE + x */
+    uint16_t* costs; /* node_count * node_count */
+    uint32_t node_count;
+    int built;
+} IsoPathCluster;
+
+typedef struct
+{
+    const IsoMap* map;
+
+    IsoPathCluster* clusters;
+    uint32_t cluster_cols;
+    uint32_t cluster_rows;
+
+    IsoPathSearch search;
+
+    /* state of the running hierarchical search */
+    uint32_t start_cluster;
+    uint32_t goal_cluster;
+    uint32_t start_key;
+    uint32_t goal_key;
+    uint16_t start_costs[ISO_PATH_CLUSTER_NODES];
+    uint16_t goal_costs[ISO_PATH_CLUSTER_NODES];
+
+    uint32_t clusters_built; /* stats */
+} IsoPathfinder;
+
+int isoPathfinderInit(IsoPathfinder* pathfinder, const IsoMap* map);
+void isoPathfinderDestroy(IsoPathfinder* pathfinder);
+
+/* has to be called after isoMapSetTile, only the touched clusters are rebuilt */
+void isoPathfinderTileChanged(IsoPathfinder* pathfinder, uint32_t col, uint32_t row);
+
+/* same for a whole map chunk, e.g. after it was streamed in */
+void isoPathfinderChunkChanged(IsoPathfinder* pathfinder, uint32_t chunk);
+
+/* plain A* on the tile grid with 8 neighbours and no corner cutting */
+int isoPathFindGrid(IsoPathfinder* pathfinder, IsoPathPoint start, IsoPathPoint goal, IsoPath* path);
+
+/* A* over the cluster graph, refined to tiles inside each cluster; near optimal */
+int isoPathFind(IsoPathfinder* pathfinder, IsoPathPoint start, IsoPathPoint goal, IsoPath* path);
+
+#endif // !PATH_H
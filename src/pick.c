@@ -0,0 +1,247 @@
+#include "pick.h"
+#include "render.h"
+
+#include <math.h>
+
+#define ISO_PICK_CANDIDATES 64 /* entities tested per point, more are skipped */
+
+/*
+ * Highest level any layer draws at a tile, 0 if none draws there. Levels
+ * of one tile are contiguous: upper tiles start on top of the ground.
+ */
+static int isoPickStack(const IsoLayerStack* stack, uint32_t col, uint32_t row, uint32_t* top)
+{
+    uint32_t ground = isoLayerTile(stack, 0, col, row);
+    int drawn = ISO_TILE_ID(ground) != ISO_TILE_EMPTY;
+    uint32_t base = isoLayerBase(ground);
+
+    *top = base;
+    for (uint32_t i = 1; i < stack->count; i++)
+    {
+        uint32_t tile = isoLayerTile(stack, i, col, row);
+        if (ISO_TILE_ID(tile) == ISO_TILE_EMPTY) continue;
+
+        if (base + ISO_TILE_ELEVATION(tile) > *top) *top = base + ISO_TILE_ELEVATION(tile);
+        drawn = 1;
+    }
+    return drawn;
+}
+
+/* the last layer drawn at a level of a tile */
+static uint32_t isoPickLayer(const IsoLayerStack* stack, uint32_t col, uint32_t row, uint32_t level)
+{
+    uint32_t base = isoLayerBase(isoLayerTile(stack, 0, col, row));
+
+    for (uint32_t i = stack->count; i-- > 1;)
+    {
+        uint32_t tile = isoLayerTile(stack, i, col, row);
+        if (ISO_TILE_ID(tile) != ISO_TILE_EMPTY && level >= base && level <= base + ISO_TILE_ELEVATION(tile))
+            return i;
+    }
+    return 0;
+}
+
+/* fills the tile part of pick, returns the diagonal of the tile or -1 */
+static int32_t isoPickTileStack(const IsoLayerStack* stack, vec2 point, IsoPick* pick)
+{
+    const IsoMap* map = stack->layers[0].map;
+    float size = map->tile_size;
+    float offset = map->tile_offset;
+
+    pick->col = pick->row = ISO_PICK_NONE;
+    if (!map->width || !map->height || size <= 0.0f) return -1;
+
+    // relative to the map, the image of tile col, row at level 0 starts at ((col - row - 1), (col + row) / 2) * size
+    float x = point.x - map->origin.x;
+    float y = point.y - map->origin.y;
+    uint32_t max_top = isoLayerStackMaxElevation(stack, ISO_LAYER_ALL);
+
+    // diagonals whose images can reach y, front to back
+    int32_t sum_max = (int32_t)floorf((y + max_top * offset) * 2.0f / size);
+    int32_t sum_min = (int32_t)ceilf((y - size - offset) * 2.0f / size);
+    int32_t last = (int32_t)(map->width + map->height) - 2;
+    if (sum_max > last) sum_max = last;
+    if (sum_min < 0) sum_min = 0;
+
+    int32_t diff = (int32_t)floorf(x / size);
+    for (int32_t sum = sum_max; sum >= sum_min; sum--)
+    {
+        // of the two columns under x only one is on this diagonal
+        int32_t d = ((sum + diff) & 1) ? diff + 1 : diff;
+        int32_t col = (sum + d) / 2, row = (sum - d) / 2;
+        if (col < 0 || row < 0 || col >= (int32_t)map->width || row >= (int32_t)map->height)
+            continue;
+
+        float dx = fabsf(x - d * size);
+        if (dx > size) continue;
+
+        uint32_t top;
+        if (!isoPickStack(stack, (uint32_t)col, (uint32_t)row, &top)) continue;
+
+        // silhouette of the stack: top edge of the top level down to the bottom edge of the sides of level 0
+        float ground = sum * size * .5f;
+        float lowest = ground + size - dx * .5f + offset;
+        if (y < ground - top * offset + dx * .5f || y > lowest) continue;
+
+        // the highest level still reaching down to y is drawn last
+        float levels = (lowest - y) / offset;
+        uint32_t level = offset > 0.0f && levels < (float)top ? (uint32_t)levels : top;
+
+        pick->col = (uint32_t)col;
+        pick->row = (uint32_t)row;
+        pick->level = level;
+        pick->layer = isoPickLayer(stack, (uint32_t)col, (uint32_t)row, level);
+        pick->side = level < top || y > ground - top * offset + size - dx * .5f;
+        return sum;
+    }
+    return -1;
+}
+
+/* the entity drawn last under point, ISO_ENTITY_NONE if there is none */
+static uint32_t isoPickEntity(const IsoPicker* picker, vec2 point, float* depth)
+{
+    const IsoEntityLayer* layer = picker->entities;
+    const IsoMap* map = picker->tiles->layers[0].map;
+
+    uint32_t ids[ISO_PICK_CANDIDATES];
+    uint32_t count = layer->count;
+    if (picker->hash)
+    {
+        // foot points of sprites that can reach the point lie below it
+        vec2 half = { picker->entity_size.x * .5f, 0.0f };
+        vec2 corners[4] = {
+            screenToWorld(map, vec2_sub(point, half)),
+            screenToWorld(map, vec2_add(point, half)),
+            screenToWorld(map, (vec2){ point.x - half.x, point.y + picker->entity_size.y }),
+            screenToWorld(map, (vec2){ point.x + half.x, point.y + picker->entity_size.y })
+        };
+
+        rect area = { corners[0], corners[0] };
+        for (uint32_t i = 1; i < 4; i++)
+        {
+            area.min.x = fminf(area.min.x, corners[i].x);
+            area.min.y = fminf(area.min.y, corners[i].y);
+            area.max.x = fmaxf(area.max.x, corners[i].x);
+            area.max.y = fmaxf(area.max.y, corners[i].y);
+        }
+
+        count = isoSpatialHashQueryRect(picker->hash, area, ids, ISO_PICK_CANDIDATES);
+        if (count > ISO_PICK_CANDIDATES) count = ISO_PICK_CANDIDATES;
+    }
+
+    uint32_t picked = ISO_ENTITY_NONE;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t id = picker->hash ? ids[i] : i;
+        const IsoEntity* entity = &layer->entities[id];
+
+        vec2 foot = worldToScreen(map, entity->position);
+        if (point.x < foot.x - entity->size.x * .5f || point.x > foot.x + entity->size.x * .5f) continue;
+        if (point.y < foot.y - entity->size.y || point.y > foot.y) continue;
+
+        // same key as isoEntityLayerSort, ties go to the higher index
+        float key = (entity->position.x + entity->position.y) / map->tile_size;
+        if (picked == ISO_ENTITY_NONE || key > *depth || (key == *depth && id > picked))
+        {
+            picked = id;
+            *depth = key;
+        }
+    }
+    return picked;
+}
+
+int isoPickPoint(const IsoPicker* picker, vec2 point, IsoPick* pick)
+{
+    int32_t sum = isoPickTileStack(picker->tiles, point, pick);
+
+    // entities go after the diagonals up to their depth
+    pick->entity = ISO_ENTITY_NONE;
+    if (picker->entities)
+    {
+        float depth = 0.0f;
+        uint32_t entity = isoPickEntity(picker, point, &depth);
+        if (entity != ISO_ENTITY_NONE && (sum < 0 || depth >= (float)sum))
+            pick->entity = entity;
+    }
+
+    return sum >= 0 || pick->entity != ISO_ENTITY_NONE;
+}
+
+void isoPickPoints(const IsoPicker* picker, const vec2* points, uint32_t count, IsoPick* picks)
+{
+    for (uint32_t i = 0; i < count; i++)
+        isoPickPoint(picker, points[i], &picks[i]);
+}
+
+uint32_t isoPickRectTiles(const IsoPicker* picker, rect area, IsoPick* out, uint32_t max)
+{
+    const IsoLayerStack* stack = picker->tiles;
+    const IsoMap* map = stack->layers[0].map;
+
+    IsoTileRange range;
+    if (!isoLayerStackVisibleRange(stack, area, ISO_LAYER_ALL, &range))
+        return 0;
+
+    uint32_t found = 0;
+    for (uint32_t row = range.row_min; row <= range.row_max; row++)
+    {
+        uint32_t col_min, col_max;
+        if (!isoTileRangeRow(map, &range, row, &col_min, &col_max))
+            continue;
+
+        for (uint32_t col = col_min; col <= col_max; col++)
+        {
+            uint32_t top;
+            if (!isoPickStack(stack, col, row, &top)) continue;
+
+            float x = map->origin.x + ((float)col - (float)row) * map->tile_size;
+            float y = map->origin.y + (col + row + 1) * map->tile_size * .5f - top * map->tile_offset;
+            if (x < area.min.x || x > area.max.x || y < area.min.y || y > area.max.y)
+                continue;
+
+            if (found < max)
+            {
+                IsoPick* pick = &out[found];
+                pick->col = col;
+                pick->row = row;
+                pick->level = top;
+                pick->layer = isoPickLayer(stack, col, row, top);
+                pick->side = 0;
+                pick->entity = ISO_ENTITY_NONE;
+            }
+            found++;
+        }
+    }
+    return found;
+}
+
+uint32_t isoPickRectEntities(const IsoPicker* picker, rect area, uint32_t* out, uint32_t max)
+{
+    const IsoEntityLayer* layer = picker->entities;
+    const IsoMap* map = picker->tiles->layers[0].map;
+    if (!layer) return 0;
+
+    // box selection is rare enough to go over all of them
+    uint32_t found = 0;
+    for (uint32_t i = 0; i < layer->count; i++)
+    {
+        vec2 foot = worldToScreen(map, layer->entities[i].position);
+        if (foot.x < area.min.x || foot.x > area.max.x || foot.y < area.min.y || foot.y > area.max.y)
+            continue;
+
+        if (found < max) out[found] = i;
+        found++;
+    }
+    return found;
+}
+
+void highlightPick(const IsoMap* map, const IsoPick* pick)
+{
+    if (pick->col == ISO_PICK_NONE) return;
+
+    float x = map->origin.x + ((float)pick->col - (float)pick->row) * map->tile_size;
+    float y = map->origin.y + (pick->col + pick->row + 1) * map->tile_size * .5f - pick->level * map->tile_offset;
+
+    isoRenderRhombus(x, y, 2 * map->tile_size, map->tile_size, IGNIS_WHITE);
+    if (pick->side) isoRenderRhombus(x, y + map->tile_offset, 2 * map->tile_size, map->tile_size, IGNIS_WHITE);
+}
@@ -0,0 +1,56 @@
+#ifndef PICK_H
+#define PICK_H
+
+#include "iso.h"
+#include "layer.h"
+#include "entity.h"
+#include "spatial.h"
+
+#define ISO_PICK_NONE 0xffffffff
+
+typedef struct
+{
+    uint32_t col;    /* ISO_PICK_NONE if there is no tile under the point */
+    uint32_t row;
+    uint32_t level;  /* elevation level of the face hit */
+    uint32_t layer;  /* index in the stack of the tile drawn there */
+    int side;        /* 1 for a side face, 0 for the top face */
+    uint32_t entity; /* ISO_ENTITY_NONE if no entity is in front of the tile */
+} IsoPick;
+
+/*
+ * What is drawn under a point of the map's screen space. The tiles that can
+ * cover a point lie on the screen column through it: for every diagonal
+ * col + row only one tile is left and later diagonals are drawn on top, so
+ * the candidates are walked front to back and the first stack whose
+ * silhouette contains the point is the one on top. That is a handful of
+ * tiles per max_elevation, whatever the size of the map. Tile shapes are the
+ * analytic rhombus and sides of the images, transparent pixels count as hit.
+ *
+ * Entities are sprites standing on their foot point and are in front of a
+ * tile if isoEntityLayerRender draws them after it.
+ */
+typedef struct
+{
+    const IsoLayerStack* tiles;
+    const IsoEntityLayer* entities; /* may be NULL */
+    const IsoSpatialHash* hash;     /* of the entities, NULL to test every entity */
+    vec2 entity_size;               /* largest sprite, bounds the hash query */
+} IsoPicker;
+
+/* returns 1 if a tile or an entity is under point */
+int isoPickPoint(const IsoPicker* picker, vec2 point, IsoPick* pick);
+void isoPickPoints(const IsoPicker* picker, const vec2* points, uint32_t count, IsoPick* picks);
+
+/*
+ * Box selection: the tiles whose top face center lies in area, back to front,
+ * and the entities whose foot point does. Both write up to max results and
+ * return the number found, which can be larger than max.
+ */
+uint32_t isoPickRectTiles(const IsoPicker* picker, rect area, IsoPick* out, uint32_t max);
+uint32_t isoPickRectEntities(const IsoPicker* picker, rect area, uint32_t* out, uint32_t max);
+
+/* outlines the face of a pick */
+void highlightPick(const IsoMap* map, const IsoPick* pick);
+
+#endif // !PICK_H
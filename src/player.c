@@ -0,0 +1,13 @@
+#include "player.h"
+
+#include "collision.h"
+
+void playerUpdate(Player* player, const IsoMap* map, vec2 input, float deltatime)
+{
+    vec2 velocity = vec2_mult(input, player->speed);
+
+    velocity = vec2_normalize(isoToCartesian(velocity));
+
+    vec2 extent = { player->extent, player->extent };
+    isoMapSweep(map, &player->position, extent, vec2_mult(velocity, deltatime));
+}
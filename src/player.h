@@ -0,0 +1,16 @@
+#ifndef PLAYER_H
+#define PLAYER_H
+
+#include "iso.h"
+
+typedef struct
+{
+    vec2 position;
+    float speed;
+    float extent; /* half size of the collision box in world units */
+} Player;
+
+/* input is the screen space direction, e.g. from WASD; the player slides along blocked tiles */
+void playerUpdate(Player* player, const IsoMap* map, vec2 input, float deltatime);
+
+#endif // !PLAYER_H
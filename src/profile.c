@@ -0,0 +1,160 @@
+#include "profile.h"
+#include "alloc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int isoProfilerInit(IsoProfiler* profiler, const char* const* names, uint32_t zone_count, uint32_t capacity)
+{
+    memset(profiler, 0, sizeof(IsoProfiler));
+    profiler->names = names;
+    profiler->zone_count = zone_count;
+
+    profiler->capacity = 1;
+    while (profiler->capacity < capacity) profiler->capacity <<= 1;
+
+    profiler->events = isoCalloc(ISO_MEM_GENERAL, profiler->capacity, sizeof(IsoProfileEvent));
+    profiler->totals = isoCalloc(ISO_MEM_GENERAL, zone_count ? zone_count : 1, sizeof(uint64_t));
+    profiler->history = isoCalloc(ISO_MEM_GENERAL, (size_t)(zone_count ? zone_count : 1) * ISO_PROFILE_HISTORY, sizeof(uint32_t));
+    if (!profiler->events || !profiler->totals || !profiler->history)
+    {
+        isoProfilerDestroy(profiler);
+        return 0;
+    }
+
+    // as if written one lap ago
+    for (uint32_t i = 0; i < profiler->capacity; i++)
+        profiler->events[i].sequence = i + 1 - profiler->capacity;
+
+    profiler->epoch = isoClockNs();
+    return 1;
+}
+
+void isoProfilerDestroy(IsoProfiler* profiler)
+{
+    isoFree(profiler->events);
+    isoFree(profiler->totals);
+    isoFree(profiler->history);
+    memset(profiler, 0, sizeof(IsoProfiler));
+}
+
+void isoProfileEnd(IsoProfiler* profiler, uint32_t zone, uint64_t start)
+{
+    uint64_t end = isoClockNs();
+
+    uint32_t index = isoAtomicAdd(&profiler->head, 1);
+    IsoProfileEvent* event = &profiler->events[index & (profiler->capacity - 1)];
+
+    isoAtomicStore(&event->sequence, index);
+    isoAtomicFenceRelease(); // readers must not see the fields change before the sequence
+    event->zone = zone;
+    event->thread = isoThreadId();
+    event->start = start;
+    event->end = end;
+    isoAtomicStore(&event->sequence, index + 1);
+}
+
+/* 1 if the event was copied, 0 while it is being written, -1 if it was overwritten */
+static int isoProfilerRead(IsoProfiler* profiler, uint32_t index, IsoProfileEvent* event)
+{
+    IsoProfileEvent* slot = &profiler->events[index & (profiler->capacity - 1)];
+
+    // index while being written, the previous lap's value until then
+    uint32_t sequence = isoAtomicLoad(&slot->sequence);
+    if (sequence == index || sequence == index + 1 - profiler->capacity) return 0;
+    if (sequence != index + 1) return -1;
+
+    event->zone = slot->zone;
+    event->thread = slot->thread;
+    event->start = slot->start;
+    event->end = slot->end;
+
+    // a writer may have lapped us while copying, the copies have to be done before checking
+    isoAtomicFenceAcquire();
+    return isoAtomicLoad(&slot->sequence) == index + 1 ? 1 : -1;
+}
+
+void isoProfilerFrame(IsoProfiler* profiler)
+{
+    uint32_t head = isoAtomicLoad(&profiler->head);
+    if (head - profiler->read > profiler->capacity)
+    {
+        profiler->dropped += head - profiler->read - profiler->capacity;
+        profiler->read = head - profiler->capacity;
+    }
+
+    while (profiler->read != head)
+    {
+        IsoProfileEvent event;
+        int result = isoProfilerRead(profiler, profiler->read, &event);
+        if (result == 0) break; // picked up next frame
+
+        if (result < 0)                             profiler->dropped++;
+        else if (event.zone < profiler->zone_count) profiler->totals[event.zone] += event.end - event.start;
+        profiler->read++;
+    }
+
+    uint32_t slot = profiler->frames % ISO_PROFILE_HISTORY;
+    for (uint32_t i = 0; i < profiler->zone_count; i++)
+    {
+        uint64_t total = profiler->totals[i];
+        profiler->history[i * ISO_PROFILE_HISTORY + slot] = total > UINT32_MAX ? UINT32_MAX : (uint32_t)total;
+        profiler->totals[i] = 0;
+    }
+    profiler->frames++;
+}
+
+static int isoProfilerCompare(const void* a, const void* b)
+{
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+void isoProfilerStats(const IsoProfiler* profiler, uint32_t zone, IsoProfileStats* stats)
+{
+    memset(stats, 0, sizeof(IsoProfileStats));
+
+    uint32_t count = profiler->frames < ISO_PROFILE_HISTORY ? profiler->frames : ISO_PROFILE_HISTORY;
+    if (zone >= profiler->zone_count || count == 0) return;
+
+    uint32_t samples[ISO_PROFILE_HISTORY];
+    memcpy(samples, profiler->history + zone * ISO_PROFILE_HISTORY, count * sizeof(uint32_t));
+    qsort(samples, count, sizeof(uint32_t), isoProfilerCompare);
+
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < count; i++)
+        sum += samples[i];
+
+    stats->min = samples[0] / 1e6;
+    stats->avg = (double)sum / count / 1e6;
+    stats->p99 = samples[(count * 99 + 99) / 100 - 1] / 1e6;
+}
+
+int isoProfilerWriteTrace(IsoProfiler* profiler, const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (!file) return 0;
+
+    uint32_t head = isoAtomicLoad(&profiler->head);
+    uint32_t first = head > profiler->capacity ? head - profiler->capacity : 0;
+
+    fprintf(file, "{\"traceEvents\":[\n");
+
+    int separator = 0;
+    for (uint32_t i = first; i != head; i++)
+    {
+        IsoProfileEvent event;
+        if (isoProfilerRead(profiler, i, &event) <= 0 || event.zone >= profiler->zone_count)
+            continue;
+
+        fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"iso\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                separator ? ",\n" : "", profiler->names[event.zone],
+                (double)(event.start - profiler->epoch) / 1e3, (double)(event.end - event.start) / 1e3, event.thread);
+        separator = 1;
+    }
+
+    fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    return fclose(file) == 0;
+}
@@ -0,0 +1,67 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "thread.h"
+
+#define ISO_PROFILE_HISTORY 256 /* frames in the rolling stats */
+
+/*
+ * CPU timers for named zones. Finished timings go into a ring buffer that
+ * any thread can write to without a lock: a writer claims a slot with an
+ * atomic add and publishes it by storing its index + 1 in sequence. Old
+ * events are overwritten, the ring holds the last capacity events for the
+ * trace export. The thread calling isoProfilerFrame reads the new events
+ * into per zone frame totals, min/avg/p99 are over the last frames.
+ */
+typedef struct
+{
+    volatile uint32_t sequence;
+    uint32_t zone;
+    uint32_t thread;
+    uint64_t start;
+    uint64_t end;
+} IsoProfileEvent;
+
+typedef struct
+{
+    double min, avg, p99; /* ms */
+} IsoProfileStats;
+
+typedef struct
+{
+    const char* const* names;
+    uint32_t zone_count;
+
+    IsoProfileEvent* events;
+    uint32_t capacity; /* power of two */
+    volatile uint32_t head;
+
+    uint32_t read;
+    uint32_t dropped; /* overwritten before they were read */
+
+    uint64_t epoch;
+
+    uint64_t* totals;  /* ns per zone in the current frame */
+    uint32_t* history; /* zone_count * ISO_PROFILE_HISTORY */
+    uint32_t frames;
+} IsoProfiler;
+
+/* names has to outlive the profiler, capacity is rounded up to a power of two */
+int isoProfilerInit(IsoProfiler* profiler, const char* const* names, uint32_t zone_count, uint32_t capacity);
+void isoProfilerDestroy(IsoProfiler* profiler);
+
+/* records a timing that started at start (isoClockNs), from any thread */
+void isoProfileEnd(IsoProfiler* profiler, uint32_t zone, uint64_t start);
+
+/* times the following statement or block, which must not jump out of it */
+#define ISO_PROFILE(profiler, zone) \
+    for (uint64_t _profile_start = isoClockNs(), _profile_once = 1; _profile_once; _profile_once = 0, isoProfileEnd(profiler, zone, _profile_start))
+
+/* ends the frame, only one thread may call this */
+void isoProfilerFrame(IsoProfiler* profiler);
+void isoProfilerStats(const IsoProfiler* profiler, uint32_t zone, IsoProfileStats* stats);
+
+/* writes the events still in the ring as chrome://tracing json */
+int isoProfilerWriteTrace(IsoProfiler* profiler, const char* path);
+
+#endif // !PROFILE_H
@@ -0,0 +1,330 @@
+#include "queue.h"
+#include "alloc.h"
+
+#include <string.h>
+
+#define ISO_QUEUE_RADIX_BITS    12
+#define ISO_QUEUE_RADIX_BUCKETS (1 << ISO_QUEUE_RADIX_BITS)
+#define ISO_QUEUE_RADIX_MASK    (ISO_QUEUE_RADIX_BUCKETS - 1)
+#define ISO_QUEUE_KEY_SHIFT     16 /* the low bits are always 0 */
+
+#define ISO_QUEUE_KEY_LAYER   60
+#define ISO_QUEUE_KEY_DEPTH   28
+#define ISO_QUEUE_KEY_SHADER  24
+#define ISO_QUEUE_KEY_TEXTURE 16
+
+#define ISO_QUEUE_NO_SHADER 0xffffffff
+
+/* returns 1 if a command of shader and texture can not join the current run */
+static int isoQueueNextRun(uint32_t* shader, const IgnisTexture2D** texture, uint32_t next_shader, const IgnisTexture2D* next_texture, uint32_t* changes)
+{
+    int run = 0;
+    if (*shader != next_shader)
+    {
+        *shader = next_shader;
+        (*changes)++;
+        run = 1;
+    }
+
+    // the batch keeps its texture bound across other renderers
+    if (next_shader == ISO_QUEUE_BATCH && *texture != next_texture)
+    {
+        *texture = next_texture;
+        (*changes)++;
+        run = 1;
+    }
+
+    return run;
+}
+
+static uint32_t isoQueueTextureId(IsoRenderQueue* queue, const IgnisTexture2D* texture)
+{
+    if (!texture) return 0;
+
+    for (uint32_t i = queue->texture_count; i > 0; i--)
+    {
+        if (queue->textures[i - 1] == texture) return i;
+    }
+
+    if (queue->texture_count == ISO_QUEUE_TEXTURES) return ISO_QUEUE_TEXTURES;
+
+    queue->textures[queue->texture_count++] = texture;
+    return queue->texture_count;
+}
+
+static int isoQueueGrow(IsoRenderQueue* queue)
+{
+    uint32_t capacity = queue->capacity * 2;
+
+    IsoQueueCommand* commands = isoRealloc(ISO_MEM_RENDER, queue->commands, capacity * sizeof(IsoQueueCommand));
+    if (!commands) return 0;
+    queue->commands = commands;
+
+    IsoQueueKey* keys = isoRealloc(ISO_MEM_RENDER, queue->keys, capacity * sizeof(IsoQueueKey));
+    if (!keys) return 0;
+    queue->keys = keys;
+
+    IsoQueueKey* scratch = isoRealloc(ISO_MEM_RENDER, queue->scratch, capacity * sizeof(IsoQueueKey));
+    if (!scratch) return 0;
+    queue->scratch = scratch;
+
+    queue->capacity = capacity;
+    return 1;
+}
+
+static IsoQueueCommand* isoQueuePush(IsoRenderQueue* queue, uint32_t type, uint32_t shader, const IgnisTexture2D* texture)
+{
+    if (queue->count == queue->capacity && !isoQueueGrow(queue))
+    {
+        queue->dropped++;
+        return NULL;
+    }
+
+    if (isoQueueNextRun(&queue->last_shader, &queue->last_texture, shader, texture, &queue->unsorted_binds))
+        queue->unsorted_runs++;
+
+    IsoQueueKey* key = &queue->keys[queue->count];
+    key->key = queue->order
+             | ((uint64_t)shader << ISO_QUEUE_KEY_SHADER)
+             | ((uint64_t)isoQueueTextureId(queue, texture) << ISO_QUEUE_KEY_TEXTURE);
+    key->command = queue->count;
+
+    IsoQueueCommand* command = &queue->commands[queue->count++];
+    command->type = type;
+    command->frame = 0;
+    command->texture = texture;
+    return command;
+}
+
+static void isoQueueTextureSrc(void* context, const IgnisTexture2D* texture, IgnisRect rect, IgnisRect src)
+{
+    IsoQueueCommand* command = isoQueuePush(context, ISO_QUEUE_TEXTURE_SRC, ISO_QUEUE_BATCH, texture);
+    if (!command) return;
+
+    command->rect = rect;
+    command->src = src;
+}
+
+static void isoQueueTextureFrame(void* context, const IgnisTexture2D* texture, IgnisRect rect, uint32_t frame)
+{
+    IsoQueueCommand* command = isoQueuePush(context, ISO_QUEUE_TEXTURE_FRAME, ISO_QUEUE_BATCH, texture);
+    if (!command) return;
+
+    command->rect = rect;
+    command->frame = frame;
+}
+
+static void isoQueuePrimitive(void* context, uint32_t type, IgnisRect rect, IgnisColorRGBA color)
+{
+    IsoQueueCommand* command = isoQueuePush(context, type, ISO_QUEUE_PRIMITIVES, NULL);
+    if (!command) return;
+
+    command->rect = rect;
+    command->color = color;
+}
+
+static void isoQueueRect(void* context, float x, float y, float w, float h, IgnisColorRGBA color)
+{
+    isoQueuePrimitive(context, ISO_QUEUE_RECT, (IgnisRect){ x, y, w, h }, color);
+}
+
+static void isoQueueRhombus(void* context, float x, float y, float w, float h, IgnisColorRGBA color)
+{
+    isoQueuePrimitive(context, ISO_QUEUE_RHOMBUS, (IgnisRect){ x, y, w, h }, color);
+}
+
+static void isoQueueFillCircle(void* context, float x, float y, float radius, IgnisColorRGBA color)
+{
+    isoQueuePrimitive(context, ISO_QUEUE_FILL_CIRCLE, (IgnisRect){ x, y, radius, radius }, color);
+}
+
+static void isoQueueText(void* context, float x, float y, const char* text)
+{
+    IsoRenderQueue* queue = context;
+
+    uint32_t size = (uint32_t)strlen(text) + 1;
+    if (queue->text_size + size > queue->text_capacity)
+    {
+        uint32_t capacity = queue->text_capacity * 2;
+        while (capacity < queue->text_size + size) capacity *= 2;
+
+        char* resized = isoRealloc(ISO_MEM_RENDER, queue->text, capacity);
+        if (!resized)
+        {
+            queue->dropped++;
+            return;
+        }
+
+        queue->text = resized;
+        queue->text_capacity = capacity;
+    }
+
+    IsoQueueCommand* command = isoQueuePush(queue, ISO_QUEUE_TEXT, ISO_QUEUE_FONT, NULL);
+    if (!command) return;
+
+    command->rect = (IgnisRect){ x, y, 0.0f, 0.0f };
+    command->frame = queue->text_size;
+
+    memcpy(queue->text + queue->text_size, text, size);
+    queue->text_size += size;
+}
+
+static void isoQueueFlush(void* context)
+{
+    // drawn by isoRenderQueueSubmit
+}
+
+static void isoQueueOrder(void* context, uint32_t layer, uint32_t depth)
+{
+    IsoRenderQueue* queue = context;
+    queue->order = ((uint64_t)(layer & 0xf) << ISO_QUEUE_KEY_LAYER) | ((uint64_t)depth << ISO_QUEUE_KEY_DEPTH);
+}
+
+static void isoQueueReset(IsoRenderQueue* queue)
+{
+    queue->count = 0;
+    queue->text_size = 0;
+    queue->texture_count = 0;
+    queue->order = 0;
+
+    queue->last_shader = ISO_QUEUE_NO_SHADER;
+    queue->last_texture = NULL;
+    queue->unsorted_runs = 0;
+    queue->unsorted_binds = 0;
+}
+
+int isoRenderQueueInit(IsoRenderQueue* queue, uint32_t capacity)
+{
+    memset(queue, 0, sizeof(IsoRenderQueue));
+
+    queue->capacity = capacity ? capacity : 1024;
+    queue->commands = isoMalloc(ISO_MEM_RENDER, queue->capacity * sizeof(IsoQueueCommand));
+    queue->keys = isoMalloc(ISO_MEM_RENDER, queue->capacity * sizeof(IsoQueueKey));
+    queue->scratch = isoMalloc(ISO_MEM_RENDER, queue->capacity * sizeof(IsoQueueKey));
+
+    queue->text_capacity = 1024;
+    queue->text = isoMalloc(ISO_MEM_RENDER, queue->text_capacity);
+
+    queue->backend = (IsoRenderBackend){
+        queue,
+        isoQueueTextureSrc,
+        isoQueueTextureFrame,
+        isoQueueRect,
+        isoQueueRhombus,
+        isoQueueFillCircle,
+        isoQueueText,
+        isoQueueFlush,
+        isoQueueOrder
+    };
+
+    if (!queue->commands || !queue->keys || !queue->scratch || !queue->text)
+    {
+        isoRenderQueueDestroy(queue);
+        return 0;
+    }
+
+    isoQueueReset(queue);
+    return 1;
+}
+
+void isoRenderQueueDestroy(IsoRenderQueue* queue)
+{
+    isoFree(queue->commands);
+    isoFree(queue->keys);
+    isoFree(queue->scratch);
+    isoFree(queue->text);
+    memset(queue, 0, sizeof(IsoRenderQueue));
+}
+
+const IsoRenderBackend* isoRenderQueueBackend(IsoRenderQueue* queue)
+{
+    return &queue->backend;
+}
+
+/* stable lsd radix sort of the used key bits, returns the buffer holding the result */
+static IsoQueueKey* isoQueueRadixSort(IsoQueueKey* keys, IsoQueueKey* scratch, uint32_t count, uint32_t* passes)
+{
+    uint32_t offsets[ISO_QUEUE_RADIX_BUCKETS];
+
+    *passes = 0;
+    for (uint32_t shift = ISO_QUEUE_KEY_SHIFT; shift < 64; shift += ISO_QUEUE_RADIX_BITS)
+    {
+        memset(offsets, 0, sizeof(offsets));
+
+        for (uint32_t i = 0; i < count; i++)
+            offsets[(keys[i].key >> shift) & ISO_QUEUE_RADIX_MASK]++;
+
+        // a frame mostly shares the layer and texture bits
+        if (offsets[(keys[0].key >> shift) & ISO_QUEUE_RADIX_MASK] == count) continue;
+
+        uint32_t sum = 0;
+        for (uint32_t b = 0; b < ISO_QUEUE_RADIX_BUCKETS; b++)
+        {
+            uint32_t n = offsets[b];
+            offsets[b] = sum;
+            sum += n;
+        }
+
+        for (uint32_t i = 0; i < count; i++)
+            scratch[offsets[(keys[i].key >> shift) & ISO_QUEUE_RADIX_MASK]++] = keys[i];
+
+        IsoQueueKey* tmp = keys;
+        keys = scratch;
+        scratch = tmp;
+        (*passes)++;
+    }
+
+    return keys;
+}
+
+static void isoQueueReplay(const IsoRenderQueue* queue, const IsoQueueCommand* command, const IsoRenderBackend* target)
+{
+    void* context = target->context;
+    const IgnisRect* r = &command->rect;
+
+    switch (command->type)
+    {
+    case ISO_QUEUE_TEXTURE_SRC:   target->texture_src(context, command->texture, *r, command->src); break;
+    case ISO_QUEUE_TEXTURE_FRAME: target->texture_frame(context, command->texture, *r, command->frame); break;
+    case ISO_QUEUE_RECT:          target->rect(context, r->x, r->y, r->w, r->h, command->color); break;
+    case ISO_QUEUE_RHOMBUS:       target->rhombus(context, r->x, r->y, r->w, r->h, command->color); break;
+    case ISO_QUEUE_FILL_CIRCLE:   target->fill_circle(context, r->x, r->y, r->w, command->color); break;
+    case ISO_QUEUE_TEXT:          target->text(context, r->x, r->y, queue->text + command->frame); break;
+    }
+}
+
+void isoRenderQueueSubmit(IsoRenderQueue* queue, const IsoRenderBackend* target)
+{
+    queue->commands_submitted = queue->count;
+    queue->unsorted_draws = queue->unsorted_runs;
+    queue->unsorted_state_changes = queue->unsorted_binds;
+    queue->draws = 0;
+    queue->state_changes = 0;
+    queue->sort_passes = 0;
+
+    if (queue->count)
+    {
+        const IsoQueueKey* sorted = isoQueueRadixSort(queue->keys, queue->scratch, queue->count, &queue->sort_passes);
+
+        uint32_t shader = ISO_QUEUE_NO_SHADER;
+        const IgnisTexture2D* texture = NULL;
+        for (uint32_t i = 0; i < queue->count; i++)
+        {
+            const IsoQueueCommand* command = &queue->commands[sorted[i].command];
+            uint32_t next = (uint32_t)(sorted[i].key >> ISO_QUEUE_KEY_SHADER) & 0xf;
+
+            // the renderers draw in their own order, so each run is flushed before the next
+            if (isoQueueNextRun(&shader, &texture, next, command->texture, &queue->state_changes))
+            {
+                if (queue->draws) target->flush(target->context);
+                queue->draws++;
+            }
+
+            isoQueueReplay(queue, command, target);
+        }
+
+        target->flush(target->context);
+    }
+
+    isoQueueReset(queue);
+}
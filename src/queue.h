@@ -0,0 +1,97 @@
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include "render.h"
+
+#define ISO_QUEUE_TEXTURES 255 /* with their own sort id per submit, more share the last */
+
+typedef enum
+{
+    ISO_QUEUE_TEXTURE_SRC,
+    ISO_QUEUE_TEXTURE_FRAME,
+    ISO_QUEUE_RECT,
+    ISO_QUEUE_RHOMBUS,
+    ISO_QUEUE_FILL_CIRCLE,
+    ISO_QUEUE_TEXT
+} IsoQueueCommandType;
+
+/* renderer a command goes to, switching ends a draw call */
+typedef enum
+{
+    ISO_QUEUE_BATCH,
+    ISO_QUEUE_PRIMITIVES,
+    ISO_QUEUE_FONT
+} IsoQueueShader;
+
+typedef struct
+{
+    uint32_t type;
+    uint32_t frame; /* texture frame or offset of the text */
+    const IgnisTexture2D* texture;
+    IgnisRect rect; /* x, y and radius in w for circles */
+    IgnisRect src;
+    IgnisColorRGBA color;
+} IsoQueueCommand;
+
+/* layer (4), depth (32), shader (4) and texture id (8) from the top */
+typedef struct
+{
+    uint64_t key;
+    uint32_t command;
+} IsoQueueKey;
+
+/*
+ * Backend that records the draws of a frame from every render path instead
+ * of flushing the batch, primitives and font renderers one after another.
+ * Submitting sorts the commands by their key with a stable radix sort and
+ * replays them to another backend, flushing only where the renderer or the
+ * texture changes. Commands of equal order keep their submission order, so
+ * anything drawn without an order (see render.h) comes out as submitted.
+ *
+ * Buffers grow to the peak of a frame and are kept, text is copied.
+ */
+typedef struct
+{
+    IsoQueueCommand* commands;
+    IsoQueueKey* keys;
+    IsoQueueKey* scratch; /* radix sort buffer */
+    uint32_t count;
+    uint32_t capacity;
+
+    char* text;
+    uint32_t text_size;
+    uint32_t text_capacity;
+
+    const IgnisTexture2D* textures[ISO_QUEUE_TEXTURES];
+    uint32_t texture_count;
+
+    uint64_t order; /* layer and depth bits of the next commands */
+
+    /* submission order runs, for the unsorted stats */
+    uint32_t last_shader;
+    const IgnisTexture2D* last_texture;
+    uint32_t unsorted_runs;
+    uint32_t unsorted_binds;
+
+    IsoRenderBackend backend;
+
+    /* stats of the last submit */
+    uint32_t commands_submitted;
+    uint32_t draws;         /* flushed runs of one renderer and texture */
+    uint32_t state_changes; /* renderer switches and texture binds */
+    uint32_t unsorted_draws; /* the same if drawn in submission order */
+    uint32_t unsorted_state_changes;
+    uint32_t sort_passes;
+    uint32_t dropped; /* commands lost to a failed allocation */
+} IsoRenderQueue;
+
+int isoRenderQueueInit(IsoRenderQueue* queue, uint32_t capacity);
+void isoRenderQueueDestroy(IsoRenderQueue* queue);
+
+/* records into queue, pass to isoRenderSetBackend */
+const IsoRenderBackend* isoRenderQueueBackend(IsoRenderQueue* queue);
+
+/* draws the recorded commands with target in order and empties the queue, target may not be the queue */
+void isoRenderQueueSubmit(IsoRenderQueue* queue, const IsoRenderBackend* target);
+
+#endif // !QUEUE_H
@@ -0,0 +1,483 @@
+#include "raster.h"
+#include "alloc.h"
+
+#include <math.h>
+#include <string.h>
+
+static uint32_t isoRasterColor(IgnisColorRGBA color)
+{
+    float channels[4] = { color.r, color.g, color.b, color.a };
+    uint8_t bytes[4];
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        float c = channels[i] < 0.0f ? 0.0f : (channels[i] > 1.0f ? 1.0f : channels[i]);
+        bytes[i] = (uint8_t)(c * 255.0f + .5f);
+    }
+
+    uint32_t packed;
+    memcpy(&packed, bytes, 4);
+    return packed;
+}
+
+/* src over dst with straight alpha */
+static void isoRasterBlend(uint8_t* dst, const uint8_t* src)
+{
+    uint32_t a = src[3];
+    if (a == 255)
+    {
+        memcpy(dst, src, 4);
+        return;
+    }
+    if (!a) return;
+
+    uint32_t ia = 255 - a;
+    dst[0] = (uint8_t)((src[0] * a + dst[0] * ia + 127) / 255);
+    dst[1] = (uint8_t)((src[1] * a + dst[1] * ia + 127) / 255);
+    dst[2] = (uint8_t)((src[2] * a + dst[2] * ia + 127) / 255);
+    dst[3] = (uint8_t)(a + (dst[3] * ia + 127) / 255);
+}
+
+static IsoRasterCommand* isoRasterPush(IsoRaster* raster)
+{
+    if (raster->command_count == ISO_RASTER_COMMANDS)
+        isoRasterFlush(raster);
+
+    return &raster->commands[raster->command_count++];
+}
+
+static vec2 isoRasterProject(const IsoRaster* raster, float x, float y)
+{
+    return (vec2){ (x - raster->origin.x) * raster->scale.x, (y - raster->origin.y) * raster->scale.y };
+}
+
+/* clamps float pixel bounds to the raster, returns 0 if nothing is left */
+static int isoRasterBounds(const IsoRaster* raster, float x0, float y0, float x1, float y1, IsoRasterCommand* command)
+{
+    x0 = fmaxf(x0, 0.0f);
+    y0 = fmaxf(y0, 0.0f);
+    x1 = fminf(x1, (float)raster->width);
+    y1 = fminf(y1, (float)raster->height);
+    if (!(x0 < x1 && y0 < y1)) return 0;
+
+    command->x0 = (int32_t)x0;
+    command->y0 = (int32_t)y0;
+    command->x1 = (int32_t)x1;
+    command->y1 = (int32_t)y1;
+    return 1;
+}
+
+static void isoRasterQuad(IsoRaster* raster, const IgnisTexture2D* texture, IgnisRect rect, IgnisRect src)
+{
+    raster->quads++;
+
+    uint32_t index = 0;
+    while (index < raster->texture_count && raster->textures[index].texture != texture) index++;
+    if (index == raster->texture_count)
+    {
+        raster->missing++;
+        return;
+    }
+
+    vec2 pos = isoRasterProject(raster, rect.x, rect.y);
+    float w = rect.w * raster->scale.x;
+    float h = rect.h * raster->scale.y;
+    if (!(w > 0.0f && h > 0.0f)) return;
+
+    // pixels with their center inside
+    IsoRasterCommand command;
+    if (!isoRasterBounds(raster, ceilf(pos.x - .5f), ceilf(pos.y - .5f), ceilf(pos.x + w - .5f), ceilf(pos.y + h - .5f), &command))
+        return;
+
+    command.type = ISO_RASTER_QUAD;
+    command.color = 0;
+    command.texture = index;
+    command.a[0] = pos.x;
+    command.a[1] = pos.y;
+    command.a[2] = w;
+    command.a[3] = h;
+    command.src[0] = src.x * texture->width;
+    command.src[1] = src.y * texture->height;
+    command.src[2] = src.w * texture->width;
+    command.src[3] = src.h * texture->height;
+
+    *isoRasterPush(raster) = command;
+}
+
+static void isoRasterLine(IsoRaster* raster, float x0, float y0, float x1, float y1, uint32_t color)
+{
+    vec2 a = isoRasterProject(raster, x0, y0);
+    vec2 b = isoRasterProject(raster, x1, y1);
+
+    IsoRasterCommand command;
+    if (!isoRasterBounds(raster, floorf(fminf(a.x, b.x)) - 1.0f, floorf(fminf(a.y, b.y)) - 1.0f,
+                         ceilf(fmaxf(a.x, b.x)) + 1.0f, ceilf(fmaxf(a.y, b.y)) + 1.0f, &command))
+        return;
+
+    command.type = ISO_RASTER_LINE;
+    command.color = color;
+    command.texture = 0;
+    command.a[0] = a.x;
+    command.a[1] = a.y;
+    command.a[2] = b.x;
+    command.a[3] = b.y;
+
+    *isoRasterPush(raster) = command;
+}
+
+static void isoRasterBackendTextureSrc(void* context, const IgnisTexture2D* texture, IgnisRect rect, IgnisRect src)
+{
+    isoRasterQuad(context, texture, rect, src);
+}
+
+static void isoRasterBackendTextureFrame(void* context, const IgnisTexture2D* texture, IgnisRect rect, uint32_t frame)
+{
+    uint32_t columns = texture->columns ? texture->columns : 1;
+    uint32_t rows = texture->rows ? texture->rows : 1;
+
+    IgnisRect src = {
+        (float)(frame % columns) / columns, (float)(frame / columns % rows) / rows,
+        1.0f / columns, 1.0f / rows
+    };
+    isoRasterQuad(context, texture, rect, src);
+}
+
+static void isoRasterBackendRect(void* context, float x, float y, float w, float h, IgnisColorRGBA color)
+{
+    IsoRaster* raster = context;
+    uint32_t packed = isoRasterColor(color);
+    raster->primitives++;
+
+    isoRasterLine(raster, x, y, x + w, y, packed);
+    isoRasterLine(raster, x + w, y, x + w, y + h, packed);
+    isoRasterLine(raster, x + w, y + h, x, y + h, packed);
+    isoRasterLine(raster, x, y + h, x, y, packed);
+}
+
+static void isoRasterBackendRhombus(void* context, float x, float y, float w, float h, IgnisColorRGBA color)
+{
+    IsoRaster* raster = context;
+    uint32_t packed = isoRasterColor(color);
+    raster->primitives++;
+
+    float hw = w * .5f, hh = h * .5f;
+    isoRasterLine(raster, x - hw, y, x, y - hh, packed);
+    isoRasterLine(raster, x, y - hh, x + hw, y, packed);
+    isoRasterLine(raster, x + hw, y, x, y + hh, packed);
+    isoRasterLine(raster, x, y + hh, x - hw, y, packed);
+}
+
+static void isoRasterBackendFillCircle(void* context, float x, float y, float radius, IgnisColorRGBA color)
+{
+    IsoRaster* raster = context;
+    raster->primitives++;
+
+    // an ellipse if the view is stretched
+    vec2 center = isoRasterProject(raster, x, y);
+    float rx = radius * raster->scale.x;
+    float ry = radius * raster->scale.y;
+    if (!(rx > 0.0f && ry > 0.0f)) return;
+
+    IsoRasterCommand command;
+    if (!isoRasterBounds(raster, floorf(center.x - rx), floorf(center.y - ry), ceilf(center.x + rx), ceilf(center.y + ry), &command))
+        return;
+
+    command.type = ISO_RASTER_ELLIPSE;
+    command.color = isoRasterColor(color);
+    command.texture = 0;
+    command.a[0] = center.x;
+    command.a[1] = center.y;
+    command.a[2] = rx;
+    command.a[3] = ry;
+
+    *isoRasterPush(raster) = command;
+}
+
+static void isoRasterBackendText(void* context, float x, float y, const char* text)
+{
+    // no font, images are of the map only
+}
+
+static void isoRasterBackendFlush(void* context)
+{
+    isoRasterFlush(context);
+}
+
+int isoRasterInit(IsoRaster* raster, IsoJobPool* pool, uint32_t width, uint32_t height)
+{
+    memset(raster, 0, sizeof(IsoRaster));
+    if (!width || !height) return 0;
+
+    raster->width = width;
+    raster->height = height;
+    raster->pool = pool;
+
+    raster->bins_x = (width + ISO_RASTER_BIN - 1) / ISO_RASTER_BIN;
+    raster->bins_y = (height + ISO_RASTER_BIN - 1) / ISO_RASTER_BIN;
+
+    raster->pixels = isoMalloc(ISO_MEM_RENDER, (size_t)width * height * 4);
+    raster->commands = isoMalloc(ISO_MEM_RENDER, ISO_RASTER_COMMANDS * sizeof(IsoRasterCommand));
+    raster->bin_offsets = isoMalloc(ISO_MEM_RENDER, ((size_t)raster->bins_x * raster->bins_y + 1) * sizeof(uint32_t));
+
+    raster->backend = (IsoRenderBackend){
+        raster,
+        isoRasterBackendTextureSrc,
+        isoRasterBackendTextureFrame,
+        isoRasterBackendRect,
+        isoRasterBackendRhombus,
+        isoRasterBackendFillCircle,
+        isoRasterBackendText,
+        isoRasterBackendFlush,
+        NULL
+    };
+
+    if (!raster->pixels || !raster->commands || !raster->bin_offsets)
+    {
+        isoRasterDestroy(raster);
+        return 0;
+    }
+
+    isoRasterBegin(raster, (rect){ { 0.0f, 0.0f }, { (float)width, (float)height } }, IGNIS_BLACK);
+    return 1;
+}
+
+void isoRasterDestroy(IsoRaster* raster)
+{
+    isoFree(raster->pixels);
+    isoFree(raster->commands);
+    isoFree(raster->bin_offsets);
+    isoFree(raster->bin_commands);
+
+    memset(raster, 0, sizeof(IsoRaster));
+}
+
+int isoRasterAddTexture(IsoRaster* raster, const IgnisTexture2D* texture, const uint8_t* pixels)
+{
+    if (!texture || !pixels || raster->texture_count == ISO_RASTER_TEXTURES)
+        return 0;
+
+    raster->textures[raster->texture_count++] = (IsoRasterTexture){ texture, pixels };
+    return 1;
+}
+
+void isoRasterBegin(IsoRaster* raster, rect view, IgnisColorRGBA clear)
+{
+    float w = view.max.x - view.min.x;
+    float h = view.max.y - view.min.y;
+
+    raster->origin = view.min;
+    raster->scale.x = w != 0.0f ? raster->width / w : 1.0f;
+    raster->scale.y = h != 0.0f ? raster->height / h : 1.0f;
+
+    raster->clear = isoRasterColor(clear);
+    raster->cleared = 0;
+    raster->command_count = 0;
+
+    raster->quads = 0;
+    raster->primitives = 0;
+    raster->missing = 0;
+    raster->flushes = 0;
+}
+
+static void isoRasterDrawQuad(IsoRaster* raster, const IsoRasterCommand* command, int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+{
+    const IsoRasterTexture* texture = &raster->textures[command->texture];
+    int32_t tw = texture->texture->width;
+    int32_t th = texture->texture->height;
+
+    // texels of the frame, nearest sampling stays inside it
+    int32_t u_min = (int32_t)fmaxf(floorf(command->src[0]), 0.0f);
+    int32_t v_min = (int32_t)fmaxf(floorf(command->src[1]), 0.0f);
+    int32_t u_max = (int32_t)fminf(ceilf(command->src[0] + command->src[2]), (float)tw) - 1;
+    int32_t v_max = (int32_t)fminf(ceilf(command->src[1] + command->src[3]), (float)th) - 1;
+    if (u_max < u_min || v_max < v_min) return;
+
+    float step_u = command->src[2] / command->a[2];
+    float step_v = command->src[3] / command->a[3];
+
+    // columns are the same for every row of the bin
+    int32_t columns[ISO_RASTER_BIN];
+    for (int32_t x = x0; x < x1; x++)
+    {
+        int32_t u = (int32_t)(command->src[0] + (x + .5f - command->a[0]) * step_u);
+        columns[x - x0] = (u < u_min ? u_min : (u > u_max ? u_max : u)) * 4;
+    }
+
+    for (int32_t y = y0; y < y1; y++)
+    {
+        int32_t v = (int32_t)(command->src[1] + (y + .5f - command->a[1]) * step_v);
+        v = v < v_min ? v_min : (v > v_max ? v_max : v);
+
+        const uint8_t* src = texture->pixels + (size_t)v * tw * 4;
+        uint8_t* dst = raster->pixels + ((size_t)y * raster->width + x0) * 4;
+
+        for (int32_t i = 0; i < x1 - x0; i++)
+        {
+            // most texels are opaque or empty
+            const uint8_t* texel = src + columns[i];
+            if (texel[3] == 255) memcpy(dst + i * 4, texel, 4);
+            else if (texel[3]) isoRasterBlend(dst + i * 4, texel);
+        }
+    }
+}
+
+static void isoRasterDrawLine(IsoRaster* raster, const IsoRasterCommand* command, int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+{
+    float ax = command->a[0], ay = command->a[1];
+    float bx = command->a[2], by = command->a[3];
+
+    uint8_t color[4];
+    memcpy(color, &command->color, 4);
+
+    // one pixel per column or row along the longer axis
+    int major_x = fabsf(bx - ax) >= fabsf(by - ay);
+    float a_major = major_x ? ax : ay, b_major = major_x ? bx : by;
+    float a_minor = major_x ? ay : ax, b_minor = major_x ? by : bx;
+
+    float lo = fminf(a_major, b_major), hi = fmaxf(a_major, b_major);
+    float slope = hi > lo ? (b_minor - a_minor) / (b_major - a_major) : 0.0f;
+
+    int32_t first = (int32_t)ceilf(lo - .5f);
+    int32_t last = (int32_t)floorf(hi - .5f);
+    if (last < first) first = last = (int32_t)floorf(lo);
+
+    int32_t clip_min = major_x ? x0 : y0, clip_max = major_x ? x1 : y1;
+    if (first < clip_min) first = clip_min;
+    if (last >= clip_max) last = clip_max - 1;
+
+    for (int32_t m = first; m <= last; m++)
+    {
+        int32_t n = (int32_t)floorf(a_minor + (m + .5f - a_major) * slope);
+        int32_t x = major_x ? m : n, y = major_x ? n : m;
+        if (x < x0 || x >= x1 || y < y0 || y >= y1) continue;
+
+        isoRasterBlend(raster->pixels + ((size_t)y * raster->width + x) * 4, color);
+    }
+}
+
+static void isoRasterDrawEllipse(IsoRaster* raster, const IsoRasterCommand* command, int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+{
+    float cx = command->a[0], cy = command->a[1];
+    float rx = command->a[2], ry = command->a[3];
+
+    uint8_t color[4];
+    memcpy(color, &command->color, 4);
+
+    for (int32_t y = y0; y < y1; y++)
+    {
+        float dy = (y + .5f - cy) / ry;
+        if (dy * dy > 1.0f) continue;
+
+        float half = rx * sqrtf(1.0f - dy * dy);
+        int32_t first = (int32_t)ceilf(cx - half - .5f);
+        int32_t last = (int32_t)floorf(cx + half - .5f);
+        if (first < x0) first = x0;
+        if (last >= x1) last = x1 - 1;
+
+        uint8_t* dst = raster->pixels + ((size_t)y * raster->width) * 4;
+        for (int32_t x = first; x <= last; x++)
+            isoRasterBlend(dst + x * 4, color);
+    }
+}
+
+static void isoRasterBin(void* context, uint32_t index)
+{
+    IsoRaster* raster = context;
+
+    int32_t x0 = (int32_t)(index % raster->bins_x) * ISO_RASTER_BIN;
+    int32_t y0 = (int32_t)(index / raster->bins_x) * ISO_RASTER_BIN;
+    int32_t x1 = x0 + ISO_RASTER_BIN < (int32_t)raster->width ? x0 + ISO_RASTER_BIN : (int32_t)raster->width;
+    int32_t y1 = y0 + ISO_RASTER_BIN < (int32_t)raster->height ? y0 + ISO_RASTER_BIN : (int32_t)raster->height;
+
+    if (!raster->cleared)
+    {
+        for (int32_t y = y0; y < y1; y++)
+        {
+            uint32_t* row = (uint32_t*)raster->pixels + (size_t)y * raster->width;
+            for (int32_t x = x0; x < x1; x++)
+                row[x] = raster->clear;
+        }
+    }
+
+    for (uint32_t i = raster->bin_offsets[index]; i < raster->bin_offsets[index + 1]; i++)
+    {
+        const IsoRasterCommand* command = &raster->commands[raster->bin_commands[i]];
+
+        int32_t cx0 = command->x0 > x0 ? command->x0 : x0;
+        int32_t cy0 = command->y0 > y0 ? command->y0 : y0;
+        int32_t cx1 = command->x1 < x1 ? command->x1 : x1;
+        int32_t cy1 = command->y1 < y1 ? command->y1 : y1;
+
+        switch (command->type)
+        {
+        case ISO_RASTER_QUAD:    isoRasterDrawQuad(raster, command, cx0, cy0, cx1, cy1); break;
+        case ISO_RASTER_LINE:    isoRasterDrawLine(raster, command, cx0, cy0, cx1, cy1); break;
+        case ISO_RASTER_ELLIPSE: isoRasterDrawEllipse(raster, command, cx0, cy0, cx1, cy1); break;
+        }
+    }
+}
+
+void isoRasterFlush(IsoRaster* raster)
+{
+    if (!raster->command_count && raster->cleared)
+        return;
+
+    uint32_t bins = raster->bins_x * raster->bins_y;
+    uint32_t* offsets = raster->bin_offsets;
+    memset(offsets, 0, ((size_t)bins + 1) * sizeof(uint32_t));
+
+    // count the commands of every bin, then place them in order
+    for (uint32_t i = 0; i < raster->command_count; i++)
+    {
+        const IsoRasterCommand* command = &raster->commands[i];
+        for (int32_t by = command->y0 / ISO_RASTER_BIN; by <= (command->y1 - 1) / ISO_RASTER_BIN; by++)
+        {
+            for (int32_t bx = command->x0 / ISO_RASTER_BIN; bx <= (command->x1 - 1) / ISO_RASTER_BIN; bx++)
+                offsets[by * raster->bins_x + bx + 1]++;
+        }
+    }
+
+    for (uint32_t i = 0; i < bins; i++)
+        offsets[i + 1] += offsets[i];
+
+    uint32_t total = offsets[bins];
+    if (total > raster->bin_capacity)
+    {
+        uint32_t* commands = isoRealloc(ISO_MEM_RENDER, raster->bin_commands, (size_t)total * sizeof(uint32_t));
+        if (!commands)
+        {
+            // out of memory, only clear
+            memset(offsets, 0, ((size_t)bins + 1) * sizeof(uint32_t));
+            raster->command_count = 0;
+        }
+        else
+        {
+            raster->bin_commands = commands;
+            raster->bin_capacity = total;
+        }
+    }
+
+    for (uint32_t i = 0; i < raster->command_count; i++)
+    {
+        const IsoRasterCommand* command = &raster->commands[i];
+        for (int32_t by = command->y0 / ISO_RASTER_BIN; by <= (command->y1 - 1) / ISO_RASTER_BIN; by++)
+        {
+            for (int32_t bx = command->x0 / ISO_RASTER_BIN; bx <= (command->x1 - 1) / ISO_RASTER_BIN; bx++)
+                raster->bin_commands[offsets[by * raster->bins_x + bx]++] = i;
+        }
+    }
+
+    // filling moved every offset to the start of the next bin
+    memmove(offsets + 1, offsets, (size_t)bins * sizeof(uint32_t));
+    offsets[0] = 0;
+
+    isoJobPoolRun(raster->pool, isoRasterBin, raster, bins);
+
+    raster->command_count = 0;
+    raster->cleared = 1;
+    raster->flushes++;
+}
+
+const IsoRenderBackend* isoRasterBackend(IsoRaster* raster)
+{
+    return &raster->backend;
+}
@@ -0,0 +1,103 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include "math/math.h"
+#include "jobs.h"
+#include "render.h"
+
+#define ISO_RASTER_BIN      64    /* side of the square screen tiles, one job each */
+#define ISO_RASTER_COMMANDS 16384 /* recorded before the raster flushes by itself */
+#define ISO_RASTER_TEXTURES 16
+
+typedef enum
+{
+    ISO_RASTER_QUAD,
+    ISO_RASTER_LINE,
+    ISO_RASTER_ELLIPSE
+} IsoRasterCommandType;
+
+/* in pixels of the raster */
+typedef struct
+{
+    uint32_t type;
+    uint32_t color;   /* rgba8, lines and ellipses */
+    uint32_t texture; /* index in the table, quads */
+
+    int32_t x0, y0; /* bounds of the pixels touched, max exclusive */
+    int32_t x1, y1;
+
+    float a[4]; /* quad rect, line ends or ellipse center and radii */
+    float src[4]; /* quad texels */
+} IsoRasterCommand;
+
+typedef struct
+{
+    const IgnisTexture2D* texture;
+    const uint8_t* pixels; /* rgba, texture->width * texture->height */
+} IsoRasterTexture;
+
+/*
+ * Software backend for the immediate render paths (see render.h), for
+ * rendering maps on machines without a GPU: server side thumbnails and golden
+ * images. Submitted rects and primitives are recorded, a flush sorts them
+ * into bins of ISO_RASTER_BIN pixels squared and draws the bins in parallel.
+ * Every bin draws its commands in submission order, so the result is the
+ * same for any number of threads.
+ *
+ * Textures are sampled nearest and blended over like the batch renderer
+ * with straight alpha, only textures added with their pixels are drawn.
+ * Lines are one pixel wide at any scale like GL lines.
+ */
+typedef struct
+{
+    uint8_t* pixels; /* rgba, row by row from the top */
+    uint32_t width;
+    uint32_t height;
+
+    IsoJobPool* pool;
+
+    vec2 origin; /* view point at the top left corner */
+    vec2 scale;  /* pixels per view unit */
+
+    IsoRasterTexture textures[ISO_RASTER_TEXTURES];
+    uint32_t texture_count;
+
+    IsoRasterCommand* commands;
+    uint32_t command_count;
+
+    /* commands of every bin, bin i has bin_commands[bin_offsets[i]] up to bin_offsets[i + 1] */
+    uint32_t bins_x;
+    uint32_t bins_y;
+    uint32_t* bin_offsets;
+    uint32_t* bin_commands;
+    uint32_t bin_capacity;
+
+    uint32_t clear; /* rgba8, drawn by the first flush after isoRasterBegin */
+    int cleared;
+
+    IsoRenderBackend backend;
+
+    /* stats since isoRasterBegin */
+    uint32_t quads;
+    uint32_t primitives;
+    uint32_t missing; /* quads of textures without pixels */
+    uint32_t flushes;
+} IsoRaster;
+
+/* pool may be NULL to draw on the calling thread only */
+int isoRasterInit(IsoRaster* raster, IsoJobPool* pool, uint32_t width, uint32_t height);
+void isoRasterDestroy(IsoRaster* raster);
+
+/* texture is matched by address, pixels have to outlive the raster. Returns 0 if the table is full */
+int isoRasterAddTexture(IsoRaster* raster, const IgnisTexture2D* texture, const uint8_t* pixels);
+
+/* starts an image of view, which is stretched over the whole raster like an ortho projection */
+void isoRasterBegin(IsoRaster* raster, rect view, IgnisColorRGBA clear);
+
+/* draws what was recorded since the last flush */
+void isoRasterFlush(IsoRaster* raster);
+
+/* records into raster, pass to isoRenderSetBackend */
+const IsoRenderBackend* isoRasterBackend(IsoRaster* raster);
+
+#endif // !RASTER_H
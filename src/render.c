@@ -0,0 +1,157 @@
+#include "render.h"
+
+#include <Ignis/Renderer/Renderer.h>
+
+#include <math.h>
+
+static void isoIgnisTextureSrc(void* context, const IgnisTexture2D* texture, IgnisRect rect, IgnisRect src)
+{
+    ignisBatch2DRenderTextureSrc(texture, rect, src);
+}
+
+static void isoIgnisTextureFrame(void* context, const IgnisTexture2D* texture, IgnisRect rect, uint32_t frame)
+{
+    ignisBatch2DRenderTextureFrame(texture, rect, frame);
+}
+
+static void isoIgnisRect(void* context, float x, float y, float w, float h, IgnisColorRGBA color)
+{
+    ignisPrimitives2DRenderRect(x, y, w, h, color);
+}
+
+static void isoIgnisRhombus(void* context, float x, float y, float w, float h, IgnisColorRGBA color)
+{
+    ignisPrimitives2DRenderRhombus(x, y, w, h, color);
+}
+
+static void isoIgnisFillCircle(void* context, float x, float y, float radius, IgnisColorRGBA color)
+{
+    ignisPrimitives2DFillCircle(x, y, radius, color);
+}
+
+static void isoIgnisText(void* context, float x, float y, const char* text)
+{
+    ignisFontRendererRenderTextFormat(x, y, "%s", text);
+}
+
+static void isoIgnisFlush(void* context)
+{
+    ignisBatch2DFlush();
+    ignisPrimitives2DFlush();
+    ignisFontRendererFlush();
+}
+
+static const IsoRenderBackend iso_render_ignis = {
+    NULL,
+    isoIgnisTextureSrc,
+    isoIgnisTextureFrame,
+    isoIgnisRect,
+    isoIgnisRhombus,
+    isoIgnisFillCircle,
+    isoIgnisText,
+    isoIgnisFlush,
+    NULL
+};
+
+static const IsoRenderBackend* iso_render_backend = &iso_render_ignis;
+
+void isoRenderSetBackend(const IsoRenderBackend* backend)
+{
+    iso_render_backend = backend ? backend : &iso_render_ignis;
+}
+
+const IsoRenderBackend* isoRenderGetBackend()
+{
+    return iso_render_backend;
+}
+
+const IsoRenderBackend* isoRenderIgnisBackend()
+{
+    return &iso_render_ignis;
+}
+
+void isoRenderTextureSrc(const IgnisTexture2D* texture, IgnisRect rect, IgnisRect src)
+{
+    iso_render_backend->texture_src(iso_render_backend->context, texture, rect, src);
+}
+
+void isoRenderTextureFrame(const IgnisTexture2D* texture, IgnisRect rect, uint32_t frame)
+{
+    iso_render_backend->texture_frame(iso_render_backend->context, texture, rect, frame);
+}
+
+void isoRenderRect(float x, float y, float w, float h, IgnisColorRGBA color)
+{
+    iso_render_backend->rect(iso_render_backend->context, x, y, w, h, color);
+}
+
+void isoRenderRhombus(float x, float y, float w, float h, IgnisColorRGBA color)
+{
+    iso_render_backend->rhombus(iso_render_backend->context, x, y, w, h, color);
+}
+
+void isoRenderFillCircle(float x, float y, float radius, IgnisColorRGBA color)
+{
+    iso_render_backend->fill_circle(iso_render_backend->context, x, y, radius, color);
+}
+
+void isoRenderText(float x, float y, const char* text)
+{
+    iso_render_backend->text(iso_render_backend->context, x, y, text);
+}
+
+void isoRenderFlush()
+{
+    iso_render_backend->flush(iso_render_backend->context);
+}
+
+/*
+ * World depth bits: above the map (1), diagonal + 1 (15), layer of the
+ * stack (7) and level (9). Entities take the last stack slot and put the
+ * fraction of their depth into the level bits.
+ */
+#define ISO_DEPTH_ABOVE_MAP  0x80000000u
+#define ISO_DEPTH_DIAGONAL   16
+#define ISO_DEPTH_SLOT       9
+#define ISO_DEPTH_SLOT_MAX   0x7f
+#define ISO_DEPTH_LEVEL_MAX  0x1ff
+
+void isoRenderSetOrder(uint32_t layer, uint32_t depth)
+{
+    if (iso_render_backend->order)
+        iso_render_backend->order(iso_render_backend->context, layer, depth);
+}
+
+void isoRenderSetTileOrder(uint32_t col, uint32_t row, uint32_t level, uint32_t layer)
+{
+    if (!iso_render_backend->order) return;
+
+    uint32_t diagonal = col + row < ISO_RENDER_DIAGONAL_MAX ? col + row : ISO_RENDER_DIAGONAL_MAX;
+    uint32_t slot = layer < ISO_DEPTH_SLOT_MAX ? layer : ISO_DEPTH_SLOT_MAX - 1;
+    uint32_t depth = ((diagonal + 1) << ISO_DEPTH_DIAGONAL)
+                   | (slot << ISO_DEPTH_SLOT)
+                   | (level < ISO_DEPTH_LEVEL_MAX ? level : ISO_DEPTH_LEVEL_MAX);
+
+    iso_render_backend->order(iso_render_backend->context, ISO_RENDER_LAYER_WORLD, depth);
+}
+
+void isoRenderSetEntityOrder(float depth, int above_map)
+{
+    if (!iso_render_backend->order) return;
+
+    // drawn before the tiles of every diagonal greater than depth
+    uint32_t diagonal = 0;
+    uint32_t fraction = 0;
+    if (depth >= 0.0f)
+    {
+        float whole = floorf(depth);
+        diagonal = whole < ISO_RENDER_DIAGONAL_MAX ? (uint32_t)whole + 1 : ISO_RENDER_DIAGONAL_MAX + 1;
+        fraction = (uint32_t)((depth - whole) * (ISO_DEPTH_LEVEL_MAX + 1));
+        if (fraction > ISO_DEPTH_LEVEL_MAX) fraction = ISO_DEPTH_LEVEL_MAX;
+    }
+
+    uint32_t key = (diagonal << ISO_DEPTH_DIAGONAL) | (ISO_DEPTH_SLOT_MAX << ISO_DEPTH_SLOT) | fraction;
+    if (above_map) key |= ISO_DEPTH_ABOVE_MAP;
+
+    iso_render_backend->order(iso_render_backend->context, ISO_RENDER_LAYER_WORLD, key);
+}
@@ -0,0 +1,77 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <Ignis/Ignis.h>
+
+/*
+ * What the immediate render paths (renderMap, renderLayers, the entity
+ * layer and the highlights) draw with: textured rects and a few primitives.
+ * By default they go to the Ignis batch and primitives renderers, another
+ * backend like the software rasterizer of raster.h can take over for
+ * rendering without a GPU. Coordinates are in the space of the current view,
+ * backends apply their own projection. The cached, threaded and impostor
+ * paths upload to OpenGL directly and always need Ignis.
+ *
+ * The backend is global like the Ignis renderers and only used by the thread
+ * that renders.
+ *
+ * Draws carry an order for backends that sort them (see queue.h): a layer,
+ * then a depth within the layer. Draws of equal layer and depth must not
+ * overlap, so they can be grouped by texture. The world depth of a tile
+ * level is its diagonal, then the layer of the stack, then the level, which
+ * is the order renderMap and isoEntityLayerRender draw in. Entities sit after
+ * the diagonal they stand on, or above the map if it is drawn without them.
+ * Diagonals past ISO_RENDER_DIAGONAL_MAX share the last depth.
+ */
+
+#define ISO_RENDER_LAYER_WORLD   0
+#define ISO_RENDER_LAYER_OVERLAY 1 /* primitives over the map */
+#define ISO_RENDER_LAYER_UI      2 /* text, in screen space */
+
+#define ISO_RENDER_DIAGONAL_MAX 0x7ffe
+
+typedef struct
+{
+    void* context;
+
+    void (*texture_src)(void* context, const IgnisTexture2D* texture, IgnisRect rect, IgnisRect src);
+    void (*texture_frame)(void* context, const IgnisTexture2D* texture, IgnisRect rect, uint32_t frame);
+
+    /* outlines, centered at x, y for the rhombus */
+    void (*rect)(void* context, float x, float y, float w, float h, IgnisColorRGBA color);
+    void (*rhombus)(void* context, float x, float y, float w, float h, IgnisColorRGBA color);
+    void (*fill_circle)(void* context, float x, float y, float radius, IgnisColorRGBA color);
+
+    /* screen space text, backends without a font skip it */
+    void (*text)(void* context, float x, float y, const char* text);
+
+    /* draws everything submitted so far */
+    void (*flush)(void* context);
+
+    /* order of the following draws, NULL for backends that draw in submission order */
+    void (*order)(void* context, uint32_t layer, uint32_t depth);
+} IsoRenderBackend;
+
+/* NULL goes back to Ignis, backend has to outlive its use */
+void isoRenderSetBackend(const IsoRenderBackend* backend);
+const IsoRenderBackend* isoRenderGetBackend();
+const IsoRenderBackend* isoRenderIgnisBackend();
+
+void isoRenderTextureSrc(const IgnisTexture2D* texture, IgnisRect rect, IgnisRect src);
+void isoRenderTextureFrame(const IgnisTexture2D* texture, IgnisRect rect, uint32_t frame);
+
+void isoRenderRect(float x, float y, float w, float h, IgnisColorRGBA color);
+void isoRenderRhombus(float x, float y, float w, float h, IgnisColorRGBA color);
+void isoRenderFillCircle(float x, float y, float radius, IgnisColorRGBA color);
+void isoRenderText(float x, float y, const char* text);
+
+/* flushes the textured rects, the primitives, then the text */
+void isoRenderFlush();
+
+void isoRenderSetOrder(uint32_t layer, uint32_t depth);
+
+/* world orders, cheap for backends without an order */
+void isoRenderSetTileOrder(uint32_t col, uint32_t row, uint32_t level, uint32_t layer);
+void isoRenderSetEntityOrder(float depth, int above_map); /* depth as in IsoDepthKey */
+
+#endif // !RENDER_H
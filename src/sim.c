@@ -0,0 +1,133 @@
+#include "sim.h"
+
+#include "alloc.h"
+#include "collision.h"
+#include "path.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* agents pick a new direction about every two seconds or when blocked */
+#define ISO_SIM_TURN_CHANCE 0.008f
+
+static float isoSimRandom(IsoSim* sim)
+{
+    sim->seed = sim->seed * 1664525u + 1013904223u;
+    return (float)(sim->seed >> 8) / (float)(1u << 24);
+}
+
+static void isoSimTurn(IsoSim* sim, uint32_t agent)
+{
+    float angle = isoSimRandom(sim) * 6.2831853f;
+    sim->vx[agent] = cosf(angle) * sim->agent_speed;
+    sim->vy[agent] = sinf(angle) * sim->agent_speed;
+}
+
+int isoSimInit(IsoSim* sim, const IsoMap* map, float tick_rate, uint32_t agents, uint32_t seed)
+{
+    memset(sim, 0, sizeof(IsoSim));
+
+    sim->map = map;
+    sim->step = 1.0f / tick_rate;
+    sim->seed = seed;
+
+    sim->player.speed = 60.0f;
+    sim->player.extent = .2f * map->tile_size;
+
+    sim->agent_speed = 1.5f * map->tile_size;
+    sim->agent_extent = (vec2){ .2f * map->tile_size, .2f * map->tile_size };
+
+    if (!agents) return 1;
+
+    float* buffer = isoMalloc(ISO_MEM_SIM, 6 * (size_t)agents * sizeof(float));
+    if (!buffer) return 0;
+
+    sim->x = buffer;
+    sim->y = sim->x + agents;
+    sim->vx = sim->y + agents;
+    sim->vy = sim->vx + agents;
+    sim->previous_x = sim->vy + agents;
+    sim->previous_y = sim->previous_x + agents;
+    sim->agent_count = agents;
+
+    // agents start in the middle of random walkable tiles
+    for (uint32_t i = 0; i < agents; i++)
+    {
+        uint32_t col = 0, row = 0;
+        for (int tries = 0; tries < 64; tries++)
+        {
+            col = (uint32_t)(isoSimRandom(sim) * map->width);
+            row = (uint32_t)(isoSimRandom(sim) * map->height);
+            if (isoTileWalkable(isoMapGetTile(map, col, row))) break;
+        }
+
+        sim->x[i] = sim->previous_x[i] = (col + .5f) * map->tile_size;
+        sim->y[i] = sim->previous_y[i] = (row + .5f) * map->tile_size;
+        isoSimTurn(sim, i);
+    }
+
+    return 1;
+}
+
+void isoSimDestroy(IsoSim* sim)
+{
+    // all agent arrays share one block
+    if (sim->x) isoFree(sim->x);
+    memset(sim, 0, sizeof(IsoSim));
+}
+
+void isoSimTick(IsoSim* sim, const IsoSimInput* input)
+{
+    sim->player_previous = sim->player.position;
+    playerUpdate(&sim->player, sim->map, input->move, sim->step);
+
+    memcpy(sim->previous_x, sim->x, sim->agent_count * sizeof(float));
+    memcpy(sim->previous_y, sim->y, sim->agent_count * sizeof(float));
+
+    isoMapSweepArray(sim->map, sim->x, sim->y, sim->vx, sim->vy, sim->agent_extent, sim->step, sim->agent_count);
+
+    for (uint32_t i = 0; i < sim->agent_count; i++)
+    {
+        if ((sim->vx[i] == 0.0f && sim->vy[i] == 0.0f) || isoSimRandom(sim) < ISO_SIM_TURN_CHANCE)
+            isoSimTurn(sim, i);
+    }
+
+    sim->ticks++;
+}
+
+uint32_t isoSimAdvance(IsoSim* sim, const IsoSimInput* input, float deltatime, uint32_t max_ticks)
+{
+    sim->accumulator += deltatime;
+
+    uint32_t ticks = 0;
+    while (sim->accumulator >= sim->step && ticks < max_ticks)
+    {
+        isoSimTick(sim, input);
+        sim->accumulator -= sim->step;
+        ticks++;
+    }
+
+    // drop the time that could not be simulated instead of catching up later
+    if (sim->accumulator >= sim->step)
+        sim->accumulator = 0.0f;
+
+    return ticks;
+}
+
+float isoSimAlpha(const IsoSim* sim)
+{
+    return sim->accumulator / sim->step;
+}
+
+vec2 isoSimPlayerPosition(const IsoSim* sim, float alpha)
+{
+    vec2 delta = vec2_sub(sim->player.position, sim->player_previous);
+    return vec2_add(sim->player_previous, vec2_mult(delta, alpha));
+}
+
+vec2 isoSimAgentPosition(const IsoSim* sim, uint32_t agent, float alpha)
+{
+    float x = sim->previous_x[agent] + (sim->x[agent] - sim->previous_x[agent]) * alpha;
+    float y = sim->previous_y[agent] + (sim->y[agent] - sim->previous_y[agent]) * alpha;
+    return (vec2){ x, y };
+}
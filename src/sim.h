@@ -0,0 +1,59 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include "iso.h"
+#include "player.h"
+
+typedef struct
+{
+    vec2 move; /* screen space direction of the player */
+} IsoSimInput;
+
+/*
+ * World state advanced in fixed steps, independent of the frame rate. The
+ * state of the previous tick is kept so rendering can interpolate between
+ * the last two ticks. Nothing in here calls into Ignis, so the simulation
+ * can run headless as fast as the cpu allows.
+ */
+typedef struct
+{
+    const IsoMap* map;
+
+    Player player;
+    vec2 player_previous;
+
+    /* wandering agents, structure-of-arrays for isoMapSweepArray */
+    float* x;
+    float* y;
+    float* vx;
+    float* vy;
+    float* previous_x;
+    float* previous_y;
+    uint32_t agent_count;
+    float agent_speed;
+    vec2 agent_extent;
+
+    float step;        /* seconds per tick */
+    float accumulator;
+    uint64_t ticks;
+    uint32_t seed;
+} IsoSim;
+
+int isoSimInit(IsoSim* sim, const IsoMap* map, float tick_rate, uint32_t agents, uint32_t seed);
+void isoSimDestroy(IsoSim* sim);
+
+void isoSimTick(IsoSim* sim, const IsoSimInput* input);
+
+/*
+ * Adds deltatime to the accumulator and runs as many ticks as fit, but at
+ * most max_ticks so a slow frame cannot snowball. Returns the ticks run.
+ */
+uint32_t isoSimAdvance(IsoSim* sim, const IsoSimInput* input, float deltatime, uint32_t max_ticks);
+
+/* how far rendering is between the previous and the current tick, in [0, 1) */
+float isoSimAlpha(const IsoSim* sim);
+
+vec2 isoSimPlayerPosition(const IsoSim* sim, float alpha);
+vec2 isoSimAgentPosition(const IsoSim* sim, uint32_t agent, float alpha);
+
+#endif // !SIM_H
@@ -0,0 +1,244 @@
+#include "spatial.h"
+#include "alloc.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+static uint32_t isoSpatialBucket(const IsoSpatialHash* hash, int32_t x, int32_t y)
+{
+    uint32_t h = (uint32_t)x * 0x8da6b343u ^ (uint32_t)y * 0xd8163841u;
+    h ^= h >> 15;
+    return h & hash->bucket_mask;
+}
+
+static int32_t isoSpatialCell(const IsoSpatialHash* hash, float f)
+{
+    return (int32_t)floorf(f * hash->inv_cell_size);
+}
+
+int isoSpatialHashInit(IsoSpatialHash* hash, const IsoMap* map, uint32_t cell_tiles, uint32_t buckets)
+{
+    memset(hash, 0, sizeof(IsoSpatialHash));
+
+    hash->cell_size = map->tile_size * (cell_tiles ? cell_tiles : 1);
+    hash->inv_cell_size = 1.0f / hash->cell_size;
+
+    uint32_t bucket_count = 16;
+    while (bucket_count < buckets && bucket_count < 0x80000000u) bucket_count <<= 1;
+
+    hash->bucket_mask = bucket_count - 1;
+    hash->buckets = isoMalloc(ISO_MEM_ENTITY, bucket_count * sizeof(uint32_t));
+    if (!hash->buckets) return 0;
+
+    memset(hash->buckets, 0xff, bucket_count * sizeof(uint32_t));
+    return 1;
+}
+
+void isoSpatialHashDestroy(IsoSpatialHash* hash)
+{
+    if (hash->buckets) isoFree(hash->buckets);
+    if (hash->items) isoFree(hash->items);
+
+    memset(hash, 0, sizeof(IsoSpatialHash));
+}
+
+void isoSpatialHashClear(IsoSpatialHash* hash)
+{
+    memset(hash->buckets, 0xff, (hash->bucket_mask + 1) * sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < hash->capacity; i++)
+        hash->items[i].bucket = ISO_SPATIAL_NONE;
+
+    hash->count = 0;
+}
+
+static int isoSpatialHashReserve(IsoSpatialHash* hash, uint32_t id)
+{
+    if (id < hash->capacity) return 1;
+
+    uint32_t capacity = hash->capacity ? hash->capacity : 64;
+    while (capacity <= id) capacity *= 2;
+
+    IsoSpatialItem* items = isoRealloc(ISO_MEM_ENTITY, hash->items, capacity * sizeof(IsoSpatialItem));
+    if (!items) return 0;
+
+    for (uint32_t i = hash->capacity; i < capacity; i++)
+        items[i].bucket = ISO_SPATIAL_NONE;
+
+    hash->items = items;
+    hash->capacity = capacity;
+    return 1;
+}
+
+static void isoSpatialHashLink(IsoSpatialHash* hash, uint32_t id)
+{
+    IsoSpatialItem* item = &hash->items[id];
+    item->bucket = isoSpatialBucket(hash, item->cell_x, item->cell_y);
+    item->prev = ISO_SPATIAL_NONE;
+    item->next = hash->buckets[item->bucket];
+
+    if (item->next != ISO_SPATIAL_NONE) hash->items[item->next].prev = id;
+    hash->buckets[item->bucket] = id;
+}
+
+static void isoSpatialHashUnlink(IsoSpatialHash* hash, uint32_t id)
+{
+    IsoSpatialItem* item = &hash->items[id];
+
+    if (item->prev != ISO_SPATIAL_NONE) hash->items[item->prev].next = item->next;
+    else                                hash->buckets[item->bucket] = item->next;
+
+    if (item->next != ISO_SPATIAL_NONE) hash->items[item->next].prev = item->prev;
+}
+
+int isoSpatialHashInsert(IsoSpatialHash* hash, uint32_t id, vec2 position)
+{
+    if (id == ISO_SPATIAL_NONE || !isoSpatialHashReserve(hash, id))
+        return 0;
+
+    if (hash->items[id].bucket != ISO_SPATIAL_NONE)
+    {
+        isoSpatialHashMove(hash, id, position);
+        return 1;
+    }
+
+    IsoSpatialItem* item = &hash->items[id];
+    item->position = position;
+    item->cell_x = isoSpatialCell(hash, position.x);
+    item->cell_y = isoSpatialCell(hash, position.y);
+
+    isoSpatialHashLink(hash, id);
+    hash->count++;
+    return 1;
+}
+
+void isoSpatialHashRemove(IsoSpatialHash* hash, uint32_t id)
+{
+    if (id >= hash->capacity || hash->items[id].bucket == ISO_SPATIAL_NONE)
+        return;
+
+    isoSpatialHashUnlink(hash, id);
+    hash->items[id].bucket = ISO_SPATIAL_NONE;
+    hash->count--;
+}
+
+void isoSpatialHashMove(IsoSpatialHash* hash, uint32_t id, vec2 position)
+{
+    if (id >= hash->capacity || hash->items[id].bucket == ISO_SPATIAL_NONE)
+        return;
+
+    IsoSpatialItem* item = &hash->items[id];
+    item->position = position;
+
+    int32_t x = isoSpatialCell(hash, position.x);
+    int32_t y = isoSpatialCell(hash, position.y);
+
+    // most moves stay inside the cell
+    if (x == item->cell_x && y == item->cell_y)
+        return;
+
+    isoSpatialHashUnlink(hash, id);
+    item->cell_x = x;
+    item->cell_y = y;
+    isoSpatialHashLink(hash, id);
+}
+
+uint32_t isoSpatialHashQueryCell(const IsoSpatialHash* hash, vec2 point, uint32_t* out, uint32_t max)
+{
+    int32_t x = isoSpatialCell(hash, point.x);
+    int32_t y = isoSpatialCell(hash, point.y);
+
+    uint32_t found = 0;
+    for (uint32_t id = hash->buckets[isoSpatialBucket(hash, x, y)]; id != ISO_SPATIAL_NONE; id = hash->items[id].next)
+    {
+        const IsoSpatialItem* item = &hash->items[id];
+        if (item->cell_x != x || item->cell_y != y) continue;
+
+        if (found < max) out[found] = id;
+        found++;
+    }
+
+    return found;
+}
+
+/* walks all items in the cells overlapping area, filtering by the given test */
+typedef int (*IsoSpatialFilter)(const IsoSpatialItem* item, const void* shape);
+
+static uint32_t isoSpatialHashQuery(const IsoSpatialHash* hash, rect area, IsoSpatialFilter filter, const void* shape, uint32_t* out, uint32_t max)
+{
+    int32_t x_min = isoSpatialCell(hash, area.min.x);
+    int32_t y_min = isoSpatialCell(hash, area.min.y);
+    int32_t x_max = isoSpatialCell(hash, area.max.x);
+    int32_t y_max = isoSpatialCell(hash, area.max.y);
+
+    uint32_t found = 0;
+
+    // for huge areas every bucket is visited anyway, so just scan them once
+    uint64_t cells = (uint64_t)(x_max - x_min + 1) * (uint64_t)(y_max - y_min + 1);
+    if (cells > hash->bucket_mask)
+    {
+        for (uint32_t id = 0; id < hash->capacity; id++)
+        {
+            const IsoSpatialItem* item = &hash->items[id];
+            if (item->bucket == ISO_SPATIAL_NONE || !filter(item, shape)) continue;
+
+            if (found < max) out[found] = id;
+            found++;
+        }
+        return found;
+    }
+
+    for (int32_t y = y_min; y <= y_max; y++)
+    {
+        for (int32_t x = x_min; x <= x_max; x++)
+        {
+            for (uint32_t id = hash->buckets[isoSpatialBucket(hash, x, y)]; id != ISO_SPATIAL_NONE; id = hash->items[id].next)
+            {
+                const IsoSpatialItem* item = &hash->items[id];
+                if (item->cell_x != x || item->cell_y != y || !filter(item, shape)) continue;
+
+                if (found < max) out[found] = id;
+                found++;
+            }
+        }
+    }
+
+    return found;
+}
+
+typedef struct
+{
+    vec2 center;
+    float radius_sq;
+} IsoSpatialCircle;
+
+static int isoSpatialInCircle(const IsoSpatialItem* item, const void* shape)
+{
+    const IsoSpatialCircle* circle = shape;
+    float dx = item->position.x - circle->center.x;
+    float dy = item->position.y - circle->center.y;
+    return dx * dx + dy * dy <= circle->radius_sq;
+}
+
+static int isoSpatialInRect(const IsoSpatialItem* item, const void* shape)
+{
+    const rect* area = shape;
+    return item->position.x >= area->min.x && item->position.x <= area->max.x
+        && item->position.y >= area->min.y && item->position.y <= area->max.y;
+}
+
+uint32_t isoSpatialHashQueryRadius(const IsoSpatialHash* hash, vec2 center, float radius, uint32_t* out, uint32_t max)
+{
+    IsoSpatialCircle circle = { center, radius * radius };
+    rect area = {
+        { center.x - radius, center.y - radius },
+        { center.x + radius, center.y + radius }
+    };
+    return isoSpatialHashQuery(hash, area, isoSpatialInCircle, &circle, out, max);
+}
+
+uint32_t isoSpatialHashQueryRect(const IsoSpatialHash* hash, rect area, uint32_t* out, uint32_t max)
+{
+    return isoSpatialHashQuery(hash, area, isoSpatialInRect, &area, out, max);
+}
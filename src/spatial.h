@@ -0,0 +1,57 @@
+#ifndef SPATIAL_H
+#define SPATIAL_H
+
+#include "iso.h"
+
+#define ISO_SPATIAL_NONE 0xffffffff
+
+typedef struct
+{
+    vec2 position;
+    int32_t cell_x;
+    int32_t cell_y;
+    uint32_t bucket; /* ISO_SPATIAL_NONE if the id is not in the hash */
+    uint32_t prev;
+    uint32_t next;
+} IsoSpatialItem;
+
+/*
+ * Uniform grid of world space cells, one tile wide by default. Cells are
+ * hashed into a fixed number of buckets holding intrusive linked lists, so
+ * memory only depends on the number of items and not on the map size, and
+ * insert, remove and move are O(1). Items are addressed by a caller chosen
+ * id, e.g. the index of an entity in its IsoEntityLayer.
+ */
+typedef struct
+{
+    float cell_size;
+    float inv_cell_size;
+
+    uint32_t* buckets;
+    uint32_t bucket_mask;
+
+    IsoSpatialItem* items;
+    uint32_t capacity;
+    uint32_t count;
+} IsoSpatialHash;
+
+/* cell_tiles is the cell size in tiles, buckets is rounded up to a power of two */
+int isoSpatialHashInit(IsoSpatialHash* hash, const IsoMap* map, uint32_t cell_tiles, uint32_t buckets);
+void isoSpatialHashDestroy(IsoSpatialHash* hash);
+
+void isoSpatialHashClear(IsoSpatialHash* hash);
+
+/* inserting an id that is already in the hash moves it */
+int isoSpatialHashInsert(IsoSpatialHash* hash, uint32_t id, vec2 position);
+void isoSpatialHashRemove(IsoSpatialHash* hash, uint32_t id);
+void isoSpatialHashMove(IsoSpatialHash* hash, uint32_t id, vec2 position);
+
+/*
+ * Queries write up to max ids to out and return the number of ids found,
+ * which can be larger than max. Results are in no particular order.
+ */
+uint32_t isoSpatialHashQueryCell(const IsoSpatialHash* hash, vec2 point, uint32_t* out, uint32_t max);
+uint32_t isoSpatialHashQueryRadius(const IsoSpatialHash* hash, vec2 center, float radius, uint32_t* out, uint32_t max);
+uint32_t isoSpatialHashQueryRect(const IsoSpatialHash* hash, rect area, uint32_t* out, uint32_t max);
+
+#endif // !SPATIAL_H
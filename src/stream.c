@@ -0,0 +1,398 @@
+#include "stream.h"
+#include "alloc.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define ISO_STREAM_CHUNK_BYTES (ISO_CHUNK_TILES * sizeof(uint32_t))
+
+static int isoStreamWorker(void* arg)
+{
+    IsoStreamer* streamer = arg;
+
+    isoMutexLock(streamer->mutex);
+    for (;;)
+    {
+        while (streamer->running && streamer->pending_head == streamer->pending_count)
+            isoCondWait(streamer->wake, streamer->mutex);
+
+        if (!streamer->running) break;
+
+        IsoStreamLoad load = { streamer->pending[streamer->pending_head++], NULL };
+        streamer->busy = 1;
+        isoMutexUnlock(streamer->mutex);
+
+        // the copy faults the pages in here instead of on the render thread
+        const uint32_t* src = isoMapFileTiles(streamer->file, &streamer->directory[load.chunk]);
+        load.tiles = isoChunkAllocTiles();
+        if (load.tiles) memcpy(load.tiles, src, ISO_STREAM_CHUNK_BYTES);
+
+        isoMutexLock(streamer->mutex);
+        streamer->done[streamer->done_count++] = load;
+        streamer->busy = 0;
+        if (streamer->pending_head == streamer->pending_count)
+            isoCondBroadcast(streamer->idle);
+    }
+    isoMutexUnlock(streamer->mutex);
+
+    return 0;
+}
+
+static void isoStreamLruRemove(IsoStreamer* streamer, uint32_t chunk)
+{
+    uint32_t prev = streamer->prev[chunk];
+    uint32_t next = streamer->next[chunk];
+
+    if (prev != ISO_STREAM_NONE) streamer->next[prev] = next;
+    else                         streamer->lru_head = next;
+
+    if (next != ISO_STREAM_NONE) streamer->prev[next] = prev;
+    else                         streamer->lru_tail = prev;
+}
+
+static void isoStreamLruPush(IsoStreamer* streamer, uint32_t chunk)
+{
+    streamer->prev[chunk] = ISO_STREAM_NONE;
+    streamer->next[chunk] = streamer->lru_head;
+
+    if (streamer->lru_head != ISO_STREAM_NONE) streamer->prev[streamer->lru_head] = chunk;
+    else                                       streamer->lru_tail = chunk;
+
+    streamer->lru_head = chunk;
+}
+
+static void isoStreamChanged(IsoStreamer* streamer, uint32_t chunk)
+{
+    // sized for an update and a flush, see isoStreamOpen
+    streamer->changed[streamer->changed_count++] = chunk;
+}
+
+/* keeps what was edited while the chunk was a placeholder, the loaded tiles fill in the rest */
+static void isoStreamMerge(const IsoChunk* chunk, uint32_t* tiles)
+{
+    for (uint32_t i = 0; i < ISO_CHUNK_TILES; i++)
+    {
+        uint32_t tile = chunk->tiles ? chunk->tiles[i] : chunk->value;
+        if (tile == ISO_TILE_PLACEHOLDER) continue;
+
+        // only raised, the tile itself comes from the file
+        if (ISO_TILE_ID(tile) == ISO_TILE_PLACEHOLDER)
+            tiles[i] = ISO_TILE_ID(tiles[i]) | (tile & ~ISO_TILE_ID_MASK);
+        else
+            tiles[i] = tile;
+    }
+}
+
+/* called with the mutex held */
+static void isoStreamInstall(IsoStreamer* streamer, uint64_t now)
+{
+    for (uint32_t i = 0; i < streamer->done_count; i++)
+    {
+        IsoStreamLoad* load = &streamer->done[i];
+        uint32_t index = load->chunk;
+
+        if (!load->tiles)
+        {
+            streamer->state[index] = ISO_STREAM_EVICTED;
+            continue;
+        }
+
+        IsoChunk* chunk = &streamer->map->chunks[index];
+        int edited = chunk->version != streamer->version[index];
+        if (edited) isoStreamMerge(chunk, load->tiles);
+
+        isoChunkFree(chunk);
+        chunk->tiles = load->tiles;
+        chunk->version++;
+
+        // dropping edited tiles would lose them, so they are never evicted
+        streamer->version[index] = chunk->version;
+        streamer->state[index] = edited ? ISO_STREAM_FIXED : ISO_STREAM_RESIDENT;
+        if (!edited) isoStreamLruPush(streamer, index);
+        isoStreamChanged(streamer, index);
+
+        uint64_t latency = now - streamer->requested[index];
+        streamer->requested[index] = 0;
+
+        streamer->stats.loads++;
+        streamer->stats.latency_total += latency;
+        if (latency > streamer->stats.latency_max) streamer->stats.latency_max = latency;
+        streamer->stats.resident_bytes += ISO_STREAM_CHUNK_BYTES;
+    }
+    streamer->done_count = 0;
+}
+
+static void isoStreamEvict(IsoStreamer* streamer, uint32_t index)
+{
+    IsoChunk* chunk = &streamer->map->chunks[index];
+    isoChunkFree(chunk);
+    chunk->value = ISO_TILE_PLACEHOLDER;
+    chunk->version++;
+
+    streamer->version[index] = chunk->version;
+    streamer->state[index] = ISO_STREAM_EVICTED;
+    isoStreamChanged(streamer, index);
+
+    streamer->stats.evictions++;
+    streamer->stats.resident_bytes -= ISO_STREAM_CHUNK_BYTES;
+}
+
+int isoStreamOpen(IsoStreamer* streamer, IsoMap* map, const char* path, uint32_t radius, uint64_t budget)
+{
+    memset(streamer, 0, sizeof(IsoStreamer));
+
+    streamer->file = isoFileMap(path);
+    if (!streamer->file) return 0;
+
+    const IsoMapFileHeader* header = isoMapFileHeader(streamer->file);
+    if (!header || !isoMapInit(map, NULL, header->width, header->height, header->tile_size, header->tile_offset))
+    {
+        isoFileUnmap(streamer->file);
+        streamer->file = NULL;
+        return 0;
+    }
+
+    map->max_elevation = header->max_elevation;
+
+    streamer->map = map;
+    streamer->directory = isoMapFileDirectory(streamer->file);
+    streamer->radius = radius;
+    streamer->lookahead = 1.0f;
+    streamer->budget = budget;
+    streamer->lru_head = ISO_STREAM_NONE;
+    streamer->lru_tail = ISO_STREAM_NONE;
+
+    // the area around the focus and the one ahead of it
+    uint32_t side = 2 * radius + 1;
+    streamer->request_capacity = 2 * side * side;
+
+    size_t count = (size_t)map->chunk_cols * map->chunk_rows;
+    streamer->state = isoCalloc(ISO_MEM_STREAM, count, sizeof(uint8_t));
+    streamer->needed = isoCalloc(ISO_MEM_STREAM, count, sizeof(uint32_t));
+    streamer->version = isoCalloc(ISO_MEM_STREAM, count, sizeof(uint32_t));
+    streamer->requested = isoCalloc(ISO_MEM_STREAM, count, sizeof(uint64_t));
+    streamer->prev = isoMalloc(ISO_MEM_STREAM, count * sizeof(uint32_t));
+    streamer->next = isoMalloc(ISO_MEM_STREAM, count * sizeof(uint32_t));
+    streamer->requests = isoMalloc(ISO_MEM_STREAM, streamer->request_capacity * sizeof(uint32_t));
+    streamer->pending = isoMalloc(ISO_MEM_STREAM, streamer->request_capacity * sizeof(uint32_t));
+    streamer->done = isoMalloc(ISO_MEM_STREAM, (streamer->request_capacity + 1) * sizeof(IsoStreamLoad));
+    // an update installs and evicts, a flush after it installs once more
+    streamer->changed = isoMalloc(ISO_MEM_STREAM, (3 * streamer->request_capacity + 2) * sizeof(uint32_t));
+
+    if (!streamer->state || !streamer->needed || !streamer->version || !streamer->requested || !streamer->prev
+        || !streamer->next || !streamer->requests || !streamer->pending || !streamer->done || !streamer->changed)
+    {
+        isoStreamClose(streamer);
+        isoMapDestroy(map);
+        return 0;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const IsoMapFileChunk* entry = &streamer->directory[i];
+        IsoChunk* chunk = &map->chunks[i];
+
+        if (!entry->offset)
+        {
+            chunk->value = entry->value;
+            streamer->state[i] = ISO_STREAM_FIXED;
+        }
+        else if (isoMapFileTiles(streamer->file, entry))
+        {
+            chunk->value = ISO_TILE_PLACEHOLDER;
+            streamer->version[i] = chunk->version;
+        }
+        else
+        {
+            isoStreamClose(streamer);
+            isoMapDestroy(map);
+            return 0;
+        }
+    }
+
+    streamer->mutex = isoMutexCreate();
+    streamer->wake = isoCondCreate();
+    streamer->idle = isoCondCreate();
+    streamer->running = 1;
+    if (streamer->mutex && streamer->wake && streamer->idle)
+        streamer->thread = isoThreadCreate(isoStreamWorker, streamer);
+
+    if (!streamer->thread)
+    {
+        isoStreamClose(streamer);
+        isoMapDestroy(map);
+        return 0;
+    }
+
+    return 1;
+}
+
+void isoStreamClose(IsoStreamer* streamer)
+{
+    if (streamer->thread)
+    {
+        isoMutexLock(streamer->mutex);
+        streamer->running = 0;
+        isoCondBroadcast(streamer->wake);
+        isoMutexUnlock(streamer->mutex);
+
+        isoThreadJoin(streamer->thread);
+    }
+
+    // loads that were never installed
+    for (uint32_t i = 0; i < streamer->done_count; i++)
+        isoChunkFreeTiles(streamer->done[i].tiles);
+
+    if (streamer->mutex) isoMutexDestroy(streamer->mutex);
+    if (streamer->wake) isoCondDestroy(streamer->wake);
+    if (streamer->idle) isoCondDestroy(streamer->idle);
+
+    isoFree(streamer->state);
+    isoFree(streamer->needed);
+    isoFree(streamer->version);
+    isoFree(streamer->requested);
+    isoFree(streamer->prev);
+    isoFree(streamer->next);
+    isoFree(streamer->requests);
+    isoFree(streamer->pending);
+    isoFree(streamer->done);
+    isoFree(streamer->changed);
+
+    if (streamer->file) isoFileUnmap(streamer->file);
+
+    memset(streamer, 0, sizeof(IsoStreamer));
+}
+
+static void isoStreamNeed(IsoStreamer* streamer, uint32_t index, uint64_t now)
+{
+    if (streamer->needed[index] == streamer->update) return;
+    streamer->needed[index] = streamer->update;
+
+    // uniform chunks are not streamed and would only inflate the hit rate
+    if (!streamer->directory[index].offset) return;
+
+    switch (streamer->state[index])
+    {
+    case ISO_STREAM_RESIDENT:
+        isoStreamLruRemove(streamer, index);
+        isoStreamLruPush(streamer, index);
+        streamer->stats.hits++;
+        break;
+    case ISO_STREAM_FIXED:
+        streamer->stats.hits++;
+        break;
+    case ISO_STREAM_PENDING:
+        streamer->stats.misses++;
+        break;
+    case ISO_STREAM_EVICTED:
+        streamer->stats.misses++;
+        if (streamer->request_count < streamer->request_capacity)
+        {
+            streamer->requests[streamer->request_count++] = index;
+            streamer->state[index] = ISO_STREAM_PENDING;
+            if (!streamer->requested[index]) streamer->requested[index] = now;
+        }
+        break;
+    }
+}
+
+/* square rings around the center chunk, nearest first */
+static void isoStreamNeedArea(IsoStreamer* streamer, int32_t cx, int32_t cy, uint64_t now)
+{
+    int32_t cols = (int32_t)streamer->map->chunk_cols;
+    int32_t rows = (int32_t)streamer->map->chunk_rows;
+    int32_t radius = (int32_t)streamer->radius;
+
+    for (int32_t d = 0; d <= radius; d++)
+    {
+        for (int32_t y = cy - d; y <= cy + d; y++)
+        {
+            if (y < 0 || y >= rows) continue;
+
+            // inner rows of the ring only have their two ends
+            int32_t step = (y == cy - d || y == cy + d) ? 1 : 2 * d;
+
+            for (int32_t x = cx - d; x <= cx + d; x += step)
+            {
+                if (x >= 0 && x < cols)
+                    isoStreamNeed(streamer, (uint32_t)(y * cols + x), now);
+            }
+        }
+    }
+}
+
+void isoStreamUpdate(IsoStreamer* streamer, vec2 focus, vec2 velocity)
+{
+    uint64_t now = isoClockNs();
+    streamer->update++;
+    streamer->changed_count = 0;
+    streamer->request_count = 0;
+
+    // take back what the worker has not started, priorities are redone below
+    isoMutexLock(streamer->mutex);
+    uint32_t dropped_first = streamer->pending_head;
+    uint32_t dropped_last = streamer->pending_count;
+    streamer->pending_count = streamer->pending_head;
+
+    for (uint32_t i = dropped_first; i < dropped_last; i++)
+        streamer->state[streamer->pending[i]] = ISO_STREAM_EVICTED;
+
+    isoStreamInstall(streamer, now);
+    isoMutexUnlock(streamer->mutex);
+
+    float chunk_size = streamer->map->tile_size * ISO_CHUNK_SIZE;
+    int32_t cx = (int32_t)floorf(focus.x / chunk_size);
+    int32_t cy = (int32_t)floorf(focus.y / chunk_size);
+    isoStreamNeedArea(streamer, cx, cy, now);
+
+    vec2 ahead = vec2_add(focus, vec2_mult(velocity, streamer->lookahead));
+    int32_t ax = (int32_t)floorf(ahead.x / chunk_size);
+    int32_t ay = (int32_t)floorf(ahead.y / chunk_size);
+    if (ax != cx || ay != cy) isoStreamNeedArea(streamer, ax, ay, now);
+
+    isoMutexLock(streamer->mutex);
+    for (uint32_t i = dropped_first; i < dropped_last; i++)
+    {
+        uint32_t index = streamer->pending[i];
+        if (streamer->needed[index] != streamer->update) streamer->requested[index] = 0;
+    }
+
+    memcpy(streamer->pending, streamer->requests, streamer->request_count * sizeof(uint32_t));
+    streamer->pending_head = 0;
+    streamer->pending_count = streamer->request_count;
+    if (streamer->request_count) isoCondSignal(streamer->wake);
+    isoMutexUnlock(streamer->mutex);
+
+    streamer->stats.pending = streamer->request_count;
+
+    // coldest first, everything needed this update was moved to the front
+    uint32_t evictions = 0;
+    while (streamer->stats.resident_bytes > streamer->budget && streamer->lru_tail != ISO_STREAM_NONE
+           && evictions < streamer->request_capacity)
+    {
+        uint32_t index = streamer->lru_tail;
+        if (streamer->needed[index] == streamer->update) break;
+
+        isoStreamLruRemove(streamer, index);
+
+        // dropping edited tiles would lose them
+        if (streamer->map->chunks[index].version != streamer->version[index])
+        {
+            streamer->state[index] = ISO_STREAM_FIXED;
+            continue;
+        }
+
+        isoStreamEvict(streamer, index);
+        evictions++;
+    }
+}
+
+void isoStreamFlush(IsoStreamer* streamer)
+{
+    isoMutexLock(streamer->mutex);
+    while (streamer->pending_head < streamer->pending_count || streamer->busy)
+        isoCondWait(streamer->idle, streamer->mutex);
+
+    isoStreamInstall(streamer, isoClockNs());
+    isoMutexUnlock(streamer->mutex);
+}
@@ -0,0 +1,106 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include "iso.h"
+#include "mapfile.h"
+#include "thread.h"
+
+/*
+ * Streams the chunks of a map file around a focus point. Chunks within
+ * radius of the focus and of where the focus is heading are kept resident,
+ * missing ones are copied out of the file on a background thread, so the
+ * page faults (i.e. the disk reads) never happen on the render thread.
+ * Until they arrive chunks are uniform ISO_TILE_PLACEHOLDER. Resident chunks
+ * no longer needed are evicted least recently used first once more than
+ * budget bytes are loaded. Chunks edited since they arrived are never evicted.
+ * Edits made to a placeholder are kept when its tiles arrive.
+ * Uniform chunks come from the directory and are always resident.
+ */
+#define ISO_STREAM_EVICTED  0
+#define ISO_STREAM_PENDING  1 /* queued or being loaded */
+#define ISO_STREAM_RESIDENT 2 /* in the lru list */
+#define ISO_STREAM_FIXED    3 /* uniform or edited, never evicted */
+
+#define ISO_STREAM_NONE UINT32_MAX
+
+typedef struct
+{
+    uint32_t chunk;
+    uint32_t* tiles; /* NULL if the load failed */
+} IsoStreamLoad;
+
+typedef struct
+{
+    uint64_t loads;
+    uint64_t evictions;
+    uint64_t hits;     /* needed chunks that were resident */
+    uint64_t misses;
+    uint64_t latency_total; /* ns from request to install */
+    uint64_t latency_max;
+    uint64_t resident_bytes;
+    uint32_t pending;
+} IsoStreamStats;
+
+typedef struct
+{
+    IsoMap* map;
+    IsoMappedFile* file;
+    const IsoMapFileChunk* directory;
+
+    /* per chunk */
+    uint8_t* state;
+    uint32_t* needed;    /* update that last needed the chunk */
+    uint32_t* version;   /* chunk version when it arrived or became a placeholder */
+    uint64_t* requested; /* time of the first request, 0 if not wanted */
+    uint32_t* prev;      /* lru list of resident chunks, head is hottest */
+    uint32_t* next;
+    uint32_t lru_head;
+    uint32_t lru_tail;
+
+    uint32_t radius;    /* in chunks */
+    float lookahead;    /* seconds of movement loaded ahead */
+    uint64_t budget;    /* bytes */
+    uint32_t update;
+
+    /* requests in priority order, owned by the main thread until published */
+    uint32_t* requests;
+    uint32_t request_count;
+    uint32_t request_capacity;
+
+    /* chunks loaded or evicted by the last update, e.g. for the pathfinder */
+    uint32_t* changed;
+    uint32_t changed_count;
+
+    /* shared with the worker, guarded by mutex */
+    IsoThread* thread;
+    IsoMutex* mutex;
+    IsoCond* wake;
+    IsoCond* idle;
+    uint32_t* pending;
+    uint32_t pending_head;
+    uint32_t pending_count;
+    IsoStreamLoad* done;
+    uint32_t done_count;
+    int busy;
+    int running;
+
+    IsoStreamStats stats;
+} IsoStreamer;
+
+/* initializes map from the file with every non-uniform chunk missing */
+int isoStreamOpen(IsoStreamer* streamer, IsoMap* map, const char* path, uint32_t radius, uint64_t budget);
+
+/* stops the worker and unmaps the file, loaded chunks stay in map */
+void isoStreamClose(IsoStreamer* streamer);
+
+/*
+ * Installs finished loads, requests what is missing around focus and focus +
+ * velocity * lookahead (world space) and evicts over budget. Never blocks on
+ * loads in flight.
+ */
+void isoStreamUpdate(IsoStreamer* streamer, vec2 focus, vec2 velocity);
+
+/* blocks until every request is done and installed, e.g. before a headless run */
+void isoStreamFlush(IsoStreamer* streamer);
+
+#endif // !STREAM_H
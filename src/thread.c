@@ -0,0 +1,238 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "thread.h"
+
+#include <stdlib.h>
+
+#ifdef _WIN32
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+struct IsoThread
+{
+    HANDLE handle;
+    IsoThreadFn fn;
+    void* arg;
+};
+
+struct IsoMutex { CRITICAL_SECTION cs; };
+struct IsoCond { CONDITION_VARIABLE cv; };
+
+static DWORD WINAPI isoThreadEntry(LPVOID param)
+{
+    IsoThread* thread = param;
+    return (DWORD)thread->fn(thread->arg);
+}
+
+IsoThread* isoThreadCreate(IsoThreadFn fn, void* arg)
+{
+    IsoThread* thread = malloc(sizeof(IsoThread));
+    if (!thread) return NULL;
+
+    thread->fn = fn;
+    thread->arg = arg;
+    thread->handle = CreateThread(NULL, 0, isoThreadEntry, thread, 0, NULL);
+    if (!thread->handle)
+    {
+        free(thread);
+        return NULL;
+    }
+    return thread;
+}
+
+void isoThreadJoin(IsoThread* thread)
+{
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+    free(thread);
+}
+
+IsoMutex* isoMutexCreate()
+{
+    IsoMutex* mutex = malloc(sizeof(IsoMutex));
+    if (mutex) InitializeCriticalSection(&mutex->cs);
+    return mutex;
+}
+
+void isoMutexDestroy(IsoMutex* mutex)
+{
+    DeleteCriticalSection(&mutex->cs);
+    free(mutex);
+}
+
+void isoMutexLock(IsoMutex* mutex)   { EnterCriticalSection(&mutex->cs); }
+void isoMutexUnlock(IsoMutex* mutex) { LeaveCriticalSection(&mutex->cs); }
+
+IsoCond* isoCondCreate()
+{
+    IsoCond* cond = malloc(sizeof(IsoCond));
+    if (cond) InitializeConditionVariable(&cond->cv);
+    return cond;
+}
+
+void isoCondDestroy(IsoCond* cond) { free(cond); }
+
+void isoCondWait(IsoCond* cond, IsoMutex* mutex) { SleepConditionVariableCS(&cond->cv, &mutex->cs, INFINITE); }
+void isoCondSignal(IsoCond* cond)                { WakeConditionVariable(&cond->cv); }
+void isoCondBroadcast(IsoCond* cond)             { WakeAllConditionVariable(&cond->cv); }
+
+uint32_t isoCpuCount()
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+}
+
+uint64_t isoClockNs()
+{
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+}
+
+uint32_t isoThreadId() { return (uint32_t)GetCurrentThreadId(); }
+
+uint32_t isoAtomicAdd(volatile uint32_t* value, uint32_t add) { return (uint32_t)InterlockedExchangeAdd((volatile LONG*)value, (LONG)add); }
+uint32_t isoAtomicLoad(volatile uint32_t* value)              { return (uint32_t)InterlockedCompareExchange((volatile LONG*)value, 0, 0); }
+void isoAtomicStore(volatile uint32_t* value, uint32_t store) { InterlockedExchange((volatile LONG*)value, (LONG)store); }
+uint32_t isoAtomicExchange(volatile uint32_t* value, uint32_t exchange) { return (uint32_t)InterlockedExchange((volatile LONG*)value, (LONG)exchange); }
+
+uint64_t isoAtomicAdd64(volatile uint64_t* value, uint64_t add) { return (uint64_t)InterlockedExchangeAdd64((volatile LONG64*)value, (LONG64)add); }
+
+uint64_t isoAtomicCompareExchange64(volatile uint64_t* value, uint64_t expected, uint64_t exchange)
+{
+    return (uint64_t)InterlockedCompareExchange64((volatile LONG64*)value, (LONG64)exchange, (LONG64)expected);
+}
+
+void isoAtomicFenceRelease() { MemoryBarrier(); }
+void isoAtomicFenceAcquire() { MemoryBarrier(); }
+
+#else
+
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+struct IsoThread
+{
+    pthread_t handle;
+    IsoThreadFn fn;
+    void* arg;
+};
+
+struct IsoMutex { pthread_mutex_t mutex; };
+struct IsoCond { pthread_cond_t cond; };
+
+static void* isoThreadEntry(void* param)
+{
+    IsoThread* thread = param;
+    thread->fn(thread->arg);
+    return NULL;
+}
+
+IsoThread* isoThreadCreate(IsoThreadFn fn, void* arg)
+{
+    IsoThread* thread = malloc(sizeof(IsoThread));
+    if (!thread) return NULL;
+
+    thread->fn = fn;
+    thread->arg = arg;
+    if (pthread_create(&thread->handle, NULL, isoThreadEntry, thread) != 0)
+    {
+        free(thread);
+        return NULL;
+    }
+    return thread;
+}
+
+void isoThreadJoin(IsoThread* thread)
+{
+    pthread_join(thread->handle, NULL);
+    free(thread);
+}
+
+IsoMutex* isoMutexCreate()
+{
+    IsoMutex* mutex = malloc(sizeof(IsoMutex));
+    if (mutex && pthread_mutex_init(&mutex->mutex, NULL) != 0)
+    {
+        free(mutex);
+        return NULL;
+    }
+    return mutex;
+}
+
+void isoMutexDestroy(IsoMutex* mutex)
+{
+    pthread_mutex_destroy(&mutex->mutex);
+    free(mutex);
+}
+
+void isoMutexLock(IsoMutex* mutex)   { pthread_mutex_lock(&mutex->mutex); }
+void isoMutexUnlock(IsoMutex* mutex) { pthread_mutex_unlock(&mutex->mutex); }
+
+IsoCond* isoCondCreate()
+{
+    IsoCond* cond = malloc(sizeof(IsoCond));
+    if (cond && pthread_cond_init(&cond->cond, NULL) != 0)
+    {
+        free(cond);
+        return NULL;
+    }
+    return cond;
+}
+
+void isoCondDestroy(IsoCond* cond)
+{
+    pthread_cond_destroy(&cond->cond);
+    free(cond);
+}
+
+void isoCondWait(IsoCond* cond, IsoMutex* mutex) { pthread_cond_wait(&cond->cond, &mutex->mutex); }
+void isoCondSignal(IsoCond* cond)                { pthread_cond_signal(&cond->cond); }
+void isoCondBroadcast(IsoCond* cond)             { pthread_cond_broadcast(&cond->cond); }
+
+uint32_t isoCpuCount()
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (uint32_t)count : 1;
+}
+
+uint64_t isoClockNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+uint32_t isoAtomicAdd(volatile uint32_t* value, uint32_t add) { return __atomic_fetch_add(value, add, __ATOMIC_SEQ_CST); }
+uint32_t isoAtomicLoad(volatile uint32_t* value)              { return __atomic_load_n(value, __ATOMIC_SEQ_CST); }
+void isoAtomicStore(volatile uint32_t* value, uint32_t store) { __atomic_store_n(value, store, __ATOMIC_SEQ_CST); }
+uint32_t isoAtomicExchange(volatile uint32_t* value, uint32_t exchange) { return __atomic_exchange_n(value, exchange, __ATOMIC_SEQ_CST); }
+
+uint64_t isoAtomicAdd64(volatile uint64_t* value, uint64_t add) { return __atomic_fetch_add(value, add, __ATOMIC_SEQ_CST); }
+
+uint64_t isoAtomicCompareExchange64(volatile uint64_t* value, uint64_t expected, uint64_t exchange)
+{
+    __atomic_compare_exchange_n(value, &expected, exchange, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return expected;
+}
+
+void isoAtomicFenceRelease() { __atomic_thread_fence(__ATOMIC_RELEASE); }
+void isoAtomicFenceAcquire() { __atomic_thread_fence(__ATOMIC_ACQUIRE); }
+
+/* pthread_t is opaque, so threads number themselves on first use */
+static volatile uint32_t thread_count = 0;
+static __thread uint32_t thread_id = 0;
+
+uint32_t isoThreadId()
+{
+    if (!thread_id) thread_id = isoAtomicAdd(&thread_count, 1) + 1;
+    return thread_id;
+}
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef THREAD_H
+#define THREAD_H
+
+#include <stdint.h>
+
+/* thin wrappers over win32 and pthreads, the handles are opaque */
+typedef struct IsoThread IsoThread;
+typedef struct IsoMutex IsoMutex;
+typedef struct IsoCond IsoCond;
+
+typedef int (*IsoThreadFn)(void* arg);
+
+IsoThread* isoThreadCreate(IsoThreadFn fn, void* arg);
+void isoThreadJoin(IsoThread* thread); /* also frees the handle */
+
+IsoMutex* isoMutexCreate();
+void isoMutexDestroy(IsoMutex* mutex);
+void isoMutexLock(IsoMutex* mutex);
+void isoMutexUnlock(IsoMutex* mutex);
+
+IsoCond* isoCondCreate();
+void isoCondDestroy(IsoCond* cond);
+void isoCondWait(IsoCond* cond, IsoMutex* mutex);
+void isoCondSignal(IsoCond* cond);
+void isoCondBroadcast(IsoCond* cond);
+
+uint32_t isoCpuCount();
+
+/* monotonic clock */
+uint64_t isoClockNs();
+
+/* small id of the calling thread, never 0 */
+uint32_t isoThreadId();
+
+/* sequentially consistent, add returns the previous value */
+uint32_t isoAtomicAdd(volatile uint32_t* value, uint32_t add);
+uint32_t isoAtomicLoad(volatile uint32_t* value);
+void isoAtomicStore(volatile uint32_t* value, uint32_t store);
+uint32_t isoAtomicExchange(volatile uint32_t* value, uint32_t exchange);
+
+uint64_t isoAtomicAdd64(volatile uint64_t* value, uint64_t add);
+uint64_t isoAtomicCompareExchange64(volatile uint64_t* value, uint64_t expected, uint64_t exchange); /* returns the previous value */
+
+/* order plain accesses around the atomics: earlier accesses before later stores, earlier loads before later accesses */
+void isoAtomicFenceRelease();
+void isoAtomicFenceAcquire();
+
+#endif // !THREAD_H
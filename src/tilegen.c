@@ -0,0 +1,173 @@
+#include "tilegen.h"
+#include "alloc.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+int isoTileBuilderInit(IsoTileBuilder* builder, IsoJobPool* pool, uint32_t bands)
+{
+    memset(builder, 0, sizeof(IsoTileBuilder));
+
+    builder->pool = pool;
+    builder->band_max = bands ? bands : 1;
+    builder->bands = isoMalloc(ISO_MEM_RENDER, builder->band_max * sizeof(IsoTileBand));
+
+    return builder->bands != NULL;
+}
+
+void isoTileBuilderDestroy(IsoTileBuilder* builder)
+{
+    if (builder->bands) isoFree(builder->bands);
+    if (builder->vertices) isoFree(builder->vertices);
+
+    memset(builder, 0, sizeof(IsoTileBuilder));
+}
+
+/* an upper bound for the quads of a row, empty and hidden tiles are skipped */
+static uint32_t isoTileBuilderRowQuads(const IsoTileBuilder* builder, uint32_t row)
+{
+    const IsoLayerStack* layers = builder->layers;
+
+    uint32_t col_min, col_max;
+    if (!isoTileRangeRow(layers->layers[0].map, &builder->range, row, &col_min, &col_max))
+        return 0;
+
+    // the ground levels left by the sweep, every level of the other layers
+    uint32_t span = col_max - col_min + 1;
+    uint32_t quads = span * isoLayerStackMaxQuads(layers, ISO_LAYER_STATIC);
+
+    const IsoOcclusion* occlusion = &builder->occlusion;
+    if (occlusion->first && row >= occlusion->row_min && row <= occlusion->row_max)
+        quads += occlusion->quads[row - occlusion->row_min] - span * (layers->layers[0].map->max_elevation + 1);
+
+    return quads;
+}
+
+static void isoTileBuilderBand(void* context, uint32_t index)
+{
+    IsoTileBuilder* builder = context;
+    IsoTileBand* band = &builder->bands[index];
+
+    const IsoLayerStack* layers = builder->layers;
+    const IsoMap* map = layers->layers[0].map;
+    IsoVertex* vertices = builder->vertices + (size_t)band->offset * ISO_QUAD_VERTICES;
+    uint32_t quads = 0;
+
+    for (uint32_t row = band->row_min; row <= band->row_max; row++)
+    {
+        uint32_t col_min, col_max;
+        if (!isoTileRangeRow(map, &builder->range, row, &col_min, &col_max))
+            continue;
+
+        uint32_t col = col_min;
+        while (col <= col_max)
+        {
+            uint32_t end = col | ISO_CHUNK_MASK;
+            if (end > col_max) end = col_max;
+
+            if (!isoLayerChunkUsed(layers, col, row, ISO_LAYER_STATIC))
+            {
+                col = end + 1;
+                continue;
+            }
+
+            for (; col <= end; col++)
+            {
+                uint32_t first = isoOcclusionFirst(&builder->occlusion, col, row);
+                quads += isoLayerTileQuads(layers, col, row, first, ISO_LAYER_STATIC, vertices + (size_t)quads * ISO_QUAD_VERTICES);
+            }
+        }
+    }
+
+    band->quads = quads;
+}
+
+int isoTileBuilderBuild(IsoTileBuilder* builder, const IsoLayerStack* layers, rect view)
+{
+    builder->quads = 0;
+    builder->band_count = 0;
+
+    builder->layers = layers;
+    const IsoMap* map = layers->layers[0].map;
+
+    memset(&builder->occlusion, 0, sizeof(IsoOcclusion));
+    if (!isoLayerStackVisibleRange(layers, view, ISO_LAYER_STATIC, &builder->range))
+        return 1;
+
+    uint32_t row_min = builder->range.row_min;
+    uint32_t row_max = builder->range.row_max;
+
+    size_t mark = isoFrameMark();
+    if (map->max_elevation)
+        isoOcclusionBuild(&builder->occlusion, map, layers->layers[0].texture_atlas, &builder->range, 0, row_min, map->width - 1, row_max);
+
+    uint32_t total = 0;
+    for (uint32_t row = row_min; row <= row_max; row++)
+        total += isoTileBuilderRowQuads(builder, row);
+
+    if (total > builder->capacity)
+    {
+        uint32_t capacity = total + total / 2;
+        IsoVertex* vertices = isoRealloc(ISO_MEM_RENDER, builder->vertices, (size_t)capacity * ISO_QUAD_VERTICES * sizeof(IsoVertex));
+        if (!vertices)
+        {
+            isoFrameRelease(mark);
+            memset(&builder->occlusion, 0, sizeof(IsoOcclusion));
+            return 0;
+        }
+
+        builder->vertices = vertices;
+        builder->capacity = capacity;
+    }
+
+    // close a band once it holds its share of the tiles
+    uint32_t bands = builder->band_max;
+    if (bands > row_max - row_min + 1) bands = row_max - row_min + 1;
+
+    uint32_t share = (total + bands - 1) / bands;
+    uint32_t offset = 0, count = 0;
+
+    IsoTileBand* band = &builder->bands[0];
+    band->row_min = row_min;
+    band->offset = 0;
+
+    for (uint32_t row = row_min; row <= row_max; row++)
+    {
+        count += isoTileBuilderRowQuads(builder, row);
+
+        if ((count >= share && builder->band_count + 1 < bands) || row == row_max)
+        {
+            band->row_max = row;
+            band->quads = 0;
+            builder->band_count++;
+
+            offset += count;
+            count = 0;
+
+            if (row == row_max) break;
+
+            band = &builder->bands[builder->band_count];
+            band->row_min = row + 1;
+            band->offset = offset;
+        }
+    }
+
+    isoJobPoolRun(builder->pool, isoTileBuilderBand, builder, builder->band_count);
+
+    // pack the slabs in band order
+    for (uint32_t i = 0; i < builder->band_count; i++)
+    {
+        const IsoTileBand* slab = &builder->bands[i];
+        if (slab->offset != builder->quads)
+        {
+            memmove(builder->vertices + (size_t)builder->quads * ISO_QUAD_VERTICES,
+                    builder->vertices + (size_t)slab->offset * ISO_QUAD_VERTICES,
+                    (size_t)slab->quads * ISO_QUAD_VERTICES * sizeof(IsoVertex));
+        }
+        builder->quads += slab->quads;
+    }
+
+    isoFrameRelease(mark);
+    memset(&builder->occlusion, 0, sizeof(IsoOcclusion));
+    return 1;
+}
@@ -0,0 +1,51 @@
+#ifndef TILEGEN_H
+#define TILEGEN_H
+
+#include "iso.h"
+#include "jobs.h"
+#include "layer.h"
+#include "occlusion.h"
+
+/*
+ * Parallel vertex generation for the visible tiles. The visible rows are
+ * split into bands of about equal tile count; every band fills its own slab
+ * of the vertex buffer and the slabs are packed in band order afterwards, so
+ * the result keeps the back to front order of renderMap. On raised maps the
+ * occlusion sweep runs first on the calling thread and the bands are split
+ * by the levels left to draw. Only the static layers of a stack are built.
+ */
+typedef struct
+{
+    uint32_t row_min;
+    uint32_t row_max;
+
+    uint32_t offset; /* first quad of the slab */
+    uint32_t quads;  /* quads written */
+} IsoTileBand;
+
+typedef struct
+{
+    IsoJobPool* pool;
+
+    IsoTileBand* bands;
+    uint32_t band_max;
+    uint32_t band_count;
+
+    IsoVertex* vertices;
+    uint32_t capacity; /* in quads */
+    uint32_t quads;
+
+    /* state of the running build */
+    const IsoLayerStack* layers;
+    IsoTileRange range;
+    IsoOcclusion occlusion;
+} IsoTileBuilder;
+
+/* pool may be NULL to build on the calling thread only */
+int isoTileBuilderInit(IsoTileBuilder* builder, IsoJobPool* pool, uint32_t bands);
+void isoTileBuilderDestroy(IsoTileBuilder* builder);
+
+/* generates the map space quads of all visible tile levels, returns 0 if out of memory */
+int isoTileBuilderBuild(IsoTileBuilder* builder, const IsoLayerStack* layers, rect view);
+
+#endif // !TILEGEN_H
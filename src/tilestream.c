@@ -0,0 +1,248 @@
+#include "tilestream.h"
+#include "alloc.h"
+#include "occlusion.h"
+
+#include <string.h>
+
+#define ISO_TILE_WORD_DIFF_MASK  ((1u << ISO_TILE_WORD_DIFF_BITS) - 1)
+#define ISO_TILE_WORD_SUM_MASK   ((1u << ISO_TILE_WORD_SUM_BITS) - 1)
+#define ISO_TILE_WORD_LEVEL_MASK ((1u << ISO_TILE_WORD_LEVEL_BITS) - 1)
+
+#define ISO_TILE_WORD_SUM_SHIFT   ISO_TILE_WORD_DIFF_BITS
+#define ISO_TILE_WORD_LEVEL_SHIFT (ISO_TILE_WORD_SUM_SHIFT + ISO_TILE_WORD_SUM_BITS)
+#define ISO_TILE_WORD_FRAME_SHIFT (ISO_TILE_WORD_LEVEL_SHIFT + ISO_TILE_WORD_LEVEL_BITS)
+
+int isoTileStreamInit(IsoTileStream* stream)
+{
+    memset(stream, 0, sizeof(IsoTileStream));
+
+    stream->draw_capacity = 4;
+    stream->draws = isoMalloc(ISO_MEM_RENDER, stream->draw_capacity * sizeof(IsoTileStreamDraw));
+
+    return stream->draws != NULL;
+}
+
+void isoTileStreamDestroy(IsoTileStream* stream)
+{
+    if (stream->words) isoFree(stream->words);
+    if (stream->draws) isoFree(stream->draws);
+
+    memset(stream, 0, sizeof(IsoTileStream));
+}
+
+/* state of a running build */
+typedef struct
+{
+    IsoTileStream* stream;
+    IsoTileStreamDraw* draw;
+    IsoTileRange range;
+    int fits; /* the whole range fits the window of one draw */
+} IsoTileStreamState;
+
+static int isoTileStreamBeginDraw(IsoTileStreamState* state, int32_t diff, int32_t sum)
+{
+    IsoTileStream* stream = state->stream;
+    if (stream->draw_count == stream->draw_capacity)
+    {
+        uint32_t capacity = stream->draw_capacity * 2;
+        IsoTileStreamDraw* draws = isoRealloc(ISO_MEM_RENDER, stream->draws, capacity * sizeof(IsoTileStreamDraw));
+        if (!draws) return 0;
+
+        stream->draws = draws;
+        stream->draw_capacity = capacity;
+    }
+
+    IsoTileStreamDraw* draw = &stream->draws[stream->draw_count++];
+    draw->first = stream->count;
+    draw->count = 0;
+    draw->frame_count = 0;
+
+    // far out the window follows the tiles, centered on the one that did not fit
+    draw->diff_base = state->range.diff_min;
+    draw->sum_base = state->range.sum_min;
+    if (!state->fits)
+    {
+        if (diff - (int32_t)(ISO_TILE_WORD_DIFF_MASK / 2) > draw->diff_base) draw->diff_base = diff - (int32_t)(ISO_TILE_WORD_DIFF_MASK / 2);
+        if (sum - (int32_t)(ISO_TILE_WORD_SUM_MASK / 2) > draw->sum_base) draw->sum_base = sum - (int32_t)(ISO_TILE_WORD_SUM_MASK / 2);
+    }
+
+    state->draw = draw;
+    return 1;
+}
+
+/* the table entry of src in layer unit, ISO_TILE_WORD_FRAMES if the table is full */
+static uint32_t isoTileStreamFrame(IsoTileStreamDraw* draw, const IsoAtlasFrame* src, uint32_t unit)
+{
+    for (uint32_t i = 0; i < draw->frame_count; i++)
+    {
+        if (draw->sources[i] == src && draw->units[i] == unit) return i;
+    }
+
+    if (draw->frame_count == ISO_TILE_WORD_FRAMES) return ISO_TILE_WORD_FRAMES;
+
+    draw->sources[draw->frame_count] = src;
+    draw->frames[draw->frame_count] = src->src;
+    draw->units[draw->frame_count] = unit;
+    return draw->frame_count++;
+}
+
+static int isoTileStreamPush(IsoTileStreamState* state, uint32_t col, uint32_t row, uint32_t level, const IsoAtlasFrame* src, uint32_t unit)
+{
+    IsoTileStream* stream = state->stream;
+    if (level > ISO_TILE_WORD_LEVEL_MASK)
+    {
+        stream->dropped++;
+        return 1;
+    }
+
+    int32_t diff = (int32_t)col - (int32_t)row;
+    int32_t sum = (int32_t)(col + row);
+
+    IsoTileStreamDraw* draw = state->draw;
+    uint32_t d = (uint32_t)(diff - draw->diff_base);
+    uint32_t s = (uint32_t)(sum - draw->sum_base);
+    uint32_t frame = ISO_TILE_WORD_FRAMES;
+
+    if (d <= ISO_TILE_WORD_DIFF_MASK && s <= ISO_TILE_WORD_SUM_MASK)
+        frame = isoTileStreamFrame(draw, src, unit);
+
+    if (frame == ISO_TILE_WORD_FRAMES)
+    {
+        if (!isoTileStreamBeginDraw(state, diff, sum)) return 0;
+
+        draw = state->draw;
+        d = (uint32_t)(diff - draw->diff_base);
+        s = (uint32_t)(sum - draw->sum_base);
+        frame = isoTileStreamFrame(draw, src, unit);
+    }
+
+    stream->words[stream->count++] = ISO_TILE_WORD(d, s, level, frame);
+    draw->count++;
+    return 1;
+}
+
+/* the levels of a tile in the order of isoLayerTileQuads, returns 0 if out of memory */
+static int isoTileStreamLevels(IsoTileStreamState* state, const IsoLayerStack* layers, uint32_t col, uint32_t row, uint32_t first, uint32_t modes)
+{
+    uint32_t tile = isoLayerTile(layers, 0, col, row);
+
+    if ((layers->layers[0].mode & modes) && ISO_TILE_ID(tile) != ISO_TILE_EMPTY)
+    {
+        const IsoAtlasFrame* src = isoAtlasTileFrame(layers->layers[0].texture_atlas, ISO_TILE_ID(tile));
+        for (uint32_t level = first; src && level <= ISO_TILE_ELEVATION(tile); level++)
+        {
+            if (!isoTileStreamPush(state, col, row, level, src, 0)) return 0;
+        }
+    }
+
+    uint32_t base = isoLayerBase(tile);
+    for (uint32_t i = 1; i < layers->count; i++)
+    {
+        const IsoTileLayer* layer = &layers->layers[i];
+        if (!(layer->mode & modes)) continue;
+
+        uint32_t upper = isoLayerTile(layers, i, col, row);
+        if (ISO_TILE_ID(upper) == ISO_TILE_EMPTY) continue;
+
+        const IsoAtlasFrame* src = isoAtlasTileFrame(layer->texture_atlas, ISO_TILE_ID(upper));
+        for (uint32_t level = base; src && level <= base + ISO_TILE_ELEVATION(upper); level++)
+        {
+            if (!isoTileStreamPush(state, col, row, level, src, i)) return 0;
+        }
+    }
+
+    return 1;
+}
+
+int isoTileStreamBuild(IsoTileStream* stream, const IsoLayerStack* layers, rect view, uint32_t modes)
+{
+    const IsoMap* map = layers->layers[0].map;
+
+    stream->count = 0;
+    stream->draw_count = 0;
+    stream->dropped = 0;
+    stream->tile_size = map->tile_size;
+    stream->tile_offset = map->tile_offset;
+
+    IsoTileStreamState state = { 0 };
+    state.stream = stream;
+    if (!isoLayerStackVisibleRange(layers, view, modes, &state.range))
+        return 1;
+
+    IsoTileRange* range = &state.range;
+    state.fits = (uint32_t)(range->diff_max - range->diff_min) <= ISO_TILE_WORD_DIFF_MASK
+              && (uint32_t)(range->sum_max - range->sum_min) <= ISO_TILE_WORD_SUM_MASK;
+
+    // every level of every tile in the range at most
+    uint32_t tile_quads = isoLayerStackMaxQuads(layers, modes);
+    uint32_t total = 0;
+    for (uint32_t row = range->row_min; row <= range->row_max; row++)
+    {
+        uint32_t col_min, col_max;
+        if (isoTileRangeRow(map, range, row, &col_min, &col_max))
+            total += (col_max - col_min + 1) * tile_quads;
+    }
+
+    if (total > stream->capacity)
+    {
+        uint32_t capacity = total + total / 2;
+        uint32_t* words = isoRealloc(ISO_MEM_RENDER, stream->words, (size_t)capacity * sizeof(uint32_t));
+        if (!words) return 0;
+
+        stream->words = words;
+        stream->capacity = capacity;
+    }
+
+    size_t mark = isoFrameMark();
+    IsoOcclusion occlusion = { 0 };
+    if (map->max_elevation && (layers->layers[0].mode & modes))
+        isoOcclusionBuild(&occlusion, map, layers->layers[0].texture_atlas, range, 0, range->row_min, map->width - 1, range->row_max);
+
+    int result = isoTileStreamBeginDraw(&state, range->diff_min, range->sum_min);
+    for (uint32_t row = range->row_min; row <= range->row_max && result; row++)
+    {
+        uint32_t col_min, col_max;
+        if (!isoTileRangeRow(map, range, row, &col_min, &col_max))
+            continue;
+
+        uint32_t col = col_min;
+        while (col <= col_max && result)
+        {
+            uint32_t end = col | ISO_CHUNK_MASK;
+            if (end > col_max) end = col_max;
+
+            if (!isoLayerChunkUsed(layers, col, row, modes))
+            {
+                col = end + 1;
+                continue;
+            }
+
+            for (; col <= end && result; col++)
+                result = isoTileStreamLevels(&state, layers, col, row, isoOcclusionFirst(&occlusion, col, row), modes);
+        }
+    }
+
+    isoFrameRelease(mark);
+    return result;
+}
+
+void isoTileStreamQuad(const IsoTileStream* stream, const IsoTileStreamDraw* draw, uint32_t word, IsoVertex* vertices)
+{
+    float diff = (float)(draw->diff_base + (int32_t)(word & ISO_TILE_WORD_DIFF_MASK));
+    float sum = (float)(draw->sum_base + (int32_t)((word >> ISO_TILE_WORD_SUM_SHIFT) & ISO_TILE_WORD_SUM_MASK));
+    float level = (float)((word >> ISO_TILE_WORD_LEVEL_SHIFT) & ISO_TILE_WORD_LEVEL_MASK);
+    uint32_t frame = word >> ISO_TILE_WORD_FRAME_SHIFT;
+
+    float x = (diff - 1.0f) * stream->tile_size;
+    float y = sum * stream->tile_size * .5f - level * stream->tile_offset;
+    float w = stream->tile_size * 2.0f;
+    float h = stream->tile_size + stream->tile_offset;
+
+    IgnisRect src = draw->frames[frame];
+    float t = (float)draw->units[frame];
+
+    vertices[0] = (IsoVertex){ x,     y,     0.0f, src.x,         src.y,         t };
+    vertices[1] = (IsoVertex){ x + w, y,     0.0f, src.x + src.w, src.y,         t };
+    vertices[2] = (IsoVertex){ x + w, y + h, 0.0f, src.x + src.w, src.y + src.h, t };
+    vertices[3] = (IsoVertex){ x,     y + h, 0.0f, src.x,         src.y + src.h, t };
+}
@@ -0,0 +1,72 @@
+#ifndef TILESTREAM_H
+#define TILESTREAM_H
+
+#include "iso.h"
+#include "layer.h"
+
+/* bits of a tile word, see res/shaders/tiles.vert */
+#define ISO_TILE_WORD_DIFF_BITS  9  /* col - row from the base of the draw */
+#define ISO_TILE_WORD_SUM_BITS   10 /* col + row from the base of the draw */
+#define ISO_TILE_WORD_LEVEL_BITS 8
+#define ISO_TILE_WORD_FRAME_BITS 5  /* entry in the frame table of the draw */
+
+#define ISO_TILE_WORD_FRAMES (1 << ISO_TILE_WORD_FRAME_BITS)
+
+#define ISO_TILE_WORD(diff, sum, level, frame) \
+    ((diff) | (sum) << ISO_TILE_WORD_DIFF_BITS | (level) << (ISO_TILE_WORD_DIFF_BITS + ISO_TILE_WORD_SUM_BITS) \
+     | (frame) << (ISO_TILE_WORD_DIFF_BITS + ISO_TILE_WORD_SUM_BITS + ISO_TILE_WORD_LEVEL_BITS))
+
+/* a run of words drawn with one instanced call */
+typedef struct
+{
+    uint32_t first;
+    uint32_t count;
+
+    int32_t diff_base;
+    int32_t sum_base;
+
+    IgnisRect frames[ISO_TILE_WORD_FRAMES]; /* normalized src of each entry */
+    uint32_t units[ISO_TILE_WORD_FRAMES];   /* texture unit, the index of the layer */
+    const IsoAtlasFrame* sources[ISO_TILE_WORD_FRAMES];
+    uint32_t frame_count;
+} IsoTileStreamDraw;
+
+/*
+ * Compact per tile input for instanced rendering: one 32 bit word for every
+ * visible tile level instead of a quad of four vertices, in the order of
+ * isoLayerTileQuads. A word holds the screen column (col - row) and screen
+ * row (col + row) of its tile, the level and an entry of the frame table,
+ * the vertex shader builds the quad from them. A new draw starts when a tile
+ * leaves the window of its draw or the frame table is full, which only
+ * happens far out where impostors take over. Animated tiles get the frame
+ * of the last isoAtlasAnimate. Levels above 255, the most a word holds, are
+ * dropped and counted in dropped. Only tall upper layer tiles on high ground
+ * reach that far, they stand on the ground tile below them.
+ */
+typedef struct
+{
+    uint32_t* words;
+    uint32_t count;
+    uint32_t capacity;
+
+    IsoTileStreamDraw* draws;
+    uint32_t draw_count;
+    uint32_t draw_capacity;
+
+    float tile_size;
+    float tile_offset;
+
+    /* stats of the last build */
+    uint32_t dropped; /* levels too high for a word, not drawn */
+} IsoTileStream;
+
+int isoTileStreamInit(IsoTileStream* stream);
+void isoTileStreamDestroy(IsoTileStream* stream);
+
+/* the visible tile levels of the layers of modes, returns 0 if out of memory */
+int isoTileStreamBuild(IsoTileStream* stream, const IsoLayerStack* layers, rect view, uint32_t modes);
+
+/* the map space quad of a word as the vertex shader builds it, laid out like isoMapTileQuad */
+void isoTileStreamQuad(const IsoTileStream* stream, const IsoTileStreamDraw* draw, uint32_t word, IsoVertex* vertices);
+
+#endif // !TILESTREAM_H
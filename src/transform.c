@@ -0,0 +1,211 @@
+#include "transform.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ISO_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(ISO_SSE2) && (defined(_MSC_VER) || defined(__GNUC__))
+#define ISO_AVX2
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define ISO_TARGET_AVX2
+#else
+#define ISO_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#endif
+
+typedef void (*IsoAffineKernel)(const IsoAffine* a, const float* in_x, const float* in_y, float* out_x, float* out_y, size_t count);
+typedef void (*IsoAffineKernelU32)(const IsoAffine* a, const uint32_t* in_x, const uint32_t* in_y, float* out_x, float* out_y, size_t count);
+
+/* scalar */
+static void isoAffineScalar(const IsoAffine* a, const float* in_x, const float* in_y, float* out_x, float* out_y, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        float x = in_x[i];
+        float y = in_y[i];
+        out_x[i] = a->m00 * x + a->m01 * y + a->tx;
+        out_y[i] = a->m10 * x + a->m11 * y + a->ty;
+    }
+}
+
+static void isoAffineScalarU32(const IsoAffine* a, const uint32_t* in_x, const uint32_t* in_y, float* out_x, float* out_y, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        float x = (float)(int32_t)in_x[i];
+        float y = (float)(int32_t)in_y[i];
+        out_x[i] = a->m00 * x + a->m01 * y + a->tx;
+        out_y[i] = a->m10 * x + a->m11 * y + a->ty;
+    }
+}
+
+/* sse2 */
+#ifdef ISO_SSE2
+
+#define ISO_AFFINE_SSE2(x, y)                                                                   \
+    _mm_storeu_ps(out_x + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, x), _mm_mul_ps(m01, y)), tx)); \
+    _mm_storeu_ps(out_y + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m10, x), _mm_mul_ps(m11, y)), ty))
+
+static void isoAffineSSE2(const IsoAffine* a, const float* in_x, const float* in_y, float* out_x, float* out_y, size_t count)
+{
+    __m128 m00 = _mm_set1_ps(a->m00), m01 = _mm_set1_ps(a->m01), tx = _mm_set1_ps(a->tx);
+    __m128 m10 = _mm_set1_ps(a->m10), m11 = _mm_set1_ps(a->m11), ty = _mm_set1_ps(a->ty);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(in_x + i);
+        __m128 y = _mm_loadu_ps(in_y + i);
+        ISO_AFFINE_SSE2(x, y);
+    }
+
+    isoAffineScalar(a, in_x + i, in_y + i, out_x + i, out_y + i, count - i);
+}
+
+static void isoAffineSSE2U32(const IsoAffine* a, const uint32_t* in_x, const uint32_t* in_y, float* out_x, float* out_y, size_t count)
+{
+    __m128 m00 = _mm_set1_ps(a->m00), m01 = _mm_set1_ps(a->m01), tx = _mm_set1_ps(a->tx);
+    __m128 m10 = _mm_set1_ps(a->m10), m11 = _mm_set1_ps(a->m11), ty = _mm_set1_ps(a->ty);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(in_x + i)));
+        __m128 y = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(in_y + i)));
+        ISO_AFFINE_SSE2(x, y);
+    }
+
+    isoAffineScalarU32(a, in_x + i, in_y + i, out_x + i, out_y + i, count - i);
+}
+
+#endif
+
+/* avx2 */
+#ifdef ISO_AVX2
+
+#define ISO_AFFINE_AVX2(x, y)                                                                               \
+    _mm256_storeu_ps(out_x + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m00, x), _mm256_mul_ps(m01, y)), tx)); \
+    _mm256_storeu_ps(out_y + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m10, x), _mm256_mul_ps(m11, y)), ty))
+
+ISO_TARGET_AVX2
+static void isoAffineAVX2(const IsoAffine* a, const float* in_x, const float* in_y, float* out_x, float* out_y, size_t count)
+{
+    __m256 m00 = _mm256_set1_ps(a->m00), m01 = _mm256_set1_ps(a->m01), tx = _mm256_set1_ps(a->tx);
+    __m256 m10 = _mm256_set1_ps(a->m10), m11 = _mm256_set1_ps(a->m11), ty = _mm256_set1_ps(a->ty);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(in_x + i);
+        __m256 y = _mm256_loadu_ps(in_y + i);
+        ISO_AFFINE_AVX2(x, y);
+    }
+
+    isoAffineScalar(a, in_x + i, in_y + i, out_x + i, out_y + i, count - i);
+}
+
+ISO_TARGET_AVX2
+static void isoAffineAVX2U32(const IsoAffine* a, const uint32_t* in_x, const uint32_t* in_y, float* out_x, float* out_y, size_t count)
+{
+    __m256 m00 = _mm256_set1_ps(a->m00), m01 = _mm256_set1_ps(a->m01), tx = _mm256_set1_ps(a->tx);
+    __m256 m10 = _mm256_set1_ps(a->m10), m11 = _mm256_set1_ps(a->m11), ty = _mm256_set1_ps(a->ty);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)(in_x + i)));
+        __m256 y = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)(in_y + i)));
+        ISO_AFFINE_AVX2(x, y);
+    }
+
+    isoAffineScalarU32(a, in_x + i, in_y + i, out_x + i, out_y + i, count - i);
+}
+
+static int isoCpuHasAVX2()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return 0;
+
+    // the os has to save the ymm registers too
+    __cpuid(info, 1);
+    if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28))) return 0;
+    if ((_xgetbv(0) & 6) != 6) return 0;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+/* dispatch */
+static IsoKernel kernel_active = ISO_KERNEL_AUTO;
+static IsoAffineKernel kernel_affine = isoAffineScalar;
+static IsoAffineKernelU32 kernel_affine_u32 = isoAffineScalarU32;
+
+IsoKernel isoTransformSetKernel(IsoKernel kernel)
+{
+    if (kernel == ISO_KERNEL_AUTO) kernel = ISO_KERNEL_AVX2;
+
+#ifdef ISO_AVX2
+    if (kernel == ISO_KERNEL_AVX2 && isoCpuHasAVX2())
+    {
+        kernel_affine = isoAffineAVX2;
+        kernel_affine_u32 = isoAffineAVX2U32;
+        return kernel_active = ISO_KERNEL_AVX2;
+    }
+#endif
+
+#ifdef ISO_SSE2
+    if (kernel >= ISO_KERNEL_SSE2)
+    {
+        kernel_affine = isoAffineSSE2;
+        kernel_affine_u32 = isoAffineSSE2U32;
+        return kernel_active = ISO_KERNEL_SSE2;
+    }
+#endif
+
+    kernel_affine = isoAffineScalar;
+    kernel_affine_u32 = isoAffineScalarU32;
+    return kernel_active = ISO_KERNEL_SCALAR;
+}
+
+IsoKernel isoTransformGetKernel()
+{
+    if (kernel_active == ISO_KERNEL_AUTO)
+        isoTransformSetKernel(ISO_KERNEL_AUTO);
+    return kernel_active;
+}
+
+const char* isoKernelName(IsoKernel kernel)
+{
+    switch (kernel)
+    {
+    case ISO_KERNEL_SCALAR: return "scalar";
+    case ISO_KERNEL_SSE2:   return "sse2";
+    case ISO_KERNEL_AVX2:   return "avx2";
+    default:                return "auto";
+    }
+}
+
+void isoAffineTransform(const IsoAffine* affine, const float* in_x, const float* in_y, float* out_x, float* out_y, size_t count)
+{
+    isoTransformGetKernel();
+    kernel_affine(affine, in_x, in_y, out_x, out_y, count);
+}
+
+void isoAffineTransformU32(const IsoAffine* affine, const uint32_t* in_x, const uint32_t* in_y, float* out_x, float* out_y, size_t count)
+{
+    isoTransformGetKernel();
+    kernel_affine_u32(affine, in_x, in_y, out_x, out_y, count);
+}
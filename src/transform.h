@@ -0,0 +1,41 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Batched 2D affine transforms over structure-of-arrays input:
+ *   out_x = m00 * x + m01 * y + tx
+ *   out_y = m10 * x + m11 * y + ty
+ * All iso/cartesian/screen conversions are of this form. Input and output
+ * arrays may alias.
+ */
+typedef struct
+{
+    float m00, m01, tx;
+    float m10, m11, ty;
+} IsoAffine;
+
+typedef enum
+{
+    ISO_KERNEL_AUTO = 0,
+    ISO_KERNEL_SCALAR,
+    ISO_KERNEL_SSE2,
+    ISO_KERNEL_AVX2
+} IsoKernel;
+
+/*
+ * Selects the kernel used by all batch transforms. AUTO (the default) picks
+ * the widest one the cpu supports, unsupported requests fall back to the next
+ * narrower kernel. Returns the kernel actually in use.
+ */
+IsoKernel isoTransformSetKernel(IsoKernel kernel);
+IsoKernel isoTransformGetKernel();
+
+const char* isoKernelName(IsoKernel kernel);
+
+void isoAffineTransform(const IsoAffine* affine, const float* in_x, const float* in_y, float* out_x, float* out_y, size_t count);
+void isoAffineTransformU32(const IsoAffine* affine, const uint32_t* in_x, const uint32_t* in_y, float* out_x, float* out_y, size_t count);
+
+#endif // !TRANSFORM_H